@@ -2,25 +2,18 @@
 #define INCLUDE_TRAFFICLIGHTCONTROLLERAPP_H_
 
 #include "interfaces/app/IApp.hpp"
+#include "interfaces/app/IDecisionPolicy.hpp"
 #include "interfaces/clock/IClock.hpp"
 
+#include "impl/app/demandEstimator.hpp"
+#include "impl/app/patternTable.hpp"
+#include "impl/app/transitionTable.hpp"
+#include "impl/config/configManager.hpp"
 #include "impl/simulator/simulator.hpp"
+#include "impl/util/deadlineHeap.hpp"
 
 #include <cstdint>
-#include <map>
-
-////////////////////////////////////////////////////////////
-///  @brief The possible patterns of the traffic light
-///  
-////////////////////////////////////////////////////////////
-enum TrafficLightPattern
-{
-    NorthSouthTurning, ///< State 0 for N_W & S_E turning
-    NorthSouthThrough, ///< State 1 for N_N & S_S through
-    EastWestTurning,   ///< State 2 for E_N & W_S turning
-    EastWestThrough,   ///< State 3 for E_E & W_W through
-    NUM_PATTERNS
-};
+#include <iostream>
 
 ////////////////////////////////////////////////////////////
 ///  @brief Traffic Light on/off and time tracking
@@ -49,6 +42,32 @@ struct VehicleState
     IClock::Time waitTime;
 };
 
+////////////////////////////////////////////////////////////
+///  @brief Everything a TrafficLightControllerApp decides on,
+///  copied out at one tick.
+///
+///  Times are absolute clock times, so a snapshot restores
+///  onto a controller whose clock reads the same time.
+///
+////////////////////////////////////////////////////////////
+struct ControllerSnapshot
+{
+    IClock::Time now;                   ///< clock time of the snapshot
+    TrafficLightPattern activePattern;  ///< pattern currently GREEN
+    bool carsAwaiting;                  ///< cars waiting at red lights
+    IClock::Time maxWaitTime;           ///< max wait at a red light
+    TrafficSignals signals;             ///< signal of each lane
+    VehicleSensors sensors;             ///< sensors read this tick
+    std::array<TrafficLightState, TrafficLightPattern::NUM_PATTERNS> lightStates; ///< state of each pattern
+    std::array<VehicleState, Lane::COUNT> vehicleStates;                          ///< state of each lane
+    TrafficLightPattern preemptPattern; ///< pattern held for an emergency vehicle, NUM_PATTERNS when none
+    bool preemptYellow;                 ///< lanes are showing the preemption YELLOW
+    bool preemptReleased;               ///< release once the preempting pattern is GREEN
+    IClock::Time preemptRedAt;          ///< clock time the YELLOW lanes turn RED
+    IClock::Time preemptGreenAt;        ///< clock time the preempting pattern may turn GREEN
+    IClock::Time tickLength;            ///< clock time between the last two ticks
+};
+
 ////////////////////////////////////////////////////////////
 ///  @brief TrafficLightControllerApp controls a four-way
 ///  traffic light intersection.
@@ -57,6 +76,19 @@ struct VehicleState
 class TrafficLightControllerApp : public IApp
 {
 public:
+    /// Clock time lanes losing GREEN show YELLOW when preempted
+    static constexpr IClock::Time PREEMPTION_YELLOW_TIME = 3;
+
+    /// Clock time every lane then shows RED before the
+    /// preempting pattern turns GREEN
+    static constexpr IClock::Time PREEMPTION_RED_TIME = 2;
+
+    /// Ticks before its max wait that a waiting vehicle's
+    /// pattern is forced GREEN. Lanes waiting in every other
+    /// pattern can come due together, and each takes a tick,
+    /// so at any tick length none waits past the bound.
+    static constexpr unsigned DEADLINE_LEAD_TICKS = TrafficLightPattern::NUM_PATTERNS - 1;
+
     ////////////////////////////////////////////////////////////
     ///  @brief Construct a new Traffic Light Controller App object
     ///  
@@ -64,10 +96,12 @@ public:
     ///  @param sensorsRef Reference to a VehicleSensors
     ///  @param laneActiveTimesRef Reference to a LaneActiveTimes
     ///  @param maxWaitTime Max wait time for a vehicle at red light
+    ///  @param log Stream for status messages, nullptr for none
     ////////////////////////////////////////////////////////////
     TrafficLightControllerApp(const Clock &clockRef,
                               const VehicleSensors &sensorsRef,
-                              IClock::Time maxWaitTime);
+                              IClock::Time maxWaitTime,
+                              std::ostream *log = &std::cout);
 
     ////////////////////////////////////////////////////////////
     ///  @brief Initialize all necessary members for this app.
@@ -77,10 +111,149 @@ public:
 
     ////////////////////////////////////////////////////////////
     ///  @brief Execute the logic of this app when called upon.
+    ///
+    ///  With enforceMaxWait in the timing plan, a vehicle that
+    ///  would reach its max wait time within DEADLINE_LEAD_TICKS
+    ///  more ticks, at the clock time between the last two
+    ///  run() calls, gets its pattern GREEN first, whatever the
+    ///  active pattern's minActiveTime, the cycle order or the
+    ///  policy. Only a preemption comes before it.
+    ///
+    ///  Never allocates once initApp() has returned.
     ///  
     ////////////////////////////////////////////////////////////
     void run() override;
 
+    ////////////////////////////////////////////////////////////
+    ///  @brief Take timing from a ConfigManager from now on.
+    ///
+    ///  Each run() applies the live TimingConfig before
+    ///  checking the cycle, so a reload takes effect on the
+    ///  next tick with no lock or allocation.
+    ///
+    ///  @param config The ConfigManager to read
+    ///  @param reader Reader registered by the calling thread
+    ////////////////////////////////////////////////////////////
+    void attachConfig(ConfigManager &config, ConfigManager::ReaderId reader);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Let a policy choose when patterns end.
+    ///
+    ///  Each run() asks the policy instead of checking the
+    ///  cycle, then still holds a pattern until its
+    ///  minActiveTime and ends it at maxActiveTime while cars
+    ///  are waiting.
+    ///
+    ///  @param policy The policy to ask, nullptr for the rules
+    ////////////////////////////////////////////////////////////
+    inline void attachPolicy(IDecisionPolicy *policy)
+    {
+        policy_ = policy;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Decide each tick with one TransitionTable lookup
+    ///  instead of checking the cycle and sensors.
+    ///
+    ///  The table is used while no policy or log is attached
+    ///  and every pattern's limits are above zero; otherwise
+    ///  the rules run as before.
+    ///
+    ///  @param table The table to use, nullptr for the rules
+    ////////////////////////////////////////////////////////////
+    inline void attachTransitionTable(const TransitionTable *table)
+    {
+        table_ = table;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Adapt green limits to the measured demand.
+    ///
+    ///  Each run() feeds the sensors to the estimator and
+    ///  applies the limits it adapts from the live
+    ///  TimingConfig, or the defaults without one, before the
+    ///  cycle is checked. The estimator's history is not part
+    ///  of a snapshot.
+    ///
+    ///  @param estimator The estimator to feed, nullptr for
+    ///  fixed limits
+    ////////////////////////////////////////////////////////////
+    void attachEstimator(DemandEstimator *estimator);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Hand the intersection to an emergency vehicle.
+    ///
+    ///     Lanes showing GREEN turn YELLOW at once and every
+    ///     other lane RED. PREEMPTION_YELLOW_TIME later all
+    ///     lanes are RED, and PREEMPTION_RED_TIME after that
+    ///     the pattern turns GREEN on the next run(), which is
+    ///     never sooner than two run()s after this call. A
+    ///     pattern already GREEN is simply held.
+    ///
+    ///     The pattern is held, whatever the sensors, until
+    ///     releasePreemption(). Preempting again switches the
+    ///     target, continuing any clearance under way. Sensors
+    ///     and wait times are still processed throughout.
+    ///
+    ///  @param pattern Pattern the emergency vehicle needs
+    ////////////////////////////////////////////////////////////
+    void preempt(TrafficLightPattern pattern);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Return to the normal cycle after preempt().
+    ///
+    ///  The preempting pattern counts as starting when it
+    ///  turned GREEN, so it still ends on its min and max
+    ///  active times. A release during the clearance takes
+    ///  effect once the pattern is GREEN.
+    ///
+    ////////////////////////////////////////////////////////////
+    void releasePreemption();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Check whether a preemption holds the signals
+    ///
+    ///  @return true Between preempt() and the release taking
+    ///  effect
+    ////////////////////////////////////////////////////////////
+    inline bool isPreempted() const
+    {
+        return preemptPattern_ != TrafficLightPattern::NUM_PATTERNS;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Check whether a preemption is still clearing
+    ///  the intersection for its pattern
+    ///
+    ///  @return true While the preempting pattern is not yet
+    ///  GREEN
+    ////////////////////////////////////////////////////////////
+    inline bool isClearingForPreemption() const
+    {
+        return isPreempted() && !lightStates_[preemptPattern_].isOn;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Copy out the controller's state.
+    ///
+    ///  @return ControllerSnapshot The state at the clock's
+    ///  current time
+    ////////////////////////////////////////////////////////////
+    ControllerSnapshot snapshot() const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Continue from a snapshot.
+    ///
+    ///  The sensors are not restored; they belong to whoever
+    ///  feeds the controller. The log, config and policy stay
+    ///  as attached. A preemption under way carries on, so a
+    ///  snapshot taken mid-clearance still ends with the
+    ///  preempting pattern GREEN.
+    ///
+    ///  @param state The snapshot to continue from
+    ////////////////////////////////////////////////////////////
+    void restore(const ControllerSnapshot &state);
+
     ////////////////////////////////////////////////////////////
     ///  @brief Get the TrafficSignals object
     ///  
@@ -91,6 +264,29 @@ public:
         return signals_;
     }
 
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the pattern currently GREEN
+    ///  
+    ///  @return TrafficLightPattern The active pattern
+    ////////////////////////////////////////////////////////////
+    inline TrafficLightPattern getActivePattern() const
+    {
+        return activePattern_;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the patterns with a vehicle waiting for them
+    ///
+    ///  With skipUncalled in the timing plan, a pattern ends
+    ///  into the next of these in the cycle.
+    ///
+    ///  @return PatternMask One bit per called pattern
+    ////////////////////////////////////////////////////////////
+    inline PatternMask getCalls() const
+    {
+        return CALL_TABLE.calls[waitingLanes_];
+    }
+
 private:
     ////////////////////////////////////////////////////////////
     ///  @brief Checks the state of the controller.
@@ -103,6 +299,43 @@ private:
     ////////////////////////////////////////////////////////////
     void checkCycleState();
 
+    ////////////////////////////////////////////////////////////
+    ///  @brief Ask the attached policy whether to end the
+    ///  active pattern, within its min and max active times.
+    ///
+    ////////////////////////////////////////////////////////////
+    void selectPattern();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Turn GREEN the pattern of the vehicle that has
+    ///  waited longest, if its deadline has come.
+    ///
+    ///  @return true If a pattern was started for it
+    ////////////////////////////////////////////////////////////
+    bool serveOverdue();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Check whether the attached TransitionTable holds
+    ///  this tick's decision.
+    ///
+    ///  @return true If the table can replace the rules
+    ////////////////////////////////////////////////////////////
+    bool usesTable() const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Apply the TransitionTable entry of the current
+    ///  state, then update the vehicles' wait times.
+    ///
+    ////////////////////////////////////////////////////////////
+    void lookupTransition();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Step the preemption clearance: YELLOW to all
+    ///  RED to the preempting pattern, one step per run().
+    ///
+    ////////////////////////////////////////////////////////////
+    void stepPreemption();
+
     ////////////////////////////////////////////////////////////
     ///  @brief Process SensorStates, SignalState, VehicleStates
     ///
@@ -114,11 +347,24 @@ private:
 
     ////////////////////////////////////////////////////////////
     ///  @brief Advances to next light pattern iteration.
+    ///
+    ///  With skipUncalled, goes to the next called pattern
+    ///  instead, if any.
     ///  
-    ///  @param patternIndex Pattern to advance to
+    ///  @param patternIndex Pattern to advance from
     ////////////////////////////////////////////////////////////
     void nextPattern(int patternIndex);
 
+    ////////////////////////////////////////////////////////////
+    ///  @brief Mark a vehicle waiting or not, keeping the call
+    ///  registry and deadlines in step. A vehicle starting to
+    ///  wait arrives now.
+    ///
+    ///  @param vehicleState Reference to a VehicleState
+    ///  @param isWaiting Whether the vehicle now waits
+    ////////////////////////////////////////////////////////////
+    void setWaiting(VehicleState &vehicleState, bool isWaiting);
+
     ////////////////////////////////////////////////////////////
     ///  @brief Process a vehicle queued at a red light.
     ///  
@@ -135,39 +381,14 @@ private:
 
     ////////////////////////////////////////////////////////////
     ///  @brief Go to the next pattern in the cycle.
+    ///
+    ///  Disables the active pattern and applies the pattern's
+    ///  PATTERN_TRANSITIONS entry to the signals.
     ///  
     ///  @param lightState Reference to a TrafficLightState
     ////////////////////////////////////////////////////////////
     void updateCycle(TrafficLightState &lightState);
 
-    ////////////////////////////////////////////////////////////
-    ///  @brief Enables North & South Turning Pattern.
-    ///
-    ///  @param lightState Reference to a TrafficLightState  
-    ////////////////////////////////////////////////////////////
-    void enableNorthSouthTurning(TrafficLightState &lightState);
-
-    ////////////////////////////////////////////////////////////
-    ///  @brief Enables North & South Through Pattern.
-    ///
-    ///  @param lightState Reference to a TrafficLightState 
-    ////////////////////////////////////////////////////////////
-    void enableNorthSouthThrough(TrafficLightState &lightState);
-
-    ////////////////////////////////////////////////////////////
-    ///  @brief Enables East & West Turning Pattern.
-    ///
-    ///  @param lightState Reference to a TrafficLightState  
-    ////////////////////////////////////////////////////////////
-    void enableEastWestTurning(TrafficLightState &lightState);
-
-    ////////////////////////////////////////////////////////////
-    ///  @brief Enables East & West Through Pattern.
-    ///
-    ///  @param lightState Reference to a TrafficLightState  
-    ////////////////////////////////////////////////////////////
-    void enableEastWestThrough(TrafficLightState &lightState);
-
     ////////////////////////////////////////////////////////////
     ///  @brief Turns on the light and sets startTime to
     ///  current clock time.
@@ -213,29 +434,28 @@ private:
     ////////////////////////////////////////////////////////////
     void checkIfCarsAreWaiting();
 
-    ////////////////////////////////////////////////////////////
-    ///  @brief Update TrafficSignals lane and state.
-    ///  
-    ///  @param lane The lane to set
-    ///  @param state The state to set
-    ////////////////////////////////////////////////////////////
-    void setLaneSignal(Lane lane, SignalState state);
-
     ////////////////////////////////////////////////////////////
     ///  @brief Converts a TrafficLightPattern to a string.
     ///  
     ///  @param pattern The TrafficLightPattern to convert
-    ///  @return std::string The string version of the TrafficLightPattern
+    ///  @return const char* The string version of the TrafficLightPattern
     ////////////////////////////////////////////////////////////
-    std::string lightPatternToString(TrafficLightPattern pattern);
+    const char* lightPatternToString(TrafficLightPattern pattern);
 
     ////////////////////////////////////////////////////////////
     ///  @brief Converts a Lane to a string.
     ///  
     ///  @param lane The Lane to convert
-    ///  @return std::string The string version of the Lane
+    ///  @return const char* The string version of the Lane
+    ////////////////////////////////////////////////////////////
+    const char* laneToString(Lane lane);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Copy a timing plan into the TrafficLightStates.
+    ///
+    ///  @param timing The timing plan to apply
     ////////////////////////////////////////////////////////////
-    std::string laneToString(Lane lane);
+    void applyTiming(const TimingConfig &timing);
 
     ////////////////////////////////////////////////////////////
     ///  @brief Initialize the default TrafficLightStates.
@@ -249,29 +469,34 @@ private:
     ////////////////////////////////////////////////////////////
     void populateVehicleStates();
 
-    ////////////////////////////////////////////////////////////
-    ///  @brief Initialize a Lane to opposing lanes mapping.
-    ///  
-    ////////////////////////////////////////////////////////////
-    void makeOpposingLanesMap();
-
-    ////////////////////////////////////////////////////////////
-    ///  @brief Initialize a TrafficLightPattern to Lane mapping.
-    ///  
-    ////////////////////////////////////////////////////////////
-    void makePatternToLaneMap();
-
     // Members
     const Clock &clock_; ///< Clock reference from Simulator
     const VehicleSensors &sensors_; ///< Reference to signal for each lane
+    std::ostream *log_; ///< Status message stream, nullptr when silent
     TrafficSignals signals_; ///< Signals for each lane
     bool appState_; ///< Is this app in a good state or not
     bool carsAwaiting_; ///< Are there cars waiting at red lights
+    LaneMask waitingLanes_; ///< Lanes whose vehicle isWaiting, the call registry
+    bool skipUncalled_; ///< Skip patterns with no call when advancing
+    bool enforceMaxWait_; ///< Serve vehicles before they wait past maxWaitTime_
+    DeadlineHeap<IClock::Time, Lane::COUNT> deadlines_; ///< Waiting lanes by arrival time, the longest waiting on top
+    TrafficLightPattern activePattern_; ///< Pattern currently GREEN
     IClock::Time maxWaitTime_; ///< Config driven value for maxWaitTime at red light
+    ConfigManager *config_; ///< Source of live timing, nullptr for defaults
+    ConfigManager::ReaderId configReader_; ///< Reader id used with config_
+    IDecisionPolicy *policy_; ///< Chooses when patterns end, nullptr for the rules
+    const TransitionTable *table_; ///< Precomputed rules, nullptr to run them
+    DemandEstimator *estimator_; ///< Adapts green limits, nullptr for fixed ones
+    TimingConfig defaultTiming_; ///< Limits the estimator adapts without a ConfigManager
+    TrafficLightPattern preemptPattern_; ///< Pattern held for an emergency vehicle, NUM_PATTERNS when none
+    bool preemptYellow_; ///< Lanes are showing the preemption YELLOW
+    bool preemptReleased_; ///< Release once the preempting pattern is GREEN
+    IClock::Time preemptRedAt_; ///< Clock time the YELLOW lanes turn RED
+    IClock::Time preemptGreenAt_; ///< Clock time the preempting pattern may turn GREEN
+    IClock::Time lastRunTime_; ///< Clock time of the last run()
+    IClock::Time tickLength_; ///< Clock time between the last two run() calls, 1 until the clock moves
     std::array<TrafficLightState, TrafficLightPattern::NUM_PATTERNS> lightStates_; ///< States of traffic light for each pattern
     std::array<VehicleState, Lane::COUNT> vehicleStates_; ///< States of vehicle for each lane
-    std::map<Lane, std::array<Lane, Lane::COUNT>> laneToOpposingLaneMap_; ///< Map of Lanes to it's opposing lanes
-    std::map<TrafficLightPattern, std::array<Lane, Lane::COUNT>> patternToLaneMap_; ///< Map of patterns to it's lanes
 };
 
 #endif // INCLUDE_TRAFFICLIGHTCONTROLLERAPP_H_
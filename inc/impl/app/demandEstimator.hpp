@@ -0,0 +1,192 @@
+#ifndef INCLUDE_DEMANDESTIMATOR_H_
+#define INCLUDE_DEMANDESTIMATOR_H_
+
+#include "interfaces/clock/IClock.hpp"
+
+#include "impl/app/patternTable.hpp"
+#include "impl/config/timingConfig.hpp"
+
+#include <array>
+#include <cstdint>
+
+////////////////////////////////////////////////////////////
+///  @brief Estimates a DemandEstimator may use when it
+///  adapts green limits, as bits of DemandConfig::features.
+///
+////////////////////////////////////////////////////////////
+enum DemandFeature : unsigned
+{
+    ARRIVAL_RATE = 1u << 0, ///< EWMA of detector rising edges
+    OCCUPANCY    = 1u << 1, ///< share of recent GREEN ticks with the detector SET
+    PROFILE      = 1u << 2, ///< arrival rate learned for the time of day
+    ALL_FEATURES = ARRIVAL_RATE | OCCUPANCY | PROFILE
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Settings of a DemandEstimator
+///
+////////////////////////////////////////////////////////////
+struct DemandConfig
+{
+    unsigned features;          ///< DemandFeature bits used by adapt()
+    unsigned rateShift;         ///< arrival rate EWMA weighs each second 2^-rateShift
+    unsigned profileShift;      ///< profile EWMA weighs each day 2^-profileShift
+    IClock::Time profileBin;    ///< seconds per time-of-day bin
+    float saturationFlow;       ///< vehicles per second a GREEN lane discharges
+    IClock::Time lostTime;      ///< start-up time lost at each pattern change
+    IClock::Time minCycle;      ///< shortest cycle planned
+    IClock::Time maxCycle;      ///< longest cycle planned
+    IClock::Time minGreen;      ///< shortest minActiveTime given to any pattern
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Get a DemandConfig using every feature, with a
+///  half-minute rate EWMA, a 24 hour profile in half-hour
+///  bins and Webster cycles of 40 to 180 seconds.
+///
+///  @return DemandConfig The default settings
+////////////////////////////////////////////////////////////
+DemandConfig defaultDemandConfig();
+
+////////////////////////////////////////////////////////////
+///  @brief Per-lane demand estimates of one intersection,
+///  turned into green limits each tick.
+///
+///     Each update() reads the detectors once and, for every
+///     lane at the same time:
+///       - counts rising edges as arrivals into a fixed-point
+///         EWMA of vehicles per second,
+///       - shifts the detector state of GREEN ticks into a
+///         64-tick bitset whose popcount is how much of its
+///         recent green the lane kept in use,
+///       - adds the arrivals to the current time-of-day bin,
+///         folded into that bin's EWMA across days when the
+///         bin ends.
+///     The updates are shifts, masks and adds over fixed
+///     arrays: no allocation and no branch per lane.
+///
+///     adapt() turns the estimates into Webster green times:
+///     each pattern's flow ratio is that of its busiest GREEN
+///     lane, the cycle is sized from their sum, and each
+///     pattern's minActiveTime is its share of the green,
+///     kept between the bounds' minActiveTime and
+///     maxActiveTime. A lane's occupancy counts as the flow
+///     ratio it would have if it used that share of its green
+///     at saturation flow.
+///     Since the rules end a pattern at minActiveTime once
+///     cars wait elsewhere, that share is what each pattern
+///     gets when the intersection is busy.
+///
+////////////////////////////////////////////////////////////
+class DemandEstimator
+{
+public:
+    /// Time-of-day bins kept per lane
+    static constexpr unsigned PROFILE_BINS = 48;
+
+    /// Fractional bits of the fixed-point rates
+    static constexpr unsigned RATE_BITS = 16;
+
+    /// Ticks covered by the occupancy window
+    static constexpr unsigned OCCUPANCY_TICKS = 64;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new DemandEstimator object with no
+    ///  history.
+    ///
+    ///  @param config Estimator settings
+    ////////////////////////////////////////////////////////////
+    explicit DemandEstimator(const DemandConfig &config = defaultDemandConfig());
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Fold in one tick of detector readings.
+    ///
+    ///  @param now Clock time of the readings
+    ///  @param sensors One bit per SET lane
+    ///  @param green One bit per lane shown GREEN since the
+    ///  last update
+    ////////////////////////////////////////////////////////////
+    void update(IClock::Time now, LaneMask sensors, LaneMask green);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get green limits for the current demand.
+    ///
+    ///  Patterns keep the bounds' maxActiveTime and
+    ///  maxWaitTime. Until a feature in use has seen a
+    ///  vehicle, the bounds are returned as they are.
+    ///
+    ///  @param bounds Timing plan the limits stay within
+    ///  @return const TimingConfig& The adapted plan, valid
+    ///  until the next call
+    ////////////////////////////////////////////////////////////
+    const TimingConfig& adapt(const TimingConfig &bounds);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get a lane's arrival rate
+    ///
+    ///  @param lane Lane to query
+    ///  @return float EWMA of vehicles per second
+    ////////////////////////////////////////////////////////////
+    float arrivalRate(Lane lane) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get a lane's occupancy
+    ///
+    ///  @param lane Lane to query
+    ///  @return float Share of the last OCCUPANCY_TICKS GREEN
+    ///  ticks with the detector SET
+    ////////////////////////////////////////////////////////////
+    float occupancy(Lane lane) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get a lane's learned arrival rate for a time of
+    ///  day
+    ///
+    ///  @param lane Lane to query
+    ///  @param now Clock time whose bin to read
+    ///  @return float Vehicles per second, 0 for a bin never
+    ///  completed
+    ////////////////////////////////////////////////////////////
+    float profileRate(Lane lane, IClock::Time now) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the settings
+    ///
+    ///  @return const DemandConfig& The settings
+    ////////////////////////////////////////////////////////////
+    inline const DemandConfig& config() const
+    {
+        return config_;
+    }
+
+private:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the time-of-day bin of a clock time
+    ///
+    ////////////////////////////////////////////////////////////
+    unsigned binOf(IClock::Time now) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Fold the finished bin's arrivals into the
+    ///  profile and start the next.
+    ///
+    ///  @param bin Bin starting now
+    ////////////////////////////////////////////////////////////
+    void closeBin(unsigned bin);
+
+    DemandConfig config_;       ///< settings
+    IClock::Time last_;         ///< clock time of the last update
+    LaneMask previous_;         ///< detectors at the last update
+    bool started_;              ///< update() has run
+    unsigned bin_;              ///< time-of-day bin being counted
+    IClock::Time binStart_;     ///< clock time the bin started counting
+    std::uint64_t profiled_;    ///< bins with at least one day folded in
+    LaneMask seen_;             ///< lanes that have had an arrival
+    std::array<std::int64_t, Lane::COUNT> rate_;       ///< EWMA vehicles per second, RATE_BITS fraction
+    std::array<std::uint64_t, Lane::COUNT> window_;    ///< detector state of the last 64 ticks
+    std::array<std::uint32_t, Lane::COUNT> binCount_;  ///< arrivals in the current bin
+    std::array<std::array<std::uint32_t, PROFILE_BINS>, Lane::COUNT> profile_; ///< vehicles per second per bin, RATE_BITS fraction
+    TimingConfig adapted_;      ///< last plan returned by adapt()
+};
+
+#endif // INCLUDE_DEMANDESTIMATOR_H_
@@ -0,0 +1,302 @@
+#ifndef INCLUDE_PATTERNTABLE_H_
+#define INCLUDE_PATTERNTABLE_H_
+
+#include "interfaces/clock/IClock.hpp"
+
+#include "impl/simulator/simulator.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+////////////////////////////////////////////////////////////
+///  @brief The possible patterns of the traffic light
+///
+////////////////////////////////////////////////////////////
+enum TrafficLightPattern
+{
+    NorthSouthTurning, ///< State 0 for N_W & S_E turning
+    NorthSouthThrough, ///< State 1 for N_N & S_S through
+    EastWestTurning,   ///< State 2 for E_N & W_S turning
+    EastWestThrough,   ///< State 3 for E_E & W_W through
+    NUM_PATTERNS
+};
+
+/// Printable name of each pattern, indexed by TrafficLightPattern
+constexpr const char *PATTERN_NAMES[NUM_PATTERNS] =
+{
+    "NorthSouthTurning",
+    "NorthSouthThrough",
+    "EastWestTurning",
+    "EastWestThrough",
+};
+
+/// One bit per Lane, bit index equal to the Lane value
+using LaneMask = std::uint8_t;
+
+/// TrafficSignals viewed as one word, one byte per Lane
+using SignalWord = std::uint64_t;
+
+static_assert(sizeof(TrafficSignals) == sizeof(SignalWord),
+              "TrafficSignals must pack into a single SignalWord");
+static_assert(static_cast<unsigned>(SignalState::RED) == 0,
+              "Storing a transition's greenWord must turn every other lane RED");
+
+////////////////////////////////////////////////////////////
+///  @brief Get the LaneMask bit of a lane
+///
+///  @param lane The lane
+///  @return constexpr LaneMask Mask with only that lane set
+////////////////////////////////////////////////////////////
+constexpr LaneMask laneBit(unsigned lane)
+{
+    return static_cast<LaneMask>(1u << lane);
+}
+
+/// Every lane of the intersection
+constexpr LaneMask ALL_LANES = static_cast<LaneMask>((1u << Lane::COUNT) - 1);
+
+////////////////////////////////////////////////////////////
+///  @brief Lanes whose paths cross each lane, indexed by Lane.
+///
+////////////////////////////////////////////////////////////
+constexpr LaneMask OPPOSING_LANES[Lane::COUNT] =
+{
+    /* N_N */ ALL_LANES & ~(laneBit(Lane::N_N) | laneBit(Lane::S_S)),
+    /* N_W */ ALL_LANES & ~(laneBit(Lane::N_W) | laneBit(Lane::S_E)),
+    /* S_S */ ALL_LANES & ~(laneBit(Lane::N_N) | laneBit(Lane::S_S)),
+    /* S_E */ ALL_LANES & ~(laneBit(Lane::N_W) | laneBit(Lane::S_E)),
+    /* E_E */ ALL_LANES & ~(laneBit(Lane::E_E) | laneBit(Lane::W_W)),
+    /* E_N */ ALL_LANES & ~(laneBit(Lane::E_N) | laneBit(Lane::W_S)),
+    /* W_W */ ALL_LANES & ~(laneBit(Lane::E_E) | laneBit(Lane::W_W)),
+    /* W_S */ ALL_LANES & ~(laneBit(Lane::E_N) | laneBit(Lane::W_S)),
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Spread a LaneMask into a SignalWord with the
+///  matching lane bytes set to value.
+///
+///  @param mask Lanes to set
+///  @param value Byte value to give each lane
+///  @return constexpr SignalWord The spread word
+////////////////////////////////////////////////////////////
+constexpr SignalWord laneBytes(LaneMask mask, std::uint8_t value)
+{
+    SignalWord word = 0;
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        if (mask & laneBit(lane))
+        {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            word |= static_cast<SignalWord>(value) << ((Lane::COUNT - 1 - lane) * 8);
+#else
+            word |= static_cast<SignalWord>(value) << (lane * 8);
+#endif
+        }
+    }
+    return word;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Everything needed to switch the intersection into
+///  a pattern, and how long the pattern may stay active.
+///
+////////////////////////////////////////////////////////////
+struct PatternTransition
+{
+    TrafficLightPattern next;    ///< pattern that follows in the cycle
+    LaneMask greenLanes;         ///< lanes turned GREEN
+    LaneMask redLanes;           ///< lanes turned RED
+    SignalWord greenWord;        ///< greenLanes as GREEN signal bytes
+    IClock::Time minActiveTime;  ///< default minimum active time
+    IClock::Time maxActiveTime;  ///< default maximum active time
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Build a PatternTransition that turns every other
+///  lane RED.
+///
+///  @param next Pattern that follows in the cycle
+///  @param greenLanes Lanes turned GREEN
+///  @param minActiveTime Default minimum active time
+///  @param maxActiveTime Default maximum active time
+///  @return constexpr PatternTransition The transition
+////////////////////////////////////////////////////////////
+constexpr PatternTransition makeTransition(TrafficLightPattern next,
+                                           LaneMask greenLanes,
+                                           IClock::Time minActiveTime,
+                                           IClock::Time maxActiveTime)
+{
+    return PatternTransition{next,
+                             greenLanes,
+                             static_cast<LaneMask>(ALL_LANES & ~greenLanes),
+                             laneBytes(greenLanes, static_cast<std::uint8_t>(SignalState::GREEN)),
+                             minActiveTime,
+                             maxActiveTime};
+}
+
+////////////////////////////////////////////////////////////
+///  @brief The pattern cycle, indexed by TrafficLightPattern.
+///
+///  Adding a sequence or retiming a pattern is a change to
+///  this table only.
+///
+////////////////////////////////////////////////////////////
+constexpr PatternTransition PATTERN_TRANSITIONS[NUM_PATTERNS] =
+{
+    /* NorthSouthTurning */ makeTransition(NorthSouthThrough, laneBit(Lane::N_W) | laneBit(Lane::S_E), 10, 60),
+    /* NorthSouthThrough */ makeTransition(EastWestTurning,   laneBit(Lane::N_N) | laneBit(Lane::S_S), 30, 120),
+    /* EastWestTurning   */ makeTransition(EastWestThrough,   laneBit(Lane::E_N) | laneBit(Lane::W_S), 10, 30),
+    /* EastWestThrough   */ makeTransition(NorthSouthTurning, laneBit(Lane::E_E) | laneBit(Lane::W_W), 30, 60),
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Find the pattern that leads into a pattern.
+///
+///  @param pattern The pattern to look up
+///  @return constexpr TrafficLightPattern Its predecessor
+////////////////////////////////////////////////////////////
+constexpr TrafficLightPattern previousPattern(TrafficLightPattern pattern)
+{
+    for (unsigned p = 0; p < NUM_PATTERNS; p++)
+    {
+        if (PATTERN_TRANSITIONS[p].next == pattern)
+        {
+            return static_cast<TrafficLightPattern>(p);
+        }
+    }
+    return pattern;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Check a transition can never green two lanes that
+///  cross each other, and leaves no lane untouched.
+///
+///  @param transition The transition to check
+///  @return true If the transition is safe
+////////////////////////////////////////////////////////////
+constexpr bool isConflictFree(const PatternTransition &transition)
+{
+    if ((transition.greenLanes & transition.redLanes) != 0 ||
+        (transition.greenLanes | transition.redLanes) != ALL_LANES)
+    {
+        return false;
+    }
+
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        if ((transition.greenLanes & laneBit(lane)) && (OPPOSING_LANES[lane] & transition.greenLanes))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Check every pattern in the table is safe and that
+///  the opposing lanes relation is symmetric.
+///
+///  @return true If the whole table is safe
+////////////////////////////////////////////////////////////
+constexpr bool isPatternTableSafe()
+{
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        for (unsigned other = 0; other < Lane::COUNT; other++)
+        {
+            bool crosses = (OPPOSING_LANES[lane] & laneBit(other)) != 0;
+            bool crossed = (OPPOSING_LANES[other] & laneBit(lane)) != 0;
+            if (crosses != crossed)
+            {
+                return false;
+            }
+        }
+    }
+
+    for (unsigned p = 0; p < NUM_PATTERNS; p++)
+    {
+        if (!isConflictFree(PATTERN_TRANSITIONS[p]) ||
+            PATTERN_TRANSITIONS[p].next >= NUM_PATTERNS ||
+            PATTERN_TRANSITIONS[p].minActiveTime > PATTERN_TRANSITIONS[p].maxActiveTime)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(isPatternTableSafe(), "PATTERN_TRANSITIONS greens conflicting lanes");
+
+/// One bit per pattern, bit index equal to the TrafficLightPattern value
+using PatternMask = std::uint8_t;
+
+////////////////////////////////////////////////////////////
+///  @brief Which patterns are called by each set of waiting
+///  lanes, and where the cycle goes next for each set of
+///  calls, so the sequencer skips patterns nobody waits for
+///  with two lookups.
+///
+////////////////////////////////////////////////////////////
+struct CallTable
+{
+    PatternMask calls[1u << Lane::COUNT];                        ///< patterns greening a waiting lane, by LaneMask
+    TrafficLightPattern next[NUM_PATTERNS][1u << NUM_PATTERNS]; ///< next called pattern, by active pattern and calls
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Build the CallTable of PATTERN_TRANSITIONS.
+///
+///  The next pattern is the first called one following the
+///  active pattern in the cycle. With no calls it is simply
+///  the one that follows.
+///
+///  @return constexpr CallTable The table
+////////////////////////////////////////////////////////////
+constexpr CallTable makeCallTable()
+{
+    CallTable table = {};
+    for (unsigned waiting = 0; waiting < (1u << Lane::COUNT); waiting++)
+    {
+        for (unsigned p = 0; p < NUM_PATTERNS; p++)
+        {
+            if (PATTERN_TRANSITIONS[p].greenLanes & waiting)
+            {
+                table.calls[waiting] = static_cast<PatternMask>(table.calls[waiting] | (1u << p));
+            }
+        }
+    }
+
+    for (unsigned active = 0; active < NUM_PATTERNS; active++)
+    {
+        for (unsigned calls = 0; calls < (1u << NUM_PATTERNS); calls++)
+        {
+            TrafficLightPattern next = PATTERN_TRANSITIONS[active].next;
+            for (unsigned step = 0; calls != 0 && step < NUM_PATTERNS && !((calls >> next) & 1u); step++)
+            {
+                next = PATTERN_TRANSITIONS[next].next;
+            }
+            table.next[active][calls] = (calls >> next) & 1u ? next : PATTERN_TRANSITIONS[active].next;
+        }
+    }
+    return table;
+}
+
+/// Calls and call-skipping sequence of PATTERN_TRANSITIONS
+constexpr CallTable CALL_TABLE = makeCallTable();
+
+////////////////////////////////////////////////////////////
+///  @brief Apply a transition to the signals with one store
+///  of the signal word.
+///
+///  Every lane is in greenLanes or redLanes, and RED is 0,
+///  so greenWord is the whole new word.
+///
+///  @param signals The signals to update
+///  @param transition The transition to apply
+////////////////////////////////////////////////////////////
+inline void applyTransition(TrafficSignals &signals, const PatternTransition &transition)
+{
+    std::memcpy(signals.data(), &transition.greenWord, sizeof(transition.greenWord));
+}
+
+#endif // INCLUDE_PATTERNTABLE_H_
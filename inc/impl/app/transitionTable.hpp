@@ -0,0 +1,131 @@
+#ifndef INCLUDE_TRANSITIONTABLE_H_
+#define INCLUDE_TRANSITIONTABLE_H_
+
+#include "impl/app/patternTable.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Every decision of a TrafficLightControllerApp's
+///  rules, precomputed for each state it can be in.
+///
+///     Under its own rules the controller decides a tick from
+///     a few bits: the active pattern, whether that pattern
+///     has reached its minActiveTime and its maxActiveTime,
+///     the carsAwaiting and per-pattern opposing-lanes-clear
+///     flags left by the last tick, and the sensors. The
+///     signals follow from the active pattern, and vehicles'
+///     wait times are only bookkeeping.
+///
+///     The table holds one byte for each of those 2^17
+///     states: the pattern after the tick, whether the
+///     pattern was restarted, and the flags left for the next
+///     tick. It is generated by running the real controller
+///     from every state, so it is exact for any timing whose
+///     limits are all above zero; a pattern that has just
+///     started has then reached neither.
+///
+////////////////////////////////////////////////////////////
+class TransitionTable
+{
+public:
+    /// Bits of a table index
+    static constexpr unsigned INDEX_BITS = 17;
+
+    /// Number of entries
+    static constexpr std::size_t SIZE = std::size_t(1) << INDEX_BITS;
+
+    /// Entry bits: pattern after the tick
+    static constexpr std::uint8_t PATTERN_MASK = 0x03;
+
+    /// Entry bit: the pattern after the tick started this tick
+    static constexpr std::uint8_t RESTARTED = 0x04;
+
+    /// Entry bit: carsAwaiting after the tick
+    static constexpr std::uint8_t CARS_AWAITING = 0x08;
+
+    /// Entry bits: opposing-lanes-clear flag of each pattern
+    /// after the tick, pattern p at bit CLEAR_SHIFT + p
+    static constexpr unsigned CLEAR_SHIFT = 4;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the index of a controller state.
+    ///
+    ///  @param active Active pattern before the tick
+    ///  @param atMin Active pattern has reached minActiveTime
+    ///  @param atMax Active pattern has reached maxActiveTime
+    ///  @param carsAwaiting carsAwaiting before the tick
+    ///  @param clear Opposing-lanes-clear flags before the tick
+    ///  @param sensors SET sensors this tick
+    ///  @return std::uint32_t Index of the state's entry
+    ////////////////////////////////////////////////////////////
+    static inline std::uint32_t index(TrafficLightPattern active, bool atMin, bool atMax,
+                                      bool carsAwaiting, std::uint8_t clear, LaneMask sensors)
+    {
+        return static_cast<std::uint32_t>(sensors) |
+               static_cast<std::uint32_t>(clear & 0x0F) << 8 |
+               static_cast<std::uint32_t>(carsAwaiting) << 12 |
+               static_cast<std::uint32_t>(atMin) << 13 |
+               static_cast<std::uint32_t>(atMax) << 14 |
+               static_cast<std::uint32_t>(active & PATTERN_MASK) << 15;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Run the controller's rules from every state and
+    ///  record what each tick did.
+    ///
+    ///  @return TransitionTable The generated table
+    ////////////////////////////////////////////////////////////
+    static TransitionTable generate();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the table shared by every controller,
+    ///  generated on first use.
+    ///
+    ///  @return const TransitionTable& The shared table
+    ////////////////////////////////////////////////////////////
+    static const TransitionTable& instance();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the entry of a state
+    ///
+    ///  @param index Index from #index()
+    ///  @return std::uint8_t The state's entry
+    ////////////////////////////////////////////////////////////
+    inline std::uint8_t at(std::uint32_t index) const
+    {
+        return entries_[index];
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Write the table as a C++ array definition.
+    ///
+    ///  @param os Stream to write
+    ///  @param name Name of the array
+    ////////////////////////////////////////////////////////////
+    void emit(std::ostream &os, const std::string &name) const;
+
+private:
+    TransitionTable();
+
+    std::vector<std::uint8_t> entries_; ///< one entry per state
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Check a table against the controller's rules.
+///
+///     From every state, with vehicles both waiting and not,
+///     one controller ticks by its rules and one by the
+///     table. Their snapshots after the tick must match.
+///
+///  @param table Table to check
+///  @param error Description of the first mismatch
+///  @return true If every state matches
+////////////////////////////////////////////////////////////
+bool verifyTransitionTable(const TransitionTable &table, std::string &error);
+
+#endif // INCLUDE_TRANSITIONTABLE_H_
@@ -0,0 +1,169 @@
+#ifndef INCLUDE_CONFIGMANAGER_H_
+#define INCLUDE_CONFIGMANAGER_H_
+
+#include "impl/config/timingConfig.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Publishes the live TimingConfig to control threads
+///  and swaps in new versions while they run.
+///
+///     Control threads read the config with #read(), which is
+///     a single atomic load, and announce with #quiescent()
+///     once per tick that they no longer hold it. A new
+///     config is built off the control thread, published with
+///     an atomic pointer swap, and the old one is freed only
+///     after every registered reader has passed a quiescent
+///     point (an RCU grace period). Readers never lock, wait
+///     or allocate.
+///
+////////////////////////////////////////////////////////////
+class ConfigManager
+{
+public:
+    /// Identifies a control thread reading the config
+    using ReaderId = std::size_t;
+
+    /// Max control threads registered at once
+    static constexpr std::size_t MAX_READERS = 64;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new ConfigManager object
+    ///
+    ///  @param initial Config published until the first reload
+    ///  @param log Stream for reload messages, nullptr for none
+    ////////////////////////////////////////////////////////////
+    explicit ConfigManager(const TimingConfig &initial = defaultTimingConfig(),
+                           std::ostream *log = &std::cout);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Destroy the ConfigManager object
+    ///
+    ///  Stops the file watcher. No reader may still be using
+    ///  the config.
+    ////////////////////////////////////////////////////////////
+    ~ConfigManager();
+
+    ConfigManager(const ConfigManager&) = delete;
+    ConfigManager& operator=(const ConfigManager&) = delete;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Register the calling control thread as a reader.
+    ///
+    ///  Every controller run on the same thread may share the
+    ///  ReaderId.
+    ///
+    ///  @return ReaderId Id to pass to #quiescent(), or
+    ///  MAX_READERS if every slot is taken
+    ////////////////////////////////////////////////////////////
+    ReaderId registerReader();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Stop tracking a reader. It must no longer read.
+    ///
+    ///  @param reader Id from #registerReader()
+    ////////////////////////////////////////////////////////////
+    void unregisterReader(ReaderId reader);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the live config.
+    ///
+    ///  The reference stays valid until the calling reader's
+    ///  next #quiescent().
+    ///
+    ///  @return const TimingConfig& The live config
+    ////////////////////////////////////////////////////////////
+    inline const TimingConfig& read() const
+    {
+        return *current_.load(std::memory_order_acquire);
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Announce the reader holds no config reference.
+    ///
+    ///  @param reader Id from #registerReader()
+    ////////////////////////////////////////////////////////////
+    inline void quiescent(ReaderId reader)
+    {
+        ReaderSlot &slot = readers_[reader];
+        slot.epoch.store(slot.epoch.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Publish a new config.
+    ///
+    ///  @param config The config to publish
+    ////////////////////////////////////////////////////////////
+    void publish(const TimingConfig &config);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Load a config file over the defaults and
+    ///  publish it.
+    ///
+    ///  @param path File to load
+    ///  @return true If the file loaded and was published
+    ////////////////////////////////////////////////////////////
+    bool loadFile(const std::string &path);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Reload a config file whenever it changes.
+    ///
+    ///  A background thread polls the file's modification time
+    ///  and publishes each new version that parses.
+    ///
+    ///  @param path File to watch
+    ///  @param interval Time between polls
+    ////////////////////////////////////////////////////////////
+    void watchFile(const std::string &path,
+                   std::chrono::milliseconds interval = std::chrono::milliseconds(500));
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Stop the file watcher, if running.
+    ///
+    ////////////////////////////////////////////////////////////
+    void stopWatching();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Free retired configs whose grace period is over.
+    ///
+    ///  @return std::size_t Retired configs still waiting
+    ////////////////////////////////////////////////////////////
+    std::size_t reclaim();
+
+private:
+    /// A reader's quiescent counter, on its own cache line.
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<bool> active;
+        std::atomic<std::uint64_t> epoch;
+    };
+
+    /// A replaced config and the reader epochs at replacement.
+    struct RetiredConfig
+    {
+        const TimingConfig *config;
+        std::vector<std::uint64_t> epochs;
+    };
+
+    std::atomic<const TimingConfig*> current_;  ///< live config
+    ReaderSlot readers_[MAX_READERS];           ///< registered readers
+    std::mutex writerMutex_;                    ///< guards writers and retired_
+    std::vector<RetiredConfig> retired_;        ///< configs awaiting reclaim
+    std::ostream *log_;                         ///< reload messages, nullptr when silent
+
+    std::thread watcher_;                       ///< file polling thread
+    std::mutex watcherMutex_;                   ///< guards stopWatcher_
+    std::condition_variable watcherWake_;       ///< wakes the watcher to stop
+    bool stopWatcher_;                          ///< watcher should exit
+};
+
+#endif // INCLUDE_CONFIGMANAGER_H_
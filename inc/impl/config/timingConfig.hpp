@@ -0,0 +1,71 @@
+#ifndef INCLUDE_TIMINGCONFIG_H_
+#define INCLUDE_TIMINGCONFIG_H_
+
+#include "interfaces/clock/IClock.hpp"
+
+#include "impl/app/patternTable.hpp"
+
+#include <array>
+#include <istream>
+#include <string>
+
+/// Max wait time for a vehicle at a red light when no config is loaded
+static constexpr IClock::Time DEFAULT_MAX_WAIT_TIME = 40;
+
+////////////////////////////////////////////////////////////
+///  @brief Active time limits of one pattern
+///
+////////////////////////////////////////////////////////////
+struct PatternTiming
+{
+    IClock::Time minActiveTime; ///< pattern stays GREEN at least this long
+    IClock::Time maxActiveTime; ///< pattern advances after this long
+};
+
+////////////////////////////////////////////////////////////
+///  @brief A timing plan for the controller.
+///
+////////////////////////////////////////////////////////////
+struct TimingConfig
+{
+    std::array<PatternTiming, NUM_PATTERNS> patterns; ///< limits per pattern
+    IClock::Time maxWaitTime;                         ///< max wait at a red light
+    bool skipUncalled;                                ///< end patterns into the next one a vehicle waits for
+    bool enforceMaxWait;                              ///< serve a vehicle before it waits past maxWaitTime
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Get the timing plan built into PATTERN_TRANSITIONS
+///
+///  @return TimingConfig The default timing plan
+////////////////////////////////////////////////////////////
+TimingConfig defaultTimingConfig();
+
+////////////////////////////////////////////////////////////
+///  @brief Parse a timing plan.
+///
+///  The format is one "key = value" per line, with '#'
+///  starting a comment. Keys are "maxWaitTime" and
+///  "<Pattern>.minActiveTime" / "<Pattern>.maxActiveTime"
+///  where <Pattern> is a name from PATTERN_NAMES, and
+///  "skipUncalled" and "enforceMaxWait" set to 0 or 1. Keys
+///  that are left out keep their value from config.
+///
+///  @param in Stream to parse
+///  @param config Timing plan to update, untouched on failure
+///  @param error Description of the first problem found
+///  @return true If the whole stream parsed and validated
+////////////////////////////////////////////////////////////
+bool parseTimingConfig(std::istream &in, TimingConfig &config, std::string &error);
+
+////////////////////////////////////////////////////////////
+///  @brief Parse a timing plan from a file.
+///
+///  @param path File to parse
+///  @param config Timing plan to update, untouched on failure
+///  @param error Description of the first problem found
+///  @return true If the file parsed and validated
+////////////////////////////////////////////////////////////
+bool loadTimingConfig(const std::string &path, TimingConfig &config, std::string &error);
+
+#endif // INCLUDE_TIMINGCONFIG_H_
@@ -0,0 +1,163 @@
+#ifndef INCLUDE_BATCHENV_H_
+#define INCLUDE_BATCHENV_H_
+
+#include "interfaces/app/IDecisionPolicy.hpp"
+
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/env/tlcEnv.h"
+#include "impl/simulator/simulator.hpp"
+#include "impl/util/workerPool.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Settings of a BatchEnv
+///
+////////////////////////////////////////////////////////////
+struct BatchEnvConfig
+{
+    std::uint32_t numEnvs;     ///< environments in the batch
+    unsigned numThreads;       ///< threads stepping the batch, the caller's included; 0 for one per core
+    Clock::Time stepSeconds;   ///< controller ticks per step
+    Clock::Time maxWaitTime;   ///< max wait time given to each controller
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Get a BatchEnvConfig with one thread per core and
+///  one tick per step.
+///
+///  @param numEnvs Environments in the batch
+///  @return BatchEnvConfig The default settings
+////////////////////////////////////////////////////////////
+BatchEnvConfig defaultBatchEnvConfig(std::uint32_t numEnvs);
+
+////////////////////////////////////////////////////////////
+///  @brief Many independent intersections stepped together
+///  under the caller's decisions, for policy training.
+///
+///     Each environment replays makeDayScenario(seed) through
+///     a Simulator into a TrafficLightControllerApp whose
+///     policy returns the caller's last action. A step runs
+///     stepSeconds ticks of every environment, split into
+///     contiguous runs of environments across a WorkerPool,
+///     and writes observations, rewards and done flags into
+///     the caller's buffers at each environment's index.
+///
+///     Environments never share state, so the results do not
+///     depend on the number of threads. A step allocates
+///     nothing; a reset builds the new scenarios.
+///
+////////////////////////////////////////////////////////////
+class BatchEnv
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new BatchEnv object, every
+    ///  environment reset with seed 0.
+    ///
+    ///  @param config Batch settings
+    ////////////////////////////////////////////////////////////
+    explicit BatchEnv(const BatchEnvConfig &config);
+
+    BatchEnv(const BatchEnv&) = delete;
+    BatchEnv& operator=(const BatchEnv&) = delete;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the number of environments
+    ///
+    ///  @return std::uint32_t Environments in the batch
+    ////////////////////////////////////////////////////////////
+    inline std::uint32_t size() const
+    {
+        return static_cast<std::uint32_t>(envs_.size());
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Start a new episode in one environment.
+    ///
+    ///  @param env Environment to reset
+    ///  @param seed Seed of its scenario
+    ///  @param observation Set to its first observation
+    ////////////////////////////////////////////////////////////
+    void reset(std::uint32_t env, std::uint32_t seed, tlc_observation &observation);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Step every environment.
+    ///
+    ///  @param actions One TLC_ACTION_* per environment, each
+    ///  checked by the caller
+    ///  @param observations Set to each observation
+    ///  @param rewards Set to each step's reward
+    ///  @param dones Set to 1 where the episode has ended
+    ////////////////////////////////////////////////////////////
+    void step(const std::int32_t *actions, tlc_observation *observations, float *rewards, std::uint8_t *dones);
+
+private:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Returns whatever decision the batch last set
+    ///
+    ////////////////////////////////////////////////////////////
+    class ActionPolicy : public IDecisionPolicy
+    {
+    public:
+        Decision decide(const ControllerSnapshot &) override
+        {
+            return decision;
+        }
+
+        Decision decision = Decision::FOLLOW_RULES; ///< decision of the current step
+    };
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief One intersection
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Env
+    {
+        std::unique_ptr<Simulator> simulator;         ///< traffic of the episode
+        std::unique_ptr<TrafficLightControllerApp> app; ///< controller fed by the simulator
+        ActionPolicy policy;                          ///< the caller's action
+        bool done;                                    ///< episode over
+    };
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Buffers of the step in progress
+    ///
+    ////////////////////////////////////////////////////////////
+    struct StepJob
+    {
+        BatchEnv *batch;
+        const std::int32_t *actions;
+        tlc_observation *observations;
+        float *rewards;
+        std::uint8_t *dones;
+    };
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Step one run of environments
+    ///
+    ////////////////////////////////////////////////////////////
+    static void stepRun(void *context, std::size_t run);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Step one environment
+    ///
+    ///  @return float The step's reward
+    ////////////////////////////////////////////////////////////
+    float stepEnv(Env &env, std::int32_t action);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Write what an environment shows
+    ///
+    ////////////////////////////////////////////////////////////
+    static void observe(const Env &env, tlc_observation &observation);
+
+    BatchEnvConfig config_;  ///< settings
+    std::vector<Env> envs_;  ///< every environment
+    std::size_t runLength_;  ///< environments per job index
+    WorkerPool pool_;        ///< threads besides the caller
+};
+
+#endif // INCLUDE_BATCHENV_H_
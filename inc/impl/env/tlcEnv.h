@@ -0,0 +1,105 @@
+#ifndef INCLUDE_TLCENV_H_
+#define INCLUDE_TLCENV_H_
+
+/*
+ * Plain C interface to a batch of traffic light environments,
+ * for training decision policies from any language that can
+ * call C (ctypes, cffi, JNI, ...). Built as the shared library
+ * libTrafficLightEnv.
+ *
+ * Each environment is one intersection: a scenario Simulator
+ * replaying a day of traffic (makeDayScenario(seed)) and a
+ * TrafficLightControllerApp whose pattern ends are chosen by
+ * the caller's actions. The controller still enforces every
+ * pattern's min and max active time, except that a HOLD past
+ * max rests the pattern in GREEN while no car waits at a RED;
+ * it ends on the first step one does.
+ *
+ * Every buffer is owned by the caller and holds one entry per
+ * environment, in environment order. Only create and reset
+ * allocate; step never does.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Actions, one per environment and step */
+#define TLC_ACTION_HOLD    0 /* keep the active pattern GREEN */
+#define TLC_ACTION_ADVANCE 1 /* go to the next pattern in the cycle */
+#define TLC_ACTION_RULES   2 /* let the controller's own rules decide */
+
+/* Return codes */
+#define TLC_OK              0
+#define TLC_ERROR_ARGUMENT -1 /* a null pointer or an action out of range */
+#define TLC_ERROR_MEMORY   -2 /* a reset could not allocate its scenario */
+
+/* Lanes per intersection, in the order of the Lane enum */
+#define TLC_NUM_LANES 8
+
+/* What one environment shows after a reset or step */
+typedef struct tlc_observation
+{
+    uint8_t sensors;            /* bit i set when lane i's sensor is SET */
+    uint8_t green;              /* bit i set when lane i shows GREEN */
+    uint8_t pattern;            /* active TrafficLightPattern, 0 to 3 */
+    uint8_t reserved;           /* always 0 */
+    float elapsedGreen;         /* seconds the active pattern has been on */
+    float waits[TLC_NUM_LANES]; /* seconds each lane's car has waited at RED, 0 when none */
+} tlc_observation;
+
+/* A batch of environments */
+typedef struct tlc_batch tlc_batch;
+
+/*
+ * Create a batch. Every environment starts with seed 0 until
+ * the first reset.
+ *
+ * num_envs:     environments in the batch, at least 1
+ * num_threads:  threads stepping the batch, the caller's
+ *               included; 0 for one per core
+ * step_seconds: controller ticks per step, at least 1
+ *
+ * Returns the batch, or NULL on bad arguments.
+ */
+tlc_batch *tlc_batch_create(uint32_t num_envs, uint32_t num_threads, int32_t step_seconds);
+
+/* Destroy a batch; NULL is ignored. */
+void tlc_batch_destroy(tlc_batch *batch);
+
+/* Get the number of environments in a batch. */
+uint32_t tlc_batch_size(const tlc_batch *batch);
+
+/*
+ * Start a new episode in every environment.
+ *
+ * seeds:        one scenario seed per environment
+ * observations: set to each environment's first observation
+ */
+int tlc_batch_reset(tlc_batch *batch, const uint32_t *seeds, tlc_observation *observations);
+
+/*
+ * Start a new episode in one environment.
+ */
+int tlc_batch_reset_one(tlc_batch *batch, uint32_t env, uint32_t seed, tlc_observation *observation);
+
+/*
+ * Step every environment by step_seconds.
+ *
+ * actions:      one TLC_ACTION_* per environment
+ * observations: set to each environment's observation
+ * rewards:      set to minus the lane-seconds a car waited at a
+ *               signal that was not GREEN during the step
+ * dones:        set to 1 where the episode has ended; such an
+ *               environment stands still until it is reset
+ */
+int tlc_batch_step(tlc_batch *batch, const int32_t *actions, tlc_observation *observations,
+                   float *rewards, uint8_t *dones);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_TLCENV_H_ */
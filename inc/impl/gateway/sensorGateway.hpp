@@ -0,0 +1,243 @@
+#ifndef INCLUDE_SENSORGATEWAY_H_
+#define INCLUDE_SENSORGATEWAY_H_
+
+#include "impl/host/controllerHost.hpp"
+#include "impl/util/latencyHistogram.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief One intersection's sensors as sent by its field
+///  cabinet: 16 bytes in host byte order, since a Unix
+///  socket never leaves the machine.
+///
+///     offset 0  u8   version, SENSOR_FRAME_VERSION
+///     offset 1  u8   sensors, one bit per SET lane
+///     offset 2  u16  sequence, +1 per frame of the intersection
+///     offset 4  u32  intersection, the field's id
+///     offset 8  u64  sent, CLOCK_MONOTONIC ns, 0 if unknown
+///
+///  A datagram carries one or more frames back to back.
+///
+////////////////////////////////////////////////////////////
+struct SensorFrame
+{
+    SensorMask sensors;         ///< one bit per SET lane
+    std::uint16_t sequence;     ///< +1 per frame of the intersection
+    std::uint32_t intersection; ///< the field's id of the intersection
+    std::uint64_t sent;         ///< CLOCK_MONOTONIC ns when sent, 0 if unknown
+};
+
+/// Bytes of an encoded SensorFrame
+static constexpr std::size_t SENSOR_FRAME_SIZE = 16;
+
+/// Version byte of the current frame layout
+static constexpr std::uint8_t SENSOR_FRAME_VERSION = 1;
+
+////////////////////////////////////////////////////////////
+///  @brief Encode a frame.
+///
+///  @param frame Frame to encode
+///  @param out SENSOR_FRAME_SIZE bytes to write
+////////////////////////////////////////////////////////////
+void encodeSensorFrame(const SensorFrame &frame, std::uint8_t *out);
+
+////////////////////////////////////////////////////////////
+///  @brief Decode a frame.
+///
+///  @param in SENSOR_FRAME_SIZE bytes to read
+///  @param frame Set to the decoded frame
+///  @return true If the version is understood
+////////////////////////////////////////////////////////////
+bool decodeSensorFrame(const std::uint8_t *in, SensorFrame &frame);
+
+////////////////////////////////////////////////////////////
+///  @brief Get CLOCK_MONOTONIC in nanoseconds, the clock of
+///  SensorFrame::sent.
+///
+///  @return std::uint64_t Nanoseconds
+////////////////////////////////////////////////////////////
+std::uint64_t monotonicNanos();
+
+////////////////////////////////////////////////////////////
+///  @brief Settings of a SensorGateway.
+///
+////////////////////////////////////////////////////////////
+struct GatewayConfig
+{
+    std::vector<std::string> socketPaths; ///< Unix datagram sockets to bind, one per field link
+    std::uint32_t maxIntersections;       ///< field ids run from 0 to this, exclusive
+    unsigned batch;                       ///< datagrams per recvmmsg
+    unsigned maxDatagram;                 ///< largest datagram accepted, bytes
+    unsigned drainLimit;                  ///< recvmmsg calls per socket before serving the next
+    int receiveBuffer;                    ///< SO_RCVBUF of each socket, bytes, 0 for the default
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Get GatewayConfig defaults: no sockets, 65536
+///  intersections, 64 datagrams of up to 4 KiB per call,
+///  16 calls per socket in turn, 4 MiB receive buffers.
+///
+///  @return GatewayConfig The default settings
+////////////////////////////////////////////////////////////
+GatewayConfig defaultGatewayConfig();
+
+////////////////////////////////////////////////////////////
+///  @brief Counters of a SensorGateway.
+///
+////////////////////////////////////////////////////////////
+struct GatewayStats
+{
+    std::uint64_t wakeups;   ///< epoll_wait calls that returned events
+    std::uint64_t calls;     ///< recvmmsg calls that returned datagrams
+    std::uint64_t datagrams; ///< datagrams received
+    std::uint64_t frames;    ///< frames written to a controller
+    std::uint64_t malformed; ///< datagrams cut short or frames of an unknown version
+    std::uint64_t unrouted;  ///< frames for an intersection with no controller
+    std::uint64_t stale;     ///< frames repeating or older than the last one applied
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Feeds a ControllerHost from field cabinets over
+///  Unix datagram sockets.
+///
+///     Every socket is registered edge-triggered with one
+///     epoll instance. When one becomes readable it is
+///     drained with recvmmsg, a batch of datagrams per call,
+///     into buffers allocated up front; each frame is decoded
+///     in place and written to its controller's sensor slot
+///     with ControllerHost::setSensorMask(). The controller
+///     reads it on its shard's next tick.
+///
+///     A socket still holding datagrams after drainLimit
+///     calls goes to the back of a ready list, so one busy
+///     link cannot starve the others; poll() serves that list
+///     before waiting again.
+///
+///     Per intersection, the gateway keeps the controller it
+///     routes to and the last sequence applied. Frames at or
+///     up to 256 behind that sequence are dropped as stale;
+///     anything further back is taken as a restarted cabinet.
+///
+///     Not thread-safe: poll() and the getters belong to one
+///     thread.
+///
+////////////////////////////////////////////////////////////
+class SensorGateway
+{
+public:
+    /// Sequences this far behind the last one are stale
+    static constexpr std::uint16_t STALE_WINDOW = 256;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new SensorGateway object
+    ///
+    ///  Allocates the routes and receive buffers. No socket is
+    ///  opened until #open().
+    ///
+    ///  @param host Host whose controllers are fed
+    ///  @param config Gateway settings
+    ////////////////////////////////////////////////////////////
+    SensorGateway(ControllerHost &host, const GatewayConfig &config);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Destroy the SensorGateway object, closing and
+    ///  unlinking its sockets.
+    ///
+    ////////////////////////////////////////////////////////////
+    ~SensorGateway();
+
+    SensorGateway(const SensorGateway&) = delete;
+    SensorGateway& operator=(const SensorGateway&) = delete;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Bind every socket and register it with epoll.
+    ///
+    ///  An existing file at a socket path is replaced.
+    ///
+    ///  @param error Description of the first failure
+    ///  @return true If every socket is listening
+    ////////////////////////////////////////////////////////////
+    bool open(std::string &error);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Send an intersection's frames to a controller.
+    ///
+    ///  @param intersection Field id of the intersection
+    ///  @param controller Controller to feed, or
+    ///  INVALID_CONTROLLER to drop its frames
+    ///  @return true If the field id is below maxIntersections
+    ////////////////////////////////////////////////////////////
+    bool route(std::uint32_t intersection, ControllerId controller);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Wait for datagrams and apply every frame.
+    ///
+    ///  @param timeoutMs Longest wait, -1 for no limit; sockets
+    ///  on the ready list are served without waiting
+    ///  @return std::size_t Frames written to controllers
+    ////////////////////////////////////////////////////////////
+    std::size_t poll(int timeoutMs);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the counters
+    ///
+    ///  @return const GatewayStats& The counters
+    ////////////////////////////////////////////////////////////
+    inline const GatewayStats& stats() const
+    {
+        return stats_;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the time from each stamped frame being sent
+    ///  to its sensors reaching the controller's slot
+    ///
+    ///  @return const LatencyHistogram& Frame latencies (ns)
+    ////////////////////////////////////////////////////////////
+    inline const LatencyHistogram& latency() const
+    {
+        return latency_;
+    }
+
+private:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Read a socket until it is empty or the drain
+    ///  limit is reached.
+    ///
+    ///  @param socket Index of the socket in sockets_
+    ///  @return true If the socket is empty
+    ////////////////////////////////////////////////////////////
+    bool drain(std::size_t socket);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Apply every frame of one datagram.
+    ///
+    ///  @param data Datagram bytes
+    ///  @param size Bytes received
+    ///  @param now Receive time, CLOCK_MONOTONIC ns
+    ////////////////////////////////////////////////////////////
+    void apply(const std::uint8_t *data, std::size_t size, std::uint64_t now);
+
+    ControllerHost &host_;                    ///< host being fed
+    GatewayConfig config_;                    ///< settings
+    GatewayStats stats_;                      ///< counters
+    LatencyHistogram latency_;                ///< send-to-slot latencies (ns)
+
+    std::vector<ControllerId> routes_;        ///< controller of each field id
+    std::vector<std::uint16_t> sequences_;    ///< last sequence applied per field id
+    std::vector<bool> seen_;                  ///< a frame was applied per field id
+
+    int epoll_;                               ///< epoll instance, -1 when closed
+    std::vector<int> sockets_;                ///< bound sockets, -1 when closed
+    std::vector<std::size_t> ready_;          ///< sockets left with datagrams, in turn order
+    std::vector<bool> queued_;                ///< socket is on ready_
+
+    std::vector<std::uint8_t> buffers_;       ///< batch datagram buffers
+    std::vector<std::uint8_t> headers_;       ///< batch mmsghdr and iovec storage
+};
+
+#endif // INCLUDE_SENSORGATEWAY_H_
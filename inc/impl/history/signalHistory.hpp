@@ -0,0 +1,208 @@
+#ifndef INCLUDE_SIGNALHISTORY_H_
+#define INCLUDE_SIGNALHISTORY_H_
+
+#include "impl/app/patternTable.hpp"
+#include "impl/simulator/simulator.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Signals an intersection showed from a time on
+///
+////////////////////////////////////////////////////////////
+struct SignalChange
+{
+    Clock::Time time;       ///< first second the signals were shown
+    TrafficSignals signals; ///< signals of every lane
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Memory held by a SignalHistory
+///
+////////////////////////////////////////////////////////////
+struct SignalHistoryStats
+{
+    std::uint64_t changes;    ///< signal changes recorded
+    std::uint64_t blocks;     ///< encoded blocks
+    std::uint64_t codeBytes;  ///< bytes of encoded changes
+    std::uint64_t indexBytes; ///< bytes of the block index
+    std::uint64_t heapBytes;  ///< bytes allocated, spare capacity included
+    std::uint64_t states;     ///< distinct TrafficSignals seen
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Compressed, indexed history of the signals of
+///  many intersections.
+///
+///     Only changes are kept, so a signal held for a minute
+///     costs what one held for a second does. Each distinct
+///     TrafficSignals gets a number in a dictionary shared by
+///     every intersection; a controller shows a dozen or so.
+///
+///     An intersection's changes are cut into blocks of at
+///     most BLOCK_CHANGES. The sparse index keeps each
+///     block's first time, first state and byte offset; the
+///     block's other changes are a varint of the seconds since
+///     the previous change, with a flag for whether the new
+///     state is the one that followed the previous state the
+///     last time it was left in this block. Only when it is
+///     not does the state's number follow. Since the cycle
+///     mostly repeats, a change usually costs one byte.
+///
+///     A query finds its block by binary search of the index
+///     and decodes at most one block per point, so it costs
+///     O(log blocks + BLOCK_CHANGES) whatever the span kept.
+///
+///     Readings of an intersection come in time order. One
+///     thread records; queries may run on any thread while
+///     nothing records.
+///
+////////////////////////////////////////////////////////////
+class SignalHistory
+{
+public:
+    /// Most changes per encoded block
+    static constexpr unsigned BLOCK_CHANGES = 128;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct an empty SignalHistory
+    ///
+    ///  @param numIntersections Intersections recorded
+    ////////////////////////////////////////////////////////////
+    explicit SignalHistory(std::uint32_t numIntersections);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Record the signals an intersection shows.
+    ///
+    ///  Signals equal to the last recorded cost nothing.
+    ///
+    ///  @param intersection Intersection shown
+    ///  @param now Time of the reading
+    ///  @param signals Signals shown
+    ///  @return true If recorded, false for a change at or
+    ///  before the intersection's last change
+    ////////////////////////////////////////////////////////////
+    bool record(IntersectionId intersection, Clock::Time now, const TrafficSignals &signals);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the signals an intersection showed at a
+    ///  time.
+    ///
+    ///  @param intersection Intersection to query
+    ///  @param time Time to query
+    ///  @param signals Set to the signals shown, untouched when
+    ///  nothing was recorded by then
+    ///  @return true If the intersection had signals recorded
+    ///  at or before time
+    ////////////////////////////////////////////////////////////
+    bool at(IntersectionId intersection, Clock::Time time, TrafficSignals &signals) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the signals an intersection showed over a
+    ///  span.
+    ///
+    ///  When signals were recorded by from, the first change
+    ///  appended holds those shown at from, with its time
+    ///  clamped to from. The rest are the changes before to.
+    ///
+    ///  @param intersection Intersection to query
+    ///  @param from Start of the span, inclusive
+    ///  @param to End of the span, exclusive
+    ///  @param changes Changes to append to
+    ///  @return std::size_t Changes appended
+    ////////////////////////////////////////////////////////////
+    std::size_t range(IntersectionId intersection, Clock::Time from, Clock::Time to,
+                      std::vector<SignalChange> &changes) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the number of intersections
+    ///
+    ///  @return std::uint32_t Intersections recorded
+    ////////////////////////////////////////////////////////////
+    inline std::uint32_t numIntersections() const
+    {
+        return static_cast<std::uint32_t>(intersections_.size());
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the memory held and changes kept
+    ///
+    ///  @return SignalHistoryStats Totals over every
+    ///  intersection
+    ////////////////////////////////////////////////////////////
+    SignalHistoryStats stats() const;
+
+private:
+    /// Slots of the successor guess kept while coding a block
+    static constexpr unsigned SUCCESSOR_SLOTS = 64;
+
+    /// Guessed successor of each recently left state
+    using Successors = std::array<std::uint32_t, SUCCESSOR_SLOTS>;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Index entry of one block
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Block
+    {
+        Clock::Time start;   ///< time of the block's first change
+        std::uint32_t state; ///< state number of the first change
+        std::uint32_t offset;///< first code byte of the other changes
+    };
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief History of one intersection
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Intersection
+    {
+        std::vector<Block> blocks;       ///< sparse index, by start time
+        std::vector<std::uint8_t> code;  ///< encoded changes of every block
+        Clock::Time lastTime;            ///< time of the last change
+        std::uint32_t lastState;         ///< state number of the last change
+        std::uint32_t inBlock;           ///< changes in the last block
+        Successors successors;           ///< the last block's successor guesses
+    };
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get a state's number, numbering it if new
+    ///
+    ////////////////////////////////////////////////////////////
+    std::uint32_t stateOf(const TrafficSignals &signals);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Find the block holding a time
+    ///
+    ///  @return std::size_t Index of the block, or
+    ///  blocks.size() when time is before the first
+    ////////////////////////////////////////////////////////////
+    static std::size_t blockOf(const Intersection &history, Clock::Time time);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Append a change to an intersection's last block
+    ///
+    ////////////////////////////////////////////////////////////
+    static void append(Intersection &history, Clock::Time time, std::uint32_t state);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Decode changes from the start of a block on,
+    ///  across blocks, until the visitor returns false.
+    ///
+    ///  @param history Intersection to decode
+    ///  @param block First block to decode
+    ///  @param visit Called with each change's time and state
+    ///  number
+    ////////////////////////////////////////////////////////////
+    template <typename Visit>
+    static void decode(const Intersection &history, std::size_t block, Visit visit);
+
+    std::vector<Intersection> intersections_;              ///< history of each intersection
+    std::vector<TrafficSignals> states_;                   ///< signals of each state number
+    std::unordered_map<SignalWord, std::uint32_t> numbers_;///< state number of packed signals
+};
+
+#endif // INCLUDE_SIGNALHISTORY_H_
@@ -0,0 +1,484 @@
+#ifndef INCLUDE_CONTROLLERHOST_H_
+#define INCLUDE_CONTROLLERHOST_H_
+
+#include "interfaces/simulator/ISensorFeed.hpp"
+
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/host/stateStore.hpp"
+#include "impl/sensor/sensorConditioner.hpp"
+#include "impl/util/latencyHistogram.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// Identifies a controller hosted by a ControllerHost
+using ControllerId = std::uint32_t;
+
+/// Returned when a controller could not be added
+static constexpr ControllerId INVALID_CONTROLLER = ~ControllerId(0);
+
+/// VehicleSensors packed one bit per Lane, SET as 1
+using SensorMask = std::uint8_t;
+
+////////////////////////////////////////////////////////////
+///  @brief Pack VehicleSensors into a SensorMask
+///
+///  @param sensors The sensors to pack
+///  @return SensorMask One bit per SET lane
+////////////////////////////////////////////////////////////
+SensorMask packSensors(const VehicleSensors &sensors);
+
+////////////////////////////////////////////////////////////
+///  @brief Unpack a SensorMask into VehicleSensors
+///
+///  @param mask The mask to unpack
+///  @param sensors Sensors to write
+////////////////////////////////////////////////////////////
+void unpackSensors(SensorMask mask, VehicleSensors &sensors);
+
+////////////////////////////////////////////////////////////
+///  @brief Pack TrafficSignals into a SignalWord
+///
+///  @param signals The signals to pack
+///  @return SignalWord One byte per lane
+////////////////////////////////////////////////////////////
+SignalWord packSignals(const TrafficSignals &signals);
+
+////////////////////////////////////////////////////////////
+///  @brief Unpack a SignalWord into TrafficSignals
+///
+///  @param word The word to unpack
+///  @return TrafficSignals One signal per lane
+////////////////////////////////////////////////////////////
+TrafficSignals unpackSignals(SignalWord word);
+
+////////////////////////////////////////////////////////////
+///  @brief Settings of a ControllerHost
+///
+////////////////////////////////////////////////////////////
+struct HostConfig
+{
+    unsigned numShards;                   ///< worker threads, 0 for one per core
+    std::uint32_t shardCapacity;          ///< controllers each shard can hold
+    IClock::Time timeStep;                ///< shard clock advance per tick
+    IClock::Time maxWaitTime;             ///< max wait time given to each controller
+    std::chrono::microseconds tickPeriod; ///< wall time between ticks, 0 to free-run
+    std::uint64_t tickLimit;              ///< ticks before a shard stops, 0 for no limit
+    bool pinThreads;                      ///< pin shard i to core i
+    bool conditionSensors;                ///< filter sensors through a SensorConditioner
+    std::array<DetectorTiming, Lane::COUNT> detectorTiming; ///< filters of each lane when conditioning
+    bool transitionTable;                 ///< decide ticks with the shared TransitionTable
+    const ISensorFeed *sensorFeed;        ///< read every controller's sensors each tick, nullptr to only take setSensorMask()
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Get a HostConfig with one shard per core ticking
+///  once per second of wall time.
+///
+///  @return HostConfig The default settings
+////////////////////////////////////////////////////////////
+HostConfig defaultHostConfig();
+
+////////////////////////////////////////////////////////////
+///  @brief Tick statistics of one shard
+///
+////////////////////////////////////////////////////////////
+struct ShardReport
+{
+    unsigned shard;             ///< shard index
+    unsigned core;              ///< core the shard is pinned to, or its index when unpinned
+    std::uint32_t controllers;  ///< controllers ticked on the last tick
+    std::uint64_t ticks;        ///< ticks completed
+    std::uint64_t p50;          ///< median tick latency, ns
+    std::uint64_t p99;          ///< 99th percentile tick latency, ns
+    std::uint64_t p999;         ///< 99.9th percentile tick latency, ns
+    std::uint64_t max;          ///< worst tick latency, ns
+    std::uint64_t preemptions;  ///< preemptions and releases serviced
+    std::uint64_t preemptP99;   ///< 99th percentile request to signal change, ns
+    std::uint64_t preemptP999;  ///< 99.9th percentile request to signal change, ns
+    std::uint64_t preemptMax;   ///< worst request to signal change, ns
+    std::uint64_t preemptGreenMax; ///< worst request to preempting pattern GREEN, ns
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Runs many TrafficLightControllerApps in one
+///  process, sharded across worker threads.
+///
+///     Each shard owns a fixed pool of controller slots, a
+///     shard-local Clock every controller in it reads, and a
+///     thread that may be pinned to a core. A tick advances
+///     the clock and runs each active slot in order over
+///     contiguous memory. Sensor inputs and signal outputs are
+///     per-slot atomics, so any thread can feed or read a
+///     controller without touching the shard thread.
+///
+///     Adding or removing a controller only queues a command
+///     on the owning shard under that shard's own lock; the
+///     shard applies it at the start of its next tick. Other
+///     shards never see the change, and a shard never blocks
+///     its tick on the lock.
+///
+///     Preemptions are queued the same way but also wake the
+///     shard: a sleeping shard services them at once, and a
+///     ticking shard between every PREEMPT_CHECK_INTERVAL
+///     controllers, instead of waiting for the next tick.
+///
+////////////////////////////////////////////////////////////
+class ControllerHost
+{
+public:
+    /// Controllers a tick runs between looks for preemptions
+    static constexpr std::uint32_t PREEMPT_CHECK_INTERVAL = 64;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new ControllerHost object
+    ///
+    ///  Allocates every shard's slots up front. No thread runs
+    ///  until #start().
+    ///
+    ///  @param config Host settings
+    ////////////////////////////////////////////////////////////
+    explicit ControllerHost(const HostConfig &config);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Destroy the ControllerHost object, stopping the
+    ///  shards first.
+    ///
+    ////////////////////////////////////////////////////////////
+    ~ControllerHost();
+
+    ControllerHost(const ControllerHost&) = delete;
+    ControllerHost& operator=(const ControllerHost&) = delete;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Keep every controller's state in a file and
+    ///  resume from what it already holds.
+    ///
+    ///     Each tick commits every controller's snapshot and
+    ///     the shard clocks to a StateStore. Once attached,
+    ///     the shard clocks continue from the file, and a
+    ///     controller added to a slot the file holds state for
+    ///     resumes from it, mid-cycle and with its wait times,
+    ///     instead of starting at NorthSouthTurning.
+    ///
+    ///     Ids are handed out in the same order as before, so
+    ///     making the same adds after a restart finds the same
+    ///     controllers. Attaching maps the file without reading
+    ///     it, so its cost does not grow with the controllers.
+    ///     A preemption under way is kept with the rest of the
+    ///     snapshot, so a restart mid-clearance still ends with
+    ///     the preempting pattern GREEN.
+    ///
+    ///     Call before start(). A file laid out for another
+    ///     number of shards or capacity starts afresh.
+    ///
+    ///  @param path File to keep state in
+    ///  @param error Description of the problem, on failure
+    ///  @return true If the file is attached
+    ////////////////////////////////////////////////////////////
+    bool attachState(const std::string &path, std::string &error);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the attached StateStore
+    ///
+    ///  @return const StateStore& The store, closed when none
+    ///  is attached
+    ////////////////////////////////////////////////////////////
+    inline const StateStore& state() const
+    {
+        return state_;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Start every shard thread.
+    ///
+    ////////////////////////////////////////////////////////////
+    void start();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Stop every shard thread and wait for them.
+    ///
+    ////////////////////////////////////////////////////////////
+    void stop();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Wait for every shard to reach the tick limit.
+    ///
+    ///  Returns at once when the tick limit is 0.
+    ////////////////////////////////////////////////////////////
+    void wait();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Add a controller to the least loaded shard.
+    ///
+    ///  It starts running on the shard's next tick. Until then
+    ///  its signals read all RED.
+    ///
+    ///  @return ControllerId The new controller, or
+    ///  INVALID_CONTROLLER when every shard is full
+    ////////////////////////////////////////////////////////////
+    ControllerId addController();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Remove a controller.
+    ///
+    ///  It stops running on the shard's next tick.
+    ///
+    ///  @param id Controller to remove
+    ///  @return true If the controller existed
+    ////////////////////////////////////////////////////////////
+    bool removeController(ControllerId id);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Set the sensors a controller reads on its next
+    ///  tick.
+    ///
+    ///  @param id Controller to feed
+    ///  @param sensors Sensor state of each lane
+    ///  @return true If the controller exists
+    ////////////////////////////////////////////////////////////
+    bool setSensors(ControllerId id, const VehicleSensors &sensors);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Set the packed sensors a controller reads on
+    ///  its next tick.
+    ///
+    ///  An id that was never handed out or was removed is
+    ///  ignored. An id handed out again by a later add feeds
+    ///  the new controller.
+    ///
+    ///  @param id Controller to feed
+    ///  @param mask One bit per SET lane
+    ///  @return true If the controller exists
+    ////////////////////////////////////////////////////////////
+    bool setSensorMask(ControllerId id, SensorMask mask);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the packed sensors a controller reads on
+    ///  its next tick.
+    ///
+    ///  @param id Controller to look up
+    ///  @return SensorMask One bit per SET lane, 0 when the
+    ///  controller does not exist
+    ////////////////////////////////////////////////////////////
+    SensorMask sensorMask(ControllerId id) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Preempt a controller for an emergency vehicle.
+    ///
+    ///     The owning shard applies
+    ///     TrafficLightControllerApp::preempt() and publishes
+    ///     the YELLOW within one tick's worth of
+    ///     PREEMPT_CHECK_INTERVAL controllers, or at once if
+    ///     it is sleeping. The pattern is GREEN on the first
+    ///     tick at least PREEMPTION_YELLOW_TIME +
+    ///     PREEMPTION_RED_TIME of shard clock later, and no
+    ///     sooner than the second tick.
+    ///
+    ///     A controller whose add is still queued ignores it.
+    ///     Safe to call from any thread.
+    ///
+    ///  @param id Controller to preempt
+    ///  @param pattern Pattern the emergency vehicle needs
+    ///  @return true If the request was queued
+    ////////////////////////////////////////////////////////////
+    bool preempt(ControllerId id, TrafficLightPattern pattern);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Return a preempted controller to its cycle.
+    ///
+    ///  Serviced like preempt(). Safe to call from any thread.
+    ///
+    ///  @param id Controller to release
+    ///  @return true If the request was queued
+    ////////////////////////////////////////////////////////////
+    bool releasePreemption(ControllerId id);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the signals a controller showed after its
+    ///  last tick.
+    ///
+    ///  @param id Controller to read
+    ///  @return TrafficSignals The controller's signals, all
+    ///  RED when it does not exist
+    ////////////////////////////////////////////////////////////
+    TrafficSignals signals(ControllerId id) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the number of shards
+    ///
+    ///  @return unsigned Shards
+    ////////////////////////////////////////////////////////////
+    inline unsigned numShards() const
+    {
+        return static_cast<unsigned>(shards_.size());
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the shard that runs a controller
+    ///
+    ///  @param id Controller to look up
+    ///  @return unsigned The owning shard
+    ////////////////////////////////////////////////////////////
+    inline unsigned shardOf(ControllerId id) const
+    {
+        return id / config_.shardCapacity;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the tick statistics of a shard
+    ///
+    ///  @param shard Shard to report
+    ///  @return ShardReport The shard's statistics
+    ////////////////////////////////////////////////////////////
+    ShardReport report(unsigned shard) const;
+
+private:
+    /// A controller and its I/O, reused after removal.
+    struct Slot
+    {
+        Slot();
+        ~Slot();
+
+        std::atomic<SensorMask> sensorInput;  ///< written by feeders, read each tick
+        std::atomic<SignalWord> signalOutput; ///< written each tick, read by consumers
+        VehicleSensors sensors;               ///< unpacked input the controller reads
+        std::uint64_t preemptedAt;            ///< request time of a preemption not yet GREEN, ns, 0 if none
+        std::atomic<bool> used;               ///< handed out by addController, written under the shard's commandMutex
+        TrafficLightControllerApp *app;       ///< constructed in storage, nullptr when free
+        typename std::aligned_storage<sizeof(TrafficLightControllerApp),
+                                      alignof(TrafficLightControllerApp)>::type storage; ///< app storage
+    };
+
+    /// A change to a shard's set of controllers.
+    struct Command
+    {
+        std::uint32_t slot; ///< slot index within the shard
+        bool add;           ///< add when true, remove when false
+    };
+
+    /// A preemption or release waiting for its shard.
+    struct Preemption
+    {
+        std::uint32_t slot;          ///< slot index within the shard
+        TrafficLightPattern pattern; ///< pattern to preempt for, NUM_PATTERNS to release
+        std::uint64_t requested;     ///< steady clock time of the request, ns
+    };
+
+    /// A worker thread and the controllers it runs.
+    struct Shard
+    {
+        explicit Shard(std::uint32_t capacity);
+
+        Clock clock;                       ///< read by every controller in the shard
+        std::unique_ptr<Slot[]> slots;     ///< fixed pool of controller slots
+        std::vector<std::uint32_t> active; ///< slots ticked, in tick order
+        std::vector<std::uint32_t> position; ///< index of each slot in active
+
+        std::mutex commandMutex;           ///< guards the fields below
+        std::vector<Command> pending;      ///< commands not yet applied
+        std::vector<Command> applying;     ///< commands being applied, swapped with pending
+        std::vector<std::uint32_t> freeSlots; ///< slots not in use
+        std::vector<Preemption> preemptions; ///< preemptions not yet serviced
+        std::vector<Preemption> servicing; ///< preemptions being serviced, swapped with preemptions
+
+        std::atomic<bool> urgent;          ///< preemptions are queued
+        std::mutex wakeMutex;              ///< guards sleeping on wake
+        std::condition_variable wake;      ///< wakes a sleeping shard for preemptions or stop
+
+        std::atomic<std::uint32_t> load;   ///< controllers handed out
+        std::atomic<std::uint32_t> ticked; ///< controllers run on the last tick
+        std::atomic<std::uint64_t> ticks;  ///< ticks completed
+        SensorConditioner conditioner;     ///< filters every slot's sensors
+        LatencyHistogram latency;          ///< wall time of each tick
+        LatencyHistogram preemptLatency;   ///< request to signal change of each preemption
+        LatencyHistogram greenLatency;     ///< request to preempting pattern GREEN
+        std::atomic<std::uint64_t> preempted; ///< preemptions and releases serviced
+        unsigned core;                     ///< core pinned to
+        unsigned index;                    ///< position in shards_, and clock in the StateStore
+        std::thread thread;                ///< worker thread
+    };
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Body of a shard thread.
+    ///
+    ///  @param shard Shard to run
+    ////////////////////////////////////////////////////////////
+    void runShard(Shard &shard);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Apply a shard's pending commands, if its lock
+    ///  is free.
+    ///
+    ///  @param shard Shard to update
+    ////////////////////////////////////////////////////////////
+    void applyCommands(Shard &shard);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Apply a shard's queued preemptions and publish
+    ///  the affected signals.
+    ///
+    ///  @param shard Shard to service
+    ////////////////////////////////////////////////////////////
+    void servicePreemptions(Shard &shard);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Sleep until a tick is due, servicing any
+    ///  preemption that arrives meanwhile.
+    ///
+    ///  @param shard Shard to put to sleep
+    ///  @param nextTick When the next tick is due
+    ////////////////////////////////////////////////////////////
+    void sleepUntil(Shard &shard, std::chrono::steady_clock::time_point nextTick);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Queue a preemption or release on a shard and
+    ///  wake it.
+    ///
+    ///  @param id Controller concerned
+    ///  @param pattern Pattern to preempt for, NUM_PATTERNS to
+    ///  release
+    ///  @return true If the request was queued
+    ////////////////////////////////////////////////////////////
+    bool queuePreemption(ControllerId id, TrafficLightPattern pattern);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Run every active controller of a shard once.
+    ///
+    ///  @param shard Shard to tick
+    ////////////////////////////////////////////////////////////
+    void tick(Shard &shard);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Find a controller's slot
+    ///
+    ///  @param id Controller to look up
+    ///  @return Slot* The controller's slot, nullptr when id is
+    ///  out of range or its slot is not handed out
+    ////////////////////////////////////////////////////////////
+    inline Slot* slotOf(ControllerId id) const
+    {
+        if (id / config_.shardCapacity >= shards_.size())
+        {
+            return nullptr;
+        }
+
+        Slot &slot = shards_[id / config_.shardCapacity]->slots[id % config_.shardCapacity];
+        return slot.used.load(std::memory_order_acquire) ? &slot : nullptr;
+    }
+
+    HostConfig config_;                          ///< host settings
+    std::vector<std::unique_ptr<Shard>> shards_; ///< one per worker thread
+    std::atomic<bool> running_;                  ///< shard threads should keep ticking
+    StateStore state_;                           ///< kept controller state, closed when none
+};
+
+#endif // INCLUDE_CONTROLLERHOST_H_
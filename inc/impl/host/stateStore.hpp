@@ -0,0 +1,183 @@
+#ifndef INCLUDE_STATESTORE_H_
+#define INCLUDE_STATESTORE_H_
+
+#include "impl/app/TrafficLightControllerApp.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/// Bumped whenever the file layout or ControllerSnapshot changes
+static constexpr std::uint32_t STATE_STORE_VERSION = 3;
+
+static_assert(std::is_trivially_copyable<ControllerSnapshot>::value,
+              "ControllerSnapshot is stored as raw bytes");
+
+////////////////////////////////////////////////////////////
+///  @brief Controller snapshots and clocks kept in a
+///  memory-mapped file, so a restarted process picks up
+///  where the last one stopped.
+///
+///     The file is a header, a row of clocks, and two copies
+///     of each slot's snapshot. A save overwrites the older
+///     copy: it zeroes the copy's sequence, writes the
+///     snapshot and its checksum, then stores the next
+///     sequence as the commit marker. A load takes the copy
+///     with the highest sequence whose checksum matches, so a
+///     save cut short by a crash leaves the previous one.
+///
+///     Saves are plain stores into shared pages; the kernel
+///     writes them back, and they survive the process dying
+///     at any point. flush() also asks for write-back, for
+///     surviving the machine going down.
+///
+///     Opening maps the file without reading it, so it takes
+///     the same few microseconds however many slots it holds;
+///     each slot's pages are faulted in by its first load.
+///
+///     Each slot and each clock has one writer at a time.
+///
+////////////////////////////////////////////////////////////
+class StateStore
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a closed StateStore
+    ///
+    ////////////////////////////////////////////////////////////
+    StateStore();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Destroy the StateStore object, unmapping the
+    ///  file.
+    ///
+    ////////////////////////////////////////////////////////////
+    ~StateStore();
+
+    StateStore(const StateStore&) = delete;
+    StateStore& operator=(const StateStore&) = delete;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Map a state file, creating it if missing.
+    ///
+    ///  A file of another version, snapshot size, or number
+    ///  of clocks or slots is emptied and laid out afresh.
+    ///
+    ///  @param path File to map
+    ///  @param numClocks Clocks the file keeps
+    ///  @param capacity Slots the file keeps
+    ///  @param error Description of the problem, on failure
+    ///  @return true If the file is mapped
+    ////////////////////////////////////////////////////////////
+    bool open(const std::string &path, std::uint32_t numClocks, std::uint32_t capacity, std::string &error);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Unmap the file, if one is mapped.
+    ///
+    ////////////////////////////////////////////////////////////
+    void close();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Check whether a file is mapped
+    ///
+    ///  @return true Between a successful open() and close()
+    ////////////////////////////////////////////////////////////
+    inline bool isOpen() const
+    {
+        return base_ != nullptr;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Check whether open() laid the file out afresh
+    ///
+    ///  @return true If nothing was kept from an earlier run
+    ////////////////////////////////////////////////////////////
+    inline bool wasReset() const
+    {
+        return reset_;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Commit a slot's snapshot.
+    ///
+    ///  @param slot Slot to write
+    ///  @param state Snapshot to keep
+    ////////////////////////////////////////////////////////////
+    void save(std::uint32_t slot, const ControllerSnapshot &state);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Read a slot's last committed snapshot.
+    ///
+    ///  @param slot Slot to read
+    ///  @param state Set to the snapshot, untouched if none
+    ///  @return true If the slot holds a snapshot
+    ////////////////////////////////////////////////////////////
+    bool load(std::uint32_t slot, ControllerSnapshot &state) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Forget a slot's snapshots.
+    ///
+    ///  @param slot Slot to clear
+    ////////////////////////////////////////////////////////////
+    void erase(std::uint32_t slot);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Keep a clock's time.
+    ///
+    ///  @param index Clock to write
+    ///  @param now Time to keep
+    ////////////////////////////////////////////////////////////
+    void saveClock(std::uint32_t index, IClock::Time now);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get a clock's kept time
+    ///
+    ///  @param index Clock to read
+    ///  @return IClock::Time The time, 0 in a fresh file
+    ////////////////////////////////////////////////////////////
+    IClock::Time clock(std::uint32_t index) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Start writing every committed save back to the
+    ///  file without waiting for it.
+    ///
+    ////////////////////////////////////////////////////////////
+    void flush();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the number of slots
+    ///
+    ///  @return std::uint32_t Slots in the file
+    ////////////////////////////////////////////////////////////
+    inline std::uint32_t capacity() const
+    {
+        return capacity_;
+    }
+
+private:
+    /// One committed or half-written snapshot.
+    struct alignas(64) Copy
+    {
+        std::atomic<std::uint64_t> sequence; ///< commit marker, 0 while unwritten
+        std::uint64_t checksum;              ///< of sequence and state
+        ControllerSnapshot state;            ///< the snapshot
+    };
+
+    /// Both copies of a slot's snapshot.
+    struct Record
+    {
+        Copy copies[2]; ///< written alternately
+    };
+
+    std::uint8_t *base_;    ///< mapped file, nullptr when closed
+    std::size_t size_;      ///< bytes mapped
+    std::atomic<std::int64_t> *clocks_; ///< clocks in the mapping
+    Record *records_;       ///< slots in the mapping
+    std::uint32_t numClocks_; ///< clocks in the file
+    std::uint32_t capacity_;  ///< slots in the file
+    bool reset_;            ///< open() laid the file out afresh
+};
+
+#endif // INCLUDE_STATESTORE_H_
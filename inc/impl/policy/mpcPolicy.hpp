@@ -0,0 +1,155 @@
+#ifndef INCLUDE_MPCPOLICY_H_
+#define INCLUDE_MPCPOLICY_H_
+
+#include "interfaces/app/IDecisionPolicy.hpp"
+
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/util/latencyHistogram.hpp"
+#include "impl/util/workerPool.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Settings of an MpcPolicy.
+///
+////////////////////////////////////////////////////////////
+struct MpcConfig
+{
+    unsigned candidates;               ///< choices per decision: end now, or hold 1..candidates-1 more steps
+    unsigned samples;                  ///< sampled demand futures each choice is scored on
+    unsigned horizon;                  ///< steps each rollout looks ahead
+    IClock::Time timeStep;             ///< seconds per step, the controller's tick period
+    std::chrono::microseconds budget;  ///< time allowed per decision
+    unsigned workers;                  ///< threads besides the controller's, 0 for none
+    std::uint64_t seed;                ///< seed of the sampled futures
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Get MpcConfig defaults: 6 choices, 8 futures of
+///  60 one-second steps, 5 ms budget, no extra threads.
+///
+///  @return MpcConfig The default settings
+////////////////////////////////////////////////////////////
+MpcConfig defaultMpcConfig();
+
+////////////////////////////////////////////////////////////
+///  @brief Counters of an MpcPolicy.
+///
+////////////////////////////////////////////////////////////
+struct MpcStats
+{
+    std::uint64_t decisions; ///< ticks the policy was asked about
+    std::uint64_t searches;  ///< decisions settled by rollouts
+    std::uint64_t rollouts;  ///< rollouts run to the horizon
+    std::uint64_t overruns;  ///< searches cut short by the budget
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Model-predictive policy for a
+///  TrafficLightControllerApp.
+///
+///     With nobody waiting the policy holds, and the
+///     controller rests the pattern in GREEN even past its
+///     max active time. Whenever the active pattern may end
+///     and cars are waiting, the policy forks the controller
+///     from its snapshot once per choice and future: the fork
+///     holds the pattern for the chosen number of steps, ends
+///     it, then follows the controller's own rules to the
+///     horizon. The choice with the least mean wait (the
+///     lane-seconds of replayed metrics) is taken, and the
+///     search runs again next tick.
+///
+///     Futures are sampled from a two-state Markov model of
+///     each sensor, whose arrival and departure rates are
+///     learned from the ticks the policy has seen. Every
+///     choice sees the same futures, so they are compared on
+///     equal terms.
+///
+///     The forks are built once, in the constructor, and
+///     rollouts run on a WorkerPool, so a decision never
+///     allocates. A search that runs out of budget scores
+///     only the choices it finished; with fewer than two,
+///     the controller follows its rules for that tick.
+///
+////////////////////////////////////////////////////////////
+class MpcPolicy : public IDecisionPolicy
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new MpcPolicy object
+    ///
+    ///  @param config Settings
+    ////////////////////////////////////////////////////////////
+    explicit MpcPolicy(const MpcConfig &config = defaultMpcConfig());
+
+    ~MpcPolicy();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Decide the active pattern for this tick.
+    ///
+    ///  @param state The controller's state this tick
+    ///  @return Decision What the controller should do
+    ////////////////////////////////////////////////////////////
+    Decision decide(const ControllerSnapshot &state) override;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the counters
+    ///
+    ///  @return const MpcStats& The counters
+    ////////////////////////////////////////////////////////////
+    inline const MpcStats& stats() const
+    {
+        return stats_;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the time spent in each decision
+    ///
+    ///  @return const LatencyHistogram& Decision latencies
+    ////////////////////////////////////////////////////////////
+    inline const LatencyHistogram& latency() const
+    {
+        return latency_;
+    }
+
+private:
+    struct Rollout;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Learn the sensors' arrival and departure rates
+    ///  from one more tick.
+    ///
+    ///  @param state The controller's state this tick
+    ////////////////////////////////////////////////////////////
+    void observe(const ControllerSnapshot &state);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Run one fork to the horizon and store its wait.
+    ///
+    ///  @param job Index of the (choice, future) pair
+    ////////////////////////////////////////////////////////////
+    void rollout(std::size_t job);
+
+    MpcConfig config_;                               ///< settings
+    MpcStats stats_;                                 ///< counters
+    LatencyHistogram latency_;                       ///< decision latencies (ns)
+    std::array<float, Lane::COUNT> arrivalRate_;     ///< P(CLEAR -> SET) per step
+    std::array<float, Lane::COUNT> departureRate_;   ///< P(SET -> CLEAR) per step
+    VehicleSensors lastSensors_;                     ///< sensors at the last observed tick
+    IClock::Time lastTime_;                          ///< time of the last observed tick
+    bool observed_;                                  ///< lastSensors_ is valid
+
+    /// State of the search in progress, read by every rollout
+    const ControllerSnapshot *state_;
+    std::chrono::steady_clock::time_point deadline_;
+
+    std::vector<std::unique_ptr<Rollout>> rollouts_; ///< one fork per (choice, future)
+    std::vector<std::int64_t> waits_;                ///< wait of each fork, -1 if not run
+    WorkerPool pool_;                                ///< runs the rollouts
+};
+
+#endif // INCLUDE_MPCPOLICY_H_
@@ -0,0 +1,56 @@
+#ifndef INCLUDE_PIPELINE_H_
+#define INCLUDE_PIPELINE_H_
+
+#include "impl/config/configManager.hpp"
+#include "impl/replay/replay.hpp"
+
+#include <cstddef>
+#include <ostream>
+
+////////////////////////////////////////////////////////////
+///  @brief How often each stage of a replayPipelined() had
+///  to wait for its neighbour.
+///
+////////////////////////////////////////////////////////////
+struct PipelineStats
+{
+    std::size_t ticks;           ///< controller ticks run
+    std::size_t simulatorWaits;  ///< sensor frames held back by a full queue
+    std::size_t controllerWaits; ///< ticks that waited for their sensor frame
+    std::size_t outputWaits;     ///< ticks whose signals the output stage waited for
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Run a TrafficLightControllerApp through a
+///  scenario with the simulator, the controller and the
+///  output each on their own thread.
+///
+///     A scenario is replayed open-loop, so the sensors of a
+///     tick never depend on the signals of the one before.
+///     The simulator stage reads the sensor frames ahead into
+///     a bounded lock-free queue. The controller stage runs a
+///     tick for each frame and passes the signals, with
+///     whatever the controller logged during the tick, to the
+///     output stage on the calling thread, which prints and
+///     scores them in order. The output and the result are
+///     the same as running every step in one loop.
+///
+///  @param scenario Scenario to replay
+///  @param timeStep Time between controller ticks
+///  @param config Timing the controller reads each tick
+///  @param reader The controller's reader of config, used
+///  only by the controller stage until the call returns
+///  @param out Stream to print the controller's messages and
+///  the signals of each tick to, nullptr to only score them
+///  @param stats Filled in with the waits of each stage,
+///  nullptr to ignore
+///  @return ReplayResult The controller's schedule and score
+////////////////////////////////////////////////////////////
+ReplayResult replayPipelined(const Scenario &scenario,
+                             Clock::Time timeStep,
+                             ConfigManager &config,
+                             ConfigManager::ReaderId reader,
+                             std::ostream *out = nullptr,
+                             PipelineStats *stats = nullptr);
+
+#endif // INCLUDE_PIPELINE_H_
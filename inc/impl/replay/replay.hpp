@@ -0,0 +1,188 @@
+#ifndef INCLUDE_REPLAY_H_
+#define INCLUDE_REPLAY_H_
+
+#include "interfaces/app/IDecisionPolicy.hpp"
+
+#include "impl/app/patternTable.hpp"
+#include "impl/config/timingConfig.hpp"
+#include "impl/simulator/simulator.hpp"
+#include "impl/util/workerPool.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Sensor state at each step of a scenario, index = time / timeStep
+using SensorTimeline = std::vector<VehicleSensors>;
+
+/// Active pattern at each step of a scenario, index = time / timeStep
+using PatternSchedule = std::vector<TrafficLightPattern>;
+
+////////////////////////////////////////////////////////////
+///  @brief How well a pattern schedule served a scenario.
+///
+///     A lane waits for a step when its sensor is SET and its
+///     signal is not GREEN, the same condition under which the
+///     controller counts a vehicle as waiting at a red light.
+///
+////////////////////////////////////////////////////////////
+struct ReplayMetrics
+{
+    IClock::Time duration;       ///< time covered by the schedule
+    std::int64_t totalWait;      ///< lane-seconds spent waiting, summed over lanes
+    IClock::Time maxWait;        ///< longest unbroken wait of any lane
+    std::uint32_t patternChanges; ///< times the active pattern changed
+};
+
+////////////////////////////////////////////////////////////
+///  @brief A controller's run through a scenario.
+///
+////////////////////////////////////////////////////////////
+struct ReplayResult
+{
+    PatternSchedule schedule;      ///< pattern the controller showed at each step
+    ReplayMetrics metrics;         ///< score of that schedule
+    std::size_t fastForwardSteps;  ///< steps copied from an earlier cycle instead of run
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Sample a scenario's sensors at each step, exactly
+///  as the Simulator replays it.
+///
+///  @param scenario Scenario to sample
+///  @param timeStep Time between samples
+///  @return SensorTimeline The sensors at each step
+////////////////////////////////////////////////////////////
+SensorTimeline sampleScenario(const Scenario &scenario, Clock::Time timeStep);
+
+////////////////////////////////////////////////////////////
+///  @brief Scores a pattern schedule one step at a time, as
+///  scoreSchedule() does for a whole one.
+///
+////////////////////////////////////////////////////////////
+class ScheduleScorer
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a ScheduleScorer with no steps scored
+    ///
+    ///  @param timeStep Time between steps
+    ////////////////////////////////////////////////////////////
+    explicit ScheduleScorer(Clock::Time timeStep);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Score the next step
+    ///
+    ///  @param sensors Sensors at the step
+    ///  @param pattern Pattern shown at the step
+    ////////////////////////////////////////////////////////////
+    void add(const VehicleSensors &sensors, TrafficLightPattern pattern);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the score of the steps so far
+    ///
+    ///  @return const ReplayMetrics& The score
+    ////////////////////////////////////////////////////////////
+    inline const ReplayMetrics& metrics() const
+    {
+        return metrics_;
+    }
+
+private:
+    Clock::Time timeStep_;                          ///< time between steps
+    ReplayMetrics metrics_;                         ///< score so far
+    std::array<IClock::Time, Lane::COUNT> waiting_; ///< unbroken wait of each lane
+    TrafficLightPattern last_;                      ///< pattern of the last step, NUM_PATTERNS before the first
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Score a pattern schedule against a timeline.
+///
+///  @param timeline Sensors at each step
+///  @param schedule Pattern at each step, at least as long
+///  @param timeStep Time between steps
+///  @return ReplayMetrics The schedule's score
+////////////////////////////////////////////////////////////
+ReplayMetrics scoreSchedule(const SensorTimeline &timeline,
+                            const PatternSchedule &schedule,
+                            Clock::Time timeStep);
+
+////////////////////////////////////////////////////////////
+///  @brief Run a silent TrafficLightControllerApp through a
+///  scenario and score what it did.
+///
+///     While the sensors hold steady, the controller's state
+///     is recorded each step with its times taken relative to
+///     the clock. Once a state repeats, the controller is in a
+///     steady cycle, or resting in one pattern: with
+///     fastForward, the schedule of whole cycles is copied up
+///     to the end of the timeslice and the controller is
+///     restored a whole number of cycles later. The schedule
+///     and metrics are the same as running every step.
+///
+///     A controller with a policy is always run step by step,
+///     since the policy's own state is not recorded.
+///
+///  @param scenario Scenario to replay
+///  @param timeStep Time between controller ticks
+///  @param timing Timing plan the controller runs with
+///  @param policy Policy attached to the controller, nullptr
+///  for its own rules
+///  @param fastForward Skip over repeated cycles
+///  @return ReplayResult The controller's schedule and score
+////////////////////////////////////////////////////////////
+ReplayResult replayController(const Scenario &scenario,
+                              Clock::Time timeStep,
+                              const TimingConfig &timing = defaultTimingConfig(),
+                              IDecisionPolicy *policy = nullptr,
+                              bool fastForward = true);
+
+////////////////////////////////////////////////////////////
+///  @brief How the work of a replayControllerParallel() was
+///  split up.
+///
+////////////////////////////////////////////////////////////
+struct ParallelReplayStats
+{
+    std::size_t segments;      ///< pieces the scenario was cut into
+    std::size_t converged;     ///< segments whose predicted start state was right
+    std::size_t steps;         ///< controller ticks in the scenario
+    std::size_t parallelSteps; ///< ticks run on the pool, warm-up included
+    std::size_t fixupSteps;    ///< ticks run again, one segment after another
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Run a silent TrafficLightControllerApp through a
+///  scenario on every thread of a pool, and score what it did.
+///
+///     The scenario is cut into segments, each starting where
+///     the sensors have just gone all CLEAR. Every segment is
+///     run at once by its own controller, started a warm-up
+///     before the segment from the state it powers up in, and
+///     the state it reaches every few steps is recorded.
+///
+///     Then, one segment after another, a controller is
+///     restored to the true end state of the segment before
+///     and run until it reaches a recorded state. From there
+///     on both controllers do the same, so the rest of the
+///     speculative run is kept. Only a segment whose controller
+///     never meets the recorded states is run through again.
+///     The schedule and metrics are the same as
+///     replayController() without a policy.
+///
+///  @param scenario Scenario to replay
+///  @param timeStep Time between controller ticks
+///  @param pool Threads to run the segments on
+///  @param timing Timing plan the controller runs with
+///  @param stats Filled in with the split of the work,
+///  nullptr to ignore
+///  @return ReplayResult The controller's schedule and score
+////////////////////////////////////////////////////////////
+ReplayResult replayControllerParallel(const Scenario &scenario,
+                                      Clock::Time timeStep,
+                                      WorkerPool &pool,
+                                      const TimingConfig &timing = defaultTimingConfig(),
+                                      ParallelReplayStats *stats = nullptr);
+
+#endif // INCLUDE_REPLAY_H_
@@ -0,0 +1,198 @@
+#ifndef INCLUDE_SENSORCONDITIONER_H_
+#define INCLUDE_SENSORCONDITIONER_H_
+
+#include "impl/app/patternTable.hpp"
+#include "impl/simulator/simulator.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Filter settings of one detector, in ticks.
+///
+///  Settings of 1, 0 and 1 pass the raw sensor through.
+///  Values above SensorConditioner::MAX_TICKS are clamped.
+///
+////////////////////////////////////////////////////////////
+struct DetectorTiming
+{
+    std::uint8_t onDelay;     ///< ticks a raw SET must last before a call is placed (debounce)
+    std::uint8_t minPresence; ///< ticks a placed call is held at least
+    std::uint8_t gapOut;      ///< ticks a raw CLEAR must last before a call is dropped (hysteresis)
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Get DetectorTiming defaults for chattering loops:
+///  2 ticks on, 3 ticks held, 2 ticks gap.
+///
+///  @return DetectorTiming The default settings
+////////////////////////////////////////////////////////////
+DetectorTiming defaultDetectorTiming();
+
+////////////////////////////////////////////////////////////
+///  @brief Conditions the raw presence detectors of many
+///  intersections before their controllers read them.
+///
+///     Each detector places a call once its raw input has
+///     been SET for onDelay ticks, holds it for at least
+///     minPresence ticks, and drops it once the raw input
+///     has been CLEAR for gapOut ticks. Chatter shorter than
+///     the delays never reaches the controller.
+///
+///     The filters are bit-sliced: one 64-bit word holds a
+///     bit for each lane of eight intersections, and every
+///     counter and threshold is stored as COUNTER_BITS such
+///     words, one per bit of the count. A tick updates 64
+///     detectors with a few dozen word operations and no
+///     branches, whatever each detector's settings are.
+///
+////////////////////////////////////////////////////////////
+class SensorConditioner
+{
+public:
+    /// Bits of each counter and threshold
+    static constexpr unsigned COUNTER_BITS = 6;
+
+    /// Longest delay a detector can be set to
+    static constexpr unsigned MAX_TICKS = (1u << COUNTER_BITS) - 1;
+
+    /// Intersections packed in one word
+    static constexpr unsigned INTERSECTIONS_PER_WORD = 64 / Lane::COUNT;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new SensorConditioner object
+    ///
+    ///  Every detector starts CLEAR with
+    ///  defaultDetectorTiming().
+    ///
+    ///  @param numIntersections Number of intersections
+    ////////////////////////////////////////////////////////////
+    explicit SensorConditioner(std::size_t numIntersections);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Set the filters of one detector.
+    ///
+    ///  @param intersection Intersection of the detector
+    ///  @param lane Lane of the detector
+    ///  @param timing Filter settings
+    ////////////////////////////////////////////////////////////
+    void setTiming(IntersectionId intersection, Lane lane, const DetectorTiming &timing);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Set the filters of a lane at every intersection.
+    ///
+    ///  @param lane Lane to set
+    ///  @param timing Filter settings
+    ////////////////////////////////////////////////////////////
+    void setLaneTiming(Lane lane, const DetectorTiming &timing);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Set the raw detector readings of an
+    ///  intersection for the next #update().
+    ///
+    ///  @param intersection Intersection to set
+    ///  @param raw One bit per SET lane
+    ////////////////////////////////////////////////////////////
+    inline void setRaw(IntersectionId intersection, LaneMask raw)
+    {
+        bytes(raw_, intersection) = raw;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Clear an intersection's calls and counters, as
+    ///  when its detectors are replaced.
+    ///
+    ///  @param intersection Intersection to reset
+    ////////////////////////////////////////////////////////////
+    void reset(IntersectionId intersection);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Advance every detector by one tick.
+    ///
+    ////////////////////////////////////////////////////////////
+    void update();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the calls of an intersection after the
+    ///  last #update().
+    ///
+    ///  @param intersection Intersection to read
+    ///  @return LaneMask One bit per lane with a call
+    ////////////////////////////////////////////////////////////
+    inline LaneMask conditioned(IntersectionId intersection) const
+    {
+        return bytes(out_, intersection);
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the calls of an intersection as sensors.
+    ///
+    ///  @param intersection Intersection to read
+    ///  @param sensors Set to SET for each lane with a call
+    ////////////////////////////////////////////////////////////
+    void conditioned(IntersectionId intersection, VehicleSensors &sensors) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the raw edges seen by #update()
+    ///
+    ///  @return std::uint64_t SET/CLEAR changes of raw inputs
+    ////////////////////////////////////////////////////////////
+    inline std::uint64_t rawEdges() const
+    {
+        return rawEdges_;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the edges passed on by #update()
+    ///
+    ///  @return std::uint64_t Calls placed plus calls dropped
+    ////////////////////////////////////////////////////////////
+    inline std::uint64_t conditionedEdges() const
+    {
+        return conditionedEdges_;
+    }
+
+private:
+    /// One bit per detector, bit b of a count in planes[b]
+    using Planes = std::array<std::uint64_t, COUNTER_BITS>;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the byte of an intersection in a word array
+    ///
+    ///  @param words Array of packed words
+    ///  @param intersection Intersection to find
+    ///  @return std::uint8_t& The intersection's lane bits
+    ////////////////////////////////////////////////////////////
+    static inline std::uint8_t& bytes(std::vector<std::uint64_t> &words, IntersectionId intersection)
+    {
+        return reinterpret_cast<std::uint8_t*>(words.data())[intersection];
+    }
+
+    static inline std::uint8_t bytes(const std::vector<std::uint64_t> &words, IntersectionId intersection)
+    {
+        return reinterpret_cast<const std::uint8_t*>(words.data())[intersection];
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Store one detector's threshold in its planes.
+    ///
+    ////////////////////////////////////////////////////////////
+    static void setThreshold(Planes &planes, std::uint64_t bit, unsigned ticks);
+
+    std::vector<std::uint64_t> raw_;     ///< raw readings for the next update
+    std::vector<std::uint64_t> lastRaw_; ///< raw readings of the last update
+    std::vector<std::uint64_t> out_;     ///< calls
+
+    std::vector<Planes> run_;            ///< ticks the raw input has disagreed with the call
+    std::vector<Planes> held_;           ///< ticks the call has been placed
+    std::vector<Planes> onDelay_;        ///< threshold of each detector
+    std::vector<Planes> minPresence_;    ///< threshold of each detector
+    std::vector<Planes> gapOut_;         ///< threshold of each detector
+
+    std::uint64_t rawEdges_;             ///< raw changes seen
+    std::uint64_t conditionedEdges_;     ///< call changes made
+};
+
+#endif // INCLUDE_SENSORCONDITIONER_H_
@@ -0,0 +1,110 @@
+#ifndef INCLUDE_DETECTORLOG_H_
+#define INCLUDE_DETECTORLOG_H_
+
+#include "impl/simulator/simulator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief How to read a detector log.
+///
+////////////////////////////////////////////////////////////
+struct DetectorLogOptions
+{
+    std::vector<Lane> lanes; ///< lane of each detector id, Lane::PLACEHOLDER if unused
+    unsigned numThreads;     ///< parsing threads, 0 for one per core
+    std::size_t chunkSize;   ///< bytes parsed per task
+    bool rebase;             ///< shift times so the first event is at 0
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Get DetectorLogOptions with detector ids 0 to 7 on
+///  the lanes in Lane order, one thread per core, 16 MiB
+///  chunks and times rebased.
+///
+///  @return DetectorLogOptions The default options
+////////////////////////////////////////////////////////////
+DetectorLogOptions defaultDetectorLogOptions();
+
+////////////////////////////////////////////////////////////
+///  @brief Counters of one import.
+///
+////////////////////////////////////////////////////////////
+struct DetectorLogStats
+{
+    std::uint64_t bytes;     ///< bytes read
+    std::uint64_t lines;     ///< non-empty lines, header excluded
+    std::uint64_t events;    ///< lines that named a mapped detector
+    std::uint64_t unmapped;  ///< lines naming a detector with no lane
+    std::uint64_t malformed; ///< lines that did not parse
+    std::uint64_t changes;   ///< sensors that changed from one second to the next
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Build a scenario from a detector log.
+///
+///     Each line is "timestamp,detector,state": whole seconds
+///     (a fraction is dropped), an integer detector id, and
+///     1/0, SET/CLEAR or ON/OFF in any case. Lines end in LF
+///     or CRLF; a first line that does not start with a digit
+///     is a header. Timestamps must never decrease.
+///
+///     A sensor holds its state until a later event changes
+///     it, starting CLEAR, and the last event of a second
+///     wins. The scenario has one SimulationTimeslice per run
+///     of unchanged sensors, from the first event's second to
+///     the one after the last.
+///
+///     The data is cut into chunks at line ends and each
+///     chunk is tokenized on its own thread, 64 bytes at a
+///     time with SIMD compares where the target has them.
+///     A chunk keeps only the seconds in which a sensor
+///     changed, so memory follows the traffic, not the file.
+///
+///  @param data Log text
+///  @param size Bytes of text
+///  @param options How to read the log
+///  @param scenario Set to the scenario, untouched on failure
+///  @param stats Set to the import's counters
+///  @param error Description of the problem, on failure
+///  @return true If the log was in time order
+////////////////////////////////////////////////////////////
+bool parseDetectorLog(const char *data, std::size_t size, const DetectorLogOptions &options,
+                      Scenario &scenario, DetectorLogStats &stats, std::string &error);
+
+////////////////////////////////////////////////////////////
+///  @brief Build a scenario from a detector log file.
+///
+///  The file is memory-mapped, so it is paged in by the
+///  parsing threads rather than read up front.
+///
+///  @param path File to import
+///  @param options How to read the log
+///  @param scenario Set to the scenario, untouched on failure
+///  @param stats Set to the import's counters
+///  @param error Description of the problem, on failure
+///  @return true If the file was read and in time order
+////////////////////////////////////////////////////////////
+bool loadDetectorLog(const std::string &path, const DetectorLogOptions &options,
+                     Scenario &scenario, DetectorLogStats &stats, std::string &error);
+
+////////////////////////////////////////////////////////////
+///  @brief Parse a detector map.
+///
+///  The format is one "detector = lane" per line, with '#'
+///  starting a comment, where lane is a Lane name such as
+///  N_W.
+///
+///  @param in Stream to parse
+///  @param lanes Set to the lane of each detector id,
+///  untouched on failure
+///  @param error Description of the first problem found
+///  @return true If the whole stream parsed
+////////////////////////////////////////////////////////////
+bool parseDetectorMap(std::istream &in, std::vector<Lane> &lanes, std::string &error);
+
+#endif // INCLUDE_DETECTORLOG_H_
@@ -0,0 +1,278 @@
+#ifndef INCLUDE_MICROSIMULATOR_H_
+#define INCLUDE_MICROSIMULATOR_H_
+
+#include "interfaces/simulator/ISimulator.hpp"
+
+#include "impl/simulator/simulator.hpp"
+
+#include <cstdint>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Intelligent Driver Model parameters, SI units.
+///
+////////////////////////////////////////////////////////////
+struct IdmParameters
+{
+    float desiredSpeed;   ///< v0, free-flow speed (m/s)
+    float timeHeadway;    ///< T, desired time gap to the leader (s)
+    float minGap;         ///< s0, bumper-to-bumper gap when stopped (m)
+    float maxAccel;       ///< a, maximum acceleration (m/s^2)
+    float comfortDecel;   ///< b, comfortable deceleration (m/s^2)
+    float maxDecel;       ///< hardest braking a driver uses to stop for a signal (m/s^2)
+    float vehicleLength;  ///< length of every vehicle (m)
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Get urban IdmParameters: 50 km/h, 1.5 s headway.
+///
+///  @return IdmParameters The default parameters
+////////////////////////////////////////////////////////////
+IdmParameters defaultIdmParameters();
+
+////////////////////////////////////////////////////////////
+///  @brief Vehicle counters of a MicroSimulator.
+///
+////////////////////////////////////////////////////////////
+struct MicroStats
+{
+    std::uint64_t vehiclesSpawned;    ///< vehicles entering from outside the network
+    std::uint64_t vehiclesDischarged; ///< vehicles that crossed a stop line
+    std::uint64_t vehiclesExited;     ///< vehicles that left the network
+    std::uint64_t spillbackSteps;     ///< substeps a stop line was blocked by a full downstream lane
+    std::uint64_t substeps;           ///< substeps simulated
+    std::uint64_t vehicleUpdates;     ///< vehicle states integrated
+    double delay;                     ///< time lost against free-flow speed, summed (s)
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Microscopic simulator in which individual vehicles
+///  follow the Intelligent Driver Model along the approach
+///  of every Lane.
+///
+///     Each intersection has one approach road per Lane,
+///     ending at a stop line. Vehicles enter at the upstream
+///     end, either from a lane's outside demand or from the
+///     upstream intersection's stop line, and follow their
+///     leader. The front vehicle of a road also sees the stop
+///     line as a stopped obstacle unless its signal is GREEN
+///     and the downstream road has room, so queues, start-up
+///     lost time and spillback emerge from car following.
+///
+///     Vehicle state lives in structure-of-arrays form, sorted
+///     by road and front to back, so the leader of each
+///     vehicle is the one before it. A substep runs three
+///     branch-free loops over the arrays (leader gather, IDM
+///     acceleration, integration) that the compiler can
+///     vectorize, then one compaction pass moves vehicles
+///     across stop lines and spawns new ones.
+///
+///     Time advances in whole seconds on the Clock, like the
+///     other simulators, split into fixed substeps (10 Hz by
+///     default). A lane's presence detector covers the end of
+///     its approach and reads SET if any vehicle occupied it
+///     during the last #advance().
+///
+////////////////////////////////////////////////////////////
+class MicroSimulator : public ISimulator
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new MicroSimulator object
+    ///
+    ///  Every signal starts RED and every lane without demand.
+    ///
+    ///  @param numIntersections Number of intersections
+    ///  @param approachLength Length of each approach road (m)
+    ///  @param parameters Driver and vehicle parameters
+    ///  @param substepsPerSecond Integration rate (Hz)
+    ///  @param seed Seed for the arrival process
+    ////////////////////////////////////////////////////////////
+    MicroSimulator(std::size_t numIntersections,
+                   float approachLength,
+                   const IdmParameters &parameters = defaultIdmParameters(),
+                   unsigned substepsPerSecond = 10,
+                   std::uint64_t seed = 1);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Set the rate vehicles arrive at a lane from
+    ///  outside the network.
+    ///
+    ///     Arrivals are a Bernoulli process per substep. When
+    ///     the upstream end of the road is full, arrivals wait
+    ///     off the network and enter in order once there is room.
+    ///
+    ///  @param intersection Intersection to feed
+    ///  @param lane Lane to feed
+    ///  @param vehiclesPerHour Mean arrival rate
+    ////////////////////////////////////////////////////////////
+    void setDemand(IntersectionId intersection, Lane lane, float vehiclesPerHour);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Send vehicles crossing a lane's stop line onto
+    ///  the approach of another intersection.
+    ///
+    ///     Without a link, vehicles leave the network after
+    ///     the stop line.
+    ///
+    ///  @param from Upstream intersection
+    ///  @param fromLane Upstream lane
+    ///  @param to Downstream intersection
+    ///  @param toLane Lane the vehicles join downstream
+    ////////////////////////////////////////////////////////////
+    void link(IntersectionId from, Lane fromLane, IntersectionId to, Lane toLane);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Users should call this to update the traffic
+    ///  lights of an intersection
+    ///
+    ///  @param intersection Intersection to update
+    ///  @param signals Signal of each lane
+    ////////////////////////////////////////////////////////////
+    void setSignals(IntersectionId intersection, const TrafficSignals &signals);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get an intersection's presence detectors.
+    ///
+    ///  The reference stays valid for the simulator's lifetime.
+    ///
+    ///  @param intersection Intersection to query
+    ///  @return const VehicleSensors& One detector per lane
+    ////////////////////////////////////////////////////////////
+    inline const VehicleSensors& sensors(IntersectionId intersection) const
+    {
+        return sensors_[intersection];
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the simulated clock
+    ///
+    ///  @return const Clock&
+    ////////////////////////////////////////////////////////////
+    inline const Clock& clock() const
+    {
+        return clock_;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Advance the simulation by whole seconds.
+    ///
+    ///  @param delta Seconds to advance
+    ////////////////////////////////////////////////////////////
+    void advance(Clock::Time delta);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the number of vehicles on the network
+    ///
+    ///  @return std::size_t Vehicles on approach roads
+    ////////////////////////////////////////////////////////////
+    inline std::size_t vehicleCount() const
+    {
+        return position_.size();
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the number of vehicles on a lane's approach
+    ///
+    ///  @param intersection Intersection to query
+    ///  @param lane Lane to query
+    ///  @return std::uint32_t Vehicles on the approach
+    ////////////////////////////////////////////////////////////
+    inline std::uint32_t vehiclesOn(IntersectionId intersection, Lane lane) const
+    {
+        return roadCount_[roadOf(intersection, lane)];
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the number of stopped or crawling vehicles
+    ///  on a lane's approach
+    ///
+    ///  @param intersection Intersection to query
+    ///  @param lane Lane to query
+    ///  @return std::uint32_t Vehicles below 2 m/s
+    ////////////////////////////////////////////////////////////
+    std::uint32_t queueLength(IntersectionId intersection, Lane lane) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the vehicle counters
+    ///
+    ///  @return const MicroStats& The counters
+    ////////////////////////////////////////////////////////////
+    inline const MicroStats& stats() const
+    {
+        return stats_;
+    }
+
+private:
+    /// Road index of an intersection's lane
+    static inline std::uint32_t roadOf(IntersectionId intersection, Lane lane)
+    {
+        return intersection * Lane::COUNT + lane;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Advance every vehicle by one substep.
+    ///
+    ////////////////////////////////////////////////////////////
+    void substep();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Find what the front vehicle of each road sees
+    ///  ahead: the stop line, or open road.
+    ///
+    ////////////////////////////////////////////////////////////
+    void updateObstacles();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Move vehicles across stop lines, spawn arrivals
+    ///  and rebuild the sorted arrays.
+    ///
+    ////////////////////////////////////////////////////////////
+    void compact();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Draw a uniform number in [0, 1)
+    ///
+    ///  @return float The number
+    ////////////////////////////////////////////////////////////
+    float uniform();
+
+    IdmParameters parameters_;   ///< driver and vehicle parameters
+    float approachLength_;       ///< stop line position on every road (m)
+    float detectorStart_;        ///< detectors cover [detectorStart_, approachLength_]
+    float dt_;                   ///< substep length (s)
+    unsigned substepsPerSecond_; ///< substeps per Clock second
+    std::uint64_t rng_;          ///< xorshift state of the arrival process
+    Clock clock_;                ///< simulation clock
+    MicroStats stats_;           ///< counters
+
+    /// Per intersection
+    std::vector<TrafficSignals> signals_; ///< signal of each lane
+    std::vector<VehicleSensors> sensors_; ///< detectors sampled by #advance()
+
+    /// Per road, indexed by roadOf()
+    std::vector<float> arrivalProbability_;  ///< outside arrivals per substep
+    std::vector<std::uint32_t> waiting_;     ///< outside arrivals not yet on the road
+    std::vector<std::int32_t> downstream_;   ///< road fed by the stop line, -1 for none
+    std::vector<std::uint32_t> roadBegin_;   ///< first vehicle of the road
+    std::vector<std::uint32_t> roadCount_;   ///< vehicles on the road
+    std::vector<float> obstaclePosition_;    ///< leader position the front vehicle sees
+    std::vector<float> obstacleSpeed_;       ///< leader speed the front vehicle sees
+    std::vector<std::uint8_t> occupied_;     ///< detector latched since last sample
+    std::vector<std::vector<float>> inbox_;  ///< (position, speed) pairs of vehicles crossing in
+
+    /// Per vehicle, sorted by road then front to back
+    std::vector<float> position_;       ///< distance from the start of the road (m)
+    std::vector<float> speed_;          ///< speed (m/s)
+    std::vector<std::uint32_t> road_;   ///< road the vehicle is on
+    std::vector<float> leaderPosition_; ///< position of what is ahead (m)
+    std::vector<float> leaderSpeed_;    ///< speed of what is ahead (m/s)
+    std::vector<float> acceleration_;   ///< IDM acceleration this substep (m/s^2)
+
+    /// Scratch for #compact(), swapped with the arrays above
+    std::vector<float> nextPosition_;
+    std::vector<float> nextSpeed_;
+    std::vector<std::uint32_t> nextRoad_;
+};
+
+#endif // INCLUDE_MICROSIMULATOR_H_
@@ -0,0 +1,237 @@
+#ifndef INCLUDE_NETWORKSIMULATOR_H_
+#define INCLUDE_NETWORKSIMULATOR_H_
+
+#include "interfaces/simulator/ISimulator.hpp"
+
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/simulator/simulator.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief A directed road joining an exit lane of one
+///  intersection to an approach lane of another.
+///
+////////////////////////////////////////////////////////////
+struct NetworkLink
+{
+    IntersectionId from;    ///< upstream intersection
+    Lane fromLane;          ///< lane whose GREEN discharges onto this link
+    IntersectionId to;      ///< downstream intersection
+    Lane toLane;            ///< lane the vehicles queue in downstream
+    Clock::Time travelTime; ///< time to traverse the link
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Vehicle counters summed over every intersection.
+///
+////////////////////////////////////////////////////////////
+struct NetworkStats
+{
+    std::uint64_t vehiclesDischarged;   ///< vehicles that crossed on GREEN
+    std::uint64_t vehiclesDelivered;    ///< vehicles that reached a downstream queue
+    std::uint64_t crossPartitionVehicles; ///< deliveries that crossed a thread boundary
+    std::uint64_t queuedVehicleTime;    ///< sum of queue lengths times time step
+    std::uint64_t windows;              ///< synchronization windows executed
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Simulates a road network of signalled
+///  intersections, each run by its own
+///  TrafficLightControllerApp.
+///
+///     Every intersection keeps a vehicle queue per lane. A
+///     lane's sensor is SET while its queue is non-empty or
+///     its boundary demand scenario says a car is present.
+///     Each time step a GREEN lane with a car discharges one
+///     vehicle onto the lane's outgoing link, and it joins the
+///     downstream queue after the link's travel time.
+///
+///     Intersections are partitioned into spatially
+///     contiguous groups, one per thread. Partitions advance
+///     in lock-step windows no longer than the shortest link
+///     crossing a partition boundary (the lookahead), so a
+///     vehicle sent across a boundary can never arrive inside
+///     the window it was sent in. This conservative scheme
+///     needs only one barrier per window and gives results
+///     that do not depend on the number of partitions.
+///
+////////////////////////////////////////////////////////////
+class NetworkSimulator : public ISimulator
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new NetworkSimulator object
+    ///
+    ///  Links shorter than one time step are treated as one
+    ///  time step long. Each lane may have at most one
+    ///  outgoing link; later duplicates are ignored.
+    ///
+    ///  @param numIntersections Number of intersections
+    ///  @param links Roads joining the intersections
+    ///  @param numPartitions Number of threads to run on
+    ///  @param timeStep Time advanced per controller tick
+    ///  @param maxWaitTime Max wait time passed to each controller
+    ////////////////////////////////////////////////////////////
+    NetworkSimulator(std::size_t numIntersections,
+                     const std::vector<NetworkLink> &links,
+                     unsigned numPartitions,
+                     Clock::Time timeStep,
+                     IClock::Time maxWaitTime);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Set the vehicles arriving at an intersection
+    ///  from outside the network.
+    ///
+    ///  @param intersection Intersection to feed
+    ///  @param scenario Sensor states replayed as external demand
+    ////////////////////////////////////////////////////////////
+    void setBoundaryDemand(IntersectionId intersection, const Scenario &scenario);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Advance every intersection by duration.
+    ///
+    ///  @param duration Time to simulate, rounded up to whole steps
+    ////////////////////////////////////////////////////////////
+    void run(Clock::Time duration);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the network simulation time
+    ///
+    ///  @return Clock::Time The time right now
+    ////////////////////////////////////////////////////////////
+    inline Clock::Time now() const
+    {
+        return partitions_.front()->clock.now();
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the signals an intersection is showing
+    ///
+    ///  @param intersection Intersection to query
+    ///  @return const TrafficSignals& The intersection's signals
+    ////////////////////////////////////////////////////////////
+    inline const TrafficSignals& signals(IntersectionId intersection) const
+    {
+        return nodes_[intersection]->controller.getSignals();
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the number of vehicles queued in a lane
+    ///
+    ///  @param intersection Intersection to query
+    ///  @param lane Lane to query
+    ///  @return std::uint32_t Queued vehicles
+    ////////////////////////////////////////////////////////////
+    inline std::uint32_t queueLength(IntersectionId intersection, Lane lane) const
+    {
+        return nodes_[intersection]->queue[lane];
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the partition that owns an intersection
+    ///
+    ///  @param intersection Intersection to query
+    ///  @return unsigned The owning partition
+    ////////////////////////////////////////////////////////////
+    inline unsigned partitionOf(IntersectionId intersection) const
+    {
+        return partitionOf_[intersection];
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the length of a synchronization window
+    ///
+    ///  @return Clock::Time Window length, a multiple of the time step
+    ////////////////////////////////////////////////////////////
+    inline Clock::Time window() const
+    {
+        return window_;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the vehicle counters summed over all partitions
+    ///
+    ///  @return NetworkStats The counters
+    ////////////////////////////////////////////////////////////
+    NetworkStats stats() const;
+
+private:
+    /// A vehicle in transit on a link.
+    struct VehicleArrival
+    {
+        Clock::Time time;       ///< time it joins the downstream queue
+        IntersectionId to;      ///< downstream intersection
+        Lane lane;              ///< downstream lane
+    };
+
+    /// Orders the pending arrivals earliest first.
+    struct ArrivesLater
+    {
+        bool operator()(const VehicleArrival &a, const VehicleArrival &b) const
+        {
+            return a.time > b.time;
+        }
+    };
+
+    /// A thread's share of the network.
+    struct Partition
+    {
+        Clock clock; ///< shared by every controller in the partition
+        std::vector<IntersectionId> intersections; ///< owned intersections
+        std::priority_queue<VehicleArrival, std::vector<VehicleArrival>, ArrivesLater> pending; ///< arrivals not yet due
+        std::vector<std::vector<VehicleArrival>> outbox[2]; ///< [window parity][destination partition]
+        NetworkStats stats; ///< counters for owned intersections
+    };
+
+    /// One intersection and its controller.
+    struct Node
+    {
+        Node(const Clock &clock, IClock::Time maxWaitTime);
+
+        VehicleSensors sensors;                        ///< sensors read by the controller
+        std::array<std::uint32_t, Lane::COUNT> queue;  ///< vehicles waiting per lane
+        std::array<std::int32_t, Lane::COUNT> link;    ///< outgoing link per lane, -1 for none
+        Scenario boundary;                             ///< external demand
+        std::size_t boundaryCursor;                    ///< current slice in boundary
+        TrafficLightControllerApp controller;          ///< the intersection's controller
+    };
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Assign intersections to partitions in
+    ///  breadth-first order, so neighbours share a partition.
+    ///
+    ///  @param numPartitions Number of partitions to make
+    ////////////////////////////////////////////////////////////
+    void makePartitions(unsigned numPartitions);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Run one partition through windows until end.
+    ///
+    ///  @param index Partition to run
+    ///  @param firstWindow Index of the first window to run
+    ///  @param end Time to stop at
+    ////////////////////////////////////////////////////////////
+    void runPartition(unsigned index, std::uint64_t firstWindow, Clock::Time end);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Advance one partition by a single time step.
+    ///
+    ///  @param partition Partition to advance
+    ///  @param parity Parity of the current window
+    ////////////////////////////////////////////////////////////
+    void tick(Partition &partition, unsigned parity);
+
+    Clock::Time timeStep_;                          ///< time per controller tick
+    Clock::Time window_;                            ///< synchronization window length
+    std::uint64_t windowIndex_;                     ///< windows executed so far
+    std::vector<NetworkLink> links_;                ///< all links, step-clamped
+    std::vector<unsigned> partitionOf_;             ///< owning partition per intersection
+    std::vector<std::unique_ptr<Partition>> partitions_; ///< one per thread
+    std::vector<std::unique_ptr<Node>> nodes_;      ///< one per intersection
+};
+
+#endif // INCLUDE_NETWORKSIMULATOR_H_
@@ -0,0 +1,29 @@
+#ifndef INCLUDE_SCENARIOS_H_
+#define INCLUDE_SCENARIOS_H_
+
+#include "impl/simulator/simulator.hpp"
+
+/// At T+0, non-stop traffic in all directions. continues for 5 minutes
+extern const Scenario SCENARIO_1;
+
+/// at T+0, there is  N-W and S-E traffic
+/// at T+10, an infinite line of vehicles pulls up to the N-N sensor
+/// at T+20, all N-W and S-E traffic stops
+extern const Scenario SCENARIO_2;
+
+/// SCENARIO_1, then SCENARIO_2 starting at T+300
+extern const Scenario SCENARIO_3;
+
+/// SCENARIO_3, then non-stop traffic in all directions from T+600
+extern const Scenario SCENARIO_4;
+
+////////////////////////////////////////////////////////////
+///  @brief Build a day of traffic with morning and evening
+///  peaks, changing every few seconds to a minute.
+///
+///  @param seed Seed of the random traffic
+///  @return Scenario 86400 seconds of sensor states
+////////////////////////////////////////////////////////////
+Scenario makeDayScenario(unsigned seed);
+
+#endif // INCLUDE_SCENARIOS_H_
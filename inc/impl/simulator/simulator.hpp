@@ -6,6 +6,7 @@
 #include "impl/clock/clock.hpp"
 
 #include <array>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
@@ -39,7 +40,7 @@ enum class SensorState
 /// There is one vehicle sensor per lane
 using VehicleSensors = std::array<SensorState, Lane::COUNT>;
 
-enum class SignalState
+enum class SignalState : std::uint8_t
 {
     RED,
     YELLOW,
@@ -49,6 +50,9 @@ enum class SignalState
 /// There is one traffic signal per lane
 using TrafficSignals = std::array<SignalState, Lane::COUNT>;
 
+/// Index of an intersection within a multi-intersection simulator
+using IntersectionId = std::uint32_t;
+
 /// Describes the simulator state for the timespan [start, end).
 struct SimulationTimeslice
 {
@@ -69,6 +73,17 @@ struct SimulationTimeslice
 ////////////////////////////////////////////////////////////
 using Scenario = std::vector<SimulationTimeslice>;
 
+////////////////////////////////////////////////////////////
+///  @brief Print one line of simulator output: the time and
+///  the signal of each lane, as a Simulator prints itself.
+///
+///  @param os Stream to print to
+///  @param now Time of the line
+///  @param signals Signal of each lane
+///  @return std::ostream& The stream
+////////////////////////////////////////////////////////////
+std::ostream& printSignals(std::ostream &os, Clock::Time now, const TrafficSignals &signals);
+
 ////////////////////////////////////////////////////////////
 ///  @brief A simulator replays data from a given scenario.
 ///
@@ -87,6 +102,7 @@ class Simulator : public ISimulator
 public:
     Simulator(const Scenario &scenario) : 
         scenario_(scenario),
+        slice_(0),
         done_(false)
     { 
         for (unsigned lane = 0; lane < Lane::COUNT; ++lane)
@@ -127,6 +143,18 @@ public:
         return sensors_;
     }
 
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the end of the timeslice the sensors were read from.
+    ///
+    ///  The sensors hold their current state until this time at least.
+    ///  
+    ///  @return Clock::Time End of the current timeslice, exclusive
+    ////////////////////////////////////////////////////////////
+    inline Clock::Time sliceEnd(void) const
+    {
+        return done_ ? clock_.now() : scenario_[slice_].end;
+    }
+
     ////////////////////////////////////////////////////////////
     ///  @brief Users should call this to update the traffic lights in the simulated intersection
     ///  
@@ -163,17 +191,34 @@ public:
         update_simulation();
     }
 
+    ////////////////////////////////////////////////////////////
+    ///  @brief Jump the simulation to a time, forwards or back.
+    ///
+    ///  The sensors are read for that time as if the scenario
+    ///  had been replayed up to it.
+    ///
+    ///  @param time Time to jump to
+    ////////////////////////////////////////////////////////////
+    inline void seek(Clock::Time time)
+    {
+        clock_.set(time);
+        done_ = false;
+        update_simulation();
+    }
+
 private:
     ////////////////////////////////////////////////////////////
     ///  @brief Updates the simulator state.
     ///
     ///  The simulation state is read from the loaded scenario for the current
-    ///  timestamp.
+    ///  timestamp. The search resumes from the last timeslice read, since time
+    ///  only moves forward through a scenario's ordered timeslices.
     ///  
     ////////////////////////////////////////////////////////////
     void update_simulation(void);
 
     const Scenario scenario_; ///< copy of loaded scenario
+    std::size_t slice_;       ///< index of the timeslice last read
     Clock clock_;             ///< global simulation clock
     bool done_;               ///< true iff scenario completed
     VehicleSensors sensors_;  ///< sensor state for given timestamp
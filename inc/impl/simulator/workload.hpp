@@ -0,0 +1,157 @@
+#ifndef INCLUDE_WORKLOAD_H_
+#define INCLUDE_WORKLOAD_H_
+
+#include "interfaces/simulator/ISensorFeed.hpp"
+
+#include "impl/simulator/simulator.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Shape of a generated Workload
+///
+////////////////////////////////////////////////////////////
+struct WorkloadConfig
+{
+    std::uint32_t numIntersections; ///< intersections generated
+    unsigned seed;                  ///< same seed, same traffic
+    float baseRate;                 ///< through-lane arrivals off peak (veh/s)
+    float peakRate;                 ///< through-lane arrivals added at a peak (veh/s)
+    float morningPeak;              ///< hour of the morning peak
+    float eveningPeak;              ///< hour of the evening peak
+    float peakWidth;                ///< standard deviation of each peak (hours)
+    float turnShare;                ///< turning lane demand relative to through
+    float peakShift;                ///< largest shift of an intersection's peaks (hours)
+    Clock::Time occupancyTime;      ///< seconds an arrival holds its detector SET, 1 to 4
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Get a WorkloadConfig of a city day: peaks at 8:00
+///  and 17:30 of up to 900 veh/h per through lane, about 110
+///  veh/h off peak.
+///
+///  @param numIntersections Intersections to generate
+///  @return WorkloadConfig The default shape
+////////////////////////////////////////////////////////////
+WorkloadConfig defaultWorkloadConfig(std::uint32_t numIntersections);
+
+////////////////////////////////////////////////////////////
+///  @brief Reproducible detector traffic for any number of
+///  intersections over a day, generated as it is read.
+///
+///     Demand follows a rush-hour curve with a morning and an
+///     evening peak. Each intersection draws its own volume,
+///     a shift of its peaks and which street is the arterial;
+///     the morning peak loads the northbound and eastbound
+///     lanes, the evening peak the southbound and westbound.
+///
+///     Arrivals are drawn per lane and second by hashing the
+///     seed, intersection, lane and time, and each holds its
+///     detector SET for occupancyTime seconds. A read is
+///     therefore a pure function of its arguments: any thread
+///     may read any intersection at any time in any order and
+///     sees the same traffic, and nothing is stored per tick.
+///     The demand curve repeats every 24 hours.
+///
+////////////////////////////////////////////////////////////
+class Workload : public ISensorFeed
+{
+public:
+    /// Seconds in the generated day
+    static constexpr Clock::Time DAY = 24 * 3600;
+
+    /// Seconds per step of the demand curve
+    static constexpr Clock::Time CURVE_STEP = 60;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new Workload object
+    ///
+    ///  Precomputes the demand curve and each intersection's
+    ///  draw, a few bytes per intersection.
+    ///
+    ///  @param config Shape of the traffic
+    ////////////////////////////////////////////////////////////
+    explicit Workload(const WorkloadConfig &config);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the sensors of one intersection at a time.
+    ///
+    ///  @param intersection Intersection to read, below
+    ///  numIntersections
+    ///  @param now Time to read it at
+    ///  @return std::uint8_t One bit per SET Lane
+    ////////////////////////////////////////////////////////////
+    std::uint8_t sensorMask(std::uint32_t intersection, IClock::Time now) const override;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the sensors of one intersection at a time.
+    ///
+    ///  @param intersection Intersection to read
+    ///  @param now Time to read it at
+    ///  @param sensors Sensors to write
+    ////////////////////////////////////////////////////////////
+    void sensors(std::uint32_t intersection, IClock::Time now, VehicleSensors &sensors) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the arrival rate of one lane at a time.
+    ///
+    ///  @param intersection Intersection to read
+    ///  @param lane Lane to read
+    ///  @param now Time to read it at
+    ///  @return float Vehicles per second
+    ////////////////////////////////////////////////////////////
+    float arrivalRate(std::uint32_t intersection, Lane lane, IClock::Time now) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the shape of the traffic
+    ///
+    ///  @return const WorkloadConfig& The settings
+    ////////////////////////////////////////////////////////////
+    inline const WorkloadConfig& config() const
+    {
+        return config_;
+    }
+
+private:
+    /// Arrival chances are 16-bit fractions of a second
+    static constexpr std::uint32_t CHANCE_ONE = 1u << 16;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief One intersection's draw
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Intersection
+    {
+        std::uint16_t scale;        ///< volume, 256 as the curve's
+        std::int16_t shift;         ///< curve steps its peaks come early or late
+        std::uint8_t arterial;      ///< 1 when east-west is the major street
+    };
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the per-second arrival chance of each lane
+    ///
+    ///  @param intersection Intersection to read
+    ///  @param now Time to read it at
+    ///  @param chances Chances to write, of CHANCE_ONE
+    ////////////////////////////////////////////////////////////
+    void chances(std::uint32_t intersection, IClock::Time now, std::array<std::uint32_t, Lane::COUNT> &chances) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the lanes with an arrival in one second
+    ///
+    ///  @param intersection Intersection to read
+    ///  @param second Second of the arrivals
+    ///  @param chances Arrival chance of each lane
+    ///  @return std::uint8_t One bit per lane with an arrival
+    ////////////////////////////////////////////////////////////
+    std::uint8_t arrivals(std::uint32_t intersection, IClock::Time second,
+                          const std::array<std::uint32_t, Lane::COUNT> &chances) const;
+
+    WorkloadConfig config_;                   ///< settings
+    std::vector<Intersection> intersections_; ///< each intersection's draw
+    std::vector<std::array<std::uint16_t, 2>> curve_; ///< inbound and outbound chance per curve step
+};
+
+#endif // INCLUDE_WORKLOAD_H_
@@ -0,0 +1,93 @@
+#ifndef INCLUDE_SCHEDULESOLVER_H_
+#define INCLUDE_SCHEDULESOLVER_H_
+
+#include "impl/config/timingConfig.hpp"
+#include "impl/replay/replay.hpp"
+
+#include <cstdint>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Work done by one ScheduleSolver::solve()
+///
+////////////////////////////////////////////////////////////
+struct SolverStats
+{
+    std::uint64_t steps;          ///< time steps solved
+    std::uint64_t statesExpanded; ///< reachable states carried to the next step
+    std::uint64_t statesPruned;   ///< reachable states dropped as dominated
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Offline solver for the pattern schedule with the
+///  least total wait over a whole scenario.
+///
+///     The solver sees the entire scenario up front, so its
+///     schedule is an oracle: no controller reacting to
+///     sensors can wait less under the same rules. Those are
+///     the controller's rules: the cycle starts in
+///     NorthSouthTurning, patterns follow PATTERN_TRANSITIONS
+///     order, and a pattern may end once it has been active
+///     for its minActiveTime and must end at maxActiveTime
+///     unless no other lane was waiting on the last step, when
+///     it may rest. The controller decides to rest on a flag
+///     it only refreshes when a car is seen on the pattern's own
+///     lanes, so on busy scenarios it can rest longer than
+///     these rules allow; #isFeasible() reports that.
+///
+///     It is a forward dynamic program over (time step, active
+///     pattern, steps the pattern has been active). Each step
+///     keeps the least wait to reach every state, which is
+///     the memo, plus a back-pointer for each pattern start.
+///     States past minActiveTime are pruned when a younger
+///     state of the same pattern is at least as cheap, since
+///     the younger one can do everything the older one can.
+///
+////////////////////////////////////////////////////////////
+class ScheduleSolver
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new ScheduleSolver object
+    ///
+    ///  @param timing Active time limits of each pattern
+    ///  @param timeStep Schedule resolution
+    ////////////////////////////////////////////////////////////
+    ScheduleSolver(const TimingConfig &timing, Clock::Time timeStep);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Find the schedule with the least total wait.
+    ///
+    ///  @param timeline Sensors at each step
+    ///  @param stats Optional counters of the work done
+    ///  @return PatternSchedule Pattern at each step
+    ////////////////////////////////////////////////////////////
+    PatternSchedule solve(const SensorTimeline &timeline, SolverStats *stats = nullptr) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Find the schedule with the least total wait.
+    ///
+    ///  @param scenario Scenario to solve
+    ///  @param stats Optional counters of the work done
+    ///  @return PatternSchedule Pattern at each step
+    ////////////////////////////////////////////////////////////
+    PatternSchedule solve(const Scenario &scenario, SolverStats *stats = nullptr) const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Check a schedule keeps to the timing rules.
+    ///
+    ///  @param schedule Schedule to check
+    ///  @param timeline Sensors at each step
+    ///  @return true If every pattern runs in cycle order for
+    ///  between its min and max active time, or rests past max
+    ///  only while no other lane was waiting on the last step
+    ////////////////////////////////////////////////////////////
+    bool isFeasible(const PatternSchedule &schedule, const SensorTimeline &timeline) const;
+
+private:
+    Clock::Time timeStep_;                                 ///< schedule resolution
+    std::array<std::uint32_t, NUM_PATTERNS> minSteps_;     ///< steps before a pattern may end
+    std::array<std::uint32_t, NUM_PATTERNS> maxSteps_;     ///< steps at which a pattern must end
+};
+
+#endif // INCLUDE_SCHEDULESOLVER_H_
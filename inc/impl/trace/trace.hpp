@@ -0,0 +1,193 @@
+#ifndef INCLUDE_TRACE_H_
+#define INCLUDE_TRACE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+////////////////////////////////////////////////////////////
+///  @brief Read the CPU cycle counter.
+///
+///  Uses rdtsc on x86. Other targets fall back to the
+///  steady clock in nanoseconds, which the exporter treats
+///  the same way since it calibrates ticks against it.
+///
+///  @return std::uint64_t Current tick count
+////////////////////////////////////////////////////////////
+inline std::uint64_t readCycleCounter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+////////////////////////////////////////////////////////////
+///  @brief One completed span, in raw cycle counter ticks.
+///
+////////////////////////////////////////////////////////////
+struct TraceEvent
+{
+    const char *name;    ///< static string naming the span
+    std::uint64_t begin; ///< tick count at span entry
+    std::uint64_t end;   ///< tick count at span exit
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Fixed capacity span buffer owned by one thread.
+///
+///  Only the owning thread writes to the buffer, so recording
+///  a span is a plain store with no synchronization. Once the
+///  buffer is full further spans are counted and dropped.
+///
+////////////////////////////////////////////////////////////
+class TraceBuffer
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new TraceBuffer object
+    ///
+    ///  @param threadId Id reported as "tid" in the export
+    ///  @param capacity Max number of spans kept
+    ////////////////////////////////////////////////////////////
+    TraceBuffer(std::uint32_t threadId, std::size_t capacity);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Record a completed span.
+    ///
+    ///  @param name Static string naming the span
+    ///  @param begin Tick count at span entry
+    ///  @param end Tick count at span exit
+    ////////////////////////////////////////////////////////////
+    inline void record(const char *name, std::uint64_t begin, std::uint64_t end)
+    {
+        if (count_ < events_.size())
+        {
+            events_[count_++] = TraceEvent{name, begin, end};
+        }
+        else
+        {
+            dropped_++;
+        }
+    }
+
+    std::uint32_t threadId() const { return threadId_; }
+    std::size_t count() const { return count_; }
+    std::size_t dropped() const { return dropped_; }
+    const TraceEvent& event(std::size_t index) const { return events_[index]; }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Forget all recorded spans, keeping the storage.
+    ///
+    ////////////////////////////////////////////////////////////
+    void clear();
+
+private:
+    std::uint32_t threadId_;         ///< id reported in the export
+    std::vector<TraceEvent> events_; ///< preallocated span storage
+    std::size_t count_;              ///< number of spans recorded
+    std::size_t dropped_;            ///< spans lost to a full buffer
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Registry of all per-thread TraceBuffers and the
+///  Chrome trace_event exporter.
+///
+///  Buffers are created the first time a thread records a
+///  span (or calls #registerThread()) and live until #reset(),
+///  so spans from finished worker threads are still exported.
+///
+////////////////////////////////////////////////////////////
+class Tracer
+{
+public:
+    /// Spans kept per thread before dropping
+    static constexpr std::size_t BUFFER_CAPACITY = 1 << 16;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the calling thread's buffer, creating it on
+    ///  first use.
+    ///
+    ///  @return TraceBuffer& The calling thread's buffer
+    ////////////////////////////////////////////////////////////
+    static inline TraceBuffer& threadBuffer()
+    {
+        TraceBuffer *buffer = threadBuffer_;
+        return buffer ? *buffer : registerThread();
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Create the calling thread's buffer up front so
+    ///  the first span does not pay for the allocation.
+    ///
+    ///  @param name Optional thread name shown by the viewer
+    ///  @return TraceBuffer& The calling thread's buffer
+    ////////////////////////////////////////////////////////////
+    static TraceBuffer& registerThread(const char *name = nullptr);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Write every recorded span as Chrome trace_event
+    ///  JSON, loadable in Perfetto or chrome://tracing.
+    ///
+    ///  Must not race with threads still recording spans.
+    ///
+    ///  @param os Stream to write the JSON to
+    ////////////////////////////////////////////////////////////
+    static void writeChromeTrace(std::ostream &os);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Clear the spans of every registered thread.
+    ///
+    ////////////////////////////////////////////////////////////
+    static void reset();
+
+private:
+    static thread_local TraceBuffer *threadBuffer_; ///< calling thread's buffer
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Scoped span, recorded into the thread's buffer
+///  when it goes out of scope.
+///
+////////////////////////////////////////////////////////////
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name) :
+        name_(name),
+        begin_(readCycleCounter())
+    { }
+
+    ~TraceSpan()
+    {
+        Tracer::threadBuffer().record(name_, begin_, readCycleCounter());
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char *name_;    ///< static string naming the span
+    std::uint64_t begin_; ///< tick count at span entry
+};
+
+/// Spans are compiled in only when built with -Denable_tracing=ON
+#if defined(TLC_TRACE_ENABLED)
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#endif
+
+#endif // INCLUDE_TRACE_H_
@@ -0,0 +1,65 @@
+#ifndef INCLUDE_BARRIER_H_
+#define INCLUDE_BARRIER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+////////////////////////////////////////////////////////////
+///  @brief Reusable spinning barrier for a fixed number of
+///  threads.
+///
+///  Threads spin briefly and then yield, which keeps the
+///  wake-up latency low for the short, frequent rendezvous
+///  of lock-step simulation windows.
+///
+////////////////////////////////////////////////////////////
+class Barrier
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new Barrier object
+    ///
+    ///  @param numThreads Threads that must arrive each round
+    ////////////////////////////////////////////////////////////
+    explicit Barrier(std::size_t numThreads) :
+        numThreads_(numThreads),
+        waiting_(0),
+        generation_(0)
+    { }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Block until all threads have arrived.
+    ///
+    ///  The last thread to arrive releases the others. Memory
+    ///  written before the call is visible to every thread
+    ///  after it returns.
+    ///
+    ////////////////////////////////////////////////////////////
+    void wait()
+    {
+        std::size_t generation = generation_.load(std::memory_order_acquire);
+
+        if (waiting_.fetch_add(1, std::memory_order_acq_rel) + 1 == numThreads_)
+        {
+            waiting_.store(0, std::memory_order_relaxed);
+            generation_.fetch_add(1, std::memory_order_acq_rel);
+            return;
+        }
+
+        for (unsigned spins = 0; generation_.load(std::memory_order_acquire) == generation; spins++)
+        {
+            if (spins > 1024)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    const std::size_t numThreads_;         ///< threads per round
+    std::atomic<std::size_t> waiting_;     ///< threads arrived this round
+    std::atomic<std::size_t> generation_;  ///< completed rounds
+};
+
+#endif // INCLUDE_BARRIER_H_
@@ -0,0 +1,192 @@
+#ifndef INCLUDE_DEADLINEHEAP_H_
+#define INCLUDE_DEADLINEHEAP_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+////////////////////////////////////////////////////////////
+///  @brief Indexed binary min-heap of up to N items, each
+///  known by an index below N and ordered by a key.
+///
+///     The smallest key is read in O(1); setting or removing
+///     an item's key is O(log N) and never allocates. Equal
+///     keys are ordered by index, so the top depends only on
+///     the items held and not on the order they came in.
+///
+////////////////////////////////////////////////////////////
+template <typename Key, std::size_t N>
+class DeadlineHeap
+{
+public:
+    /// Position of an item not in the heap
+    static constexpr std::uint8_t ABSENT = 0xFF;
+
+    static_assert(N < ABSENT, "DeadlineHeap positions are kept in a byte");
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct an empty DeadlineHeap
+    ///
+    ////////////////////////////////////////////////////////////
+    DeadlineHeap()
+    {
+        clear();
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Remove every item.
+    ///
+    ////////////////////////////////////////////////////////////
+    inline void clear()
+    {
+        size_ = 0;
+        position_.fill(ABSENT);
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Add an item, or move it if already held.
+    ///
+    ///  @param index Item, below N
+    ///  @param key Its key
+    ////////////////////////////////////////////////////////////
+    void set(std::size_t index, Key key)
+    {
+        keys_[index] = key;
+        if (position_[index] == ABSENT)
+        {
+            position_[index] = static_cast<std::uint8_t>(size_);
+            heap_[size_++] = static_cast<std::uint8_t>(index);
+        }
+        siftUp(position_[index]);
+        siftDown(position_[index]);
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Remove an item; one not held is ignored.
+    ///
+    ///  @param index Item, below N
+    ////////////////////////////////////////////////////////////
+    void erase(std::size_t index)
+    {
+        std::size_t at = position_[index];
+        if (at == ABSENT)
+        {
+            return;
+        }
+
+        position_[index] = ABSENT;
+        if (at != --size_)
+        {
+            std::uint8_t moved = heap_[size_];
+            place(at, moved);
+            siftUp(at);
+            siftDown(position_[moved]);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Check whether an item is held
+    ///
+    ///  @param index Item, below N
+    ///  @return true If the item is in the heap
+    ////////////////////////////////////////////////////////////
+    inline bool contains(std::size_t index) const
+    {
+        return position_[index] != ABSENT;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Check whether no item is held
+    ///
+    ///  @return true If the heap is empty
+    ////////////////////////////////////////////////////////////
+    inline bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the item with the smallest key
+    ///
+    ///  @return std::size_t The item; only valid when not empty
+    ////////////////////////////////////////////////////////////
+    inline std::size_t top() const
+    {
+        return heap_[0];
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the smallest key
+    ///
+    ///  @return Key The key of #top(); only valid when not empty
+    ////////////////////////////////////////////////////////////
+    inline Key topKey() const
+    {
+        return keys_[heap_[0]];
+    }
+
+private:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Check whether one item orders before another
+    ///
+    ////////////////////////////////////////////////////////////
+    inline bool before(std::size_t a, std::size_t b) const
+    {
+        return keys_[a] < keys_[b] || (keys_[a] == keys_[b] && a < b);
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Put an item at a heap position
+    ///
+    ////////////////////////////////////////////////////////////
+    inline void place(std::size_t at, std::uint8_t index)
+    {
+        heap_[at] = index;
+        position_[index] = static_cast<std::uint8_t>(at);
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Move the item at a position up to its place
+    ///
+    ////////////////////////////////////////////////////////////
+    void siftUp(std::size_t at)
+    {
+        std::uint8_t index = heap_[at];
+        while (at > 0 && before(index, heap_[(at - 1) / 2]))
+        {
+            place(at, heap_[(at - 1) / 2]);
+            at = (at - 1) / 2;
+        }
+        place(at, index);
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Move the item at a position down to its place
+    ///
+    ////////////////////////////////////////////////////////////
+    void siftDown(std::size_t at)
+    {
+        std::uint8_t index = heap_[at];
+        for (std::size_t child = 2 * at + 1; child < size_; child = 2 * at + 1)
+        {
+            child += child + 1 < size_ && before(heap_[child + 1], heap_[child]) ? 1 : 0;
+            if (!before(heap_[child], index))
+            {
+                break;
+            }
+            place(at, heap_[child]);
+            at = child;
+        }
+        place(at, index);
+    }
+
+    std::size_t size_;                    ///< items held
+    std::array<Key, N> keys_;             ///< key of each item, by index
+    std::array<std::uint8_t, N> heap_;    ///< items in heap order
+    std::array<std::uint8_t, N> position_; ///< heap position of each item, ABSENT when not held
+};
+
+template <typename Key, std::size_t N>
+constexpr std::uint8_t DeadlineHeap<Key, N>::ABSENT;
+
+#endif // INCLUDE_DEADLINEHEAP_H_
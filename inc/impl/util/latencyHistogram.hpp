@@ -0,0 +1,172 @@
+#ifndef INCLUDE_LATENCYHISTOGRAM_H_
+#define INCLUDE_LATENCYHISTOGRAM_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+////////////////////////////////////////////////////////////
+///  @brief Log-linear histogram of latencies in nanoseconds.
+///
+///     Each power of two is split into SUB_BUCKETS linear
+///     buckets, so any recorded value is reported within
+///     1/SUB_BUCKETS of its true size. Recording is a few
+///     shifts and one relaxed increment, and never allocates.
+///
+///     One thread records; any thread may read while it does
+///     and sees a slightly stale but consistent-enough view.
+///
+////////////////////////////////////////////////////////////
+class LatencyHistogram
+{
+public:
+    /// Linear buckets per power of two
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr unsigned SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+
+    /// Powers of two covered, enough for about 18 minutes
+    static constexpr unsigned MAGNITUDES = 40;
+
+    static constexpr std::size_t NUM_BUCKETS = (MAGNITUDES - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct an empty LatencyHistogram
+    ///
+    ////////////////////////////////////////////////////////////
+    LatencyHistogram()
+    {
+        reset();
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Record one latency.
+    ///
+    ///  @param nanoseconds The latency
+    ////////////////////////////////////////////////////////////
+    inline void record(std::uint64_t nanoseconds)
+    {
+        std::atomic<std::uint64_t> &bucket = buckets_[bucketOf(nanoseconds)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (nanoseconds > max_.load(std::memory_order_relaxed))
+        {
+            max_.store(nanoseconds, std::memory_order_relaxed);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the number of latencies recorded
+    ///
+    ///  @return std::uint64_t Recorded latencies
+    ////////////////////////////////////////////////////////////
+    inline std::uint64_t count() const
+    {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the largest latency recorded
+    ///
+    ///  @return std::uint64_t Max latency in nanoseconds
+    ////////////////////////////////////////////////////////////
+    inline std::uint64_t max() const
+    {
+        return max_.load(std::memory_order_relaxed);
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the latency at or below which a fraction of
+    ///  the recorded latencies fall.
+    ///
+    ///  @param fraction Fraction in [0, 1], e.g. 0.99 for p99
+    ///  @return std::uint64_t Upper bound of the bucket holding
+    ///  that latency, 0 when nothing is recorded
+    ////////////////////////////////////////////////////////////
+    std::uint64_t percentile(double fraction) const
+    {
+        std::uint64_t total = count();
+        if (total == 0)
+        {
+            return 0;
+        }
+
+        std::uint64_t rank = static_cast<std::uint64_t>(fraction * static_cast<double>(total - 1)) + 1;
+        std::uint64_t seen = 0;
+
+        for (std::size_t bucket = 0; bucket < NUM_BUCKETS; bucket++)
+        {
+            seen += buckets_[bucket].load(std::memory_order_relaxed);
+            if (seen >= rank)
+            {
+                std::uint64_t upper = upperBoundOf(bucket);
+                return upper < max() ? upper : max();
+            }
+        }
+        return max();
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Forget every recorded latency.
+    ///
+    ///  Only call while nothing is recording.
+    ////////////////////////////////////////////////////////////
+    void reset()
+    {
+        for (auto &bucket : buckets_)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Find the bucket of a latency
+    ///
+    ///  @param value Latency in nanoseconds
+    ///  @return std::size_t Bucket index
+    ////////////////////////////////////////////////////////////
+    static inline std::size_t bucketOf(std::uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+        {
+            return static_cast<std::size_t>(value);
+        }
+
+        unsigned magnitude = 63u - static_cast<unsigned>(__builtin_clzll(value));
+        if (magnitude >= MAGNITUDES)
+        {
+            return NUM_BUCKETS - 1;
+        }
+
+        unsigned shift = magnitude - SUB_BUCKET_BITS;
+        std::size_t sub = static_cast<std::size_t>((value >> shift) & (SUB_BUCKETS - 1));
+        return (shift + 1) * SUB_BUCKETS + sub;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Find the largest latency held by a bucket
+    ///
+    ///  @param bucket Bucket index
+    ///  @return std::uint64_t Largest latency in nanoseconds
+    ////////////////////////////////////////////////////////////
+    static inline std::uint64_t upperBoundOf(std::size_t bucket)
+    {
+        if (bucket < SUB_BUCKETS)
+        {
+            return bucket;
+        }
+
+        unsigned shift = static_cast<unsigned>(bucket / SUB_BUCKETS) - 1;
+        std::uint64_t sub = bucket % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+    }
+
+    std::atomic<std::uint64_t> buckets_[NUM_BUCKETS]; ///< latencies per bucket
+    std::atomic<std::uint64_t> count_;                ///< latencies recorded
+    std::atomic<std::uint64_t> max_;                  ///< largest latency
+};
+
+#endif // INCLUDE_LATENCYHISTOGRAM_H_
@@ -0,0 +1,135 @@
+#ifndef INCLUDE_SPSCQUEUE_H_
+#define INCLUDE_SPSCQUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+////////////////////////////////////////////////////////////
+///  @brief Bounded lock-free queue between one producer
+///  thread and one consumer thread.
+///
+///     Each side owns one index and only reads the other's,
+///     keeping a cached copy so it touches the other side's
+///     cache line only when the queue looks full or empty.
+///     Items are copied into a fixed ring, so pushing and
+///     popping never allocate. The blocking calls spin briefly
+///     and then yield, like Barrier.
+///
+////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+class SpscQueue
+{
+public:
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct an empty SpscQueue
+    ///
+    ////////////////////////////////////////////////////////////
+    SpscQueue() :
+        head_(0),
+        tailSeen_(0),
+        tail_(0),
+        headSeen_(0)
+    { }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Add an item if there is room; producer only.
+    ///
+    ///  @param item The item to add
+    ///  @return true If the item was added
+    ////////////////////////////////////////////////////////////
+    bool tryPush(const T &item)
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headSeen_ == N)
+        {
+            headSeen_ = head_.load(std::memory_order_acquire);
+            if (tail - headSeen_ == N)
+            {
+                return false;
+            }
+        }
+
+        slots_[tail & (N - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Take the oldest item if there is one; consumer
+    ///  only.
+    ///
+    ///  @param item Set to the item taken
+    ///  @return true If an item was taken
+    ////////////////////////////////////////////////////////////
+    bool tryPop(T &item)
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailSeen_)
+        {
+            tailSeen_ = tail_.load(std::memory_order_acquire);
+            if (head == tailSeen_)
+            {
+                return false;
+            }
+        }
+
+        item = slots_[head & (N - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Add an item, waiting for room; producer only.
+    ///
+    ///  @param item The item to add
+    ///  @return unsigned Times the queue was found full
+    ////////////////////////////////////////////////////////////
+    unsigned push(const T &item)
+    {
+        unsigned spins = 0;
+        for (; !tryPush(item); spins++)
+        {
+            if (spins > 1024)
+            {
+                std::this_thread::yield();
+            }
+        }
+        return spins;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Take the oldest item, waiting for one; consumer
+    ///  only.
+    ///
+    ///  @param item Set to the item taken
+    ///  @return unsigned Times the queue was found empty
+    ////////////////////////////////////////////////////////////
+    unsigned pop(T &item)
+    {
+        unsigned spins = 0;
+        for (; !tryPop(item); spins++)
+        {
+            if (spins > 1024)
+            {
+                std::this_thread::yield();
+            }
+        }
+        return spins;
+    }
+
+private:
+    alignas(64) std::atomic<std::size_t> head_; ///< items popped, written by the consumer
+    std::size_t tailSeen_;                      ///< consumer's last read of tail_
+    alignas(64) std::atomic<std::size_t> tail_; ///< items pushed, written by the producer
+    std::size_t headSeen_;                      ///< producer's last read of head_
+    alignas(64) std::array<T, N> slots_;        ///< ring of items, by count modulo N
+};
+
+#endif // INCLUDE_SPSCQUEUE_H_
@@ -0,0 +1,227 @@
+#ifndef INCLUDE_WORKERPOOL_H_
+#define INCLUDE_WORKERPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Fixed set of threads that run the indices of one
+///  job at a time, with the calling thread joining in.
+///
+///     The threads are started once, so handing out a job
+///     never allocates. Workers spin briefly after a job and
+///     then sleep, which keeps the wake-up latency low for
+///     back-to-back jobs without burning a core between
+///     controller ticks.
+///
+////////////////////////////////////////////////////////////
+class WorkerPool
+{
+public:
+    /// A job: called once for every index
+    using Job = void (*)(void *context, std::size_t index);
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct a new WorkerPool object
+    ///
+    ///  @param numWorkers Threads besides the caller, 0 to run
+    ///  every job on the calling thread
+    ////////////////////////////////////////////////////////////
+    explicit WorkerPool(unsigned numWorkers) :
+        job_(nullptr),
+        context_(nullptr),
+        count_(0),
+        next_(0),
+        finished_(0),
+        generation_(0),
+        busy_(0),
+        stopping_(false),
+        mutex_(),
+        wake_(),
+        threads_()
+    {
+        for (unsigned worker = 0; worker < numWorkers; worker++)
+        {
+            threads_.emplace_back([this]() { work(); });
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Stop and join the threads
+    ///
+    ////////////////////////////////////////////////////////////
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_.store(true, std::memory_order_release);
+            generation_.fetch_add(1, std::memory_order_acq_rel);
+        }
+        wake_.notify_all();
+
+        for (std::thread &thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the number of threads that run a job
+    ///
+    ///  @return unsigned Workers plus the caller
+    ////////////////////////////////////////////////////////////
+    inline unsigned size() const
+    {
+        return static_cast<unsigned>(threads_.size()) + 1;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Call a job for every index in [0, count) and
+    ///  return once all calls have finished.
+    ///
+    ///  Only one thread may hand out jobs.
+    ///
+    ///  @param count Number of indices
+    ///  @param job Function to call
+    ///  @param context Passed to every call
+    ////////////////////////////////////////////////////////////
+    void run(std::size_t count, Job job, void *context)
+    {
+        if (threads_.empty() || count <= 1)
+        {
+            for (std::size_t index = 0; index < count; index++)
+            {
+                job(context, index);
+            }
+            return;
+        }
+
+        /// Publish only once no worker still holds the last
+        /// job, so nobody claims an index of this one with it.
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (busy_.load(std::memory_order_acquire) == 0)
+            {
+                job_ = job;
+                context_ = context;
+                count_ = count;
+                finished_.store(0, std::memory_order_relaxed);
+                next_.store(0, std::memory_order_relaxed);
+                generation_.fetch_add(1, std::memory_order_acq_rel);
+                break;
+            }
+            lock.unlock();
+            std::this_thread::yield();
+        }
+        wake_.notify_all();
+
+        finished_.fetch_add(drain(job, context, count), std::memory_order_acq_rel);
+
+        for (unsigned spins = 0; finished_.load(std::memory_order_acquire) < count; spins++)
+        {
+            if (spins > 1024)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Call a callable for every index in [0, count)
+    ///
+    ///  @param count Number of indices
+    ///  @param function Callable taking a std::size_t
+    ////////////////////////////////////////////////////////////
+    template <typename Function>
+    void run(std::size_t count, Function &function)
+    {
+        run(count, [](void *context, std::size_t index) { (*static_cast<Function*>(context))(index); },
+            &function);
+    }
+
+private:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Claim and run indices until none are left.
+    ///
+    ///  @param job Job to run
+    ///  @param context Passed to every call
+    ///  @param count Indices of the job
+    ///  @return std::size_t Indices this thread ran
+    ////////////////////////////////////////////////////////////
+    std::size_t drain(Job job, void *context, std::size_t count)
+    {
+        std::size_t ran = 0;
+        for (std::size_t index = next_.fetch_add(1, std::memory_order_relaxed); index < count;
+             index = next_.fetch_add(1, std::memory_order_relaxed))
+        {
+            job(context, index);
+            ran++;
+        }
+        return ran;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Worker loop: wait for a generation, drain it.
+    ///
+    ////////////////////////////////////////////////////////////
+    void work()
+    {
+        std::size_t seen = 0;
+
+        for (;;)
+        {
+            for (unsigned spins = 0; generation_.load(std::memory_order_acquire) == seen; spins++)
+            {
+                if (spins > 1024)
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    wake_.wait(lock, [this, seen]() {
+                        return generation_.load(std::memory_order_acquire) != seen;
+                    });
+                }
+            }
+
+            Job job;
+            void *context;
+            std::size_t count;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                seen = generation_.load(std::memory_order_acquire);
+                if (stopping_.load(std::memory_order_acquire))
+                {
+                    return;
+                }
+
+                job = job_;
+                context = context_;
+                count = count_;
+                busy_.fetch_add(1, std::memory_order_acq_rel);
+            }
+
+            finished_.fetch_add(drain(job, context, count), std::memory_order_acq_rel);
+            busy_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    Job job_;                             ///< job being run
+    void *context_;                       ///< context of job_
+    std::size_t count_;                   ///< indices of job_
+    std::atomic<std::size_t> next_;       ///< next index to claim
+    std::atomic<std::size_t> finished_;   ///< indices run to completion
+    std::atomic<std::size_t> generation_; ///< jobs handed out
+    std::atomic<unsigned> busy_;          ///< workers holding a job
+    std::atomic<bool> stopping_;          ///< set once to end the workers
+    std::mutex mutex_;                    ///< guards publishing a job
+    std::condition_variable wake_;        ///< sleeping workers wait here
+    std::vector<std::thread> threads_;    ///< the workers
+};
+
+#endif // INCLUDE_WORKERPOOL_H_
@@ -0,0 +1,49 @@
+#ifndef INCLUDE_IDECISIONPOLICY_H_
+#define INCLUDE_IDECISIONPOLICY_H_
+
+struct ControllerSnapshot;
+
+////////////////////////////////////////////////////////////
+///  @brief What a policy wants the controller to do this tick
+///
+////////////////////////////////////////////////////////////
+enum class Decision
+{
+    HOLD,        ///< keep the active pattern GREEN
+    ADVANCE,     ///< go to the next pattern in the cycle
+    FOLLOW_RULES ///< let the controller's own rules decide
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Interface Decision Policy Class
+///
+///     A policy chooses when the active pattern ends. The
+///     controller still enforces each pattern's min and max
+///     active time, so a policy cannot break the timing plan.
+///     One exception: past max, a HOLD rests the pattern in
+///     GREEN while no car waits at a RED, and the pattern
+///     ends on the first tick one does.
+///
+////////////////////////////////////////////////////////////
+class IDecisionPolicy
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Destroy the IDecisionPolicy object
+    ///
+    ////////////////////////////////////////////////////////////
+    virtual ~IDecisionPolicy() = default;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Decide the active pattern for this tick.
+    ///
+    ///  Called once per controller tick, before the sensors
+    ///  are processed.
+    ///
+    ///  @param state The controller's state this tick
+    ///  @return Decision What the controller should do
+    ////////////////////////////////////////////////////////////
+    virtual Decision decide(const ControllerSnapshot &state) = 0;
+};
+
+#endif // INCLUDE_IDECISIONPOLICY_H_
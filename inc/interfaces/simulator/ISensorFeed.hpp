@@ -0,0 +1,30 @@
+#ifndef INCLUDE_ISENSORFEED_H_
+#define INCLUDE_ISENSORFEED_H_
+
+#include "interfaces/clock/IClock.hpp"
+
+#include <cstdint>
+
+class ISensorFeed
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Destroy the ISensorFeed object
+    ///
+    ////////////////////////////////////////////////////////////
+    virtual ~ISensorFeed() = default;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the sensors of one intersection at a time.
+    ///
+    ///  Called from several threads at once, each for its own
+    ///  intersections, so it must not change shared state.
+    ///
+    ///  @param intersection Intersection to read
+    ///  @param now Time to read it at
+    ///  @return std::uint8_t One bit per SET Lane
+    ////////////////////////////////////////////////////////////
+    virtual std::uint8_t sensorMask(std::uint32_t intersection, IClock::Time now) const = 0;
+};
+
+#endif // INCLUDE_ISENSORFEED_H_
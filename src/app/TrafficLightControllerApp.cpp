@@ -1,42 +1,77 @@
 #include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/trace/trace.hpp"
 
 #include <iostream>
 #include <utility>
 
+constexpr IClock::Time TrafficLightControllerApp::PREEMPTION_YELLOW_TIME;
+constexpr IClock::Time TrafficLightControllerApp::PREEMPTION_RED_TIME;
+constexpr unsigned TrafficLightControllerApp::DEADLINE_LEAD_TICKS;
+
 TrafficLightControllerApp::TrafficLightControllerApp
 (
     const Clock &clockRef,
     const VehicleSensors &sensorsRef,
-    IClock::Time maxWaitTime
+    IClock::Time maxWaitTime,
+    std::ostream *log
 )
     : clock_(clockRef),
       sensors_(sensorsRef),
+      log_(log),
       signals_(),
       appState_(false),
       carsAwaiting_(false),
+      waitingLanes_(0),
+      skipUncalled_(false),
+      enforceMaxWait_(false),
+      deadlines_(),
+      activePattern_(previousPattern(TrafficLightPattern::NorthSouthTurning)),
       maxWaitTime_(maxWaitTime),
+      config_(nullptr),
+      configReader_(0),
+      policy_(nullptr),
+      table_(nullptr),
+      estimator_(nullptr),
+      defaultTiming_(defaultTimingConfig()),
+      preemptPattern_(TrafficLightPattern::NUM_PATTERNS),
+      preemptYellow_(false),
+      preemptReleased_(false),
+      preemptRedAt_(0),
+      preemptGreenAt_(0),
+      lastRunTime_(0),
+      tickLength_(1),
       lightStates_(),
-      vehicleStates_(),
-      laneToOpposingLaneMap_(),
-      patternToLaneMap_()
+      vehicleStates_()
 {
-    std::cout << "Constructed TrafficLightControllerApp." << std::endl;
+    defaultTiming_.maxWaitTime = maxWaitTime_;
+
+    if (log_)
+    {
+        *log_ << "Constructed TrafficLightControllerApp." << std::endl;
+    }
 }
 
 void TrafficLightControllerApp::initApp()
 {
-    makePatternToLaneMap();
-    makeOpposingLanesMap();
     populateLightStates();
     populateVehicleStates();
+    preemptPattern_ = TrafficLightPattern::NUM_PATTERNS;
+    preemptYellow_ = false;
+    preemptReleased_ = false;
+    lastRunTime_ = clock_.now();
 
     /// Start the controller in the NorthSouthTurning Pattern
-    /// as specified by the requirements.
-    enableNorthSouthTurning(lightStates_[TrafficLightPattern::NorthSouthTurning]);
+    /// as specified by the requirements, coming from the
+    /// pattern that precedes it in the cycle.
+    activePattern_ = previousPattern(TrafficLightPattern::NorthSouthTurning);
+    updateCycle(lightStates_[TrafficLightPattern::NorthSouthTurning]);
 
     appState_ = true;
 
-    std::cout << "Initialized TrafficLightControllerApp." << std::endl;
+    if (log_)
+    {
+        *log_ << "Initialized TrafficLightControllerApp." << std::endl;
+    }
 }
 
 void TrafficLightControllerApp::run()
@@ -45,21 +80,388 @@ void TrafficLightControllerApp::run()
     /// Ideally, this appState_ memeber would be eliminated
     /// with the use of an ApplicationManagerApp.
     if (appState_)
+    {
+        IClock::Time now = clock_.now();
+        if (now > lastRunTime_)
+        {
+            tickLength_ = now - lastRunTime_;
+        }
+        lastRunTime_ = now;
+
+        if (estimator_)
+        {
+            LaneMask sensors = 0;
+            LaneMask green = 0;
+            for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+            {
+                sensors |= sensors_[lane] == SensorState::SET ? laneBit(lane) : 0;
+                green |= signals_[lane] == SignalState::GREEN ? laneBit(lane) : 0;
+            }
+            estimator_->update(clock_.now(), sensors, green);
+            applyTiming(estimator_->adapt(config_ ? config_->read() : defaultTiming_));
+        }
+        else if (config_)
+        {
+            applyTiming(config_->read());
+        }
+
+        if (isPreempted())
+        {
+            stepPreemption();
+            processVehicleSensors();
+        }
+        else if (serveOverdue())
+        {
+            processVehicleSensors();
+        }
+        else if (policy_)
+        {
+            selectPattern();
+            processVehicleSensors();
+        }
+        else if (usesTable())
+        {
+            lookupTransition();
+        }
+        else
+        {
+            checkCycleState();
+            processVehicleSensors();
+        }
+
+        if (config_)
+        {
+            config_->quiescent(configReader_);
+        }
+    }
+}
+
+void TrafficLightControllerApp::attachEstimator(DemandEstimator *estimator)
+{
+    estimator_ = estimator;
+    if (!estimator_ && !config_)
+    {
+        applyTiming(defaultTiming_);
+    }
+}
+
+void TrafficLightControllerApp::attachConfig(ConfigManager &config, ConfigManager::ReaderId reader)
+{
+    if (reader < ConfigManager::MAX_READERS)
+    {
+        config_ = &config;
+        configReader_ = reader;
+    }
+}
+
+ControllerSnapshot TrafficLightControllerApp::snapshot() const
+{
+    ControllerSnapshot state;
+    state.now = clock_.now();
+    state.activePattern = activePattern_;
+    state.carsAwaiting = carsAwaiting_;
+    state.maxWaitTime = maxWaitTime_;
+    state.signals = signals_;
+    state.sensors = sensors_;
+    state.lightStates = lightStates_;
+    state.vehicleStates = vehicleStates_;
+    state.preemptPattern = preemptPattern_;
+    state.preemptYellow = preemptYellow_;
+    state.preemptReleased = preemptReleased_;
+    state.preemptRedAt = preemptRedAt_;
+    state.preemptGreenAt = preemptGreenAt_;
+    state.tickLength = tickLength_;
+
+    TrafficLightState &active = state.lightStates[activePattern_];
+    active.activeTime = clock_.elapsed(active.startTime);
+
+    return state;
+}
+
+void TrafficLightControllerApp::restore(const ControllerSnapshot &state)
+{
+    activePattern_ = state.activePattern;
+    carsAwaiting_ = state.carsAwaiting;
+    maxWaitTime_ = state.maxWaitTime;
+    defaultTiming_.maxWaitTime = maxWaitTime_;
+    signals_ = state.signals;
+    lightStates_ = state.lightStates;
+    vehicleStates_ = state.vehicleStates;
+    waitingLanes_ = 0;
+    deadlines_.clear();
+    for (const VehicleState &vehicleState : vehicleStates_)
+    {
+        waitingLanes_ |= vehicleState.isWaiting ? laneBit(vehicleState.lane) : 0;
+        if (vehicleState.isWaiting)
+        {
+            deadlines_.set(vehicleState.lane, vehicleState.arrivalTime);
+        }
+    }
+    preemptPattern_ = state.preemptPattern;
+    preemptYellow_ = state.preemptYellow;
+    preemptReleased_ = state.preemptReleased;
+    preemptRedAt_ = state.preemptRedAt;
+    preemptGreenAt_ = state.preemptGreenAt;
+    lastRunTime_ = state.now;
+    tickLength_ = state.tickLength;
+    appState_ = true;
+}
+
+void TrafficLightControllerApp::preempt(TrafficLightPattern pattern)
+{
+    if (pattern >= TrafficLightPattern::NUM_PATTERNS)
+    {
+        return;
+    }
+
+    if (log_)
+    {
+        *log_ << "Preempted for " << lightPatternToString(pattern) << "." << std::endl;
+    }
+
+    bool clearing = isClearingForPreemption();
+    preemptPattern_ = pattern;
+    preemptReleased_ = false;
+
+    TrafficLightState &target = lightStates_[pattern];
+    if (target.isOn)
+    {
+        return;
+    }
+
+    if (clearing)
+    {
+        /// Already YELLOW or RED everywhere: the new pattern
+        /// waits out the same clearance.
+        return;
+    }
+
+    /// Lanes leaving GREEN go YELLOW; the rest already show
+    /// RED, since the active pattern greens only its own.
+    disablePattern(lightStates_[activePattern_]);
+    for (SignalState &signal : signals_)
+    {
+        signal = signal == SignalState::GREEN ? SignalState::YELLOW : SignalState::RED;
+    }
+    preemptYellow_ = true;
+
+    IClock::Time now = clock_.now();
+    preemptRedAt_ = now + PREEMPTION_YELLOW_TIME;
+    preemptGreenAt_ = preemptRedAt_ + PREEMPTION_RED_TIME;
+}
+
+void TrafficLightControllerApp::releasePreemption()
+{
+    if (!isPreempted())
+    {
+        return;
+    }
+
+    if (log_)
+    {
+        *log_ << "Released preemption of " << lightPatternToString(preemptPattern_) << "." << std::endl;
+    }
+
+    if (isClearingForPreemption())
+    {
+        preemptReleased_ = true;
+        return;
+    }
+    preemptPattern_ = TrafficLightPattern::NUM_PATTERNS;
+}
+
+void TrafficLightControllerApp::stepPreemption()
+{
+    TRACE_SCOPE("stepPreemption");
+
+    TrafficLightState &target = lightStates_[preemptPattern_];
+    IClock::Time now = clock_.now();
+
+    /// Each step takes its own run(), so the all-RED is shown
+    /// for at least one tick however far the clock jumps.
+    if (preemptYellow_)
+    {
+        if (now >= preemptRedAt_)
+        {
+            signals_.fill(SignalState::RED);
+            preemptYellow_ = false;
+        }
+    }
+    else if (!target.isOn && now >= preemptGreenAt_)
+    {
+        updateCycle(target);
+    }
+
+    if (target.isOn && preemptReleased_)
+    {
+        preemptPattern_ = TrafficLightPattern::NUM_PATTERNS;
+        preemptReleased_ = false;
+    }
+}
+
+void TrafficLightControllerApp::selectPattern()
+{
+    TRACE_SCOPE("selectPattern");
+
+    Decision decision = policy_->decide(snapshot());
+    if (decision == Decision::FOLLOW_RULES)
     {
         checkCycleState();
+        return;
+    }
+
+    TrafficLightState &active = lightStates_[activePattern_];
+    active.activeTime = clock_.elapsed(active.startTime);
 
-        processVehicleSensors();
+    if (active.activeTime < active.minActiveTime)
+    {
+        return;
+    }
+
+    bool mustEnd = active.activeTime >= active.maxActiveTime && carsAwaiting_;
+    if (mustEnd || decision == Decision::ADVANCE)
+    {
+        nextPattern(activePattern_);
     }
 }
 
+bool TrafficLightControllerApp::serveOverdue()
+{
+    /// Every waiting vehicle has the same max wait, so the
+    /// earliest arrival is the earliest deadline. Serve it on
+    /// the last tick from which DEADLINE_LEAD_TICKS more still
+    /// end by the deadline.
+    IClock::Time lead = static_cast<IClock::Time>(DEADLINE_LEAD_TICKS + 1) * tickLength_;
+    if (!enforceMaxWait_ || deadlines_.empty() ||
+        clock_.now() + lead <= deadlines_.topKey() + maxWaitTime_)
+    {
+        return false;
+    }
+
+    Lane lane = static_cast<Lane>(deadlines_.top());
+    TrafficLightPattern pattern = CALL_TABLE.next[activePattern_][CALL_TABLE.calls[laneBit(lane)]];
+    if (lightStates_[pattern].isOn)
+    {
+        return false;
+    }
+
+    if (log_)
+    {
+        *log_ << "Car in lane (" << laneToString(lane) << ") reached the max wait time." << std::endl;
+    }
+
+    updateCycle(lightStates_[pattern]);
+    return true;
+}
+
+bool TrafficLightControllerApp::usesTable() const
+{
+    if (!table_ || log_ || skipUncalled_)
+    {
+        return false;
+    }
+
+    for (const TrafficLightState &lightState : lightStates_)
+    {
+        if (lightState.minActiveTime <= 0 || lightState.maxActiveTime <= 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TrafficLightControllerApp::lookupTransition()
+{
+    TRACE_SCOPE("lookupTransition");
+
+    TrafficLightState &active = lightStates_[activePattern_];
+    IClock::Time elapsed = clock_.elapsed(active.startTime);
+
+    LaneMask sensors = 0;
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        sensors |= sensors_[lane] == SensorState::SET ? laneBit(lane) : 0;
+    }
+
+    std::uint8_t clear = 0;
+    for (unsigned pattern = 0; pattern < TrafficLightPattern::NUM_PATTERNS; pattern++)
+    {
+        clear |= static_cast<std::uint8_t>(lightStates_[pattern].areOpposingLanesClear << pattern);
+    }
+
+    std::uint8_t entry = table_->at(TransitionTable::index(activePattern_,
+                                                           elapsed >= active.minActiveTime,
+                                                           elapsed >= active.maxActiveTime,
+                                                           carsAwaiting_, clear, sensors));
+
+    if (entry & TransitionTable::RESTARTED)
+    {
+        updateCycle(lightStates_[entry & TransitionTable::PATTERN_MASK]);
+    }
+
+    for (unsigned pattern = 0; pattern < TrafficLightPattern::NUM_PATTERNS; pattern++)
+    {
+        lightStates_[pattern].areOpposingLanesClear = (entry >> (TransitionTable::CLEAR_SHIFT + pattern)) & 1u;
+    }
+    carsAwaiting_ = (entry & TransitionTable::CARS_AWAITING) != 0;
+
+    /// Vehicles at a red light start or keep waiting, as in
+    /// processVehicleSensors(); every other lane is reset.
+    /// Selects rather than branches, since lanes change often.
+    LaneMask waiting = sensors & PATTERN_TRANSITIONS[activePattern_].redLanes;
+    IClock::Time now = clock_.now();
+    for (VehicleState &vehicleState : vehicleStates_)
+    {
+        bool waits = (waiting & laneBit(vehicleState.lane)) != 0;
+        bool arrives = waits && !vehicleState.isWaiting;
+
+        IClock::Time arrivalTime = arrives ? now : vehicleState.arrivalTime;
+        IClock::Time waitTime = arrives ? vehicleState.waitTime : clock_.elapsed(arrivalTime);
+
+        vehicleState.isWaiting = waits;
+        vehicleState.arrivalTime = waits ? arrivalTime : 0;
+        vehicleState.waitTime = waits ? waitTime : 0;
+    }
+
+    /// Deadlines change only where a vehicle starts or stops
+    /// waiting.
+    for (LaneMask started = static_cast<LaneMask>(waiting & ~waitingLanes_); started; started &= started - 1)
+    {
+        deadlines_.set(static_cast<unsigned>(__builtin_ctz(started)), now);
+    }
+    for (LaneMask ended = static_cast<LaneMask>(waitingLanes_ & ~waiting); ended; ended &= ended - 1)
+    {
+        deadlines_.erase(static_cast<unsigned>(__builtin_ctz(ended)));
+    }
+    waitingLanes_ = waiting;
+}
+
 void TrafficLightControllerApp::checkCycleState()
 {
+    TRACE_SCOPE("checkCycleState");
+
+    /// When skipping, clear opposing lanes only hold a pattern
+    /// while its own lanes have traffic. The flag is not
+    /// refreshed once they empty, and a skipped-to pattern
+    /// would otherwise rest there past calls elsewhere.
+    LaneMask holding = ALL_LANES;
+    if (skipUncalled_)
+    {
+        holding = 0;
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            holding |= sensors_[lane] == SensorState::SET ? laneBit(lane) : 0;
+        }
+    }
+
     for (int currentLight = 0; currentLight < TrafficLightPattern::NUM_PATTERNS; currentLight++)
     {
         TrafficLightState &currentlightState = lightStates_[currentLight];
 
         // Case 1: Light on, lanes clear, do nothing
-        if (currentlightState.isOn && currentlightState.areOpposingLanesClear)
+        if (currentlightState.isOn && currentlightState.areOpposingLanesClear &&
+            (holding & PATTERN_TRANSITIONS[currentLight].greenLanes))
         {
             break;
         }
@@ -103,6 +505,8 @@ void TrafficLightControllerApp::checkCycleState()
 
 void TrafficLightControllerApp::processVehicleSensors()
 {
+    TRACE_SCOPE("processVehicleSensors");
+
     for (int lane = 0; lane < Lane::COUNT; lane++)
     {
         SensorState sensorState = sensors_[lane];
@@ -122,7 +526,7 @@ void TrafficLightControllerApp::processVehicleSensors()
         }
         else
         {
-            vehicleState.isWaiting = false;
+            setWaiting(vehicleState, false);
             vehicleState.arrivalTime = 0;
             vehicleState.waitTime = 0;
         }
@@ -133,19 +537,36 @@ void TrafficLightControllerApp::processVehicleSensors()
 
 void TrafficLightControllerApp::nextPattern(int patternIndex)
 {
-    if (patternIndex == 3)
-    {
-        updateCycle(lightStates_[0]);
-    }
-    else
+    TrafficLightPattern next = skipUncalled_ ? CALL_TABLE.next[patternIndex][getCalls()]
+                                             : PATTERN_TRANSITIONS[patternIndex].next;
+    updateCycle(lightStates_[next]);
+}
+
+void TrafficLightControllerApp::setWaiting(VehicleState &vehicleState, bool isWaiting)
+{
+    if (isWaiting != vehicleState.isWaiting)
     {
-        updateCycle(lightStates_[patternIndex + 1]);
+        if (isWaiting)
+        {
+            deadlines_.set(vehicleState.lane, clock_.now());
+        }
+        else
+        {
+            deadlines_.erase(vehicleState.lane);
+        }
     }
+
+    vehicleState.isWaiting = isWaiting;
+    waitingLanes_ = static_cast<LaneMask>((waitingLanes_ & ~laneBit(vehicleState.lane)) |
+                                          (isWaiting ? laneBit(vehicleState.lane) : 0));
 }
 
 void TrafficLightControllerApp::processVehicleAtRed(VehicleState &vehicleState)
 {
-    std::cout << "Car in lane (" << laneToString(vehicleState.lane) << ") waiting at RED light." <<std::endl;
+    if (log_)
+    {
+        *log_ << "Car in lane (" << laneToString(vehicleState.lane) << ") waiting at RED light." <<std::endl;
+    }
 
     checkOpposingLanes(vehicleState.lane);
     checkWaitTime(vehicleState);
@@ -153,84 +574,26 @@ void TrafficLightControllerApp::processVehicleAtRed(VehicleState &vehicleState)
 
 void TrafficLightControllerApp::processVehicleAtGreen(VehicleState &vehicleState)
 {
-    std::cout << "Car in lane (" << laneToString(vehicleState.lane) << ") proceeding with GRN light."
-        " Impatient driver waited (" << vehicleState.waitTime << "s)." << std::endl;
+    if (log_)
+    {
+        *log_ << "Car in lane (" << laneToString(vehicleState.lane) << ") proceeding with GRN light."
+            " Impatient driver waited (" << vehicleState.waitTime << "s)." << std::endl;
+    }
 
     checkOpposingLanes(vehicleState.lane);
 
-    vehicleState.isWaiting = false;
+    setWaiting(vehicleState, false);
     vehicleState.arrivalTime = 0;
     vehicleState.waitTime = 0;
 }
 
 void TrafficLightControllerApp::updateCycle(TrafficLightState &lightState)
 {
-    switch (lightState.pattern)
-    {
-        case TrafficLightPattern::NorthSouthTurning:
-            enableNorthSouthTurning(lightState);
-            break;
-        
-        case TrafficLightPattern::NorthSouthThrough:
-            enableNorthSouthThrough(lightState);
-            break;
-
-        case TrafficLightPattern::EastWestTurning:
-            enableEastWestTurning(lightState);
-            break;
-
-        case TrafficLightPattern::EastWestThrough:
-            enableEastWestThrough(lightState);
-            break;
-
-        default:
-            std::cout << "Invalid pattern! Check back when you are in a flying car!" << std::endl;
-            break;
-    }
-}
-
-void TrafficLightControllerApp::enableNorthSouthTurning(TrafficLightState &lightState)
-{
-    disablePattern(lightStates_[TrafficLightPattern::EastWestThrough]);
-    setLaneSignal(Lane::E_E, SignalState::RED);
-    setLaneSignal(Lane::W_W, SignalState::RED);
-
-    enablePattern(lightState);
-    setLaneSignal(Lane::N_W, SignalState::GREEN);
-    setLaneSignal(Lane::S_E, SignalState::GREEN);
-}
-
-void TrafficLightControllerApp::enableNorthSouthThrough(TrafficLightState &lightState)
-{
-    disablePattern(lightStates_[TrafficLightPattern::NorthSouthTurning]);
-    setLaneSignal(Lane::N_W, SignalState::RED);
-    setLaneSignal(Lane::S_E, SignalState::RED);
-
-    enablePattern(lightState);
-    setLaneSignal(Lane::N_N, SignalState::GREEN);
-    setLaneSignal(Lane::S_S, SignalState::GREEN);
-}
-
-void TrafficLightControllerApp::enableEastWestTurning(TrafficLightState &lightState)
-{
-    disablePattern(lightStates_[TrafficLightPattern::NorthSouthThrough]);
-    setLaneSignal(Lane::N_N, SignalState::RED);
-    setLaneSignal(Lane::S_S, SignalState::RED);
+    disablePattern(lightStates_[activePattern_]);
 
     enablePattern(lightState);
-    setLaneSignal(Lane::E_N, SignalState::GREEN);
-    setLaneSignal(Lane::W_S, SignalState::GREEN);
-}
-
-void TrafficLightControllerApp::enableEastWestThrough(TrafficLightState &lightState)
-{
-    disablePattern(lightStates_[TrafficLightPattern::EastWestTurning]);
-    setLaneSignal(Lane::E_N, SignalState::RED);
-    setLaneSignal(Lane::W_S, SignalState::RED);
-
-    enablePattern(lightState);
-    setLaneSignal(Lane::E_E, SignalState::GREEN);
-    setLaneSignal(Lane::W_W, SignalState::GREEN);
+    applyTransition(signals_, PATTERN_TRANSITIONS[lightState.pattern]);
+    activePattern_ = lightState.pattern;
 }
 
 void TrafficLightControllerApp::enablePattern(TrafficLightState &lightState)
@@ -239,7 +602,10 @@ void TrafficLightControllerApp::enablePattern(TrafficLightState &lightState)
     lightState.startTime = clock_.now();
     lightState.activeTime = 0;
 
-    std::cout << lightPatternToString(lightState.pattern) << " Enabled." << std::endl;
+    if (log_)
+    {
+        *log_ << lightPatternToString(lightState.pattern) << " Enabled." << std::endl;
+    }
 }
 
 void TrafficLightControllerApp::disablePattern(TrafficLightState &lightState)
@@ -248,18 +614,23 @@ void TrafficLightControllerApp::disablePattern(TrafficLightState &lightState)
     lightState.startTime = 0;
     lightState.activeTime = 0;
 
-    std::cout << lightPatternToString(lightState.pattern) << " Disabled." << std::endl;
+    if (log_)
+    {
+        *log_ << lightPatternToString(lightState.pattern) << " Disabled." << std::endl;
+    }
 }
 
 void TrafficLightControllerApp::checkOpposingLanes(Lane lane)
 {
+    TRACE_SCOPE("checkOpposingLanes");
+
     bool areOpposingLanesClear = true;
 
-    auto opposingLanes = laneToOpposingLaneMap_[lane];
+    LaneMask opposingLanes = OPPOSING_LANES[lane];
     
-    for(auto i : opposingLanes)
+    for (unsigned i = 0; i < Lane::COUNT; i++)
     {
-        if (i != Lane::PLACEHOLDER && sensors_[i] == SensorState::SET)
+        if ((opposingLanes & laneBit(i)) && sensors_[i] == SensorState::SET)
         {
             areOpposingLanesClear = false;
             break;
@@ -271,20 +642,16 @@ void TrafficLightControllerApp::checkOpposingLanes(Lane lane)
 
 void TrafficLightControllerApp::notifyOpposingLanesClear(Lane lane, bool isClear)
 {
-    if (isClear)
+    if (isClear && log_)
     {
-        std::cout << "Opposing lanes are clear for lane (" << laneToString(lane) << ")." << std::endl;
+        *log_ << "Opposing lanes are clear for lane (" << laneToString(lane) << ")." << std::endl;
     }
 
-    for (auto keyPattern : patternToLaneMap_)
+    for (int pattern = 0; pattern < TrafficLightPattern::NUM_PATTERNS; pattern++)
     {
-        auto lanesInPattern = keyPattern.second;
-        for (auto laneInPattern : lanesInPattern)
-        { 
-            if (laneInPattern == lane)
-            {
-                lightStates_[keyPattern.first].areOpposingLanesClear = isClear;
-            }
+        if (PATTERN_TRANSITIONS[pattern].greenLanes & laneBit(lane))
+        {
+            lightStates_[pattern].areOpposingLanesClear = isClear;
         }
     }
 }
@@ -293,7 +660,7 @@ void TrafficLightControllerApp::checkWaitTime(VehicleState &vehicleState)
 {
     if (!vehicleState.isWaiting)
     {
-        vehicleState.isWaiting = true;
+        setWaiting(vehicleState, true);
         vehicleState.arrivalTime = clock_.now();
     }
     else
@@ -304,28 +671,5 @@ void TrafficLightControllerApp::checkWaitTime(VehicleState &vehicleState)
 
 void TrafficLightControllerApp::checkIfCarsAreWaiting()
 {
-    int isWaitingCounter = 0;
-
-    for (auto vs : vehicleStates_)
-    {
-        if (vs.isWaiting)
-        {
-            isWaitingCounter++;
-            break;
-        }
-    }
-
-    if (isWaitingCounter == 0)
-    {
-        carsAwaiting_ = false;
-    }
-    else
-    {
-        carsAwaiting_ = true;
-    }
-}
-
-void TrafficLightControllerApp::setLaneSignal(Lane lane, SignalState state)
-{
-    signals_[lane] = state;
+    carsAwaiting_ = waitingLanes_ != 0;
 }
@@ -1,8 +1,8 @@
 #include "impl/app/TrafficLightControllerApp.hpp"
 
-std::string TrafficLightControllerApp::lightPatternToString(TrafficLightPattern pattern)
+const char* TrafficLightControllerApp::lightPatternToString(TrafficLightPattern pattern)
 {
-    std::string lightPatternString = "";
+    const char *lightPatternString = "";
 
     switch(pattern)
     {
@@ -23,16 +23,19 @@ std::string TrafficLightControllerApp::lightPatternToString(TrafficLightPattern
             break;
 
         default:
-            std::cout << "Not a valid traffic light state." << std::endl;
+            if (log_)
+            {
+                *log_ << "Not a valid traffic light state." << std::endl;
+            }
             break;
     }
 
     return lightPatternString;
 }
 
-std::string TrafficLightControllerApp::laneToString(Lane lane)
+const char* TrafficLightControllerApp::laneToString(Lane lane)
 {
-    std::string laneString = "";
+    const char *laneString = "";
 
     switch(lane)
     {
@@ -69,7 +72,10 @@ std::string TrafficLightControllerApp::laneToString(Lane lane)
             break;
 
         default:
-            std::cout << "Not a valid lane." << std::endl;
+            if (log_)
+            {
+                *log_ << "Not a valid lane." << std::endl;
+            }
             break;
     }
 
@@ -85,21 +91,25 @@ void TrafficLightControllerApp::populateLightStates()
         lightStates_[i].areOpposingLanesClear = false;
         lightStates_[i].startTime = 0;
         lightStates_[i].activeTime = 0;
+
+        /// Defaults from the pattern table, replaced on each run()
+        /// when a ConfigManager is attached.
+        lightStates_[i].minActiveTime = PATTERN_TRANSITIONS[i].minActiveTime;
+        lightStates_[i].maxActiveTime = PATTERN_TRANSITIONS[i].maxActiveTime;
     }
+}
 
-    /// Ideally I would move these min/max values into a config file
-    /// and load them at runtime with a ConfigClass...
-    lightStates_[TrafficLightPattern::NorthSouthTurning].minActiveTime = 10;
-    lightStates_[TrafficLightPattern::NorthSouthTurning].maxActiveTime = 60;
+void TrafficLightControllerApp::applyTiming(const TimingConfig &timing)
+{
+    for (int i = 0; i < TrafficLightPattern::NUM_PATTERNS; i++)
+    {
+        lightStates_[i].minActiveTime = timing.patterns[i].minActiveTime;
+        lightStates_[i].maxActiveTime = timing.patterns[i].maxActiveTime;
+    }
 
-    lightStates_[TrafficLightPattern::NorthSouthThrough].minActiveTime = 30;
-    lightStates_[TrafficLightPattern::NorthSouthThrough].maxActiveTime = 120;
-    
-    lightStates_[TrafficLightPattern::EastWestTurning].minActiveTime = 10;
-    lightStates_[TrafficLightPattern::EastWestTurning].maxActiveTime = 30;
-    
-    lightStates_[TrafficLightPattern::EastWestThrough].minActiveTime = 30;
-    lightStates_[TrafficLightPattern::EastWestThrough].maxActiveTime = 60;
+    maxWaitTime_ = timing.maxWaitTime;
+    skipUncalled_ = timing.skipUncalled;
+    enforceMaxWait_ = timing.enforceMaxWait;
 }
 
 void TrafficLightControllerApp::populateVehicleStates()
@@ -111,142 +121,6 @@ void TrafficLightControllerApp::populateVehicleStates()
         vehicleStates_[i].arrivalTime = 0;
         vehicleStates_[i].waitTime = 0;
     }
-}
-
-void TrafficLightControllerApp::makeOpposingLanesMap()
-{
-    std::array<Lane, Lane::COUNT> northNorthOpposing = { Lane::PLACEHOLDER,
-                                                         Lane::N_W,
-                                                         Lane::PLACEHOLDER,
-                                                         Lane::S_E,
-                                                         Lane::E_E,
-                                                         Lane::E_N,
-                                                         Lane::W_W,
-                                                         Lane::W_S
-                                                    };
-    laneToOpposingLaneMap_.insert(std::pair<Lane, std::array<Lane, Lane::COUNT> >(Lane::N_N, northNorthOpposing));
-
-    std::array<Lane, Lane::COUNT> northWestOpposing = { Lane::N_N,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::S_S,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::E_E,
-                                                        Lane::E_N,
-                                                        Lane::W_W,
-                                                        Lane::W_S
-                                                    };
-    laneToOpposingLaneMap_.insert(std::pair<Lane, std::array<Lane, Lane::COUNT> >(Lane::N_W, northWestOpposing));
-
-    std::array<Lane, Lane::COUNT> southSouthOpposing = { Lane::PLACEHOLDER,
-                                                         Lane::N_W,
-                                                         Lane::PLACEHOLDER,
-                                                         Lane::S_E,
-                                                         Lane::E_E,
-                                                         Lane::E_N,
-                                                         Lane::W_W,
-                                                         Lane::W_S
-                                                    };
-    laneToOpposingLaneMap_.insert(std::pair<Lane, std::array<Lane, Lane::COUNT> >(Lane::S_S, southSouthOpposing));
-
-    std::array<Lane, Lane::COUNT> southEastOpposing = { Lane::N_N,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::S_S,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::E_E,
-                                                        Lane::E_N,
-                                                        Lane::W_W,
-                                                        Lane::W_S
-                                                    };
-    laneToOpposingLaneMap_.insert(std::pair<Lane, std::array<Lane, Lane::COUNT> >(Lane::S_E, southEastOpposing));
-
-    std::array<Lane, Lane::COUNT> eastEastOpposing = { Lane::N_N,
-                                                       Lane::N_W,
-                                                       Lane::S_S,
-                                                       Lane::S_E,
-                                                       Lane::PLACEHOLDER,
-                                                       Lane::E_N,
-                                                       Lane::PLACEHOLDER,
-                                                       Lane::W_S
-                                                    };
-    laneToOpposingLaneMap_.insert(std::pair<Lane, std::array<Lane, Lane::COUNT> >(Lane::E_E, eastEastOpposing));
-
-    std::array<Lane, Lane::COUNT> eastNorthOpposing = { Lane::N_N,
-                                                        Lane::N_W,
-                                                        Lane::S_S,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::E_E,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::W_W,
-                                                        Lane::W_S
-                                                    };
-    laneToOpposingLaneMap_.insert(std::pair<Lane, std::array<Lane, Lane::COUNT> >(Lane::E_N, eastNorthOpposing));
-
-    std::array<Lane, Lane::COUNT> westWestOpposing = { Lane::N_N,
-                                                       Lane::N_W,
-                                                       Lane::S_S,
-                                                       Lane::S_E,
-                                                       Lane::PLACEHOLDER,
-                                                       Lane::E_N,
-                                                       Lane::PLACEHOLDER,
-                                                       Lane::W_S
-                                                    };
-    laneToOpposingLaneMap_.insert(std::pair<Lane, std::array<Lane, Lane::COUNT> >(Lane::W_W, westWestOpposing));
-
-    std::array<Lane, Lane::COUNT> westSouthOpposing = { Lane::N_N,
-                                                        Lane::N_W,
-                                                        Lane::S_S,
-                                                        Lane::S_E,
-                                                        Lane::E_E,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::W_W,
-                                                        Lane::PLACEHOLDER
-                                                    };
-    laneToOpposingLaneMap_.insert(std::pair<Lane, std::array<Lane, Lane::COUNT> >(Lane::W_S, westSouthOpposing));
-}
-
-void TrafficLightControllerApp::makePatternToLaneMap()
-{
-    std::array<Lane, Lane::COUNT> northSouthTurning = { Lane::PLACEHOLDER,
-                                                        Lane::N_W,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::S_E,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::PLACEHOLDER
-                                                    };
-    patternToLaneMap_.insert(std::pair<TrafficLightPattern, std::array<Lane, Lane::COUNT> >(TrafficLightPattern::NorthSouthTurning, northSouthTurning));
-
-    std::array<Lane, Lane::COUNT> northSouthThrough = { Lane::N_N,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::S_S,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::PLACEHOLDER,
-                                                        Lane::PLACEHOLDER
-                                                    };
-    patternToLaneMap_.insert(std::pair<TrafficLightPattern, std::array<Lane, Lane::COUNT> >(TrafficLightPattern::NorthSouthThrough, northSouthThrough));
-
-    std::array<Lane, Lane::COUNT> eastWestTurning = { Lane::PLACEHOLDER,
-                                                      Lane::PLACEHOLDER,
-                                                      Lane::PLACEHOLDER,
-                                                      Lane::PLACEHOLDER,
-                                                      Lane::PLACEHOLDER,
-                                                      Lane::E_N,
-                                                      Lane::PLACEHOLDER,
-                                                      Lane::W_S
-                                                    };
-    patternToLaneMap_.insert(std::pair<TrafficLightPattern, std::array<Lane, Lane::COUNT> >(TrafficLightPattern::EastWestTurning, eastWestTurning));
-
-    std::array<Lane, Lane::COUNT> eastWestThrough = { Lane::PLACEHOLDER,
-                                                      Lane::PLACEHOLDER,
-                                                      Lane::PLACEHOLDER,
-                                                      Lane::PLACEHOLDER,
-                                                      Lane::E_E,
-                                                      Lane::PLACEHOLDER,
-                                                      Lane::W_W,
-                                                      Lane::PLACEHOLDER
-                                                    };
-    patternToLaneMap_.insert(std::pair<TrafficLightPattern, std::array<Lane, Lane::COUNT> >(TrafficLightPattern::EastWestThrough, eastWestThrough));
+    waitingLanes_ = 0;
+    deadlines_.clear();
 }
@@ -0,0 +1,218 @@
+#include "impl/app/demandEstimator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr unsigned DemandEstimator::PROFILE_BINS;
+constexpr unsigned DemandEstimator::RATE_BITS;
+constexpr unsigned DemandEstimator::OCCUPANCY_TICKS;
+
+/// One vehicle per second in the fixed-point rates
+static constexpr float RATE_ONE = static_cast<float>(1u << DemandEstimator::RATE_BITS);
+
+DemandConfig defaultDemandConfig()
+{
+    DemandConfig config;
+    config.features = ALL_FEATURES;
+    config.rateShift = 5;
+    config.profileShift = 2;
+    config.profileBin = 1800;
+    config.saturationFlow = 0.5f;
+    config.lostTime = 3;
+    config.minCycle = 40;
+    config.maxCycle = 180;
+    config.minGreen = 5;
+    return config;
+}
+
+DemandEstimator::DemandEstimator(const DemandConfig &config)
+    : config_(config),
+      last_(0),
+      previous_(0),
+      started_(false),
+      bin_(0),
+      binStart_(0),
+      profiled_(0),
+      seen_(0),
+      rate_(),
+      window_(),
+      binCount_(),
+      profile_(),
+      adapted_(defaultTimingConfig())
+{
+    config_.profileBin = std::max<IClock::Time>(1, config_.profileBin);
+    config_.minGreen = std::max<IClock::Time>(1, config_.minGreen);
+    for (auto &bins : profile_)
+    {
+        bins.fill(0);
+    }
+}
+
+unsigned DemandEstimator::binOf(IClock::Time now) const
+{
+    return static_cast<unsigned>(now / config_.profileBin) % PROFILE_BINS;
+}
+
+void DemandEstimator::update(IClock::Time now, LaneMask sensors, LaneMask green)
+{
+    if (!started_)
+    {
+        last_ = now;
+        bin_ = binOf(now);
+        binStart_ = now;
+        started_ = true;
+    }
+
+    unsigned bin = binOf(now);
+    if (bin != bin_)
+    {
+        closeBin(bin);
+    }
+
+    /// Seconds since the last update, capped so neither the
+    /// EWMA step nor the window shift can overshoot.
+    IClock::Time elapsed = std::min<IClock::Time>(std::max<IClock::Time>(now - last_, 0),
+                                                  IClock::Time(1) << config_.rateShift);
+    unsigned shift = static_cast<unsigned>(std::min<IClock::Time>(elapsed, OCCUPANCY_TICKS));
+    LaneMask rising = static_cast<LaneMask>(sensors & ~previous_);
+
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        std::int64_t arrived = (rising >> lane) & 1u;
+        std::uint64_t set = (sensors >> lane) & 1u;
+
+        rate_[lane] += ((arrived << RATE_BITS) - rate_[lane] * elapsed) >> config_.rateShift;
+
+        /// Only GREEN seconds enter the window. Two half shifts,
+        /// so a shift by all 64 bits is defined.
+        unsigned laneShift = shift & (0u - ((green >> lane) & 1u));
+        std::uint64_t fill = ~((~std::uint64_t(0) << (laneShift >> 1)) << (laneShift - (laneShift >> 1)));
+        std::uint64_t window = (window_[lane] << (laneShift >> 1)) << (laneShift - (laneShift >> 1));
+        window_[lane] = window | (fill & (std::uint64_t(0) - set));
+
+        binCount_[lane] += static_cast<std::uint32_t>(arrived);
+    }
+
+    seen_ |= rising;
+    previous_ = sensors;
+    last_ = now;
+}
+
+void DemandEstimator::closeBin(unsigned bin)
+{
+    /// A bin seen for less than half its length, such as the
+    /// one the estimator started in, is too thin to learn from.
+    IClock::Time elapsed = last_ - binStart_;
+    if (elapsed >= config_.profileBin / 2 && elapsed > 0)
+    {
+        bool known = (profiled_ >> bin_) & 1u;
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            std::int64_t observed = (static_cast<std::int64_t>(binCount_[lane]) << RATE_BITS) / elapsed;
+            std::int64_t learned = profile_[lane][bin_];
+            learned = known ? learned + ((observed - learned) >> config_.profileShift) : observed;
+            profile_[lane][bin_] = static_cast<std::uint32_t>(learned);
+        }
+        profiled_ |= std::uint64_t(1) << bin_;
+    }
+
+    binCount_.fill(0);
+    bin_ = bin;
+    binStart_ = last_;
+}
+
+const TimingConfig& DemandEstimator::adapt(const TimingConfig &bounds)
+{
+    /// The green each pattern had, which its occupancy was
+    /// measured against.
+    std::array<float, NUM_PATTERNS> planned;
+    float lost = static_cast<float>(config_.lostTime * NUM_PATTERNS);
+    float plannedCycle = lost;
+    for (unsigned pattern = 0; pattern < NUM_PATTERNS; pattern++)
+    {
+        planned[pattern] = static_cast<float>(adapted_.patterns[pattern].minActiveTime);
+        plannedCycle += planned[pattern];
+    }
+
+    adapted_ = bounds;
+
+    unsigned features = config_.features;
+    bool profiled = (features & PROFILE) && ((profiled_ >> bin_) & 1u);
+    if (!profiled && !seen_)
+    {
+        return adapted_;
+    }
+
+    /// Flow ratio of each lane: arrivals over what a GREEN
+    /// discharges, or, where higher, the share of its GREEN
+    /// it kept occupied times the share of the cycle it got.
+    std::array<float, Lane::COUNT> ratio;
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        float share = 0.0f;
+        for (unsigned pattern = 0; pattern < NUM_PATTERNS; pattern++)
+        {
+            bool green = (PATTERN_TRANSITIONS[pattern].greenLanes & laneBit(lane)) != 0;
+            share += green ? planned[pattern] / plannedCycle : 0.0f;
+        }
+
+        float rate = (features & ARRIVAL_RATE) ? static_cast<float>(rate_[lane]) / RATE_ONE : 0.0f;
+        float learned = static_cast<float>(profile_[lane][bin_]) / RATE_ONE;
+        rate = profiled ? ((features & ARRIVAL_RATE) ? 0.75f * rate + 0.25f * learned : learned) : rate;
+        ratio[lane] = rate / config_.saturationFlow;
+        float saturated = occupancy(static_cast<Lane>(lane)) * share;
+        ratio[lane] = (features & OCCUPANCY) ? std::max(ratio[lane], saturated) : ratio[lane];
+    }
+
+    std::array<float, NUM_PATTERNS> critical;
+    float total = 0.0f;
+    for (unsigned pattern = 0; pattern < NUM_PATTERNS; pattern++)
+    {
+        float busiest = 0.0f;
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            bool green = (PATTERN_TRANSITIONS[pattern].greenLanes & laneBit(lane)) != 0;
+            busiest = std::max(busiest, green ? ratio[lane] : 0.0f);
+        }
+        critical[pattern] = busiest;
+        total += busiest;
+    }
+
+    if (total <= 0.0f)
+    {
+        return adapted_;
+    }
+
+    /// Webster's cycle, held short of saturation where it
+    /// grows without bound.
+    float cycle = (1.5f * lost + 5.0f) / (1.0f - std::min(total, 0.9f));
+    cycle = std::min(std::max(cycle, static_cast<float>(config_.minCycle)), static_cast<float>(config_.maxCycle));
+    float green = std::max(cycle - lost, 0.0f);
+
+    for (unsigned pattern = 0; pattern < NUM_PATTERNS; pattern++)
+    {
+        PatternTiming &timing = adapted_.patterns[pattern];
+        IClock::Time share = static_cast<IClock::Time>(std::lround(green * critical[pattern] / total));
+        timing.minActiveTime = std::min(std::max(share, timing.minActiveTime),
+                                        std::max(timing.maxActiveTime, config_.minGreen));
+        timing.maxActiveTime = std::max(timing.maxActiveTime, timing.minActiveTime);
+    }
+
+    return adapted_;
+}
+
+float DemandEstimator::arrivalRate(Lane lane) const
+{
+    return static_cast<float>(rate_[lane]) / RATE_ONE;
+}
+
+float DemandEstimator::occupancy(Lane lane) const
+{
+    return static_cast<float>(__builtin_popcountll(window_[lane])) / OCCUPANCY_TICKS;
+}
+
+float DemandEstimator::profileRate(Lane lane, IClock::Time now) const
+{
+    unsigned bin = binOf(now);
+    return ((profiled_ >> bin) & 1u) ? static_cast<float>(profile_[lane][bin]) / RATE_ONE : 0.0f;
+}
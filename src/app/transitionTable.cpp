@@ -0,0 +1,229 @@
+#include "impl/app/transitionTable.hpp"
+#include "impl/app/TrafficLightControllerApp.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+constexpr unsigned TransitionTable::INDEX_BITS;
+constexpr std::size_t TransitionTable::SIZE;
+constexpr std::uint8_t TransitionTable::PATTERN_MASK;
+constexpr std::uint8_t TransitionTable::RESTARTED;
+constexpr std::uint8_t TransitionTable::CARS_AWAITING;
+constexpr unsigned TransitionTable::CLEAR_SHIFT;
+
+/// Clock time every state is built at
+static constexpr IClock::Time NOW = 1000;
+
+////////////////////////////////////////////////////////////
+///  @brief Build a controller state with a given table
+///  index.
+///
+///  Limits of 10 and 20 (20 and 10 for reached-max-only)
+///  with an active time of 5, 15 or 25 give each pair of
+///  reached-min and reached-max.
+///
+///  @param index Table index of the state
+///  @param waiting Lanes whose vehicles are already waiting
+///  @param sensors Set to the state's sensors
+///  @return ControllerSnapshot The state at time NOW
+////////////////////////////////////////////////////////////
+static ControllerSnapshot stateOf(std::uint32_t index, LaneMask waiting, VehicleSensors &sensors)
+{
+    LaneMask sensorMask = static_cast<LaneMask>(index & 0xFF);
+    std::uint8_t clear = static_cast<std::uint8_t>((index >> 8) & 0x0F);
+    bool carsAwaiting = (index >> 12) & 1u;
+    bool atMin = (index >> 13) & 1u;
+    bool atMax = (index >> 14) & 1u;
+    auto active = static_cast<TrafficLightPattern>((index >> 15) & TransitionTable::PATTERN_MASK);
+
+    IClock::Time minActiveTime = atMax && !atMin ? 20 : 10;
+    IClock::Time maxActiveTime = atMax && !atMin ? 10 : 20;
+    IClock::Time elapsed = atMin != atMax ? 15 : atMin ? 25 : 5;
+
+    ControllerSnapshot state;
+    state.now = NOW;
+    state.activePattern = active;
+    state.carsAwaiting = carsAwaiting;
+    state.maxWaitTime = DEFAULT_MAX_WAIT_TIME;
+    state.signals.fill(SignalState::RED);
+    applyTransition(state.signals, PATTERN_TRANSITIONS[active]);
+    state.preemptPattern = TrafficLightPattern::NUM_PATTERNS;
+    state.preemptYellow = false;
+    state.preemptReleased = false;
+    state.preemptRedAt = 0;
+    state.preemptGreenAt = 0;
+    state.tickLength = 1;
+
+    for (unsigned pattern = 0; pattern < TrafficLightPattern::NUM_PATTERNS; pattern++)
+    {
+        TrafficLightState &light = state.lightStates[pattern];
+        light.pattern = static_cast<TrafficLightPattern>(pattern);
+        light.isOn = pattern == active;
+        light.areOpposingLanesClear = (clear >> pattern) & 1u;
+        light.startTime = light.isOn ? NOW - elapsed : 0;
+        light.activeTime = light.isOn ? elapsed : 0;
+        light.minActiveTime = minActiveTime;
+        light.maxActiveTime = maxActiveTime;
+    }
+
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        VehicleState &vehicle = state.vehicleStates[lane];
+        vehicle.lane = static_cast<Lane>(lane);
+        vehicle.isWaiting = (waiting & laneBit(lane)) != 0;
+        vehicle.arrivalTime = vehicle.isWaiting ? NOW - 7 - static_cast<IClock::Time>(lane) : 0;
+        vehicle.waitTime = vehicle.isWaiting ? 6 + static_cast<IClock::Time>(lane) : 0;
+
+        sensors[lane] = (sensorMask & laneBit(lane)) ? SensorState::SET : SensorState::CLEAR;
+    }
+    state.sensors = sensors;
+
+    return state;
+}
+
+TransitionTable::TransitionTable()
+    : entries_(SIZE, 0)
+{ }
+
+TransitionTable TransitionTable::generate()
+{
+    TransitionTable table;
+
+    Clock clock;
+    VehicleSensors sensors;
+    sensors.fill(SensorState::CLEAR);
+    TrafficLightControllerApp app(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+    app.initApp();
+    clock.set(NOW);
+
+    for (std::uint32_t index = 0; index < SIZE; index++)
+    {
+        app.restore(stateOf(index, 0, sensors));
+        app.run();
+        ControllerSnapshot after = app.snapshot();
+
+        std::uint8_t entry = static_cast<std::uint8_t>(after.activePattern & PATTERN_MASK);
+        entry |= after.lightStates[after.activePattern].startTime == NOW ? RESTARTED : 0;
+        entry |= after.carsAwaiting ? CARS_AWAITING : 0;
+        for (unsigned pattern = 0; pattern < TrafficLightPattern::NUM_PATTERNS; pattern++)
+        {
+            entry |= static_cast<std::uint8_t>(after.lightStates[pattern].areOpposingLanesClear << (CLEAR_SHIFT + pattern));
+        }
+        table.entries_[index] = entry;
+    }
+
+    return table;
+}
+
+const TransitionTable& TransitionTable::instance()
+{
+    static const TransitionTable table = generate();
+    return table;
+}
+
+void TransitionTable::emit(std::ostream &os, const std::string &name) const
+{
+    os << "// Generated from PATTERN_TRANSITIONS by TransitionTable::emit()\n";
+    os << "const std::uint8_t " << name << "[" << SIZE << "] =\n{\n";
+    for (std::size_t index = 0; index < SIZE; index++)
+    {
+        os << (index % 16 == 0 ? "    " : " ")
+           << "0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<unsigned>(entries_[index])
+           << std::dec << std::setfill(' ') << ","
+           << (index % 16 == 15 ? "\n" : "");
+    }
+    os << "};\n";
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Compare two snapshots field by field.
+///
+///  @param a First snapshot
+///  @param b Second snapshot
+///  @return std::string The first field that differs, empty
+///  if none does
+////////////////////////////////////////////////////////////
+static std::string firstDifference(const ControllerSnapshot &a, const ControllerSnapshot &b)
+{
+    if (a.activePattern != b.activePattern)
+    {
+        return "activePattern";
+    }
+    if (a.carsAwaiting != b.carsAwaiting)
+    {
+        return "carsAwaiting";
+    }
+    if (a.signals != b.signals)
+    {
+        return "signals";
+    }
+    if (a.now != b.now || a.maxWaitTime != b.maxWaitTime)
+    {
+        return "now or maxWaitTime";
+    }
+
+    for (unsigned pattern = 0; pattern < TrafficLightPattern::NUM_PATTERNS; pattern++)
+    {
+        const TrafficLightState &x = a.lightStates[pattern];
+        const TrafficLightState &y = b.lightStates[pattern];
+        if (x.isOn != y.isOn || x.areOpposingLanesClear != y.areOpposingLanesClear ||
+            x.startTime != y.startTime || x.activeTime != y.activeTime ||
+            x.minActiveTime != y.minActiveTime || x.maxActiveTime != y.maxActiveTime)
+        {
+            return std::string("lightStates[") + PATTERN_NAMES[pattern] + "]";
+        }
+    }
+
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        const VehicleState &x = a.vehicleStates[lane];
+        const VehicleState &y = b.vehicleStates[lane];
+        if (x.isWaiting != y.isWaiting || x.arrivalTime != y.arrivalTime || x.waitTime != y.waitTime)
+        {
+            return "vehicleStates[" + std::to_string(lane) + "]";
+        }
+    }
+
+    return std::string();
+}
+
+bool verifyTransitionTable(const TransitionTable &table, std::string &error)
+{
+    Clock clock;
+    VehicleSensors sensors;
+    sensors.fill(SensorState::CLEAR);
+
+    TrafficLightControllerApp rules(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+    TrafficLightControllerApp lookup(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+    rules.initApp();
+    lookup.initApp();
+    lookup.attachTransitionTable(&table);
+    clock.set(NOW);
+
+    for (std::uint32_t index = 0; index < TransitionTable::SIZE; index++)
+    {
+        /// No vehicle waiting, all waiting, and a mix that
+        /// differs from state to state.
+        const LaneMask waitings[] = {0, ALL_LANES, static_cast<LaneMask>(index * 0x9Du >> 3)};
+        for (LaneMask waiting : waitings)
+        {
+            ControllerSnapshot state = stateOf(index, waiting, sensors);
+            rules.restore(state);
+            lookup.restore(state);
+            rules.run();
+            lookup.run();
+
+            std::string field = firstDifference(rules.snapshot(), lookup.snapshot());
+            if (!field.empty())
+            {
+                std::ostringstream message;
+                message << "state 0x" << std::hex << index << " with waiting lanes 0x"
+                        << static_cast<unsigned>(waiting) << ": " << field << " differs";
+                error = message.str();
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,209 @@
+#include "impl/config/configManager.hpp"
+
+#include <sys/stat.h>
+
+ConfigManager::ConfigManager
+(
+    const TimingConfig &initial,
+    std::ostream *log
+)
+    : current_(new TimingConfig(initial)),
+      readers_(),
+      writerMutex_(),
+      retired_(),
+      log_(log),
+      watcher_(),
+      watcherMutex_(),
+      watcherWake_(),
+      stopWatcher_(false)
+{
+    for (ReaderSlot &slot : readers_)
+    {
+        slot.active.store(false);
+        slot.epoch.store(0);
+    }
+}
+
+ConfigManager::~ConfigManager()
+{
+    stopWatching();
+
+    delete current_.load();
+    for (RetiredConfig &retired : retired_)
+    {
+        delete retired.config;
+    }
+}
+
+ConfigManager::ReaderId ConfigManager::registerReader()
+{
+    std::lock_guard<std::mutex> lock(writerMutex_);
+
+    for (ReaderId reader = 0; reader < MAX_READERS; reader++)
+    {
+        if (!readers_[reader].active.load())
+        {
+            readers_[reader].active.store(true);
+            return reader;
+        }
+    }
+
+    return MAX_READERS;
+}
+
+void ConfigManager::unregisterReader
+(
+    ReaderId reader
+)
+{
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    readers_[reader].active.store(false);
+}
+
+void ConfigManager::publish
+(
+    const TimingConfig &config
+)
+{
+    /// Allocate before taking the lock, off the control threads.
+    const TimingConfig *fresh = new TimingConfig(config);
+
+    {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+
+        RetiredConfig retired;
+        retired.config = current_.exchange(fresh, std::memory_order_seq_cst);
+        retired.epochs.resize(MAX_READERS);
+        for (ReaderId reader = 0; reader < MAX_READERS; reader++)
+        {
+            retired.epochs[reader] = readers_[reader].epoch.load(std::memory_order_seq_cst);
+        }
+        retired_.push_back(std::move(retired));
+    }
+
+    reclaim();
+}
+
+std::size_t ConfigManager::reclaim()
+{
+    std::lock_guard<std::mutex> lock(writerMutex_);
+
+    auto graceOver = [this](const RetiredConfig &retired)
+    {
+        for (ReaderId reader = 0; reader < MAX_READERS; reader++)
+        {
+            if (readers_[reader].active.load(std::memory_order_seq_cst) &&
+                readers_[reader].epoch.load(std::memory_order_seq_cst) == retired.epochs[reader])
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < retired_.size(); i++)
+    {
+        if (graceOver(retired_[i]))
+        {
+            delete retired_[i].config;
+        }
+        else
+        {
+            /// A self-move would empty the epochs.
+            if (kept != i)
+            {
+                retired_[kept] = std::move(retired_[i]);
+            }
+            kept++;
+        }
+    }
+    retired_.resize(kept);
+
+    return kept;
+}
+
+bool ConfigManager::loadFile
+(
+    const std::string &path
+)
+{
+    TimingConfig config = defaultTimingConfig();
+    std::string error;
+
+    if (!loadTimingConfig(path, config, error))
+    {
+        if (log_)
+        {
+            *log_ << "Timing config not loaded, " << error << "." << std::endl;
+        }
+        return false;
+    }
+
+    publish(config);
+
+    if (log_)
+    {
+        *log_ << "Loaded timing config " << path << "." << std::endl;
+    }
+    return true;
+}
+
+void ConfigManager::watchFile
+(
+    const std::string &path,
+    std::chrono::milliseconds interval
+)
+{
+    stopWatching();
+
+    {
+        std::lock_guard<std::mutex> lock(watcherMutex_);
+        stopWatcher_ = false;
+    }
+
+    watcher_ = std::thread([this, path, interval]()
+    {
+        auto modifiedTime = [&path]()
+        {
+            struct stat info;
+            if (stat(path.c_str(), &info) != 0)
+            {
+                return std::chrono::nanoseconds(0);
+            }
+            return std::chrono::seconds(info.st_mtim.tv_sec) + std::chrono::nanoseconds(info.st_mtim.tv_nsec);
+        };
+
+        auto lastModified = modifiedTime();
+        std::unique_lock<std::mutex> lock(watcherMutex_);
+
+        while (!watcherWake_.wait_for(lock, interval, [this]() { return stopWatcher_; }))
+        {
+            lock.unlock();
+
+            auto modified = modifiedTime();
+            if (modified != lastModified && modified.count() != 0)
+            {
+                lastModified = modified;
+                loadFile(path);
+            }
+            reclaim();
+
+            lock.lock();
+        }
+    });
+}
+
+void ConfigManager::stopWatching()
+{
+    {
+        std::lock_guard<std::mutex> lock(watcherMutex_);
+        stopWatcher_ = true;
+    }
+    watcherWake_.notify_all();
+
+    if (watcher_.joinable())
+    {
+        watcher_.join();
+    }
+}
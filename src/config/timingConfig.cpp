@@ -0,0 +1,150 @@
+#include "impl/config/timingConfig.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+static std::string trim
+(
+    const std::string &text
+)
+{
+    const char *whitespace = " \t\r\n";
+    std::size_t first = text.find_first_not_of(whitespace);
+    if (first == std::string::npos)
+    {
+        return "";
+    }
+    std::size_t last = text.find_last_not_of(whitespace);
+    return text.substr(first, last - first + 1);
+}
+
+static bool parseTime
+(
+    const std::string &text,
+    IClock::Time &value
+)
+{
+    char *end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || parsed < 0 || parsed > 86400)
+    {
+        return false;
+    }
+    value = static_cast<IClock::Time>(parsed);
+    return true;
+}
+
+TimingConfig defaultTimingConfig()
+{
+    TimingConfig config;
+
+    for (int p = 0; p < NUM_PATTERNS; p++)
+    {
+        config.patterns[p].minActiveTime = PATTERN_TRANSITIONS[p].minActiveTime;
+        config.patterns[p].maxActiveTime = PATTERN_TRANSITIONS[p].maxActiveTime;
+    }
+    config.maxWaitTime = DEFAULT_MAX_WAIT_TIME;
+    config.skipUncalled = false;
+    config.enforceMaxWait = false;
+
+    return config;
+}
+
+bool parseTimingConfig
+(
+    std::istream &in,
+    TimingConfig &config,
+    std::string &error
+)
+{
+    TimingConfig parsed = config;
+    std::string line;
+
+    for (int lineNumber = 1; std::getline(in, line); lineNumber++)
+    {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
+        {
+            continue;
+        }
+
+        std::size_t equals = line.find('=');
+        std::string key = trim(line.substr(0, equals));
+        std::string text = equals == std::string::npos ? "" : trim(line.substr(equals + 1));
+        IClock::Time value = 0;
+
+        if (equals == std::string::npos || !parseTime(text, value))
+        {
+            error = "line " + std::to_string(lineNumber) + ": expected \"key = seconds\"";
+            return false;
+        }
+
+        bool *option = key == "skipUncalled" ? &parsed.skipUncalled
+                     : key == "enforceMaxWait" ? &parsed.enforceMaxWait : nullptr;
+        if (option != nullptr)
+        {
+            if (value > 1)
+            {
+                error = "line " + std::to_string(lineNumber) + ": " + key + " must be 0 or 1";
+                return false;
+            }
+            *option = value == 1;
+            continue;
+        }
+
+        IClock::Time *field = nullptr;
+        if (key == "maxWaitTime")
+        {
+            field = &parsed.maxWaitTime;
+        }
+        for (int p = 0; p < NUM_PATTERNS && field == nullptr; p++)
+        {
+            std::string name = PATTERN_NAMES[p];
+            if (key == name + ".minActiveTime")
+            {
+                field = &parsed.patterns[p].minActiveTime;
+            }
+            else if (key == name + ".maxActiveTime")
+            {
+                field = &parsed.patterns[p].maxActiveTime;
+            }
+        }
+
+        if (field == nullptr)
+        {
+            error = "line " + std::to_string(lineNumber) + ": unknown key \"" + key + "\"";
+            return false;
+        }
+        *field = value;
+    }
+
+    for (int p = 0; p < NUM_PATTERNS; p++)
+    {
+        if (parsed.patterns[p].minActiveTime > parsed.patterns[p].maxActiveTime)
+        {
+            error = std::string(PATTERN_NAMES[p]) + ": minActiveTime is above maxActiveTime";
+            return false;
+        }
+    }
+
+    config = parsed;
+    return true;
+}
+
+bool loadTimingConfig
+(
+    const std::string &path,
+    TimingConfig &config,
+    std::string &error
+)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    return parseTimingConfig(file, config, error);
+}
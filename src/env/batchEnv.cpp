@@ -0,0 +1,128 @@
+#include "impl/env/batchEnv.hpp"
+
+#include "impl/simulator/scenarios.hpp"
+
+#include <algorithm>
+#include <thread>
+
+/// Job indices handed out per thread, so a slow run of
+/// environments does not hold up the step
+static constexpr std::size_t RUNS_PER_THREAD = 4;
+
+BatchEnvConfig defaultBatchEnvConfig(std::uint32_t numEnvs)
+{
+    BatchEnvConfig config;
+    config.numEnvs = numEnvs;
+    config.numThreads = 0;
+    config.stepSeconds = 1;
+    config.maxWaitTime = DEFAULT_MAX_WAIT_TIME;
+    return config;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Get the threads a batch steps on
+///
+////////////////////////////////////////////////////////////
+static unsigned threadsFor(const BatchEnvConfig &config)
+{
+    unsigned threads = config.numThreads ? config.numThreads : std::max(1u, std::thread::hardware_concurrency());
+    return std::max(1u, std::min<unsigned>(threads, config.numEnvs));
+}
+
+BatchEnv::BatchEnv(const BatchEnvConfig &config)
+    : config_(config),
+      envs_(config.numEnvs),
+      runLength_(1),
+      pool_(threadsFor(config) - 1)
+{
+    config_.stepSeconds = std::max<Clock::Time>(1, config_.stepSeconds);
+
+    std::size_t runs = pool_.size() * RUNS_PER_THREAD;
+    runLength_ = std::max<std::size_t>(1, (envs_.size() + runs - 1) / runs);
+
+    tlc_observation observation;
+    for (std::uint32_t env = 0; env < size(); env++)
+    {
+        reset(env, 0, observation);
+    }
+}
+
+void BatchEnv::reset(std::uint32_t index, std::uint32_t seed, tlc_observation &observation)
+{
+    Env &env = envs_[index];
+    env.app.reset();
+    env.simulator.reset(new Simulator(makeDayScenario(seed)));
+    env.app.reset(new TrafficLightControllerApp(env.simulator->clock(), env.simulator->sensors(),
+                                                config_.maxWaitTime, nullptr));
+    env.policy.decision = Decision::FOLLOW_RULES;
+    env.app->attachPolicy(&env.policy);
+    env.app->initApp();
+    env.done = false;
+
+    observe(env, observation);
+}
+
+void BatchEnv::step(const std::int32_t *actions, tlc_observation *observations, float *rewards, std::uint8_t *dones)
+{
+    StepJob job = {this, actions, observations, rewards, dones};
+    pool_.run((envs_.size() + runLength_ - 1) / runLength_, &BatchEnv::stepRun, &job);
+}
+
+void BatchEnv::stepRun(void *context, std::size_t run)
+{
+    StepJob &job = *static_cast<StepJob*>(context);
+    BatchEnv &batch = *job.batch;
+
+    std::size_t first = run * batch.runLength_;
+    std::size_t last = std::min(first + batch.runLength_, batch.envs_.size());
+    for (std::size_t index = first; index < last; index++)
+    {
+        Env &env = batch.envs_[index];
+        job.rewards[index] = batch.stepEnv(env, job.actions[index]);
+        job.dones[index] = env.done;
+        observe(env, job.observations[index]);
+    }
+}
+
+float BatchEnv::stepEnv(Env &env, std::int32_t action)
+{
+    static const Decision DECISIONS[] = {Decision::HOLD, Decision::ADVANCE, Decision::FOLLOW_RULES};
+    env.policy.decision = DECISIONS[action];
+
+    float reward = 0.0f;
+    for (Clock::Time tick = 0; tick < config_.stepSeconds && !env.done; tick++)
+    {
+        env.app->run();
+        const TrafficSignals &signals = env.app->getSignals();
+        env.simulator->update_lane_signals(signals);
+
+        const VehicleSensors &sensors = env.simulator->sensors();
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            reward -= (sensors[lane] == SensorState::SET && signals[lane] != SignalState::GREEN) ? 1.0f : 0.0f;
+        }
+
+        env.simulator->advance(1);
+        env.done = env.simulator->done();
+    }
+    return reward;
+}
+
+void BatchEnv::observe(const Env &env, tlc_observation &observation)
+{
+    ControllerSnapshot state = env.app->snapshot();
+    const TrafficLightState &active = state.lightStates[state.activePattern];
+    const VehicleSensors &sensors = env.simulator->sensors();
+
+    observation.sensors = 0;
+    observation.green = 0;
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        observation.sensors |= static_cast<std::uint8_t>((sensors[lane] == SensorState::SET) << lane);
+        observation.green |= static_cast<std::uint8_t>((state.signals[lane] == SignalState::GREEN) << lane);
+        observation.waits[lane] = static_cast<float>(state.vehicleStates[lane].waitTime);
+    }
+    observation.pattern = static_cast<std::uint8_t>(state.activePattern);
+    observation.reserved = 0;
+    observation.elapsedGreen = active.isOn ? static_cast<float>(env.simulator->clock().now() - active.startTime) : 0.0f;
+}
@@ -0,0 +1,105 @@
+#include "impl/env/tlcEnv.h"
+
+#include "impl/env/batchEnv.hpp"
+
+#include <new>
+
+static_assert(TLC_NUM_LANES == Lane::COUNT, "tlc_observation must hold every lane");
+
+/// The C handle is the batch itself
+struct tlc_batch
+{
+    BatchEnv env;
+
+    explicit tlc_batch(const BatchEnvConfig &config) : env(config)
+    {
+    }
+};
+
+tlc_batch *tlc_batch_create(uint32_t num_envs, uint32_t num_threads, int32_t step_seconds)
+{
+    if (num_envs == 0 || step_seconds < 1)
+    {
+        return nullptr;
+    }
+
+    BatchEnvConfig config = defaultBatchEnvConfig(num_envs);
+    config.numThreads = num_threads;
+    config.stepSeconds = step_seconds;
+
+    /// No exception may cross the C boundary.
+    try
+    {
+        return new tlc_batch(config);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void tlc_batch_destroy(tlc_batch *batch)
+{
+    delete batch;
+}
+
+uint32_t tlc_batch_size(const tlc_batch *batch)
+{
+    return batch ? batch->env.size() : 0;
+}
+
+int tlc_batch_reset(tlc_batch *batch, const uint32_t *seeds, tlc_observation *observations)
+{
+    if (!batch || !seeds || !observations)
+    {
+        return TLC_ERROR_ARGUMENT;
+    }
+
+    for (uint32_t env = 0; env < batch->env.size(); env++)
+    {
+        int result = tlc_batch_reset_one(batch, env, seeds[env], &observations[env]);
+        if (result != TLC_OK)
+        {
+            return result;
+        }
+    }
+    return TLC_OK;
+}
+
+int tlc_batch_reset_one(tlc_batch *batch, uint32_t env, uint32_t seed, tlc_observation *observation)
+{
+    if (!batch || !observation || env >= batch->env.size())
+    {
+        return TLC_ERROR_ARGUMENT;
+    }
+
+    try
+    {
+        batch->env.reset(env, seed, *observation);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return TLC_ERROR_MEMORY;
+    }
+    return TLC_OK;
+}
+
+int tlc_batch_step(tlc_batch *batch, const int32_t *actions, tlc_observation *observations,
+                   float *rewards, uint8_t *dones)
+{
+    if (!batch || !actions || !observations || !rewards || !dones)
+    {
+        return TLC_ERROR_ARGUMENT;
+    }
+
+    for (uint32_t env = 0; env < batch->env.size(); env++)
+    {
+        if (actions[env] < TLC_ACTION_HOLD || actions[env] > TLC_ACTION_RULES)
+        {
+            return TLC_ERROR_ARGUMENT;
+        }
+    }
+
+    batch->env.step(actions, observations, rewards, dones);
+    return TLC_OK;
+}
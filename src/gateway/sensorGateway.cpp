@@ -0,0 +1,303 @@
+#include "impl/gateway/sensorGateway.hpp"
+
+#include <cstring>
+#include <ctime>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+constexpr std::uint16_t SensorGateway::STALE_WINDOW;
+
+/// Events taken from epoll per wait
+static constexpr int MAX_EVENTS = 64;
+
+void encodeSensorFrame(const SensorFrame &frame, std::uint8_t *out)
+{
+    out[0] = SENSOR_FRAME_VERSION;
+    out[1] = frame.sensors;
+    std::memcpy(out + 2, &frame.sequence, sizeof(frame.sequence));
+    std::memcpy(out + 4, &frame.intersection, sizeof(frame.intersection));
+    std::memcpy(out + 8, &frame.sent, sizeof(frame.sent));
+}
+
+bool decodeSensorFrame(const std::uint8_t *in, SensorFrame &frame)
+{
+    frame.sensors = in[1];
+    std::memcpy(&frame.sequence, in + 2, sizeof(frame.sequence));
+    std::memcpy(&frame.intersection, in + 4, sizeof(frame.intersection));
+    std::memcpy(&frame.sent, in + 8, sizeof(frame.sent));
+    return in[0] == SENSOR_FRAME_VERSION;
+}
+
+std::uint64_t monotonicNanos()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<std::uint64_t>(now.tv_sec) * 1000000000u + static_cast<std::uint64_t>(now.tv_nsec);
+}
+
+GatewayConfig defaultGatewayConfig()
+{
+    GatewayConfig config;
+    config.maxIntersections = 65536;
+    config.batch = 64;
+    config.maxDatagram = 4096;
+    config.drainLimit = 16;
+    config.receiveBuffer = 4 << 20;
+    return config;
+}
+
+SensorGateway::SensorGateway(ControllerHost &host, const GatewayConfig &config)
+    : host_(host),
+      config_(config),
+      stats_(),
+      routes_(config.maxIntersections, INVALID_CONTROLLER),
+      sequences_(config.maxIntersections, 0),
+      seen_(config.maxIntersections, false),
+      epoll_(-1),
+      sockets_(config.socketPaths.size(), -1),
+      queued_(config.socketPaths.size(), false)
+{
+    config_.batch = config_.batch ? config_.batch : 1;
+    config_.drainLimit = config_.drainLimit ? config_.drainLimit : 1;
+    ready_.reserve(sockets_.size());
+    buffers_.resize(static_cast<std::size_t>(config_.batch) * config_.maxDatagram);
+
+#if defined(__linux__)
+    /// Every datagram of a batch lands in its own buffer, so
+    /// the headers are built once and reused by each call.
+    headers_.resize(config_.batch * (sizeof(mmsghdr) + sizeof(iovec)));
+    mmsghdr *messages = reinterpret_cast<mmsghdr*>(headers_.data());
+    iovec *vectors = reinterpret_cast<iovec*>(headers_.data() + config_.batch * sizeof(mmsghdr));
+    for (unsigned i = 0; i < config_.batch; i++)
+    {
+        vectors[i].iov_base = buffers_.data() + static_cast<std::size_t>(i) * config_.maxDatagram;
+        vectors[i].iov_len = config_.maxDatagram;
+        std::memset(&messages[i], 0, sizeof(mmsghdr));
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
+}
+
+SensorGateway::~SensorGateway()
+{
+#if defined(__linux__)
+    for (std::size_t i = 0; i < sockets_.size(); i++)
+    {
+        if (sockets_[i] >= 0)
+        {
+            close(sockets_[i]);
+            unlink(config_.socketPaths[i].c_str());
+        }
+    }
+    if (epoll_ >= 0)
+    {
+        close(epoll_);
+    }
+#endif
+}
+
+bool SensorGateway::open(std::string &error)
+{
+#if defined(__linux__)
+    epoll_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_ < 0)
+    {
+        error = std::string("epoll_create1: ") + std::strerror(errno);
+        return false;
+    }
+
+    for (std::size_t i = 0; i < sockets_.size(); i++)
+    {
+        const std::string &path = config_.socketPaths[i];
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+        {
+            error = "Bad socket path '" + path + "'";
+            return false;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+
+        int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            error = path + ": socket: " + std::strerror(errno);
+            return false;
+        }
+        if (config_.receiveBuffer > 0)
+        {
+            setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &config_.receiveBuffer, sizeof(config_.receiveBuffer));
+        }
+
+        unlink(path.c_str());
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+        {
+            error = path + ": bind: " + std::strerror(errno);
+            close(fd);
+            return false;
+        }
+        sockets_[i] = fd;
+
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLET;
+        event.data.u64 = i;
+        if (epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event) < 0)
+        {
+            error = path + ": epoll_ctl: " + std::strerror(errno);
+            return false;
+        }
+
+        /// Datagrams sent before registration raise no edge.
+        ready_.push_back(i);
+        queued_[i] = true;
+    }
+
+    return true;
+#else
+    error = "The sensor gateway needs Linux epoll";
+    return false;
+#endif
+}
+
+bool SensorGateway::route(std::uint32_t intersection, ControllerId controller)
+{
+    if (intersection >= config_.maxIntersections)
+    {
+        return false;
+    }
+    routes_[intersection] = controller;
+    seen_[intersection] = false;
+    return true;
+}
+
+std::size_t SensorGateway::poll(int timeoutMs)
+{
+    std::uint64_t before = stats_.frames;
+
+#if defined(__linux__)
+    epoll_event events[MAX_EVENTS];
+    int count = epoll_wait(epoll_, events, MAX_EVENTS, ready_.empty() ? timeoutMs : 0);
+    stats_.wakeups += count > 0;
+    for (int i = 0; i < count; i++)
+    {
+        std::size_t socket = static_cast<std::size_t>(events[i].data.u64);
+        if (!queued_[socket])
+        {
+            ready_.push_back(socket);
+            queued_[socket] = true;
+        }
+    }
+
+    /// One turn through the ready sockets; those left with
+    /// datagrams keep their order for the next call.
+    std::size_t kept = 0;
+    for (std::size_t socket : ready_)
+    {
+        if (drain(socket))
+        {
+            queued_[socket] = false;
+        }
+        else
+        {
+            ready_[kept++] = socket;
+        }
+    }
+    ready_.resize(kept);
+#else
+    (void)timeoutMs;
+#endif
+
+    return static_cast<std::size_t>(stats_.frames - before);
+}
+
+bool SensorGateway::drain(std::size_t socket)
+{
+#if defined(__linux__)
+    mmsghdr *messages = reinterpret_cast<mmsghdr*>(headers_.data());
+    for (unsigned call = 0; call < config_.drainLimit; call++)
+    {
+        int received = recvmmsg(sockets_[socket], messages, config_.batch, MSG_DONTWAIT, nullptr);
+        if (received < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            /// EAGAIN is the empty socket the edge promised.
+            return true;
+        }
+
+        std::uint64_t now = monotonicNanos();
+        stats_.calls++;
+        stats_.datagrams += static_cast<std::uint64_t>(received);
+        for (int i = 0; i < received; i++)
+        {
+            if (messages[i].msg_hdr.msg_flags & MSG_TRUNC)
+            {
+                stats_.malformed++;
+                continue;
+            }
+            apply(static_cast<const std::uint8_t*>(messages[i].msg_hdr.msg_iov->iov_base), messages[i].msg_len, now);
+        }
+
+        if (static_cast<unsigned>(received) < config_.batch)
+        {
+            return true;
+        }
+    }
+    return false;
+#else
+    (void)socket;
+    return true;
+#endif
+}
+
+void SensorGateway::apply(const std::uint8_t *data, std::size_t size, std::uint64_t now)
+{
+    if (size == 0 || size % SENSOR_FRAME_SIZE != 0)
+    {
+        stats_.malformed++;
+        return;
+    }
+
+    for (const std::uint8_t *end = data + size; data != end; data += SENSOR_FRAME_SIZE)
+    {
+        SensorFrame frame;
+        if (!decodeSensorFrame(data, frame))
+        {
+            stats_.malformed++;
+            continue;
+        }
+        if (frame.intersection >= config_.maxIntersections || routes_[frame.intersection] == INVALID_CONTROLLER)
+        {
+            stats_.unrouted++;
+            continue;
+        }
+
+        /// Sequences wrap, so "behind" is the 16-bit distance.
+        std::uint16_t behind = static_cast<std::uint16_t>(sequences_[frame.intersection] - frame.sequence);
+        if (seen_[frame.intersection] && behind < STALE_WINDOW)
+        {
+            stats_.stale++;
+            continue;
+        }
+
+        host_.setSensorMask(routes_[frame.intersection], frame.sensors);
+        sequences_[frame.intersection] = frame.sequence;
+        seen_[frame.intersection] = true;
+        stats_.frames++;
+
+        if (frame.sent != 0 && now >= frame.sent)
+        {
+            latency_.record(now - frame.sent);
+        }
+    }
+}
@@ -0,0 +1,254 @@
+#include "impl/history/signalHistory.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+constexpr unsigned SignalHistory::BLOCK_CHANGES;
+constexpr unsigned SignalHistory::SUCCESSOR_SLOTS;
+
+/// Successor guess of a state not yet left in the block
+static constexpr std::uint32_t NO_STATE = ~std::uint32_t(0);
+
+////////////////////////////////////////////////////////////
+///  @brief Append a varint: 7 bits per byte, low first, the
+///  top bit set on all but the last.
+///
+////////////////////////////////////////////////////////////
+static void putVarint(std::vector<std::uint8_t> &code, std::uint32_t value)
+{
+    while (value >= 0x80u)
+    {
+        code.push_back(static_cast<std::uint8_t>(value | 0x80u));
+        value >>= 7;
+    }
+    code.push_back(static_cast<std::uint8_t>(value));
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Read a varint written by putVarint()
+///
+///  @param code Encoded bytes
+///  @param pos Byte to read from, moved past the varint
+///  @return std::uint32_t The value
+////////////////////////////////////////////////////////////
+static inline std::uint32_t getVarint(const std::uint8_t *code, std::size_t &pos)
+{
+    std::uint32_t value = 0;
+    unsigned shift = 0;
+    std::uint8_t byte;
+    do
+    {
+        byte = code[pos++];
+        value |= static_cast<std::uint32_t>(byte & 0x7fu) << shift;
+        shift += 7;
+    } while (byte & 0x80u);
+    return value;
+}
+
+SignalHistory::SignalHistory(std::uint32_t numIntersections)
+    : intersections_(numIntersections),
+      states_(),
+      numbers_()
+{
+    for (Intersection &history : intersections_)
+    {
+        history.lastTime = 0;
+        history.lastState = NO_STATE;
+        history.inBlock = 0;
+        history.successors.fill(NO_STATE);
+    }
+}
+
+std::uint32_t SignalHistory::stateOf(const TrafficSignals &signals)
+{
+    SignalWord word;
+    std::memcpy(&word, signals.data(), sizeof(word));
+
+    auto found = numbers_.find(word);
+    if (found != numbers_.end())
+    {
+        return found->second;
+    }
+
+    std::uint32_t number = static_cast<std::uint32_t>(states_.size());
+    states_.push_back(signals);
+    numbers_.emplace(word, number);
+    return number;
+}
+
+bool SignalHistory::record(IntersectionId intersection, Clock::Time now, const TrafficSignals &signals)
+{
+    Intersection &history = intersections_[intersection];
+    if (!history.blocks.empty())
+    {
+        if (signals == states_[history.lastState])
+        {
+            return true;
+        }
+        if (now <= history.lastTime)
+        {
+            return false;
+        }
+    }
+
+    append(history, now, stateOf(signals));
+    return true;
+}
+
+void SignalHistory::append(Intersection &history, Clock::Time time, std::uint32_t state)
+{
+    if (history.blocks.empty() || history.inBlock == BLOCK_CHANGES)
+    {
+        history.blocks.push_back({time, state, static_cast<std::uint32_t>(history.code.size())});
+        history.successors.fill(NO_STATE);
+        history.inBlock = 1;
+    }
+    else
+    {
+        std::uint32_t &guess = history.successors[history.lastState % SUCCESSOR_SLOTS];
+        std::uint32_t surprise = guess != state;
+        std::uint32_t delta = static_cast<std::uint32_t>(time - history.lastTime) - 1;
+
+        putVarint(history.code, (delta << 1) | surprise);
+        if (surprise)
+        {
+            putVarint(history.code, state);
+        }
+        guess = state;
+        history.inBlock++;
+    }
+
+    history.lastTime = time;
+    history.lastState = state;
+}
+
+std::size_t SignalHistory::blockOf(const Intersection &history, Clock::Time time)
+{
+    auto after = std::upper_bound(history.blocks.begin(), history.blocks.end(), time,
+                                  [](Clock::Time t, const Block &block) { return t < block.start; });
+    if (after == history.blocks.begin())
+    {
+        return history.blocks.size();
+    }
+    return static_cast<std::size_t>(after - history.blocks.begin()) - 1;
+}
+
+template <typename Visit>
+void SignalHistory::decode(const Intersection &history, std::size_t block, Visit visit)
+{
+    const std::uint8_t *code = history.code.data();
+    Successors successors;
+
+    for (; block < history.blocks.size(); block++)
+    {
+        const Block &entry = history.blocks[block];
+        std::size_t pos = entry.offset;
+        std::size_t end = block + 1 < history.blocks.size() ? history.blocks[block + 1].offset : history.code.size();
+
+        Clock::Time time = entry.start;
+        std::uint32_t state = entry.state;
+        if (!visit(time, state))
+        {
+            return;
+        }
+
+        successors.fill(NO_STATE);
+        while (pos < end)
+        {
+            std::uint32_t head = getVarint(code, pos);
+            std::uint32_t &guess = successors[state % SUCCESSOR_SLOTS];
+            std::uint32_t next = (head & 1u) ? getVarint(code, pos) : guess;
+            guess = next;
+
+            time += static_cast<Clock::Time>(head >> 1) + 1;
+            state = next;
+            if (!visit(time, state))
+            {
+                return;
+            }
+        }
+    }
+}
+
+bool SignalHistory::at(IntersectionId intersection, Clock::Time time, TrafficSignals &signals) const
+{
+    const Intersection &history = intersections_[intersection];
+    std::size_t block = blockOf(history, time);
+    if (block == history.blocks.size())
+    {
+        return false;
+    }
+
+    std::uint32_t shown = NO_STATE;
+    decode(history, block, [time, &shown](Clock::Time changed, std::uint32_t state) {
+        if (changed > time)
+        {
+            return false;
+        }
+        shown = state;
+        return true;
+    });
+
+    signals = states_[shown];
+    return true;
+}
+
+std::size_t SignalHistory::range(IntersectionId intersection, Clock::Time from, Clock::Time to,
+                                 std::vector<SignalChange> &changes) const
+{
+    const Intersection &history = intersections_[intersection];
+    std::size_t before = changes.size();
+    if (history.blocks.empty() || from >= to)
+    {
+        return 0;
+    }
+
+    /// A span starting before the first change starts there.
+    std::size_t block = blockOf(history, from);
+    block = block == history.blocks.size() ? 0 : block;
+
+    std::uint32_t shownAtFrom = NO_STATE;
+    decode(history, block, [&](Clock::Time changed, std::uint32_t state) {
+        if (changed <= from)
+        {
+            shownAtFrom = state;
+            return true;
+        }
+        if (shownAtFrom != NO_STATE)
+        {
+            changes.push_back({from, states_[shownAtFrom]});
+            shownAtFrom = NO_STATE;
+        }
+        if (changed >= to)
+        {
+            return false;
+        }
+        changes.push_back({changed, states_[state]});
+        return true;
+    });
+
+    /// Nothing changed after from: the span is one state.
+    if (shownAtFrom != NO_STATE)
+    {
+        changes.push_back({from, states_[shownAtFrom]});
+    }
+    return changes.size() - before;
+}
+
+SignalHistoryStats SignalHistory::stats() const
+{
+    SignalHistoryStats stats = {};
+    for (const Intersection &history : intersections_)
+    {
+        stats.changes += history.blocks.empty() ? 0 : (history.blocks.size() - 1) * BLOCK_CHANGES + history.inBlock;
+        stats.blocks += history.blocks.size();
+        stats.codeBytes += history.code.size();
+        stats.indexBytes += history.blocks.size() * sizeof(Block);
+        stats.heapBytes += history.code.capacity() + history.blocks.capacity() * sizeof(Block);
+    }
+    stats.heapBytes += intersections_.capacity() * sizeof(Intersection) +
+                       states_.capacity() * sizeof(TrafficSignals) +
+                       numbers_.size() * (sizeof(SignalWord) + sizeof(std::uint32_t) + 2 * sizeof(void*));
+    stats.states = states_.size();
+    return stats;
+}
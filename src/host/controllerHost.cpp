@@ -0,0 +1,637 @@
+#include "impl/host/controllerHost.hpp"
+#include "impl/trace/trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+SensorMask packSensors(const VehicleSensors &sensors)
+{
+    SensorMask mask = 0;
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        if (sensors[lane] == SensorState::SET)
+        {
+            mask |= laneBit(lane);
+        }
+    }
+    return mask;
+}
+
+void unpackSensors(SensorMask mask, VehicleSensors &sensors)
+{
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        sensors[lane] = (mask & laneBit(lane)) ? SensorState::SET : SensorState::CLEAR;
+    }
+}
+
+SignalWord packSignals(const TrafficSignals &signals)
+{
+    SignalWord word;
+    std::memcpy(&word, signals.data(), sizeof(word));
+    return word;
+}
+
+TrafficSignals unpackSignals(SignalWord word)
+{
+    TrafficSignals signals;
+    std::memcpy(signals.data(), &word, sizeof(word));
+    return signals;
+}
+
+HostConfig defaultHostConfig()
+{
+    HostConfig config;
+    config.numShards = 0;
+    config.shardCapacity = 4096;
+    config.timeStep = 1;
+    config.maxWaitTime = DEFAULT_MAX_WAIT_TIME;
+    config.tickPeriod = std::chrono::seconds(1);
+    config.tickLimit = 0;
+    config.pinThreads = true;
+    config.conditionSensors = false;
+    config.detectorTiming.fill(defaultDetectorTiming());
+    config.transitionTable = false;
+    config.sensorFeed = nullptr;
+    return config;
+}
+
+constexpr std::uint32_t ControllerHost::PREEMPT_CHECK_INTERVAL;
+
+////////////////////////////////////////////////////////////
+///  @brief Get the steady clock time
+///
+///  @return std::uint64_t Nanoseconds since the steady epoch
+////////////////////////////////////////////////////////////
+static std::uint64_t steadyNanos()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+ControllerHost::Slot::Slot()
+    : sensorInput(0),
+      signalOutput(0),
+      sensors(),
+      preemptedAt(0),
+      used(false),
+      app(nullptr),
+      storage()
+{
+    unpackSensors(0, sensors);
+}
+
+ControllerHost::Slot::~Slot()
+{
+    if (app)
+    {
+        app->~TrafficLightControllerApp();
+    }
+}
+
+ControllerHost::Shard::Shard(std::uint32_t capacity)
+    : clock(),
+      slots(new Slot[capacity]),
+      active(),
+      position(capacity, 0),
+      commandMutex(),
+      pending(),
+      applying(),
+      freeSlots(),
+      preemptions(),
+      servicing(),
+      urgent(false),
+      wakeMutex(),
+      wake(),
+      load(0),
+      ticked(0),
+      ticks(0),
+      conditioner(capacity),
+      latency(),
+      preemptLatency(),
+      greenLatency(),
+      preempted(0),
+      core(0),
+      index(0),
+      thread()
+{
+    active.reserve(capacity);
+    pending.reserve(capacity);
+    applying.reserve(capacity);
+    freeSlots.reserve(capacity);
+    preemptions.reserve(capacity);
+    servicing.reserve(capacity);
+
+    /// Hand out low slots first so a lightly loaded shard
+    /// touches as little memory as possible.
+    for (std::uint32_t slot = capacity; slot > 0; slot--)
+    {
+        freeSlots.push_back(slot - 1);
+    }
+}
+
+ControllerHost::ControllerHost
+(
+    const HostConfig &config
+)
+    : config_(config),
+      shards_(),
+      running_(false),
+      state_()
+{
+    if (config_.numShards == 0)
+    {
+        config_.numShards = std::max(1u, std::thread::hardware_concurrency());
+    }
+    config_.shardCapacity = std::max<std::uint32_t>(1, config_.shardCapacity);
+
+    /// Generate the table now rather than on a shard's first add.
+    if (config_.transitionTable)
+    {
+        TransitionTable::instance();
+    }
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned shard = 0; shard < config_.numShards; shard++)
+    {
+        shards_.emplace_back(new Shard(config_.shardCapacity));
+        shards_.back()->core = config_.pinThreads ? shard % cores : shard;
+        shards_.back()->index = shard;
+
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            shards_.back()->conditioner.setLaneTiming(static_cast<Lane>(lane), config_.detectorTiming[lane]);
+        }
+    }
+}
+
+ControllerHost::~ControllerHost()
+{
+    stop();
+}
+
+bool ControllerHost::attachState(const std::string &path, std::string &error)
+{
+    if (running_.load())
+    {
+        error = "attach state before starting the host";
+        return false;
+    }
+
+    std::uint32_t capacity = static_cast<std::uint32_t>(shards_.size()) * config_.shardCapacity;
+    if (!state_.open(path, static_cast<std::uint32_t>(shards_.size()), capacity, error))
+    {
+        return false;
+    }
+
+    for (auto &shard : shards_)
+    {
+        shard->clock.set(state_.clock(shard->index));
+    }
+    return true;
+}
+
+void ControllerHost::start()
+{
+    if (running_.exchange(true))
+    {
+        return;
+    }
+
+    for (auto &shard : shards_)
+    {
+        Shard *owned = shard.get();
+        owned->thread = std::thread([this, owned]() { runShard(*owned); });
+    }
+}
+
+void ControllerHost::stop()
+{
+    running_.store(false);
+    for (auto &shard : shards_)
+    {
+        /// Taking the lock orders the store before a sleeping
+        /// shard's check of running_.
+        {
+            std::lock_guard<std::mutex> lock(shard->wakeMutex);
+        }
+        shard->wake.notify_one();
+    }
+    wait();
+}
+
+void ControllerHost::wait()
+{
+    if (config_.tickLimit == 0 && running_.load())
+    {
+        return;
+    }
+
+    for (auto &shard : shards_)
+    {
+        if (shard->thread.joinable())
+        {
+            shard->thread.join();
+        }
+    }
+}
+
+ControllerId ControllerHost::addController()
+{
+    /// Pick the least loaded shard. Loads are read without
+    /// the shard locks, so concurrent adds may tie, which
+    /// only costs balance.
+    unsigned best = 0;
+    for (unsigned shard = 1; shard < shards_.size(); shard++)
+    {
+        if (shards_[shard]->load.load(std::memory_order_relaxed) <
+            shards_[best]->load.load(std::memory_order_relaxed))
+        {
+            best = shard;
+        }
+    }
+
+    for (unsigned attempt = 0; attempt < shards_.size(); attempt++)
+    {
+        unsigned shardIndex = (best + attempt) % shards_.size();
+        Shard &shard = *shards_[shardIndex];
+        std::lock_guard<std::mutex> lock(shard.commandMutex);
+
+        if (shard.freeSlots.empty())
+        {
+            continue;
+        }
+
+        std::uint32_t slot = shard.freeSlots.back();
+        shard.freeSlots.pop_back();
+        shard.slots[slot].used.store(true, std::memory_order_release);
+        shard.pending.push_back({slot, true});
+        shard.load.fetch_add(1, std::memory_order_relaxed);
+
+        return shardIndex * config_.shardCapacity + slot;
+    }
+
+    return INVALID_CONTROLLER;
+}
+
+bool ControllerHost::removeController(ControllerId id)
+{
+    if (!slotOf(id))
+    {
+        return false;
+    }
+
+    Shard &shard = *shards_[id / config_.shardCapacity];
+    std::uint32_t slot = id % config_.shardCapacity;
+    std::lock_guard<std::mutex> lock(shard.commandMutex);
+
+    /// Checked again under the lock, against a racing remove.
+    if (!shard.slots[slot].used.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+
+    /// The slot may be handed out again at once; its add is
+    /// queued behind this remove, so the shard sees them in order.
+    shard.slots[slot].used.store(false, std::memory_order_release);
+    shard.freeSlots.push_back(slot);
+    shard.pending.push_back({slot, false});
+    shard.load.fetch_sub(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+bool ControllerHost::setSensors(ControllerId id, const VehicleSensors &sensors)
+{
+    return setSensorMask(id, packSensors(sensors));
+}
+
+bool ControllerHost::setSensorMask(ControllerId id, SensorMask mask)
+{
+    Slot *slot = slotOf(id);
+    if (!slot)
+    {
+        return false;
+    }
+
+    slot->sensorInput.store(mask, std::memory_order_relaxed);
+    return true;
+}
+
+bool ControllerHost::preempt(ControllerId id, TrafficLightPattern pattern)
+{
+    return pattern < TrafficLightPattern::NUM_PATTERNS && queuePreemption(id, pattern);
+}
+
+bool ControllerHost::releasePreemption(ControllerId id)
+{
+    return queuePreemption(id, TrafficLightPattern::NUM_PATTERNS);
+}
+
+bool ControllerHost::queuePreemption(ControllerId id, TrafficLightPattern pattern)
+{
+    if (!slotOf(id))
+    {
+        return false;
+    }
+
+    Shard &shard = *shards_[id / config_.shardCapacity];
+    std::uint32_t slot = id % config_.shardCapacity;
+    {
+        std::lock_guard<std::mutex> lock(shard.commandMutex);
+        if (!shard.slots[slot].used.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        shard.preemptions.push_back({slot, pattern, steadyNanos()});
+        shard.urgent.store(true, std::memory_order_release);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(shard.wakeMutex);
+    }
+    shard.wake.notify_one();
+    return true;
+}
+
+SensorMask ControllerHost::sensorMask(ControllerId id) const
+{
+    const Slot *slot = slotOf(id);
+    return slot ? slot->sensorInput.load(std::memory_order_relaxed) : SensorMask(0);
+}
+
+TrafficSignals ControllerHost::signals(ControllerId id) const
+{
+    const Slot *slot = slotOf(id);
+    return unpackSignals(slot ? slot->signalOutput.load(std::memory_order_acquire) : SignalWord(0));
+}
+
+ShardReport ControllerHost::report(unsigned shardIndex) const
+{
+    const Shard &shard = *shards_[shardIndex];
+
+    ShardReport report;
+    report.shard = shardIndex;
+    report.core = shard.core;
+    report.controllers = shard.ticked.load(std::memory_order_relaxed);
+    report.ticks = shard.ticks.load(std::memory_order_relaxed);
+    report.p50 = shard.latency.percentile(0.50);
+    report.p99 = shard.latency.percentile(0.99);
+    report.p999 = shard.latency.percentile(0.999);
+    report.max = shard.latency.max();
+    report.preemptions = shard.preempted.load(std::memory_order_relaxed);
+    report.preemptP99 = shard.preemptLatency.percentile(0.99);
+    report.preemptP999 = shard.preemptLatency.percentile(0.999);
+    report.preemptMax = shard.preemptLatency.max();
+    report.preemptGreenMax = shard.greenLatency.max();
+    return report;
+}
+
+void ControllerHost::runShard(Shard &shard)
+{
+#if defined(TLC_TRACE_ENABLED)
+    Tracer::registerThread(("shard " + std::to_string(shard.core)).c_str());
+#endif
+
+#if defined(__linux__)
+    if (config_.pinThreads)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(shard.core, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#endif
+
+    auto nextTick = std::chrono::steady_clock::now();
+
+    while (running_.load(std::memory_order_relaxed))
+    {
+        applyCommands(shard);
+        if (shard.urgent.load(std::memory_order_acquire))
+        {
+            servicePreemptions(shard);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        tick(shard);
+        auto end = std::chrono::steady_clock::now();
+
+        shard.latency.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        std::uint64_t ticks = shard.ticks.load(std::memory_order_relaxed) + 1;
+        shard.ticks.store(ticks, std::memory_order_relaxed);
+
+        if (config_.tickLimit != 0 && ticks >= config_.tickLimit)
+        {
+            break;
+        }
+
+        if (config_.tickPeriod.count() > 0)
+        {
+            nextTick += config_.tickPeriod;
+            sleepUntil(shard, nextTick);
+        }
+    }
+}
+
+void ControllerHost::sleepUntil(Shard &shard, std::chrono::steady_clock::time_point nextTick)
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(shard.wakeMutex);
+            bool woken = shard.wake.wait_until(lock, nextTick, [this, &shard]() {
+                return shard.urgent.load(std::memory_order_acquire) || !running_.load(std::memory_order_relaxed);
+            });
+            if (!woken || !running_.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+        }
+        servicePreemptions(shard);
+    }
+}
+
+void ControllerHost::servicePreemptions(Shard &shard)
+{
+    TRACE_SCOPE("ControllerHost::servicePreemptions");
+
+    {
+        /// Unlike commands, wait for the lock: the request is
+        /// what the shard was woken for.
+        std::lock_guard<std::mutex> lock(shard.commandMutex);
+        shard.urgent.store(false, std::memory_order_relaxed);
+        shard.servicing.swap(shard.preemptions);
+    }
+
+    for (const Preemption &preemption : shard.servicing)
+    {
+        Slot &slot = shard.slots[preemption.slot];
+        if (!slot.app)
+        {
+            continue;
+        }
+
+        if (preemption.pattern == TrafficLightPattern::NUM_PATTERNS)
+        {
+            slot.app->releasePreemption();
+        }
+        else
+        {
+            slot.app->preempt(preemption.pattern);
+            slot.preemptedAt = preemption.requested;
+        }
+        slot.signalOutput.store(packSignals(slot.app->getSignals()), std::memory_order_release);
+
+        std::uint64_t now = steadyNanos();
+        shard.preemptLatency.record(now - preemption.requested);
+        if (slot.preemptedAt != 0 && !slot.app->isClearingForPreemption())
+        {
+            shard.greenLatency.record(now - slot.preemptedAt);
+            slot.preemptedAt = 0;
+        }
+    }
+
+    shard.preempted.fetch_add(shard.servicing.size(), std::memory_order_relaxed);
+    shard.servicing.clear();
+}
+
+void ControllerHost::applyCommands(Shard &shard)
+{
+    {
+        /// Never wait for a feeder holding the lock; the
+        /// commands keep until the next tick.
+        std::unique_lock<std::mutex> lock(shard.commandMutex, std::try_to_lock);
+        if (!lock.owns_lock() || shard.pending.empty())
+        {
+            return;
+        }
+        shard.applying.swap(shard.pending);
+    }
+
+    for (const Command &command : shard.applying)
+    {
+        Slot &slot = shard.slots[command.slot];
+
+        if (command.add && !slot.app)
+        {
+            slot.sensorInput.store(0, std::memory_order_relaxed);
+            unpackSensors(0, slot.sensors);
+            slot.preemptedAt = 0;
+            shard.conditioner.reset(command.slot);
+            slot.app = new (&slot.storage) TrafficLightControllerApp(shard.clock, slot.sensors,
+                                                                     config_.maxWaitTime, nullptr);
+            slot.app->attachTransitionTable(config_.transitionTable ? &TransitionTable::instance() : nullptr);
+
+            ControllerSnapshot saved;
+            if (state_.isOpen() && state_.load(shard.index * config_.shardCapacity + command.slot, saved))
+            {
+                slot.app->restore(saved);
+            }
+            else
+            {
+                slot.app->initApp();
+            }
+            slot.signalOutput.store(packSignals(slot.app->getSignals()), std::memory_order_release);
+
+            shard.position[command.slot] = static_cast<std::uint32_t>(shard.active.size());
+            shard.active.push_back(command.slot);
+        }
+        else if (!command.add && slot.app)
+        {
+            slot.app->~TrafficLightControllerApp();
+            slot.app = nullptr;
+            if (state_.isOpen())
+            {
+                state_.erase(shard.index * config_.shardCapacity + command.slot);
+            }
+            slot.signalOutput.store(0, std::memory_order_release);
+
+            /// Swap-remove keeps the active list dense.
+            std::uint32_t index = shard.position[command.slot];
+            std::uint32_t last = shard.active.back();
+            shard.active[index] = last;
+            shard.position[last] = index;
+            shard.active.pop_back();
+        }
+    }
+
+    shard.applying.clear();
+}
+
+void ControllerHost::tick(Shard &shard)
+{
+    TRACE_SCOPE("ControllerHost::tick");
+
+    std::uint32_t firstSlot = shard.index * config_.shardCapacity;
+    if (config_.sensorFeed)
+    {
+        /// Read as any feeder's write would be, so conditioning
+        /// still applies.
+        for (std::uint32_t index : shard.active)
+        {
+            shard.slots[index].sensorInput.store(config_.sensorFeed->sensorMask(firstSlot + index, shard.clock.now()),
+                                                 std::memory_order_relaxed);
+        }
+    }
+
+    if (config_.conditionSensors)
+    {
+        /// One pass filters every slot's detectors together.
+        for (std::uint32_t index : shard.active)
+        {
+            shard.conditioner.setRaw(index, shard.slots[index].sensorInput.load(std::memory_order_relaxed));
+        }
+        shard.conditioner.update();
+    }
+
+    std::uint32_t untilCheck = PREEMPT_CHECK_INTERVAL;
+    for (std::uint32_t index : shard.active)
+    {
+        Slot &slot = shard.slots[index];
+
+        if (--untilCheck == 0)
+        {
+            untilCheck = PREEMPT_CHECK_INTERVAL;
+            if (shard.urgent.load(std::memory_order_acquire))
+            {
+                servicePreemptions(shard);
+            }
+        }
+
+        SensorMask sensors = config_.conditionSensors ? shard.conditioner.conditioned(index)
+                                                      : slot.sensorInput.load(std::memory_order_relaxed);
+        unpackSensors(sensors, slot.sensors);
+        slot.app->run();
+        slot.signalOutput.store(packSignals(slot.app->getSignals()), std::memory_order_release);
+
+        if (slot.preemptedAt != 0 && !slot.app->isClearingForPreemption())
+        {
+            shard.greenLatency.record(steadyNanos() - slot.preemptedAt);
+            slot.preemptedAt = 0;
+        }
+
+        if (state_.isOpen())
+        {
+            state_.save(firstSlot + index, slot.app->snapshot());
+        }
+    }
+
+    shard.ticked.store(static_cast<std::uint32_t>(shard.active.size()), std::memory_order_relaxed);
+    shard.clock.advance(config_.timeStep);
+
+    /// Saved after the controllers, so a crash mid-tick
+    /// replays the tick rather than skipping it.
+    if (state_.isOpen())
+    {
+        state_.saveClock(shard.index, shard.clock.now());
+    }
+}
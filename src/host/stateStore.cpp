@@ -0,0 +1,235 @@
+#include "impl/host/stateStore.hpp"
+
+#include <cstring>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// First bytes of every state file, "TLCSTATE" little-endian
+static constexpr std::uint64_t STATE_MAGIC = 0x4554415453434c54ull;
+
+/// Laid out at the start of the file.
+struct StateHeader
+{
+    std::atomic<std::uint64_t> magic; ///< STATE_MAGIC once the layout is written
+    std::uint32_t version;            ///< STATE_STORE_VERSION
+    std::uint32_t snapshotSize;       ///< sizeof(ControllerSnapshot)
+    std::uint32_t numClocks;          ///< clocks after the header
+    std::uint32_t capacity;           ///< records after the clocks
+};
+
+static_assert(sizeof(StateHeader) <= 64, "StateHeader must fit its cache line");
+
+////////////////////////////////////////////////////////////
+///  @brief Round a size up to whole cache lines
+///
+////////////////////////////////////////////////////////////
+static std::size_t roundToLine(std::size_t size)
+{
+    return (size + 63) & ~static_cast<std::size_t>(63);
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Hash a snapshot a word at a time, seeded with its
+///  sequence so a stale copy never passes for a newer one.
+///
+////////////////////////////////////////////////////////////
+static std::uint64_t checksumOf(std::uint64_t sequence, const ControllerSnapshot &state)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>(&state);
+    std::uint64_t hash = 0xcbf29ce484222325ull ^ sequence;
+    std::size_t offset = 0;
+    for (; offset + sizeof(std::uint64_t) <= sizeof(state); offset += sizeof(std::uint64_t))
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + offset, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ull;
+        hash ^= hash >> 29;
+    }
+    for (; offset < sizeof(state); offset++)
+    {
+        hash = (hash ^ bytes[offset]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+StateStore::StateStore()
+    : base_(nullptr),
+      size_(0),
+      clocks_(nullptr),
+      records_(nullptr),
+      numClocks_(0),
+      capacity_(0),
+      reset_(false)
+{
+}
+
+StateStore::~StateStore()
+{
+    close();
+}
+
+bool StateStore::open(const std::string &path, std::uint32_t numClocks, std::uint32_t capacity, std::string &error)
+{
+    close();
+
+#if defined(__linux__)
+    std::size_t clocksOffset = roundToLine(sizeof(StateHeader));
+    std::size_t recordsOffset = clocksOffset + roundToLine(numClocks * sizeof(std::int64_t));
+    std::size_t size = recordsOffset + static_cast<std::size_t>(capacity) * sizeof(Record);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) < 0)
+    {
+        error = "cannot open " + path;
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    /// A file of the wrong size cannot hold this layout; one
+    /// of the right size is checked once mapped.
+    bool sized = static_cast<std::size_t>(info.st_size) == size;
+    if (!sized && (ftruncate(fd, 0) < 0 || ftruncate(fd, static_cast<off_t>(size)) < 0))
+    {
+        error = "cannot size " + path;
+        ::close(fd);
+        return false;
+    }
+
+    void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        error = "cannot map " + path;
+        return false;
+    }
+
+    base_ = static_cast<std::uint8_t*>(mapped);
+    size_ = size;
+    clocks_ = reinterpret_cast<std::atomic<std::int64_t>*>(base_ + clocksOffset);
+    records_ = reinterpret_cast<Record*>(base_ + recordsOffset);
+    numClocks_ = numClocks;
+    capacity_ = capacity;
+
+    StateHeader *header = reinterpret_cast<StateHeader*>(base_);
+    reset_ = !sized ||
+             header->magic.load(std::memory_order_acquire) != STATE_MAGIC ||
+             header->version != STATE_STORE_VERSION ||
+             header->snapshotSize != sizeof(ControllerSnapshot) ||
+             header->numClocks != numClocks ||
+             header->capacity != capacity;
+
+    if (reset_)
+    {
+        /// The magic goes in last: a crash while laying out
+        /// leaves a file the next open() resets again.
+        header->magic.store(0, std::memory_order_relaxed);
+        std::memset(base_ + sizeof(header->magic), 0, size - sizeof(header->magic));
+        header->version = STATE_STORE_VERSION;
+        header->snapshotSize = sizeof(ControllerSnapshot);
+        header->numClocks = numClocks;
+        header->capacity = capacity;
+        header->magic.store(STATE_MAGIC, std::memory_order_release);
+    }
+
+    return true;
+#else
+    (void)path;
+    (void)numClocks;
+    (void)capacity;
+    error = "state files need Linux";
+    return false;
+#endif
+}
+
+void StateStore::close()
+{
+#if defined(__linux__)
+    if (base_)
+    {
+        munmap(base_, size_);
+    }
+#endif
+    base_ = nullptr;
+    size_ = 0;
+    clocks_ = nullptr;
+    records_ = nullptr;
+    numClocks_ = 0;
+    capacity_ = 0;
+}
+
+void StateStore::save(std::uint32_t slot, const ControllerSnapshot &state)
+{
+    Record &record = records_[slot];
+    std::uint64_t first = record.copies[0].sequence.load(std::memory_order_relaxed);
+    std::uint64_t second = record.copies[1].sequence.load(std::memory_order_relaxed);
+
+    Copy &copy = record.copies[first <= second ? 0 : 1];
+    std::uint64_t sequence = (first > second ? first : second) + 1;
+
+    copy.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&copy.state, &state, sizeof(state));
+    copy.checksum = checksumOf(sequence, copy.state);
+    copy.sequence.store(sequence, std::memory_order_release);
+}
+
+bool StateStore::load(std::uint32_t slot, ControllerSnapshot &state) const
+{
+    const Record &record = records_[slot];
+    const Copy *newest = nullptr;
+    std::uint64_t newestSequence = 0;
+
+    for (const Copy &copy : record.copies)
+    {
+        std::uint64_t sequence = copy.sequence.load(std::memory_order_acquire);
+        if (sequence > newestSequence && copy.checksum == checksumOf(sequence, copy.state))
+        {
+            newest = &copy;
+            newestSequence = sequence;
+        }
+    }
+
+    if (!newest)
+    {
+        return false;
+    }
+    std::memcpy(&state, &newest->state, sizeof(state));
+    return true;
+}
+
+void StateStore::erase(std::uint32_t slot)
+{
+    for (Copy &copy : records_[slot].copies)
+    {
+        copy.sequence.store(0, std::memory_order_release);
+    }
+}
+
+void StateStore::saveClock(std::uint32_t index, IClock::Time now)
+{
+    clocks_[index].store(now, std::memory_order_release);
+}
+
+IClock::Time StateStore::clock(std::uint32_t index) const
+{
+    return static_cast<IClock::Time>(clocks_[index].load(std::memory_order_acquire));
+}
+
+void StateStore::flush()
+{
+#if defined(__linux__)
+    if (base_)
+    {
+        msync(base_, size_, MS_ASYNC);
+    }
+#endif
+}
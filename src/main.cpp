@@ -1,53 +1,34 @@
 #include "impl/simulator/simulator.hpp"
+#include "impl/simulator/scenarios.hpp"
 #include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/config/configManager.hpp"
+#include "impl/replay/pipeline.hpp"
+#include "impl/trace/trace.hpp"
 
-using SS = SensorState;
+#include <fstream>
+#include <thread>
 
 static constexpr Clock::Time TIME_STEP = 10; ///< advance simulator by 10s for each step
 
-/// At T+0, non-stop traffic in all directions. continues for 5 minutes
-static const Scenario SCENARIO_1 = 
-{   //            N-N        N-W        S-S        S-E        E-E        E-N        W-W        W-S
-    { 0,  300,  { SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET   }}
-};
+static constexpr unsigned PIPELINE_MIN_CORES = 3; ///< one core per pipeline stage, else run serially
 
-/// at T+0, there is  N-W and S-E traffic
-/// at T+10, an infinite line of vehicles pulls up to the N-N sensor
-/// at T+20, all N-W and S-E traffic stops
-static const Scenario SCENARIO_2 = 
-{   //             N-N        N-W        S-S        S-E        E-E        E-N        W-W        W-S
-    { 0,   10,   { SS::CLEAR, SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
-    { 10,  20,   { SS::SET,   SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
-    { 20,  300,  { SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }}
-};
-
-static const Scenario SCENARIO_3 =
-{   //             N-N        N-W        S-S        S-E        E-E        E-N        W-W        W-S
-    { 0,   300,  { SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET   }},
-    { 300, 310,  { SS::CLEAR, SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
-    { 310, 330,  { SS::SET,   SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
-    { 330, 600,  { SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }}
-};
-
-static const Scenario SCENARIO_4 =
-{   //             N-N        N-W        S-S        S-E        E-E        E-N        W-W        W-S
-    { 0,   300,  { SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET   }},
-    { 300, 310,  { SS::CLEAR, SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
-    { 310, 330,  { SS::SET,   SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
-    { 330, 600,  { SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
-    { 600, 900,  { SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET   }}
-};
-
-/// Ideally I would move this maxWaitTime value into a config file
-/// and a ConfigClass would be passed into TrafficLightControllerApp::ctor()
-static IClock::Time maxWaitTime = 40;
-
-void runScenarios(Scenario scenario)
+void runScenarios(Scenario scenario, ConfigManager &config, ConfigManager::ReaderId reader)
 {
+    /// The simulator reads ahead and the controller runs on
+    /// threads of their own while this one prints. With fewer
+    /// cores than stages the threads only take turns, so run
+    /// the loop serially instead.
+    if (std::thread::hardware_concurrency() >= PIPELINE_MIN_CORES)
+    {
+        replayPipelined(scenario, TIME_STEP, config, reader, &std::cout);
+        return;
+    }
+
     Simulator simulator(scenario);
     auto &clock = simulator.clock();
     auto &sensors = simulator.sensors();
-    TrafficLightControllerApp tlcApp(clock, sensors, maxWaitTime);
+    TrafficLightControllerApp tlcApp(clock, sensors, config.read().maxWaitTime);
+    tlcApp.attachConfig(config, reader);
     tlcApp.initApp();
 
     std::cout << simulator.BANNER << std::endl;
@@ -74,8 +55,29 @@ int main
     char const *argv[]
 )
 {
-    runScenarios(SCENARIO_1);
-    runScenarios(SCENARIO_2);
-    runScenarios(SCENARIO_3);
-    runScenarios(SCENARIO_4);
+    /// Timing comes from the file given on the command line, if any,
+    /// and is reloaded whenever the file changes.
+    ConfigManager config;
+    if (argc > 1)
+    {
+        if (!config.loadFile(argv[1]))
+        {
+            return 1;
+        }
+        config.watchFile(argv[1]);
+    }
+    ConfigManager::ReaderId reader = config.registerReader();
+
+    runScenarios(SCENARIO_1, config, reader);
+    runScenarios(SCENARIO_2, config, reader);
+    runScenarios(SCENARIO_3, config, reader);
+    runScenarios(SCENARIO_4, config, reader);
+
+    config.unregisterReader(reader);
+
+#if defined(TLC_TRACE_ENABLED)
+    /// Open in Perfetto (ui.perfetto.dev) or chrome://tracing
+    std::ofstream traceFile("trace.json");
+    Tracer::writeChromeTrace(traceFile);
+#endif
 }
@@ -0,0 +1,274 @@
+#include "impl/policy/mpcPolicy.hpp"
+#include "impl/trace/trace.hpp"
+
+#include <algorithm>
+
+/// Weight of the newest tick in the learned sensor rates
+static constexpr float LEARNING_RATE = 1.0f / 16.0f;
+
+/// Sensor rates assumed before any tick is seen
+static constexpr float INITIAL_RATE = 0.02f;
+
+MpcConfig defaultMpcConfig()
+{
+    MpcConfig config;
+    config.candidates = 6;
+    config.samples = 8;
+    config.horizon = 60;
+    config.timeStep = 1;
+    config.budget = std::chrono::microseconds(5000);
+    config.workers = 0;
+    config.seed = 1;
+    return config;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Holds the forked pattern for a number of steps,
+///  ends it, then leaves the rest to the controller's rules.
+///
+////////////////////////////////////////////////////////////
+class HoldThenFollow : public IDecisionPolicy
+{
+public:
+    HoldThenFollow() :
+        holdSteps_(0),
+        step_(0)
+    { }
+
+    inline void reset(unsigned holdSteps)
+    {
+        holdSteps_ = holdSteps;
+        step_ = 0;
+    }
+
+    Decision decide(const ControllerSnapshot&) override
+    {
+        unsigned step = step_++;
+        if (step < holdSteps_)
+        {
+            return Decision::HOLD;
+        }
+        return step == holdSteps_ ? Decision::ADVANCE : Decision::FOLLOW_RULES;
+    }
+
+private:
+    unsigned holdSteps_; ///< steps to hold before ending the pattern
+    unsigned step_;      ///< steps decided so far
+};
+
+////////////////////////////////////////////////////////////
+///  @brief A controller forked for one (choice, future) pair,
+///  with its own clock and sensors.
+///
+////////////////////////////////////////////////////////////
+struct MpcPolicy::Rollout
+{
+    Rollout() :
+        clock(),
+        sensors(),
+        script(),
+        app(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr)
+    {
+        sensors.fill(SensorState::CLEAR);
+        app.attachPolicy(&script);
+        app.initApp();
+    }
+
+    Clock clock;                   ///< fork's clock
+    VehicleSensors sensors;        ///< sampled future sensors
+    HoldThenFollow script;         ///< the choice being scored
+    TrafficLightControllerApp app; ///< the fork
+};
+
+MpcPolicy::MpcPolicy
+(
+    const MpcConfig &config
+)
+    : config_(config),
+      stats_(),
+      latency_(),
+      arrivalRate_(),
+      departureRate_(),
+      lastSensors_(),
+      lastTime_(0),
+      observed_(false),
+      state_(nullptr),
+      deadline_(),
+      rollouts_(),
+      waits_(),
+      pool_(config.workers)
+{
+    config_.candidates = std::max(2u, config_.candidates);
+    config_.samples = std::max(1u, config_.samples);
+    config_.timeStep = std::max<IClock::Time>(1, config_.timeStep);
+
+    arrivalRate_.fill(INITIAL_RATE);
+    departureRate_.fill(INITIAL_RATE);
+
+    std::size_t jobs = static_cast<std::size_t>(config_.candidates) * config_.samples;
+    for (std::size_t job = 0; job < jobs; job++)
+    {
+        rollouts_.emplace_back(new Rollout());
+    }
+    waits_.resize(jobs, -1);
+}
+
+MpcPolicy::~MpcPolicy() = default;
+
+Decision MpcPolicy::decide(const ControllerSnapshot &state)
+{
+    TRACE_SCOPE("MpcPolicy::decide");
+
+    auto start = std::chrono::steady_clock::now();
+    stats_.decisions++;
+    observe(state);
+
+    /// Outside the window where the pattern may end, the
+    /// controller's limits decide; with nobody waiting, rest.
+    const TrafficLightState &active = state.lightStates[state.activePattern];
+    if (active.activeTime < active.minActiveTime || active.activeTime >= active.maxActiveTime ||
+        !state.carsAwaiting)
+    {
+        return Decision::HOLD;
+    }
+
+    /// Holding past maxActiveTime is the same as holding to it.
+    IClock::Time remaining = active.maxActiveTime - active.activeTime;
+    unsigned candidates = static_cast<unsigned>(std::min<IClock::Time>(
+        config_.candidates, (remaining + config_.timeStep - 1) / config_.timeStep + 1));
+
+    /// Jobs run choice by choice, so a search cut short by
+    /// the budget still has its first choices complete.
+    state_ = &state;
+    deadline_ = start + config_.budget;
+    std::fill(waits_.begin(), waits_.end(), -1);
+
+    auto runRollout = [this](std::size_t job) { rollout(job); };
+    pool_.run(static_cast<std::size_t>(candidates) * config_.samples, runRollout);
+
+    Decision decision = Decision::FOLLOW_RULES;
+    std::int64_t bestWait = -1;
+    unsigned complete = 0;
+
+    for (unsigned candidate = 0; candidate < candidates; candidate++)
+    {
+        std::int64_t wait = 0;
+        bool finished = true;
+        for (unsigned sample = 0; sample < config_.samples && finished; sample++)
+        {
+            std::int64_t sampleWait = waits_[candidate * config_.samples + sample];
+            finished = sampleWait >= 0;
+            wait += sampleWait;
+        }
+        if (!finished)
+        {
+            break;
+        }
+
+        /// Ties go to the earliest end, as under the rules, so
+        /// no lane waits longer for a choice that gains nothing.
+        complete++;
+        stats_.rollouts += config_.samples;
+        if (bestWait < 0 || wait < bestWait)
+        {
+            bestWait = wait;
+            decision = candidate == 0 ? Decision::ADVANCE : Decision::HOLD;
+        }
+    }
+
+    if (complete < 2)
+    {
+        stats_.overruns++;
+        decision = Decision::FOLLOW_RULES;
+    }
+    else
+    {
+        stats_.searches++;
+        stats_.overruns += complete < candidates;
+    }
+
+    state_ = nullptr;
+    latency_.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count()));
+
+    return decision;
+}
+
+void MpcPolicy::observe(const ControllerSnapshot &state)
+{
+    if (observed_ && state.now > lastTime_)
+    {
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            bool set = state.sensors[lane] == SensorState::SET;
+            if (lastSensors_[lane] == SensorState::SET)
+            {
+                departureRate_[lane] += LEARNING_RATE * ((set ? 0.0f : 1.0f) - departureRate_[lane]);
+            }
+            else
+            {
+                arrivalRate_[lane] += LEARNING_RATE * ((set ? 1.0f : 0.0f) - arrivalRate_[lane]);
+            }
+        }
+    }
+
+    lastSensors_ = state.sensors;
+    lastTime_ = state.now;
+    observed_ = true;
+}
+
+void MpcPolicy::rollout(std::size_t job)
+{
+    if (std::chrono::steady_clock::now() > deadline_)
+    {
+        return;
+    }
+
+    Rollout &fork = *rollouts_[job];
+    const ControllerSnapshot &state = *state_;
+    unsigned candidate = static_cast<unsigned>(job / config_.samples);
+    unsigned sample = static_cast<unsigned>(job % config_.samples);
+
+    fork.clock.set(state.now);
+    fork.sensors = state.sensors;
+    fork.app.restore(state);
+    fork.script.reset(candidate);
+
+    /// The same future for every choice: seeded by decision
+    /// and sample only.
+    std::uint64_t rng = (config_.seed ^ (stats_.decisions * 0x9E3779B97F4A7C15ull)) + sample * 0xBF58476D1CE4E5B9ull;
+    rng = rng ? rng : 1;
+
+    std::int64_t wait = 0;
+    for (unsigned step = 0; step < config_.horizon; step++)
+    {
+        fork.app.run();
+
+        LaneMask green = PATTERN_TRANSITIONS[fork.app.getActivePattern()].greenLanes;
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            if (fork.sensors[lane] == SensorState::SET && !(green & laneBit(lane)))
+            {
+                wait += config_.timeStep;
+            }
+
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+            float uniform = static_cast<float>(rng >> 40) * (1.0f / 16777216.0f);
+
+            if (fork.sensors[lane] == SensorState::SET)
+            {
+                fork.sensors[lane] = uniform < departureRate_[lane] ? SensorState::CLEAR : SensorState::SET;
+            }
+            else
+            {
+                fork.sensors[lane] = uniform < arrivalRate_[lane] ? SensorState::SET : SensorState::CLEAR;
+            }
+        }
+
+        fork.clock.advance(config_.timeStep);
+    }
+
+    waits_[job] = wait;
+}
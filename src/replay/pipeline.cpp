@@ -0,0 +1,149 @@
+#include "impl/replay/pipeline.hpp"
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/util/spscQueue.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+/// Frames each stage may run ahead of the next
+static constexpr std::size_t PIPELINE_DEPTH = 256;
+
+////////////////////////////////////////////////////////////
+///  @brief Sensors of one tick, from the simulator stage to
+///  the controller stage.
+///
+////////////////////////////////////////////////////////////
+struct SensorFrame
+{
+    Clock::Time now;        ///< time of the tick
+    VehicleSensors sensors; ///< sensors read for it
+    bool last;              ///< scenario done, no tick to run
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Outcome of one tick, from the controller stage to
+///  the output stage.
+///
+////////////////////////////////////////////////////////////
+struct SignalFrame
+{
+    Clock::Time now;             ///< time of the tick
+    VehicleSensors sensors;      ///< sensors the tick read
+    TrafficSignals signals;      ///< signals after the tick
+    TrafficLightPattern pattern; ///< active pattern after the tick
+    std::string log;             ///< messages the controller printed during the tick
+    bool last;                   ///< scenario done
+};
+
+ReplayResult replayPipelined
+(
+    const Scenario &scenario,
+    Clock::Time timeStep,
+    ConfigManager &config,
+    ConfigManager::ReaderId reader,
+    std::ostream *out,
+    PipelineStats *stats
+)
+{
+    ReplayResult result;
+    result.fastForwardSteps = 0;
+    PipelineStats waits = {};
+
+    SpscQueue<SensorFrame, PIPELINE_DEPTH> sensorFrames;
+    SpscQueue<SignalFrame, PIPELINE_DEPTH> signalFrames;
+
+    /// Built here so its start-up messages come before the
+    /// banner, then handed to the controller stage.
+    Simulator simulator(scenario);
+    Clock clock;
+    VehicleSensors sensors = simulator.sensors();
+    std::ostringstream log;
+    TrafficLightControllerApp tlcApp(clock, sensors, config.read().maxWaitTime, out ? &log : nullptr);
+    tlcApp.attachConfig(config, reader);
+    tlcApp.initApp();
+
+    if (out)
+    {
+        *out << log.str() << Simulator::BANNER << std::endl;
+        log.str(std::string());
+    }
+
+    std::thread simulatorStage([&]()
+    {
+        for (;;)
+        {
+            SensorFrame frame = {simulator.clock().now(), simulator.sensors(), simulator.done()};
+            waits.simulatorWaits += sensorFrames.push(frame) ? 1 : 0;
+            if (frame.last)
+            {
+                break;
+            }
+            simulator.advance(timeStep);
+        }
+    });
+
+    std::thread controllerStage([&]()
+    {
+        SensorFrame in;
+        SignalFrame frame;
+        for (;;)
+        {
+            waits.controllerWaits += sensorFrames.pop(in) ? 1 : 0;
+            frame.last = in.last;
+            if (!in.last)
+            {
+                clock.set(in.now);
+                sensors = in.sensors;
+                tlcApp.run();
+
+                frame.now = in.now;
+                frame.sensors = in.sensors;
+                frame.signals = tlcApp.getSignals();
+                frame.pattern = tlcApp.getActivePattern();
+                if (out)
+                {
+                    frame.log = log.str();
+                    log.str(std::string());
+                }
+            }
+
+            signalFrames.push(frame);
+            if (frame.last)
+            {
+                break;
+            }
+        }
+    });
+
+    /// The output stage, on the calling thread
+    ScheduleScorer scorer(timeStep);
+    SignalFrame frame;
+    for (;;)
+    {
+        waits.outputWaits += signalFrames.pop(frame) ? 1 : 0;
+        if (frame.last)
+        {
+            break;
+        }
+
+        if (out)
+        {
+            printSignals(*out << frame.log, frame.now, frame.signals) << std::endl;
+        }
+        result.schedule.push_back(frame.pattern);
+        scorer.add(frame.sensors, frame.pattern);
+    }
+
+    simulatorStage.join();
+    controllerStage.join();
+
+    waits.ticks = result.schedule.size();
+    if (stats)
+    {
+        *stats = waits;
+    }
+
+    result.metrics = scorer.metrics();
+    return result;
+}
@@ -0,0 +1,586 @@
+#include "impl/replay/replay.hpp"
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/config/configManager.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+SensorTimeline sampleScenario(const Scenario &scenario, Clock::Time timeStep)
+{
+    SensorTimeline timeline;
+    Simulator simulator(scenario);
+
+    while (!simulator.done())
+    {
+        timeline.push_back(simulator.sensors());
+        simulator.advance(timeStep);
+    }
+
+    return timeline;
+}
+
+ScheduleScorer::ScheduleScorer(Clock::Time timeStep) :
+    timeStep_(timeStep),
+    metrics_(),
+    waiting_(),
+    last_(NUM_PATTERNS)
+{ }
+
+void ScheduleScorer::add
+(
+    const VehicleSensors &sensors,
+    TrafficLightPattern pattern
+)
+{
+    LaneMask green = PATTERN_TRANSITIONS[pattern].greenLanes;
+
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        if (sensors[lane] == SensorState::SET && !(green & laneBit(lane)))
+        {
+            waiting_[lane] += timeStep_;
+            metrics_.totalWait += timeStep_;
+            metrics_.maxWait = std::max(metrics_.maxWait, waiting_[lane]);
+        }
+        else
+        {
+            waiting_[lane] = 0;
+        }
+    }
+
+    if (last_ != NUM_PATTERNS && pattern != last_)
+    {
+        metrics_.patternChanges++;
+    }
+    last_ = pattern;
+    metrics_.duration += timeStep_;
+}
+
+ReplayMetrics scoreSchedule
+(
+    const SensorTimeline &timeline,
+    const PatternSchedule &schedule,
+    Clock::Time timeStep
+)
+{
+    ScheduleScorer scorer(timeStep);
+    for (std::size_t step = 0; step < timeline.size() && step < schedule.size(); step++)
+    {
+        scorer.add(timeline[step], schedule[step]);
+    }
+    return scorer.metrics();
+}
+
+/// Snapshot fields as numbers, times relative to the clock
+using StateKey = std::array<std::int64_t, 4 + Lane::COUNT + 6 * NUM_PATTERNS + 3 * Lane::COUNT>;
+
+////////////////////////////////////////////////////////////
+///  @brief Reduce a controller state to what decides its
+///  future.
+///
+///  The controller only compares a pattern's active time
+///  with its limits, and a wait with maxWaitTime, so the
+///  times past those are all alike. Capping them lets a
+///  controller resting in one pattern repeat every step, and
+///  two controllers that only differ in how long ago things
+///  happened compare equal. A controller enforcing
+///  maxWaitTime serves overdue lanes oldest first, so then
+///  the waits are kept whole.
+///
+///  @param state Controller state after a step
+///  @param capWaits Cap waits at maxWaitTime
+///  @return StateKey The state's key
+////////////////////////////////////////////////////////////
+static StateKey stateKey(const ControllerSnapshot &state, bool capWaits)
+{
+    IClock::Time waitCap = capWaits ? state.maxWaitTime : std::numeric_limits<IClock::Time>::max();
+    StateKey key;
+    std::size_t i = 0;
+    key[i++] = state.activePattern;
+    key[i++] = state.carsAwaiting;
+    key[i++] = state.maxWaitTime;
+    key[i++] = state.tickLength;
+    for (SignalState signal : state.signals)
+    {
+        key[i++] = static_cast<std::int64_t>(signal);
+    }
+    for (const TrafficLightState &light : state.lightStates)
+    {
+        key[i++] = light.isOn;
+        key[i++] = light.areOpposingLanesClear;
+        IClock::Time cap = std::max(light.minActiveTime, light.maxActiveTime);
+        key[i++] = light.isOn ? std::min(cap, state.now - light.startTime) : light.startTime;
+        key[i++] = std::min(cap, light.activeTime);
+        key[i++] = light.minActiveTime;
+        key[i++] = light.maxActiveTime;
+    }
+    for (const VehicleState &vehicle : state.vehicleStates)
+    {
+        key[i++] = vehicle.isWaiting;
+        key[i++] = vehicle.isWaiting ? std::min(waitCap, state.now - vehicle.arrivalTime)
+                                     : vehicle.arrivalTime;
+        key[i++] = std::min(waitCap, vehicle.waitTime);
+    }
+    return key;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Controller states seen while the sensors hold
+///  steady, to find where the controller starts repeating.
+///
+////////////////////////////////////////////////////////////
+class CycleTable
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Construct an empty CycleTable
+    ///
+    ///  @param capWaits Cap waits in the recorded states, see
+    ///  stateKey()
+    ////////////////////////////////////////////////////////////
+    explicit CycleTable(bool capWaits) : capWaits_(capWaits) {}
+
+    /// Returned by #find() for a state not seen before
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+    inline void clear()
+    {
+        steps_.clear();
+        keys_.clear();
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Look up a state, and record it if it is new.
+    ///
+    ///  @param state Controller state after a step
+    ///  @param step Index of that step
+    ///  @return std::size_t Step with the same state, or NONE
+    ////////////////////////////////////////////////////////////
+    std::size_t find(const ControllerSnapshot &state, std::size_t step)
+    {
+        StateKey key = stateKey(state, capWaits_);
+
+        std::uint64_t hash = 0xCBF29CE484222325ull;
+        for (std::int64_t word : key)
+        {
+            hash = (hash ^ static_cast<std::uint64_t>(word)) * 0x100000001B3ull;
+        }
+
+        auto seen = steps_.emplace(hash, keys_.size());
+        if (seen.second)
+        {
+            keys_.emplace_back(key, step);
+            return NONE;
+        }
+
+        /// A different state with the same hash is never matched.
+        const std::pair<StateKey, std::size_t> &entry = keys_[seen.first->second];
+        return entry.first == key ? entry.second : NONE;
+    }
+
+private:
+    bool capWaits_;                                        ///< cap waits in the keys
+    std::unordered_map<std::uint64_t, std::size_t> steps_; ///< state hash -> index in keys_
+    std::vector<std::pair<StateKey, std::size_t>> keys_;   ///< each state seen, with its step
+};
+
+constexpr std::size_t CycleTable::NONE;
+
+////////////////////////////////////////////////////////////
+///  @brief Move a snapshot's times forward.
+///
+////////////////////////////////////////////////////////////
+static void shiftSnapshot(ControllerSnapshot &state, IClock::Time delta)
+{
+    state.now += delta;
+    for (TrafficLightState &light : state.lightStates)
+    {
+        light.startTime += light.isOn ? delta : 0;
+    }
+    for (VehicleState &vehicle : state.vehicleStates)
+    {
+        vehicle.arrivalTime += vehicle.isWaiting ? delta : 0;
+    }
+    if (state.preemptPattern != TrafficLightPattern::NUM_PATTERNS)
+    {
+        state.preemptRedAt += delta;
+        state.preemptGreenAt += delta;
+    }
+}
+
+ReplayResult replayController
+(
+    const Scenario &scenario,
+    Clock::Time timeStep,
+    const TimingConfig &timing,
+    IDecisionPolicy *policy,
+    bool fastForward
+)
+{
+    ReplayResult result;
+    result.fastForwardSteps = 0;
+    SensorTimeline timeline;
+
+    /// Every pattern shows for at least its minActiveTime, so a
+    /// timeslice shorter than two cycles has no cycle to skip.
+    IClock::Time minCycle = 0;
+    for (const PatternTiming &pattern : timing.patterns)
+    {
+        minCycle += pattern.minActiveTime;
+    }
+
+    CycleTable cycles(!timing.enforceMaxWait);
+    bool tracking = false;
+    Clock::Time sliceEnd = -1;
+
+    Clock::Time end = 0;
+    for (const SimulationTimeslice &slice : scenario)
+    {
+        end = std::max(end, slice.end);
+    }
+    std::size_t steps = static_cast<std::size_t>(end / std::max<Clock::Time>(1, timeStep)) + 1;
+    timeline.reserve(steps);
+    result.schedule.reserve(steps);
+
+    Simulator simulator(scenario);
+    ConfigManager config(timing, nullptr);
+    ConfigManager::ReaderId reader = config.registerReader();
+
+    TrafficLightControllerApp tlcApp(simulator.clock(), simulator.sensors(), timing.maxWaitTime, nullptr);
+    tlcApp.attachConfig(config, reader);
+    tlcApp.attachPolicy(policy);
+    tlcApp.initApp();
+
+    while (!simulator.done())
+    {
+        tlcApp.run();
+        simulator.update_lane_signals(tlcApp.getSignals());
+
+        timeline.push_back(simulator.sensors());
+        result.schedule.push_back(tlcApp.getActivePattern());
+
+        if (fastForward && !policy && simulator.sliceEnd() != sliceEnd)
+        {
+            sliceEnd = simulator.sliceEnd();
+            tracking = sliceEnd - simulator.clock().now() >= 2 * minCycle;
+            cycles.clear();
+        }
+
+        if (tracking)
+        {
+            ControllerSnapshot state = tlcApp.snapshot();
+            std::size_t step = result.schedule.size() - 1;
+            std::size_t earlier = cycles.find(state, step);
+
+            if (earlier != CycleTable::NONE)
+            {
+                /// Whole cycles that end before the sensors change
+                std::size_t period = step - earlier;
+                std::size_t remaining = static_cast<std::size_t>((sliceEnd - 1 - state.now) / timeStep);
+                std::size_t skip = remaining / period * period;
+
+                std::size_t copied = result.schedule.size();
+                result.schedule.resize(copied + skip);
+                for (std::size_t k = copied; k < copied + skip; k++)
+                {
+                    result.schedule[k] = result.schedule[k - period];
+                }
+                timeline.insert(timeline.end(), skip, simulator.sensors());
+
+                IClock::Time shift = static_cast<IClock::Time>(skip) * timeStep;
+                simulator.advance(shift);
+                shiftSnapshot(state, shift);
+                tlcApp.restore(state);
+                simulator.update_lane_signals(tlcApp.getSignals());
+
+                result.fastForwardSteps += skip;
+                tracking = false;
+            }
+        }
+
+        simulator.advance(timeStep);
+    }
+
+    config.unregisterReader(reader);
+
+    result.metrics = scoreSchedule(timeline, result.schedule, timeStep);
+    return result;
+}
+
+/// Ticks a speculative controller runs before its segment, to forget how it started
+static constexpr std::size_t WARMUP_STEPS = 900;
+
+/// Ticks between the states a speculative segment records
+static constexpr std::size_t CHECKPOINT_STEPS = 30;
+
+////////////////////////////////////////////////////////////
+///  @brief One piece of a replayControllerParallel(), and
+///  what its speculative run reached.
+///
+////////////////////////////////////////////////////////////
+struct ReplaySegment
+{
+    std::size_t first;                 ///< first step of the segment
+    std::size_t last;                  ///< one past its last step
+    std::vector<StateKey> checkpoints; ///< state after every CHECKPOINT_STEPS-th step from first
+    ControllerSnapshot end;            ///< state after the last step
+    std::size_t ran;                   ///< ticks run, warm-up included
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Check whether no vehicle is at the intersection
+///
+////////////////////////////////////////////////////////////
+static bool allClear(const VehicleSensors &sensors)
+{
+    return std::all_of(sensors.begin(), sensors.end(),
+                       [](SensorState sensor) { return sensor == SensorState::CLEAR; });
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Count the steps the Simulator replays a scenario
+///  for: up to the first step that falls in no timeslice.
+///
+///  @param scenario Scenario to replay
+///  @param timeStep Time between steps
+///  @return std::size_t Steps replayed
+////////////////////////////////////////////////////////////
+static std::size_t countSteps(const Scenario &scenario, Clock::Time timeStep)
+{
+    std::vector<std::pair<Clock::Time, Clock::Time>> spans;
+    for (const SimulationTimeslice &slice : scenario)
+    {
+        if (slice.start < slice.end)
+        {
+            spans.emplace_back(slice.start, slice.end);
+        }
+    }
+    std::sort(spans.begin(), spans.end());
+
+    /// First step time not yet known to be covered
+    Clock::Time next = 0;
+    for (const std::pair<Clock::Time, Clock::Time> &span : spans)
+    {
+        if (span.first > next)
+        {
+            break;
+        }
+        if (span.second > next)
+        {
+            next = (span.second + timeStep - 1) / timeStep * timeStep;
+        }
+    }
+    return static_cast<std::size_t>(next / timeStep);
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Find the steps where the sensors have just gone
+///  all CLEAR, so no vehicle is carried over.
+///
+///  @param scenario Scenario to replay
+///  @param timeStep Time between steps
+///  @return std::vector<std::size_t> The steps, in order
+////////////////////////////////////////////////////////////
+static std::vector<std::size_t> findCuts(const Scenario &scenario, Clock::Time timeStep)
+{
+    std::vector<std::size_t> cuts;
+    for (std::size_t i = 1; i < scenario.size(); i++)
+    {
+        if (allClear(scenario[i].sensors) && !allClear(scenario[i - 1].sensors) && scenario[i].start >= 0)
+        {
+            cuts.push_back(static_cast<std::size_t>((scenario[i].start + timeStep - 1) / timeStep));
+        }
+    }
+    std::sort(cuts.begin(), cuts.end());
+    return cuts;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Silent controller ticking through a scenario from
+///  any step.
+///
+////////////////////////////////////////////////////////////
+class SegmentRunner
+{
+public:
+    SegmentRunner(const Scenario &scenario, Clock::Time timeStep, const TimingConfig &timing) :
+        timeStep_(timeStep),
+        simulator_(scenario),
+        config_(timing, nullptr),
+        reader_(config_.registerReader()),
+        app_(simulator_.clock(), simulator_.sensors(), timing.maxWaitTime, nullptr)
+    {
+        app_.attachConfig(config_, reader_);
+    }
+
+    ~SegmentRunner()
+    {
+        config_.unregisterReader(reader_);
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Move to a step with a powered-up controller
+    ///
+    ////////////////////////////////////////////////////////////
+    inline void start(std::size_t step)
+    {
+        simulator_.seek(static_cast<Clock::Time>(step) * timeStep_);
+        app_.initApp();
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Move to a step with the controller in a state
+    ///
+    ////////////////////////////////////////////////////////////
+    inline void start(std::size_t step, const ControllerSnapshot &state)
+    {
+        simulator_.seek(static_cast<Clock::Time>(step) * timeStep_);
+        app_.initApp();
+        app_.restore(state);
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Run the controller for the current step and
+    ///  move to the next.
+    ///
+    ///  @return TrafficLightPattern Pattern shown for the step
+    ////////////////////////////////////////////////////////////
+    inline TrafficLightPattern tick()
+    {
+        app_.run();
+        simulator_.update_lane_signals(app_.getSignals());
+        TrafficLightPattern pattern = app_.getActivePattern();
+        simulator_.advance(timeStep_);
+        return pattern;
+    }
+
+    inline const VehicleSensors& sensors() const
+    {
+        return simulator_.sensors();
+    }
+
+    inline ControllerSnapshot snapshot() const
+    {
+        return app_.snapshot();
+    }
+
+private:
+    Clock::Time timeStep_;               ///< time between ticks
+    Simulator simulator_;                ///< replays the scenario
+    ConfigManager config_;               ///< timing plan
+    ConfigManager::ReaderId reader_;     ///< the controller's reader of config_
+    TrafficLightControllerApp app_;      ///< the controller
+};
+
+ReplayResult replayControllerParallel
+(
+    const Scenario &scenario,
+    Clock::Time timeStep,
+    WorkerPool &pool,
+    const TimingConfig &timing,
+    ParallelReplayStats *stats
+)
+{
+    ReplayResult result;
+    result.fastForwardSteps = 0;
+    std::size_t steps = countSteps(scenario, timeStep);
+    SensorTimeline timeline(steps);
+    result.schedule.resize(steps);
+    bool capWaits = !timing.enforceMaxWait;
+
+    /// Cut one even segment per thread, each moved up to the
+    /// next time the intersection empties. More segments only
+    /// add warm-ups and cuts to carry the state across.
+    std::size_t count = std::max<std::size_t>(1, std::min<std::size_t>(steps, pool.size()));
+    std::vector<std::size_t> cuts = findCuts(scenario, timeStep);
+    std::vector<ReplaySegment> segments;
+    std::size_t first = 0;
+    for (std::size_t i = 1; i <= count; i++)
+    {
+        std::size_t last = std::min(steps, std::max(first + 1, steps * i / count));
+        auto cut = std::lower_bound(cuts.begin(), cuts.end(), last);
+        if (i < count && cut != cuts.end() && *cut < steps * (i + 1) / count)
+        {
+            last = *cut;
+        }
+
+        if (last > first)
+        {
+            segments.push_back(ReplaySegment{first, last, {}, ControllerSnapshot(), 0});
+            first = last;
+        }
+    }
+
+    /// Run every segment at once from a guessed start state.
+    auto speculate = [&](std::size_t index)
+    {
+        ReplaySegment &segment = segments[index];
+        std::size_t warmup = std::min(segment.first, WARMUP_STEPS);
+        SegmentRunner runner(scenario, timeStep, timing);
+        runner.start(segment.first - warmup);
+        for (std::size_t step = segment.first - warmup; step < segment.first; step++)
+        {
+            runner.tick();
+        }
+
+        segment.checkpoints.reserve((segment.last - segment.first) / CHECKPOINT_STEPS + 1);
+        for (std::size_t step = segment.first; step < segment.last; step++)
+        {
+            timeline[step] = runner.sensors();
+            result.schedule[step] = runner.tick();
+            if ((step - segment.first) % CHECKPOINT_STEPS == 0)
+            {
+                segment.checkpoints.push_back(stateKey(runner.snapshot(), capWaits));
+            }
+        }
+        segment.end = runner.snapshot();
+        segment.ran = warmup + segment.last - segment.first;
+    };
+    pool.run(segments.size(), speculate);
+
+    /// Carry the true state across each cut until it meets the
+    /// speculative run. The first segment started from power
+    /// up like the real run, so it is right as it is.
+    ParallelReplayStats split = {segments.size(), segments.empty() ? 0u : 1u, steps, 0, 0};
+    SegmentRunner runner(scenario, timeStep, timing);
+    for (std::size_t index = 0; index < segments.size(); index++)
+    {
+        ReplaySegment &segment = segments[index];
+        split.parallelSteps += segment.ran;
+        if (index == 0)
+        {
+            continue;
+        }
+
+        runner.start(segment.first, segments[index - 1].end);
+        bool met = false;
+        std::size_t step = segment.first;
+        for (; step < segment.last && !met; step++)
+        {
+            result.schedule[step] = runner.tick();
+            split.fixupSteps++;
+            met = (step - segment.first) % CHECKPOINT_STEPS == 0 &&
+                  stateKey(runner.snapshot(), capWaits) == segment.checkpoints[(step - segment.first) / CHECKPOINT_STEPS];
+        }
+
+        if (met)
+        {
+            split.converged += step == segment.first + 1 ? 1 : 0;
+        }
+        else
+        {
+            segment.end = runner.snapshot();
+        }
+    }
+
+    if (stats)
+    {
+        *stats = split;
+    }
+
+    result.metrics = scoreSchedule(timeline, result.schedule, timeStep);
+    return result;
+}
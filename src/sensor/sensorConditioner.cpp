@@ -0,0 +1,200 @@
+#include "impl/sensor/sensorConditioner.hpp"
+#include "impl/trace/trace.hpp"
+
+#include <algorithm>
+#include <bitset>
+
+constexpr unsigned SensorConditioner::COUNTER_BITS;
+constexpr unsigned SensorConditioner::MAX_TICKS;
+constexpr unsigned SensorConditioner::INTERSECTIONS_PER_WORD;
+
+DetectorTiming defaultDetectorTiming()
+{
+    DetectorTiming timing;
+    timing.onDelay = 2;
+    timing.minPresence = 3;
+    timing.gapOut = 2;
+    return timing;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Add one to the counters selected by a mask,
+///  stopping at the largest count.
+///
+////////////////////////////////////////////////////////////
+static inline void increment(std::array<std::uint64_t, SensorConditioner::COUNTER_BITS> &planes, std::uint64_t mask)
+{
+    std::uint64_t carry = mask;
+    for (std::uint64_t &plane : planes)
+    {
+        std::uint64_t next = plane & carry;
+        plane ^= carry;
+        carry = next;
+    }
+
+    /// A carry out of the top bit wrapped to zero: saturate.
+    for (std::uint64_t &plane : planes)
+    {
+        plane |= carry;
+    }
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Zero the counters selected by a mask.
+///
+////////////////////////////////////////////////////////////
+static inline void clear(std::array<std::uint64_t, SensorConditioner::COUNTER_BITS> &planes, std::uint64_t mask)
+{
+    for (std::uint64_t &plane : planes)
+    {
+        plane &= ~mask;
+    }
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Compare every counter with its threshold.
+///
+///  @return std::uint64_t Bits whose counter >= threshold
+////////////////////////////////////////////////////////////
+static inline std::uint64_t atLeast(const std::array<std::uint64_t, SensorConditioner::COUNTER_BITS> &counter,
+                                    const std::array<std::uint64_t, SensorConditioner::COUNTER_BITS> &threshold)
+{
+    /// From the top bit down: greater once a bit differs in
+    /// the counter's favour while all higher bits were equal.
+    std::uint64_t greater = 0;
+    std::uint64_t equal = ~0ull;
+    for (unsigned bit = SensorConditioner::COUNTER_BITS; bit > 0; bit--)
+    {
+        std::uint64_t c = counter[bit - 1];
+        std::uint64_t t = threshold[bit - 1];
+        greater |= equal & c & ~t;
+        equal &= ~(c ^ t);
+    }
+    return greater | equal;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Get the word bit of a detector, laid out the same
+///  as the bytes written by SensorConditioner::setRaw().
+///
+////////////////////////////////////////////////////////////
+static inline std::uint64_t detectorBit(IntersectionId intersection, Lane lane)
+{
+    std::uint64_t word = 0;
+    reinterpret_cast<std::uint8_t*>(&word)[intersection % SensorConditioner::INTERSECTIONS_PER_WORD] = laneBit(lane);
+    return word;
+}
+
+SensorConditioner::SensorConditioner
+(
+    std::size_t numIntersections
+)
+    : raw_((numIntersections + INTERSECTIONS_PER_WORD - 1) / INTERSECTIONS_PER_WORD, 0),
+      lastRaw_(raw_.size(), 0),
+      out_(raw_.size(), 0),
+      run_(raw_.size(), Planes()),
+      held_(raw_.size(), Planes()),
+      onDelay_(raw_.size(), Planes()),
+      minPresence_(raw_.size(), Planes()),
+      gapOut_(raw_.size(), Planes()),
+      rawEdges_(0),
+      conditionedEdges_(0)
+{
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        setLaneTiming(static_cast<Lane>(lane), defaultDetectorTiming());
+    }
+}
+
+void SensorConditioner::setThreshold(Planes &planes, std::uint64_t bit, unsigned ticks)
+{
+    ticks = std::min(ticks, MAX_TICKS);
+    for (unsigned b = 0; b < COUNTER_BITS; b++)
+    {
+        planes[b] = (ticks & (1u << b)) ? (planes[b] | bit) : (planes[b] & ~bit);
+    }
+}
+
+void SensorConditioner::setTiming(IntersectionId intersection, Lane lane, const DetectorTiming &timing)
+{
+    std::size_t word = intersection / INTERSECTIONS_PER_WORD;
+    std::uint64_t bit = detectorBit(intersection, lane);
+
+    setThreshold(onDelay_[word], bit, timing.onDelay);
+    setThreshold(minPresence_[word], bit, timing.minPresence);
+    setThreshold(gapOut_[word], bit, timing.gapOut);
+}
+
+void SensorConditioner::setLaneTiming(Lane lane, const DetectorTiming &timing)
+{
+    for (std::size_t word = 0; word < raw_.size(); word++)
+    {
+        for (IntersectionId i = 0; i < INTERSECTIONS_PER_WORD; i++)
+        {
+            setTiming(static_cast<IntersectionId>(word * INTERSECTIONS_PER_WORD + i), lane, timing);
+        }
+    }
+}
+
+void SensorConditioner::reset(IntersectionId intersection)
+{
+    std::size_t word = intersection / INTERSECTIONS_PER_WORD;
+    std::uint64_t bits = 0;
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        bits |= detectorBit(intersection, static_cast<Lane>(lane));
+    }
+
+    raw_[word] &= ~bits;
+    lastRaw_[word] &= ~bits;
+    out_[word] &= ~bits;
+    clear(run_[word], bits);
+    clear(held_[word], bits);
+}
+
+void SensorConditioner::update()
+{
+    TRACE_SCOPE("SensorConditioner::update");
+
+    std::uint64_t rawEdges = 0;
+    std::uint64_t conditionedEdges = 0;
+
+    for (std::size_t word = 0; word < raw_.size(); word++)
+    {
+        std::uint64_t raw = raw_[word];
+        std::uint64_t out = out_[word];
+        Planes &run = run_[word];
+        Planes &held = held_[word];
+
+        /// Count how long the raw input has disagreed with the
+        /// call, and how long the call has been placed.
+        std::uint64_t disagree = raw ^ out;
+        clear(run, ~disagree);
+        increment(run, disagree);
+        increment(held, out);
+
+        std::uint64_t place = disagree & ~out & atLeast(run, onDelay_[word]);
+        std::uint64_t drop = disagree & out & atLeast(run, gapOut_[word]) & atLeast(held, minPresence_[word]);
+        std::uint64_t flip = place | drop;
+
+        out_[word] = out ^ flip;
+        clear(run, flip);
+        clear(held, flip);
+
+        rawEdges += std::bitset<64>(raw ^ lastRaw_[word]).count();
+        conditionedEdges += std::bitset<64>(flip).count();
+        lastRaw_[word] = raw;
+    }
+
+    rawEdges_ += rawEdges;
+    conditionedEdges_ += conditionedEdges;
+}
+
+void SensorConditioner::conditioned(IntersectionId intersection, VehicleSensors &sensors) const
+{
+    LaneMask calls = conditioned(intersection);
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        sensors[lane] = (calls & laneBit(lane)) ? SensorState::SET : SensorState::CLEAR;
+    }
+}
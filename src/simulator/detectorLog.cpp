@@ -0,0 +1,671 @@
+#include "impl/simulator/detectorLog.hpp"
+#include "impl/app/patternTable.hpp"
+#include "impl/util/workerPool.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// Bytes tokenized per step, one bit each in a delimiter mask
+static constexpr std::size_t BLOCK = 64;
+
+/// Largest detector id a map may name
+static constexpr unsigned long MAX_DETECTOR_ID = 1ul << 24;
+
+/// Names of the lanes, in Lane order
+static const char *const LANE_NAMES[Lane::COUNT] = {"N_N", "N_W", "S_S", "S_E", "E_E", "E_N", "W_W", "W_S"};
+
+/// The sensors that changed in one second of a chunk
+struct Change
+{
+    std::int64_t time; ///< second of the events
+    LaneMask set;      ///< lanes whose last event this second was SET
+    LaneMask clear;    ///< lanes whose last event this second was CLEAR
+};
+
+/// One piece of the log, cut at line ends, and what parsing it found.
+struct Chunk
+{
+    const char *begin;           ///< first byte, at a line start
+    const char *end;             ///< one past the last byte, after a line end or at the end of the log
+    std::vector<Change> changes; ///< seconds in which a sensor changed, in order
+    DetectorLogStats stats;      ///< counters of the chunk, without changes
+    std::int64_t first;          ///< time of the first parsed line, -1 if none
+    std::int64_t last;           ///< time of the last parsed line, -1 if none
+    const char *disorder;        ///< line whose time went backwards, nullptr if none
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Find the commas and line feeds in 64 bytes.
+///
+///  @param block Bytes to scan
+///  @param newlines Set to one bit per line feed
+///  @return std::uint64_t One bit per comma or line feed
+////////////////////////////////////////////////////////////
+static inline std::uint64_t delimiters(const char *block, std::uint64_t &newlines)
+{
+    std::uint64_t commas = 0;
+    std::uint64_t lines = 0;
+
+#if defined(__SSE2__)
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i lineFeed = _mm_set1_epi8('\n');
+    for (unsigned i = 0; i < BLOCK / 16; i++)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        commas |= static_cast<std::uint64_t>(static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, comma)))) << (16 * i);
+        lines |= static_cast<std::uint64_t>(static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, lineFeed)))) << (16 * i);
+    }
+#else
+    for (unsigned i = 0; i < BLOCK; i++)
+    {
+        commas |= static_cast<std::uint64_t>(block[i] == ',') << i;
+        lines |= static_cast<std::uint64_t>(block[i] == '\n') << i;
+    }
+#endif
+
+    newlines = lines;
+    return commas | lines;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Get the sensors of a set of lanes
+///
+///  @param lanes Lanes whose sensor is SET
+///  @return VehicleSensors One state per lane
+////////////////////////////////////////////////////////////
+static VehicleSensors sensorsOf(LaneMask lanes)
+{
+    VehicleSensors sensors;
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        sensors[lane] = (lanes & laneBit(lane)) ? SensorState::SET : SensorState::CLEAR;
+    }
+    return sensors;
+}
+
+static inline bool isDigit(char c)
+{
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+static inline const char* skipSpaces(const char *p, const char *end)
+{
+    while (p != end && (*p == ' ' || *p == '\t' || *p == '\r'))
+    {
+        p++;
+    }
+    return p;
+}
+
+static inline std::uint64_t loadEight(const char *p)
+{
+    std::uint64_t chars;
+    std::memcpy(&chars, p, sizeof(chars));
+    return chars;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Check eight characters are all digits.
+///
+////////////////////////////////////////////////////////////
+static inline bool eightDigits(std::uint64_t chars)
+{
+    return ((chars & 0xF0F0F0F0F0F0F0F0u) |
+            (((chars + 0x0606060606060606u) & 0xF0F0F0F0F0F0F0F0u) >> 4)) == 0x3333333333333333u;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Convert eight digit characters, first digit in
+///  the lowest byte, with three multiplies.
+///
+////////////////////////////////////////////////////////////
+static inline std::uint64_t eightDigitValue(std::uint64_t chars)
+{
+    chars -= 0x3030303030303030u;
+    chars = chars * 10 + (chars >> 8);
+    return ((chars & 0x000000FF000000FFu) * (100 + (1000000ull << 32)) +
+            ((chars >> 16) & 0x000000FF000000FFu) * (1 + (10000ull << 32))) >> 32;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Parse a field of 8 to 16 digits, as timestamps
+///  are, eight at a time.
+///
+///  Both loads stay inside the field.
+///
+///  @param p First byte of the field
+///  @param length Bytes in the field, 8 to 16
+///  @param value Set to the number
+///  @return true If every byte was a digit
+////////////////////////////////////////////////////////////
+static inline bool parseLongDigits(const char *p, std::size_t length, std::int64_t &value)
+{
+    std::uint64_t head = loadEight(p);
+    std::uint64_t tail = loadEight(p + length - 8);
+    if (!eightDigits(head) || !eightDigits(tail))
+    {
+        return false;
+    }
+
+    /// The head's digits before the tail's, shifted to the
+    /// top and led by zeros.
+    std::size_t leading = length - 8;
+    std::uint64_t high = leading == 8 ? head
+                                      : leading == 0 ? 0x3030303030303030u
+                                                     : (head << (8 * (8 - leading))) | (0x3030303030303030u >> (8 * leading));
+    value = static_cast<std::int64_t>(eightDigitValue(high) * 100000000u + eightDigitValue(tail));
+    return true;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Parse a whole number, ignoring surrounding spaces
+///  and, if allowed, a fraction.
+///
+///  @param p First byte of the field
+///  @param end One past the last byte of the field
+///  @param fraction Accept and drop a fraction
+///  @param value Set to the number
+///  @return true If the field was a number below 2^62
+////////////////////////////////////////////////////////////
+static inline bool parseNumber(const char *p, const char *end, bool fraction, std::int64_t &value)
+{
+    std::size_t length = static_cast<std::size_t>(end - p);
+    if (length >= 8 && length <= 16 && parseLongDigits(p, length, value))
+    {
+        return true;
+    }
+
+    p = skipSpaces(p, end);
+    if (p == end || !isDigit(*p))
+    {
+        return false;
+    }
+
+    std::int64_t number = 0;
+    const char *digits = p;
+    for (; p != end && isDigit(*p); p++)
+    {
+        number = number * 10 + (*p - '0');
+    }
+    if (p - digits > 18)
+    {
+        return false;
+    }
+
+    if (fraction && p != end && *p == '.')
+    {
+        for (p++; p != end && isDigit(*p); p++)
+        { }
+    }
+
+    value = number;
+    return skipSpaces(p, end) == end;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Parse a sensor state from its first letters.
+///
+///  @return int 1 for SET, 0 for CLEAR, -1 if neither
+////////////////////////////////////////////////////////////
+static inline int parseState(const char *p, const char *end)
+{
+    p = skipSpaces(p, end);
+    if (p == end)
+    {
+        return -1;
+    }
+
+    switch (*p | 0x20)
+    {
+    case '1':
+    case 's':
+        return 1;
+    case '0':
+    case 'c':
+        return 0;
+    case 'o':
+        if (end - p > 1)
+        {
+            char next = p[1] | 0x20;
+            return next == 'n' ? 1 : next == 'f' ? 0 : -1;
+        }
+        return -1;
+    default:
+        return -1;
+    }
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Parses one chunk, line by line.
+///
+///     Tracks the last state seen of each lane so that an
+///     event repeating it, as a polled log mostly does, adds
+///     nothing to the changes.
+///
+////////////////////////////////////////////////////////////
+class ChunkParser
+{
+public:
+    ChunkParser(Chunk &chunk, const std::vector<Lane> &lanes)
+        : chunk_(chunk),
+          lanes_(lanes),
+          lineStart_(chunk.begin),
+          numCommas_(0),
+          known_(0),
+          state_(0)
+    {
+        commas_[0] = commas_[1] = nullptr;
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Parse the whole chunk.
+    ///
+    ////////////////////////////////////////////////////////////
+    void run()
+    {
+        const char *p = chunk_.begin;
+        const char *end = chunk_.end;
+
+        for (; end - p >= static_cast<std::ptrdiff_t>(BLOCK) && !chunk_.disorder; p += BLOCK)
+        {
+            std::uint64_t newlines;
+            std::uint64_t mask = delimiters(p, newlines);
+            scan(p, mask, newlines);
+        }
+
+        /// The tail is tokenized from a padded copy.
+        if (p != end && !chunk_.disorder)
+        {
+            char padded[BLOCK] = {};
+            std::memcpy(padded, p, static_cast<std::size_t>(end - p));
+
+            std::uint64_t newlines;
+            std::uint64_t mask = delimiters(padded, newlines);
+            scan(p, mask, newlines);
+        }
+
+        /// The log's last line may have no line feed.
+        if (lineStart_ < end && !chunk_.disorder)
+        {
+            line(end);
+        }
+    }
+
+private:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Handle the delimiters of one block.
+    ///
+    ///  @param block Block start in the log
+    ///  @param mask One bit per delimiter
+    ///  @param newlines One bit per line feed
+    ////////////////////////////////////////////////////////////
+    inline void scan(const char *block, std::uint64_t mask, std::uint64_t newlines)
+    {
+        while (mask && !chunk_.disorder)
+        {
+            unsigned bit = static_cast<unsigned>(__builtin_ctzll(mask));
+            mask &= mask - 1;
+            const char *at = block + bit;
+
+            if ((newlines >> bit) & 1u)
+            {
+                line(at);
+                lineStart_ = at + 1;
+                numCommas_ = 0;
+            }
+            else
+            {
+                if (numCommas_ < 2)
+                {
+                    commas_[numCommas_] = at;
+                }
+                numCommas_++;
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Apply the line ending at a line feed.
+    ///
+    ///  @param end The line feed
+    ////////////////////////////////////////////////////////////
+    inline void line(const char *end)
+    {
+        if (skipSpaces(lineStart_, end) == end)
+        {
+            return;
+        }
+        chunk_.stats.lines++;
+
+        std::int64_t time;
+        std::int64_t detector;
+        int on = numCommas_ == 2 ? parseState(commas_[1] + 1, end) : -1;
+        if (on < 0 || !parseNumber(lineStart_, commas_[0], true, time) ||
+            !parseNumber(commas_[0] + 1, commas_[1], false, detector))
+        {
+            chunk_.stats.malformed++;
+            return;
+        }
+
+        if (time < chunk_.last)
+        {
+            chunk_.disorder = lineStart_;
+            return;
+        }
+        chunk_.first = chunk_.first < 0 ? time : chunk_.first;
+        chunk_.last = time;
+
+        Lane lane = static_cast<std::uint64_t>(detector) < lanes_.size() ? lanes_[static_cast<std::size_t>(detector)]
+                                                                          : Lane::PLACEHOLDER;
+        if (lane >= Lane::COUNT)
+        {
+            chunk_.stats.unmapped++;
+            return;
+        }
+        chunk_.stats.events++;
+
+        LaneMask bit = laneBit(lane);
+        if ((known_ & bit) && ((state_ & bit) != 0) == (on != 0))
+        {
+            return;
+        }
+        known_ |= bit;
+        state_ = on ? state_ | bit : state_ & ~bit;
+
+        if (chunk_.changes.empty() || chunk_.changes.back().time != time)
+        {
+            chunk_.changes.push_back({time, 0, 0});
+        }
+        Change &change = chunk_.changes.back();
+        change.set = on ? change.set | bit : change.set & ~bit;
+        change.clear = on ? change.clear & ~bit : change.clear | bit;
+    }
+
+    Chunk &chunk_;                   ///< chunk being parsed
+    const std::vector<Lane> &lanes_; ///< lane of each detector id
+    const char *lineStart_;          ///< first byte of the current line
+    const char *commas_[2];          ///< first two commas of the current line
+    unsigned numCommas_;             ///< commas seen on the current line
+    LaneMask known_;                 ///< lanes with an event in this chunk
+    LaneMask state_;                 ///< last state of each known lane
+};
+
+DetectorLogOptions defaultDetectorLogOptions()
+{
+    DetectorLogOptions options;
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        options.lanes.push_back(static_cast<Lane>(lane));
+    }
+    options.numThreads = 0;
+    options.chunkSize = 16u << 20;
+    options.rebase = true;
+    return options;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Find the start of the line holding a byte, or of
+///  the next line if the byte starts a line.
+///
+////////////////////////////////////////////////////////////
+static const char* lineStartAfter(const char *p, const char *begin, const char *end)
+{
+    if (p <= begin)
+    {
+        return begin;
+    }
+    if (p >= end)
+    {
+        return end;
+    }
+    const void *lineFeed = std::memchr(p - 1, '\n', static_cast<std::size_t>(end - (p - 1)));
+    return lineFeed ? static_cast<const char*>(lineFeed) + 1 : end;
+}
+
+bool parseDetectorLog(const char *data, std::size_t size, const DetectorLogOptions &options,
+                      Scenario &scenario, DetectorLogStats &stats, std::string &error)
+{
+    stats = DetectorLogStats();
+    stats.bytes = size;
+
+    const char *begin = data;
+    const char *end = data + size;
+    if (begin != end && !isDigit(*skipSpaces(begin, end)))
+    {
+        const void *lineFeed = std::memchr(begin, '\n', size);
+        begin = lineFeed ? static_cast<const char*>(lineFeed) + 1 : end;
+    }
+
+    std::size_t chunkSize = std::max<std::size_t>(options.chunkSize, BLOCK);
+    std::size_t numChunks = std::max<std::size_t>(1, (static_cast<std::size_t>(end - begin) + chunkSize - 1) / chunkSize);
+    std::vector<Chunk> chunks(numChunks);
+    const char *start = begin;
+    for (std::size_t i = 0; i < numChunks; i++)
+    {
+        Chunk &chunk = chunks[i];
+        chunk.begin = start;
+        chunk.end = i + 1 == numChunks ? end : std::max(start, lineStartAfter(begin + (i + 1) * chunkSize, begin, end));
+        chunk.stats = DetectorLogStats();
+        chunk.first = -1;
+        chunk.last = -1;
+        chunk.disorder = nullptr;
+        start = chunk.end;
+    }
+
+    unsigned numThreads = options.numThreads ? options.numThreads : std::max(1u, std::thread::hardware_concurrency());
+    WorkerPool pool(static_cast<unsigned>(std::min<std::size_t>(numThreads, numChunks)) - 1);
+    auto parse = [&chunks, &options](std::size_t i)
+    {
+        ChunkParser(chunks[i], options.lanes).run();
+    };
+    pool.run(numChunks, parse);
+
+    /// Chunks join in order; each must start no earlier than
+    /// the one before it ended.
+    std::int64_t first = -1;
+    std::int64_t last = -1;
+    for (const Chunk &chunk : chunks)
+    {
+        const char *disorder = chunk.disorder ? chunk.disorder : chunk.first >= 0 && chunk.first < last ? chunk.begin : nullptr;
+        if (disorder)
+        {
+            error = "timestamps go backwards at byte " + std::to_string(disorder - data);
+            return false;
+        }
+
+        stats.lines += chunk.stats.lines;
+        stats.events += chunk.stats.events;
+        stats.unmapped += chunk.stats.unmapped;
+        stats.malformed += chunk.stats.malformed;
+        if (chunk.first >= 0)
+        {
+            first = first < 0 ? chunk.first : first;
+            last = chunk.last;
+        }
+    }
+
+    if (first < 0)
+    {
+        error = "no events";
+        return false;
+    }
+
+    std::int64_t origin = options.rebase ? first : 0;
+    if (last + 1 - origin > INT_MAX)
+    {
+        error = "timestamps do not fit Clock::Time; rebase them";
+        return false;
+    }
+
+    Scenario imported;
+    LaneMask state = 0;
+    LaneMask sliceState = 0;
+    std::int64_t sliceStart = first;
+    std::int64_t time = first;
+    auto closeSlice = [&](std::int64_t at)
+    {
+        if (state == sliceState)
+        {
+            return;
+        }
+        if (at > sliceStart)
+        {
+            SimulationTimeslice slice;
+            slice.start = static_cast<Clock::Time>(sliceStart - origin);
+            slice.end = static_cast<Clock::Time>(at - origin);
+            slice.sensors = sensorsOf(sliceState);
+            imported.push_back(slice);
+        }
+        sliceStart = at;
+        sliceState = state;
+    };
+
+    /// A second cut by a chunk boundary has a change in each
+    /// chunk; only what the second as a whole changed counts.
+    LaneMask settled = 0;
+    for (const Chunk &chunk : chunks)
+    {
+        for (const Change &change : chunk.changes)
+        {
+            if (change.time != time)
+            {
+                stats.changes += static_cast<std::uint64_t>(__builtin_popcount(settled ^ state));
+                settled = state;
+                closeSlice(time);
+                time = change.time;
+            }
+            state = static_cast<LaneMask>((state | change.set) & ~change.clear);
+        }
+    }
+    stats.changes += static_cast<std::uint64_t>(__builtin_popcount(settled ^ state));
+    closeSlice(time);
+
+    SimulationTimeslice slice;
+    slice.start = static_cast<Clock::Time>(sliceStart - origin);
+    slice.end = static_cast<Clock::Time>(last + 1 - origin);
+    slice.sensors = sensorsOf(sliceState);
+    imported.push_back(slice);
+
+    scenario.swap(imported);
+    return true;
+}
+
+bool loadDetectorLog(const std::string &path, const DetectorLogOptions &options,
+                     Scenario &scenario, DetectorLogStats &stats, std::string &error)
+{
+#if defined(__linux__)
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) < 0)
+    {
+        error = "cannot open " + path;
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return false;
+    }
+
+    std::size_t size = static_cast<std::size_t>(info.st_size);
+    if (size == 0)
+    {
+        close(fd);
+        return parseDetectorLog("", 0, options, scenario, stats, error);
+    }
+
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        error = "cannot map " + path;
+        return false;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    bool parsed = parseDetectorLog(static_cast<const char*>(mapped), size, options, scenario, stats, error);
+    munmap(mapped, size);
+    return parsed;
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return parseDetectorLog(text.data(), text.size(), options, scenario, stats, error);
+#endif
+}
+
+static std::string trim(const std::string &text)
+{
+    const char *whitespace = " \t\r\n";
+    std::size_t first = text.find_first_not_of(whitespace);
+    if (first == std::string::npos)
+    {
+        return "";
+    }
+    std::size_t last = text.find_last_not_of(whitespace);
+    return text.substr(first, last - first + 1);
+}
+
+bool parseDetectorMap(std::istream &in, std::vector<Lane> &lanes, std::string &error)
+{
+    std::vector<Lane> parsed;
+    std::string line;
+
+    for (int lineNumber = 1; std::getline(in, line); lineNumber++)
+    {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
+        {
+            continue;
+        }
+
+        std::size_t equals = line.find('=');
+        std::string id = trim(line.substr(0, equals));
+        std::string name = equals == std::string::npos ? "" : trim(line.substr(equals + 1));
+
+        char *idEnd = nullptr;
+        unsigned long detector = std::strtoul(id.c_str(), &idEnd, 10);
+        if (equals == std::string::npos || id.empty() || *idEnd != '\0' || detector > MAX_DETECTOR_ID)
+        {
+            error = "line " + std::to_string(lineNumber) + ": expected \"detector = lane\"";
+            return false;
+        }
+
+        const char *const *found = std::find(std::begin(LANE_NAMES), std::end(LANE_NAMES), name);
+        if (found == std::end(LANE_NAMES))
+        {
+            error = "line " + std::to_string(lineNumber) + ": unknown lane \"" + name + "\"";
+            return false;
+        }
+
+        if (parsed.size() <= detector)
+        {
+            parsed.resize(detector + 1, Lane::PLACEHOLDER);
+        }
+        parsed[detector] = static_cast<Lane>(found - std::begin(LANE_NAMES));
+    }
+
+    lanes.swap(parsed);
+    return true;
+}
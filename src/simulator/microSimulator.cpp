@@ -0,0 +1,339 @@
+#include "impl/simulator/microSimulator.hpp"
+#include "impl/trace/trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/// Distance to the leader seen by a front vehicle on open road (m)
+static constexpr float OPEN_ROAD = 1.0e4f;
+
+/// Gap used when a vehicle is touching what is ahead (m)
+static constexpr float MIN_GAP_CLAMP = 0.1f;
+
+/// Below this speed a vehicle counts as queued (m/s)
+static constexpr float QUEUED_SPEED = 2.0f;
+
+/// Length of the presence detector before each stop line (m)
+static constexpr float DETECTOR_LENGTH = 20.0f;
+
+IdmParameters defaultIdmParameters()
+{
+    IdmParameters parameters;
+    parameters.desiredSpeed = 13.9f;
+    parameters.timeHeadway = 1.5f;
+    parameters.minGap = 2.0f;
+    parameters.maxAccel = 1.0f;
+    parameters.comfortDecel = 1.5f;
+    parameters.maxDecel = 6.0f;
+    parameters.vehicleLength = 5.0f;
+    return parameters;
+}
+
+MicroSimulator::MicroSimulator
+(
+    std::size_t numIntersections,
+    float approachLength,
+    const IdmParameters &parameters,
+    unsigned substepsPerSecond,
+    std::uint64_t seed
+)
+    : parameters_(parameters),
+      approachLength_(approachLength),
+      detectorStart_(std::max(0.0f, approachLength - DETECTOR_LENGTH)),
+      dt_(1.0f / static_cast<float>(std::max(1u, substepsPerSecond))),
+      substepsPerSecond_(std::max(1u, substepsPerSecond)),
+      rng_(seed ? seed : 1),
+      clock_(),
+      stats_(),
+      signals_(numIntersections),
+      sensors_(numIntersections),
+      arrivalProbability_(numIntersections * Lane::COUNT, 0.0f),
+      waiting_(numIntersections * Lane::COUNT, 0),
+      downstream_(numIntersections * Lane::COUNT, -1),
+      roadBegin_(numIntersections * Lane::COUNT, 0),
+      roadCount_(numIntersections * Lane::COUNT, 0),
+      obstaclePosition_(numIntersections * Lane::COUNT, OPEN_ROAD),
+      obstacleSpeed_(numIntersections * Lane::COUNT, 0.0f),
+      occupied_(numIntersections * Lane::COUNT, 0),
+      inbox_(numIntersections * Lane::COUNT)
+{
+    for (std::size_t intersection = 0; intersection < numIntersections; intersection++)
+    {
+        signals_[intersection].fill(SignalState::RED);
+        sensors_[intersection].fill(SensorState::CLEAR);
+    }
+}
+
+void MicroSimulator::setDemand(IntersectionId intersection, Lane lane, float vehiclesPerHour)
+{
+    float probability = vehiclesPerHour / 3600.0f * dt_;
+    arrivalProbability_[roadOf(intersection, lane)] = std::min(1.0f, std::max(0.0f, probability));
+}
+
+void MicroSimulator::link(IntersectionId from, Lane fromLane, IntersectionId to, Lane toLane)
+{
+    downstream_[roadOf(from, fromLane)] = static_cast<std::int32_t>(roadOf(to, toLane));
+}
+
+void MicroSimulator::setSignals(IntersectionId intersection, const TrafficSignals &signals)
+{
+    signals_[intersection] = signals;
+}
+
+std::uint32_t MicroSimulator::queueLength(IntersectionId intersection, Lane lane) const
+{
+    std::uint32_t road = roadOf(intersection, lane);
+    std::uint32_t queued = 0;
+
+    for (std::uint32_t i = roadBegin_[road]; i < roadBegin_[road] + roadCount_[road]; i++)
+    {
+        queued += speed_[i] < QUEUED_SPEED;
+    }
+    return queued;
+}
+
+void MicroSimulator::advance(Clock::Time delta)
+{
+    TRACE_SCOPE("MicroSimulator::advance");
+
+    std::fill(occupied_.begin(), occupied_.end(), 0);
+
+    for (Clock::Time second = 0; second < delta; second++)
+    {
+        for (unsigned step = 0; step < substepsPerSecond_; step++)
+        {
+            substep();
+        }
+        clock_.advance(1);
+    }
+
+    for (std::size_t intersection = 0; intersection < sensors_.size(); intersection++)
+    {
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            bool occupied = occupied_[intersection * Lane::COUNT + lane] != 0;
+            sensors_[intersection][lane] = occupied ? SensorState::SET : SensorState::CLEAR;
+        }
+    }
+}
+
+void MicroSimulator::updateObstacles()
+{
+    const float stopLine = approachLength_ + parameters_.vehicleLength;
+    const float entryRoom = parameters_.vehicleLength + parameters_.minGap;
+
+    for (std::uint32_t road = 0; road < roadCount_.size(); road++)
+    {
+        obstaclePosition_[road] = stopLine;
+        obstacleSpeed_[road] = 0.0f;
+
+        if (roadCount_[road] == 0)
+        {
+            continue;
+        }
+
+        /// A full downstream road blocks the stop line whatever
+        /// the signal shows: spillback.
+        bool blocked = false;
+        std::int32_t next = downstream_[road];
+        if (next >= 0 && roadCount_[next] > 0)
+        {
+            std::uint32_t last = roadBegin_[next] + roadCount_[next] - 1;
+            blocked = position_[last] < entryRoom;
+        }
+
+        std::uint32_t front = roadBegin_[road];
+        float distance = approachLength_ - position_[front];
+        SignalState signal = signals_[road / Lane::COUNT][road % Lane::COUNT];
+
+        if (blocked)
+        {
+            stats_.spillbackSteps += (signal == SignalState::GREEN && distance < DETECTOR_LENGTH);
+            continue;
+        }
+
+        /// Drivers too close to stop comfortably for a changing
+        /// signal carry on through it.
+        float stoppingDistance = speed_[front] * speed_[front] / (2.0f * parameters_.maxDecel);
+        if (signal == SignalState::GREEN || stoppingDistance > distance)
+        {
+            obstaclePosition_[road] = position_[front] + OPEN_ROAD;
+            obstacleSpeed_[road] = parameters_.desiredSpeed;
+        }
+    }
+}
+
+void MicroSimulator::substep()
+{
+    updateObstacles();
+
+    const std::size_t count = position_.size();
+    leaderPosition_.resize(count);
+    leaderSpeed_.resize(count);
+    acceleration_.resize(count);
+
+    float *__restrict position = position_.data();
+    float *__restrict speed = speed_.data();
+    const std::uint32_t *__restrict road = road_.data();
+    float *__restrict leaderPosition = leaderPosition_.data();
+    float *__restrict leaderSpeed = leaderSpeed_.data();
+    float *__restrict acceleration = acceleration_.data();
+
+    /// Leader gather: the vehicle ahead on the same road, or the
+    /// road's obstacle for its front vehicle.
+    if (count > 0)
+    {
+        leaderPosition[0] = obstaclePosition_[road[0]];
+        leaderSpeed[0] = obstacleSpeed_[road[0]];
+    }
+    for (std::size_t i = 1; i < count; i++)
+    {
+        bool sameRoad = road[i - 1] == road[i];
+        leaderPosition[i] = sameRoad ? position[i - 1] : obstaclePosition_[road[i]];
+        leaderSpeed[i] = sameRoad ? speed[i - 1] : obstacleSpeed_[road[i]];
+    }
+
+    /// IDM acceleration: a [1 - (v/v0)^4 - (s*/s)^2]
+    const float maxAccel = parameters_.maxAccel;
+    const float inverseDesiredSpeed = 1.0f / parameters_.desiredSpeed;
+    const float timeHeadway = parameters_.timeHeadway;
+    const float minGap = parameters_.minGap;
+    const float length = parameters_.vehicleLength;
+    const float inverseBrakingTerm = 1.0f / (2.0f * std::sqrt(parameters_.maxAccel * parameters_.comfortDecel));
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        float v = speed[i];
+        float gap = std::max(leaderPosition[i] - position[i] - length, MIN_GAP_CLAMP);
+        float approach = v - leaderSpeed[i];
+        float desiredGap = minGap + std::max(0.0f, v * timeHeadway + v * approach * inverseBrakingTerm);
+        float ratio = v * inverseDesiredSpeed;
+        float ratio2 = ratio * ratio;
+        float interaction = desiredGap / gap;
+        acceleration[i] = maxAccel * (1.0f - ratio2 * ratio2 - interaction * interaction);
+    }
+
+    /// Ballistic integration, speeds never negative.
+    const float dt = dt_;
+    float delay = 0.0f;
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        float v = speed[i];
+        float next = std::max(0.0f, v + acceleration[i] * dt);
+        position[i] += 0.5f * (v + next) * dt;
+        speed[i] = next;
+        delay += std::max(0.0f, 1.0f - next * inverseDesiredSpeed);
+    }
+
+    stats_.delay += static_cast<double>(delay) * dt;
+    stats_.vehicleUpdates += count;
+    stats_.substeps++;
+
+    compact();
+}
+
+void MicroSimulator::compact()
+{
+    const float entryRoom = parameters_.vehicleLength + parameters_.minGap;
+    const float spacing = parameters_.vehicleLength + parameters_.minGap;
+
+    /// Hand every vehicle past a stop line to its downstream
+    /// road first, so all roads see this substep's arrivals.
+    for (std::uint32_t road = 0; road < roadCount_.size(); road++)
+    {
+        std::uint32_t end = roadBegin_[road] + roadCount_[road];
+        for (std::uint32_t i = roadBegin_[road]; i < end && position_[i] >= approachLength_; i++)
+        {
+            stats_.vehiclesDischarged++;
+            occupied_[road] = 1;
+
+            std::int32_t next = downstream_[road];
+            if (next >= 0)
+            {
+                inbox_[next].push_back(position_[i] - approachLength_);
+                inbox_[next].push_back(speed_[i]);
+            }
+            else
+            {
+                stats_.vehiclesExited++;
+            }
+        }
+    }
+
+    nextPosition_.clear();
+    nextSpeed_.clear();
+    nextRoad_.clear();
+
+    for (std::uint32_t road = 0; road < roadCount_.size(); road++)
+    {
+        std::uint32_t begin = roadBegin_[road];
+        std::uint32_t end = begin + roadCount_[road];
+        std::uint32_t newBegin = static_cast<std::uint32_t>(nextPosition_.size());
+
+        while (begin < end && position_[begin] >= approachLength_)
+        {
+            begin++;
+        }
+        if (begin < end && position_[begin] >= detectorStart_)
+        {
+            occupied_[road] = 1;
+        }
+
+        nextPosition_.insert(nextPosition_.end(), position_.begin() + begin, position_.begin() + end);
+        nextSpeed_.insert(nextSpeed_.end(), speed_.begin() + begin, speed_.begin() + end);
+        nextRoad_.insert(nextRoad_.end(), end - begin, road);
+
+        /// Vehicles crossing in from upstream, front first, never
+        /// overlapping the vehicle ahead.
+        std::vector<float> &inbox = inbox_[road];
+        for (std::size_t k = 0; k < inbox.size(); k += 2)
+        {
+            float entry = inbox[k];
+            if (nextPosition_.size() > newBegin)
+            {
+                entry = std::min(entry, nextPosition_.back() - spacing);
+            }
+            nextPosition_.push_back(entry);
+            nextSpeed_.push_back(inbox[k + 1]);
+            nextRoad_.push_back(road);
+        }
+        inbox.clear();
+
+        /// Arrivals from outside wait off the road until there
+        /// is room at its upstream end.
+        if (arrivalProbability_[road] > 0.0f && uniform() < arrivalProbability_[road])
+        {
+            waiting_[road]++;
+        }
+        bool hasRoom = nextPosition_.size() == newBegin || nextPosition_.back() >= entryRoom;
+        if (waiting_[road] > 0 && hasRoom)
+        {
+            float entrySpeed = parameters_.desiredSpeed;
+            if (nextPosition_.size() > newBegin)
+            {
+                entrySpeed = std::min(entrySpeed, nextSpeed_.back());
+            }
+            nextPosition_.push_back(0.0f);
+            nextSpeed_.push_back(entrySpeed);
+            nextRoad_.push_back(road);
+            waiting_[road]--;
+            stats_.vehiclesSpawned++;
+        }
+
+        roadBegin_[road] = newBegin;
+        roadCount_[road] = static_cast<std::uint32_t>(nextPosition_.size()) - newBegin;
+    }
+
+    position_.swap(nextPosition_);
+    speed_.swap(nextSpeed_);
+    road_.swap(nextRoad_);
+}
+
+float MicroSimulator::uniform()
+{
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 7;
+    rng_ ^= rng_ << 17;
+    return static_cast<float>(rng_ >> 40) * (1.0f / 16777216.0f);
+}
@@ -0,0 +1,338 @@
+#include "impl/simulator/networkSimulator.hpp"
+#include "impl/util/barrier.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+NetworkSimulator::Node::Node
+(
+    const Clock &clock,
+    IClock::Time maxWaitTime
+)
+    : sensors(),
+      queue(),
+      link(),
+      boundary(),
+      boundaryCursor(0),
+      controller(clock, sensors, maxWaitTime, nullptr)
+{
+    sensors.fill(SensorState::CLEAR);
+    queue.fill(0);
+    link.fill(-1);
+}
+
+NetworkSimulator::NetworkSimulator
+(
+    std::size_t numIntersections,
+    const std::vector<NetworkLink> &links,
+    unsigned numPartitions,
+    Clock::Time timeStep,
+    IClock::Time maxWaitTime
+)
+    : timeStep_(std::max<Clock::Time>(timeStep, 1)),
+      window_(0),
+      windowIndex_(0),
+      links_(),
+      partitionOf_(numIntersections, 0),
+      partitions_(),
+      nodes_()
+{
+    for (const NetworkLink &link : links)
+    {
+        if (link.from < numIntersections && link.to < numIntersections)
+        {
+            links_.push_back(link);
+            links_.back().travelTime = std::max(link.travelTime, timeStep_);
+        }
+    }
+
+    makePartitions(std::max(1u, std::min<unsigned>(numPartitions, std::max<std::size_t>(numIntersections, 1))));
+
+    nodes_.reserve(numIntersections);
+    for (std::size_t i = 0; i < numIntersections; i++)
+    {
+        const Clock &clock = partitions_[partitionOf_[i]]->clock;
+        nodes_.emplace_back(new Node(clock, maxWaitTime));
+    }
+
+    /// The lookahead is the shortest link crossing partitions.
+    Clock::Time lookahead = std::numeric_limits<Clock::Time>::max();
+    for (std::size_t i = 0; i < links_.size(); i++)
+    {
+        const NetworkLink &link = links_[i];
+        Node &node = *nodes_[link.from];
+
+        if (node.link[link.fromLane] < 0)
+        {
+            node.link[link.fromLane] = static_cast<std::int32_t>(i);
+        }
+
+        if (partitionOf_[link.from] != partitionOf_[link.to])
+        {
+            lookahead = std::min(lookahead, link.travelTime);
+        }
+    }
+
+    /// Windows hold whole ticks, so round the lookahead down to a step.
+    /// Without boundary links the partitions never need to meet.
+    lookahead = std::min(lookahead, std::numeric_limits<Clock::Time>::max() / 4);
+    window_ = (lookahead / timeStep_) * timeStep_;
+
+    for (std::size_t i = 0; i < numIntersections; i++)
+    {
+        nodes_[i]->controller.initApp();
+    }
+}
+
+void NetworkSimulator::setBoundaryDemand
+(
+    IntersectionId intersection,
+    const Scenario &scenario
+)
+{
+    nodes_[intersection]->boundary = scenario;
+    nodes_[intersection]->boundaryCursor = 0;
+}
+
+void NetworkSimulator::run
+(
+    Clock::Time duration
+)
+{
+    Clock::Time start = now();
+    Clock::Time steps = (duration + timeStep_ - 1) / timeStep_;
+    Clock::Time end = start + steps * timeStep_;
+
+    if (steps <= 0)
+    {
+        return;
+    }
+
+    std::uint64_t firstWindow = windowIndex_;
+    std::uint64_t numWindows = (static_cast<std::uint64_t>(end - start) + window_ - 1) / window_;
+    auto numPartitions = static_cast<unsigned>(partitions_.size());
+
+    std::vector<std::thread> threads;
+    Barrier barrier(numPartitions);
+
+    auto worker = [this, &barrier, firstWindow, end](unsigned index)
+    {
+        for (std::uint64_t w = firstWindow; partitions_[index]->clock.now() < end; w++)
+        {
+            runPartition(index, w, end);
+            barrier.wait();
+        }
+    };
+
+    for (unsigned p = 1; p < numPartitions; p++)
+    {
+        threads.emplace_back(worker, p);
+    }
+    worker(0);
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    windowIndex_ = firstWindow + numWindows;
+    for (auto &partition : partitions_)
+    {
+        partition->stats.windows += numWindows;
+    }
+}
+
+NetworkStats NetworkSimulator::stats() const
+{
+    NetworkStats total = {};
+
+    for (const auto &partition : partitions_)
+    {
+        total.vehiclesDischarged += partition->stats.vehiclesDischarged;
+        total.vehiclesDelivered += partition->stats.vehiclesDelivered;
+        total.crossPartitionVehicles += partition->stats.crossPartitionVehicles;
+        total.queuedVehicleTime += partition->stats.queuedVehicleTime;
+    }
+    total.windows = partitions_.front()->stats.windows;
+
+    return total;
+}
+
+void NetworkSimulator::makePartitions
+(
+    unsigned numPartitions
+)
+{
+    std::size_t numIntersections = partitionOf_.size();
+
+    /// Undirected adjacency for the breadth-first walk
+    std::vector<std::vector<IntersectionId>> neighbours(numIntersections);
+    for (const NetworkLink &link : links_)
+    {
+        neighbours[link.from].push_back(link.to);
+        neighbours[link.to].push_back(link.from);
+    }
+
+    std::vector<IntersectionId> order;
+    std::vector<bool> visited(numIntersections, false);
+    order.reserve(numIntersections);
+
+    for (IntersectionId root = 0; root < numIntersections; root++)
+    {
+        if (visited[root])
+        {
+            continue;
+        }
+
+        std::size_t head = order.size();
+        order.push_back(root);
+        visited[root] = true;
+
+        while (head < order.size())
+        {
+            IntersectionId current = order[head++];
+            for (IntersectionId next : neighbours[current])
+            {
+                if (!visited[next])
+                {
+                    visited[next] = true;
+                    order.push_back(next);
+                }
+            }
+        }
+    }
+
+    /// Contiguous runs of the walk make compact regions
+    std::size_t perPartition = (numIntersections + numPartitions - 1) / numPartitions;
+    for (unsigned p = 0; p < numPartitions; p++)
+    {
+        partitions_.emplace_back(new Partition());
+        partitions_.back()->outbox[0].resize(numPartitions);
+        partitions_.back()->outbox[1].resize(numPartitions);
+        partitions_.back()->stats = NetworkStats{};
+    }
+
+    for (std::size_t i = 0; i < order.size(); i++)
+    {
+        auto p = static_cast<unsigned>(i / std::max<std::size_t>(perPartition, 1));
+        partitionOf_[order[i]] = p;
+        partitions_[p]->intersections.push_back(order[i]);
+    }
+
+    /// Keep each partition's intersections in id order for locality
+    for (auto &partition : partitions_)
+    {
+        std::sort(partition->intersections.begin(), partition->intersections.end());
+    }
+}
+
+void NetworkSimulator::runPartition
+(
+    unsigned index,
+    std::uint64_t window,
+    Clock::Time end
+)
+{
+    Partition &partition = *partitions_[index];
+    unsigned parity = static_cast<unsigned>(window & 1);
+
+    /// Take delivery of vehicles sent across the boundary last window.
+    /// Senders only write the other parity now, so this is race free.
+    for (auto &sender : partitions_)
+    {
+        auto &inbox = sender->outbox[parity ^ 1][index];
+        for (const VehicleArrival &arrival : inbox)
+        {
+            partition.pending.push(arrival);
+        }
+        inbox.clear();
+    }
+
+    Clock::Time windowEnd = std::min(partition.clock.now() + window_, end);
+    while (partition.clock.now() < windowEnd)
+    {
+        tick(partition, parity);
+    }
+}
+
+void NetworkSimulator::tick
+(
+    Partition &partition,
+    unsigned parity
+)
+{
+    Clock::Time now = partition.clock.now();
+
+    while (!partition.pending.empty() && partition.pending.top().time <= now)
+    {
+        const VehicleArrival &arrival = partition.pending.top();
+        nodes_[arrival.to]->queue[arrival.lane]++;
+        partition.stats.vehiclesDelivered++;
+        partition.pending.pop();
+    }
+
+    for (IntersectionId id : partition.intersections)
+    {
+        Node &node = *nodes_[id];
+
+        /// Boundary demand, replayed like Simulator does
+        const VehicleSensors *boundary = nullptr;
+        while (node.boundaryCursor < node.boundary.size() &&
+               node.boundary[node.boundaryCursor].end <= now)
+        {
+            node.boundaryCursor++;
+        }
+        if (node.boundaryCursor < node.boundary.size() &&
+            node.boundary[node.boundaryCursor].start <= now)
+        {
+            boundary = &node.boundary[node.boundaryCursor].sensors;
+        }
+
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            bool demand = node.queue[lane] > 0 ||
+                          (boundary && (*boundary)[lane] == SensorState::SET);
+            node.sensors[lane] = demand ? SensorState::SET : SensorState::CLEAR;
+            partition.stats.queuedVehicleTime += node.queue[lane] * timeStep_;
+        }
+
+        node.controller.run();
+        const TrafficSignals &signals = node.controller.getSignals();
+
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            if (signals[lane] != SignalState::GREEN || node.sensors[lane] != SensorState::SET)
+            {
+                continue;
+            }
+
+            if (node.queue[lane] > 0)
+            {
+                node.queue[lane]--;
+            }
+            partition.stats.vehiclesDischarged++;
+
+            if (node.link[lane] < 0)
+            {
+                continue;
+            }
+
+            const NetworkLink &link = links_[node.link[lane]];
+            VehicleArrival arrival = {now + link.travelTime, link.to, link.toLane};
+            unsigned destination = partitionOf_[link.to];
+
+            if (&partition == partitions_[destination].get())
+            {
+                partition.pending.push(arrival);
+            }
+            else
+            {
+                partition.outbox[parity][destination].push_back(arrival);
+                partition.stats.crossPartitionVehicles++;
+            }
+        }
+    }
+
+    partition.clock.advance(timeStep_);
+}
@@ -0,0 +1,69 @@
+#include "impl/simulator/scenarios.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using SS = SensorState;
+
+/// At T+0, non-stop traffic in all directions. continues for 5 minutes
+const Scenario SCENARIO_1 = 
+{   //            N-N        N-W        S-S        S-E        E-E        E-N        W-W        W-S
+    { 0,  300,  { SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET   }}
+};
+
+/// at T+0, there is  N-W and S-E traffic
+/// at T+10, an infinite line of vehicles pulls up to the N-N sensor
+/// at T+20, all N-W and S-E traffic stops
+const Scenario SCENARIO_2 = 
+{   //             N-N        N-W        S-S        S-E        E-E        E-N        W-W        W-S
+    { 0,   10,   { SS::CLEAR, SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
+    { 10,  20,   { SS::SET,   SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
+    { 20,  300,  { SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }}
+};
+
+const Scenario SCENARIO_3 =
+{   //             N-N        N-W        S-S        S-E        E-E        E-N        W-W        W-S
+    { 0,   300,  { SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET   }},
+    { 300, 310,  { SS::CLEAR, SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
+    { 310, 330,  { SS::SET,   SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
+    { 330, 600,  { SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }}
+};
+
+const Scenario SCENARIO_4 =
+{   //             N-N        N-W        S-S        S-E        E-E        E-N        W-W        W-S
+    { 0,   300,  { SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET   }},
+    { 300, 310,  { SS::CLEAR, SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
+    { 310, 330,  { SS::SET,   SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
+    { 330, 600,  { SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
+    { 600, 900,  { SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET   }}
+};
+
+Scenario makeDayScenario(unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<Clock::Time> sliceLength(5, 60);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    Scenario scenario;
+    for (Clock::Time t = 0; t < 86400;)
+    {
+        Clock::Time end = std::min<Clock::Time>(86400, t + sliceLength(rng));
+        double hour = t / 3600.0;
+        double peaks = std::exp(-std::pow(hour - 8.0, 2) / 2.0) + std::exp(-std::pow(hour - 17.5, 2) / 2.0);
+        double busy = 0.05 + 0.6 * peaks;
+
+        VehicleSensors sensors;
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            /// Through lanes carry more traffic than turning lanes,
+            /// and the north-south arterial more than the cross street.
+            double weight = (lane % 2 == 0 ? 1.0 : 0.5) * (lane < Lane::E_E ? 1.2 : 0.8);
+            sensors[lane] = uniform(rng) < busy * weight ? SensorState::SET : SensorState::CLEAR;
+        }
+
+        scenario.push_back({t, end, sensors});
+        t = end;
+    }
+    return scenario;
+}
@@ -1,4 +1,5 @@
 #include "impl/simulator/simulator.hpp"
+#include "impl/trace/trace.hpp"
 
 #include <algorithm>
 #include <iomanip>
@@ -22,19 +23,28 @@ static const std::string& signal_string
     return STRINGS[static_cast<unsigned>(signal)];
 }
 
+std::ostream& printSignals
+(
+    std::ostream &os,
+    Clock::Time now,
+    const TrafficSignals &signals
+)
+{
+    os << "[" << std::setw(4) << now << "s] ";
+    for (SignalState signal : signals)
+    {
+        os << " | " << signal_string(signal);
+    }
+    return os << " | ";
+}
+
 std::ostream& operator<<
 (
     std::ostream& os, 
     const Simulator& simulator
 )
 {
-    std::cout << "[" << std::setw(4) << simulator.clock_.now() << "s] ";
-    for (unsigned lane = 0; lane < simulator.signals_.size(); lane++)
-    {
-        auto signal = simulator.signals_[lane];
-        std::cout << " | " << signal_string(signal);
-    }
-    std::cout << " | ";
+    return printSignals(os, simulator.clock_.now(), simulator.signals_);
 }
 
 void Simulator::update_simulation
@@ -42,17 +52,23 @@ void Simulator::update_simulation
     void
 )
 {
-    // find entry in scneario for current timestamp
+    TRACE_SCOPE("update_simulation");
+
+    auto contains_now = [this](const SimulationTimeslice &state) 
+    { 
+        return 
+            ( clock_.now() >= state.start ) &&
+            ( clock_.now() < state.end );
+    };
+
+    // find entry in scneario for current timestamp, from the last one read
     auto scenario_timeslice = 
-        std::find_if(
-            scenario_.begin(), scenario_.end(),
-            [this](const SimulationTimeslice &state) 
-            { 
-                return 
-                    ( clock_.now() >= state.start ) &&
-                    ( clock_.now() < state.end );
-            }
-    );
+        std::find_if(scenario_.begin() + slice_, scenario_.end(), contains_now);
+
+    if (scenario_timeslice == scenario_.end())
+    {
+        scenario_timeslice = std::find_if(scenario_.begin(), scenario_.end(), contains_now);
+    }
 
     // advanced past end of scenario
     if (scenario_timeslice == scenario_.end())
@@ -62,5 +78,6 @@ void Simulator::update_simulation
     }
 
     // update simulation state from scenario
+    slice_ = static_cast<std::size_t>(scenario_timeslice - scenario_.begin());
     sensors_ = scenario_timeslice->sensors;
 }
@@ -0,0 +1,169 @@
+#include "impl/simulator/workload.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr Clock::Time Workload::DAY;
+constexpr Clock::Time Workload::CURVE_STEP;
+constexpr std::uint32_t Workload::CHANCE_ONE;
+
+/// Steps of the demand curve in a day
+static constexpr std::size_t CURVE_STEPS = Workload::DAY / Workload::CURVE_STEP;
+
+/// Lanes loaded by the morning peak: northbound and eastbound
+static constexpr std::uint8_t INBOUND_LANES = (1u << Lane::N_N) | (1u << Lane::N_W) |
+                                              (1u << Lane::E_E) | (1u << Lane::E_N);
+
+/// Lanes of the north-south street
+static constexpr std::uint8_t NORTH_SOUTH_LANES = (1u << Lane::N_N) | (1u << Lane::N_W) |
+                                                  (1u << Lane::S_S) | (1u << Lane::S_E);
+
+/// Lanes that turn
+static constexpr std::uint8_t TURN_LANES = (1u << Lane::N_W) | (1u << Lane::S_E) |
+                                           (1u << Lane::E_N) | (1u << Lane::W_S);
+
+////////////////////////////////////////////////////////////
+///  @brief Scramble 64 bits; consecutive inputs give
+///  unrelated outputs.
+///
+///  @param x Value to scramble
+///  @return std::uint64_t Scrambled value
+////////////////////////////////////////////////////////////
+static inline std::uint64_t mix(std::uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Get a rush-hour peak
+///
+///  @param hour Hour of the day
+///  @param centre Hour of the peak
+///  @param width Standard deviation in hours
+///  @return float 1 at the peak, falling to 0 away from it
+////////////////////////////////////////////////////////////
+static float peak(float hour, float centre, float width)
+{
+    float distance = (hour - centre) / width;
+    return std::exp(-0.5f * distance * distance);
+}
+
+WorkloadConfig defaultWorkloadConfig(std::uint32_t numIntersections)
+{
+    WorkloadConfig config;
+    config.numIntersections = numIntersections;
+    config.seed = 1;
+    config.baseRate = 0.03f;
+    config.peakRate = 0.22f;
+    config.morningPeak = 8.0f;
+    config.eveningPeak = 17.5f;
+    config.peakWidth = 1.0f;
+    config.turnShare = 0.35f;
+    config.peakShift = 0.5f;
+    config.occupancyTime = 2;
+    return config;
+}
+
+Workload::Workload(const WorkloadConfig &config)
+    : config_(config),
+      intersections_(config.numIntersections),
+      curve_(CURVE_STEPS)
+{
+    config_.occupancyTime = std::min<Clock::Time>(std::max<Clock::Time>(config_.occupancyTime, 1), 4);
+
+    /// The tidal flow: most of the morning peak heads in, most
+    /// of the evening peak heads out.
+    for (std::size_t step = 0; step < CURVE_STEPS; step++)
+    {
+        float hour = static_cast<float>(step * CURVE_STEP) / 3600.0f;
+        float morning = peak(hour, config_.morningPeak, config_.peakWidth);
+        float evening = peak(hour, config_.eveningPeak, config_.peakWidth);
+        float inbound = config_.baseRate + config_.peakRate * (morning + 0.4f * evening);
+        float outbound = config_.baseRate + config_.peakRate * (0.4f * morning + evening);
+
+        curve_[step][0] = static_cast<std::uint16_t>(std::min(inbound, 0.9f) * CHANCE_ONE);
+        curve_[step][1] = static_cast<std::uint16_t>(std::min(outbound, 0.9f) * CHANCE_ONE);
+    }
+
+    std::int32_t maxShift = static_cast<std::int32_t>(config_.peakShift * 3600.0f / CURVE_STEP);
+    for (std::uint32_t i = 0; i < config_.numIntersections; i++)
+    {
+        std::uint64_t draw = mix((static_cast<std::uint64_t>(config_.seed) << 32) ^ i);
+        Intersection &intersection = intersections_[i];
+        intersection.scale = static_cast<std::uint16_t>(154 + draw % 205);
+        intersection.shift = static_cast<std::int16_t>(
+            static_cast<std::int32_t>((draw >> 16) % static_cast<std::uint64_t>(2 * maxShift + 1)) - maxShift);
+        intersection.arterial = static_cast<std::uint8_t>((draw >> 40) & 1u);
+    }
+}
+
+void Workload::chances(std::uint32_t intersection, IClock::Time now,
+                       std::array<std::uint32_t, Lane::COUNT> &chances) const
+{
+    const Intersection &draw = intersections_[intersection];
+
+    std::int64_t step = (static_cast<std::int64_t>(now) / CURVE_STEP + draw.shift) % static_cast<std::int64_t>(CURVE_STEPS);
+    step += step < 0 ? static_cast<std::int64_t>(CURVE_STEPS) : 0;
+    const std::array<std::uint16_t, 2> &rates = curve_[static_cast<std::size_t>(step)];
+
+    std::uint8_t major = draw.arterial ? static_cast<std::uint8_t>(~NORTH_SOUTH_LANES) : NORTH_SOUTH_LANES;
+    std::uint32_t turnShare = static_cast<std::uint32_t>(config_.turnShare * 256.0f);
+
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        std::uint32_t chance = rates[(INBOUND_LANES >> lane) & 1u ? 0 : 1];
+        chance = (chance * draw.scale) >> 8;
+        chance = (major >> lane) & 1u ? chance : chance / 2;
+        chance = (TURN_LANES >> lane) & 1u ? (chance * turnShare) >> 8 : chance;
+        chances[lane] = std::min(chance, CHANCE_ONE - 1);
+    }
+}
+
+std::uint8_t Workload::arrivals(std::uint32_t intersection, IClock::Time second,
+                                const std::array<std::uint32_t, Lane::COUNT> &chances) const
+{
+    /// Two draws give 16 bits for each lane.
+    std::uint64_t key = mix((static_cast<std::uint64_t>(config_.seed) << 32) ^ intersection) ^
+                        static_cast<std::uint64_t>(static_cast<std::uint32_t>(second)) * 0x100000001b3ull;
+    std::uint64_t draws[2] = {mix(key), mix(key ^ 0xd1b54a32d192ed03ull)};
+
+    std::uint8_t arrived = 0;
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        std::uint32_t roll = static_cast<std::uint32_t>(draws[lane / 4] >> (16 * (lane % 4))) & 0xffffu;
+        arrived |= static_cast<std::uint8_t>((roll < chances[lane]) << lane);
+    }
+    return arrived;
+}
+
+std::uint8_t Workload::sensorMask(std::uint32_t intersection, IClock::Time now) const
+{
+    std::array<std::uint32_t, Lane::COUNT> chance;
+    chances(intersection, now, chance);
+
+    std::uint8_t mask = 0;
+    for (Clock::Time held = 0; held < config_.occupancyTime; held++)
+    {
+        mask |= arrivals(intersection, now - held, chance);
+    }
+    return mask;
+}
+
+void Workload::sensors(std::uint32_t intersection, IClock::Time now, VehicleSensors &sensors) const
+{
+    std::uint8_t mask = sensorMask(intersection, now);
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        sensors[lane] = (mask >> lane) & 1u ? SensorState::SET : SensorState::CLEAR;
+    }
+}
+
+float Workload::arrivalRate(std::uint32_t intersection, Lane lane, IClock::Time now) const
+{
+    std::array<std::uint32_t, Lane::COUNT> chance;
+    chances(intersection, now, chance);
+    return static_cast<float>(chance[lane]) / CHANCE_ONE;
+}
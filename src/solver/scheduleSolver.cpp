@@ -0,0 +1,263 @@
+#include "impl/solver/scheduleSolver.hpp"
+
+#include <algorithm>
+#include <limits>
+
+/// Cost of an unreachable or pruned state
+static constexpr std::int64_t UNREACHABLE = std::numeric_limits<std::int64_t>::max();
+
+ScheduleSolver::ScheduleSolver
+(
+    const TimingConfig &timing,
+    Clock::Time timeStep
+)
+    : timeStep_(std::max<Clock::Time>(1, timeStep)),
+      minSteps_(),
+      maxSteps_()
+{
+    for (int p = 0; p < NUM_PATTERNS; p++)
+    {
+        IClock::Time minTime = std::max<IClock::Time>(0, timing.patterns[p].minActiveTime);
+        IClock::Time maxTime = std::max<IClock::Time>(0, timing.patterns[p].maxActiveTime);
+
+        minSteps_[p] = static_cast<std::uint32_t>((minTime + timeStep_ - 1) / timeStep_);
+        maxSteps_[p] = static_cast<std::uint32_t>((maxTime + timeStep_ - 1) / timeStep_);
+        maxSteps_[p] = std::max({maxSteps_[p], minSteps_[p], 1u});
+    }
+}
+
+PatternSchedule ScheduleSolver::solve(const Scenario &scenario, SolverStats *stats) const
+{
+    return solve(sampleScenario(scenario, timeStep_), stats);
+}
+
+PatternSchedule ScheduleSolver::solve(const SensorTimeline &timeline, SolverStats *stats) const
+{
+    SolverStats counters = {};
+    const std::size_t steps = timeline.size();
+    if (steps == 0)
+    {
+        return PatternSchedule();
+    }
+
+    /// States of pattern p live at offset[p] + elapsed steps.
+    std::array<std::size_t, NUM_PATTERNS + 1> offset = {};
+    for (int p = 0; p < NUM_PATTERNS; p++)
+    {
+        offset[p + 1] = offset[p] + maxSteps_[p];
+    }
+
+    std::vector<std::int64_t> cost(offset[NUM_PATTERNS], UNREACHABLE);
+    std::vector<std::int64_t> next(offset[NUM_PATTERNS], UNREACHABLE);
+
+    /// How each pattern's youngest and oldest states were
+    /// reached at each step, to rebuild the schedule.
+    static constexpr std::uint8_t STARTED = 1; ///< (p, 0) switched in from the previous pattern
+    static constexpr std::uint8_t RESTED = 2;  ///< (p, max - 1) held past max with nobody waiting
+    std::vector<std::uint8_t> reachedBy(steps * NUM_PATTERNS, 0);
+    std::vector<std::uint32_t> switchedFrom(steps * NUM_PATTERNS, 0);
+
+    auto setMaskOf = [&timeline](std::size_t step)
+    {
+        LaneMask set = 0;
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            if (timeline[step][lane] == SensorState::SET)
+            {
+                set |= laneBit(lane);
+            }
+        }
+        return set;
+    };
+
+    auto waitOf = [this](int pattern, LaneMask set)
+    {
+        LaneMask waiting = set & static_cast<LaneMask>(~PATTERN_TRANSITIONS[pattern].greenLanes);
+        return static_cast<std::int64_t>(__builtin_popcount(waiting)) * timeStep_;
+    };
+
+    LaneMask set = setMaskOf(0);
+    cost[offset[NorthSouthTurning]] = waitOf(NorthSouthTurning, set);
+
+    for (std::size_t step = 1; step < steps; step++)
+    {
+        LaneMask previousSet = set;
+        set = setMaskOf(step);
+        std::fill(next.begin(), next.end(), UNREACHABLE);
+        std::array<std::int64_t, NUM_PATTERNS> bestStart;
+        std::array<std::uint32_t, NUM_PATTERNS> bestFrom = {};
+        bestStart.fill(UNREACHABLE);
+
+        for (int p = 0; p < NUM_PATTERNS; p++)
+        {
+            int following = PATTERN_TRANSITIONS[p].next;
+            std::uint32_t oldest = maxSteps_[p] - 1;
+
+            /// Like the controller, a pattern may rest past its
+            /// max active time while no other lane was waiting on
+            /// the last step, which is all the controller has seen.
+            bool mayRest = waitOf(p, previousSet) == 0;
+
+            for (std::uint32_t elapsed = 0; elapsed < maxSteps_[p]; elapsed++)
+            {
+                std::int64_t stateCost = cost[offset[p] + elapsed];
+                if (stateCost == UNREACHABLE)
+                {
+                    continue;
+                }
+                counters.statesExpanded++;
+
+                if (elapsed < oldest)
+                {
+                    next[offset[p] + elapsed + 1] = stateCost;
+                }
+                else if (mayRest && stateCost < next[offset[p] + oldest])
+                {
+                    next[offset[p] + oldest] = stateCost;
+                    reachedBy[step * NUM_PATTERNS + p] |= RESTED;
+                }
+
+                if (elapsed + 1 >= minSteps_[p] && stateCost < bestStart[following])
+                {
+                    bestStart[following] = stateCost;
+                    bestFrom[following] = elapsed;
+                }
+            }
+        }
+
+        for (int p = 0; p < NUM_PATTERNS; p++)
+        {
+            if (bestStart[p] < next[offset[p]])
+            {
+                next[offset[p]] = bestStart[p];
+                switchedFrom[step * NUM_PATTERNS + p] = bestFrom[p];
+                reachedBy[step * NUM_PATTERNS + p] |= STARTED;
+            }
+
+            /// Every state of a pattern waits the same this step.
+            std::int64_t wait = waitOf(p, set);
+            std::int64_t cheapest = UNREACHABLE;
+            std::uint32_t firstComparable = minSteps_[p] > 0 ? minSteps_[p] - 1 : 0;
+
+            for (std::uint32_t elapsed = 0; elapsed < maxSteps_[p]; elapsed++)
+            {
+                std::int64_t &stateCost = next[offset[p] + elapsed];
+                if (stateCost == UNREACHABLE)
+                {
+                    continue;
+                }
+                stateCost += wait;
+
+                /// Once a pattern may end on the next step, a younger
+                /// state at least as cheap dominates an older one.
+                if (elapsed >= firstComparable)
+                {
+                    if (stateCost >= cheapest)
+                    {
+                        stateCost = UNREACHABLE;
+                        counters.statesPruned++;
+                    }
+                    else
+                    {
+                        cheapest = stateCost;
+                    }
+                }
+            }
+        }
+
+        cost.swap(next);
+    }
+
+    /// Walk back from the cheapest final state.
+    int pattern = NorthSouthTurning;
+    std::uint32_t elapsed = 0;
+    std::int64_t best = UNREACHABLE;
+    for (int p = 0; p < NUM_PATTERNS; p++)
+    {
+        for (std::uint32_t e = 0; e < maxSteps_[p]; e++)
+        {
+            if (cost[offset[p] + e] < best)
+            {
+                best = cost[offset[p] + e];
+                pattern = p;
+                elapsed = e;
+            }
+        }
+    }
+
+    PatternSchedule schedule(steps);
+    for (std::size_t step = steps; step-- > 0;)
+    {
+        schedule[step] = static_cast<TrafficLightPattern>(pattern);
+        if (step == 0)
+        {
+            break;
+        }
+
+        std::uint8_t reached = reachedBy[step * NUM_PATTERNS + pattern];
+        if (elapsed == 0 && (reached & STARTED))
+        {
+            elapsed = switchedFrom[step * NUM_PATTERNS + pattern];
+            pattern = previousPattern(static_cast<TrafficLightPattern>(pattern));
+        }
+        else if (elapsed == maxSteps_[pattern] - 1 && (reached & RESTED))
+        {
+            continue;
+        }
+        else
+        {
+            elapsed--;
+        }
+    }
+
+    counters.steps = steps;
+    if (stats)
+    {
+        *stats = counters;
+    }
+    return schedule;
+}
+
+bool ScheduleSolver::isFeasible(const PatternSchedule &schedule, const SensorTimeline &timeline) const
+{
+    if (schedule.empty())
+    {
+        return true;
+    }
+    if (schedule.front() != NorthSouthTurning || timeline.size() < schedule.size())
+    {
+        return false;
+    }
+
+    std::uint32_t run = 0;
+    for (std::size_t step = 0; step < schedule.size(); step++)
+    {
+        TrafficLightPattern pattern = schedule[step];
+        if (step > 0 && pattern != schedule[step - 1])
+        {
+            TrafficLightPattern ended = schedule[step - 1];
+            if (pattern != PATTERN_TRANSITIONS[ended].next || run < minSteps_[ended])
+            {
+                return false;
+            }
+            run = 0;
+        }
+
+        run++;
+        if (run > maxSteps_[pattern])
+        {
+            /// Only resting with nobody waiting on the last step
+            /// may run past max.
+            for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+            {
+                if (timeline[step - 1][lane] == SensorState::SET &&
+                    !(PATTERN_TRANSITIONS[pattern].greenLanes & laneBit(lane)))
+                {
+                    return false;
+                }
+            }
+            run = maxSteps_[pattern];
+        }
+    }
+    return true;
+}
@@ -0,0 +1,161 @@
+#include "impl/trace/trace.hpp"
+
+#include <iomanip>
+#include <mutex>
+#include <string>
+
+namespace
+{
+
+/// Owns every buffer ever handed out so they outlive their threads.
+struct TraceRegistry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    std::vector<std::string> names;
+    std::uint64_t baseTicks = 0;   ///< cycle counter at first registration
+    std::int64_t baseNanos = 0;    ///< steady clock at first registration
+};
+
+TraceRegistry& registry()
+{
+    static TraceRegistry instance;
+    return instance;
+}
+
+std::int64_t steadyNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Escape the few characters that can break a JSON string.
+void writeJsonString(std::ostream &os, const char *text)
+{
+    os << '"';
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            os << '\\';
+        }
+        os << *c;
+    }
+    os << '"';
+}
+
+} // namespace
+
+thread_local TraceBuffer *Tracer::threadBuffer_ = nullptr;
+
+TraceBuffer::TraceBuffer
+(
+    std::uint32_t threadId,
+    std::size_t capacity
+)
+    : threadId_(threadId),
+      events_(capacity),
+      count_(0),
+      dropped_(0)
+{ }
+
+void TraceBuffer::clear()
+{
+    count_ = 0;
+    dropped_ = 0;
+}
+
+TraceBuffer& Tracer::registerThread(const char *name)
+{
+    if (threadBuffer_ == nullptr)
+    {
+        TraceRegistry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        if (reg.buffers.empty())
+        {
+            reg.baseTicks = readCycleCounter();
+            reg.baseNanos = steadyNanos();
+        }
+
+        auto threadId = static_cast<std::uint32_t>(reg.buffers.size() + 1);
+        reg.buffers.emplace_back(new TraceBuffer(threadId, BUFFER_CAPACITY));
+        reg.names.emplace_back(name ? name : "thread " + std::to_string(threadId));
+        threadBuffer_ = reg.buffers.back().get();
+    }
+
+    return *threadBuffer_;
+}
+
+void Tracer::writeChromeTrace(std::ostream &os)
+{
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    /// Calibrate ticks against the steady clock over at least 1ms
+    /// so the exported timestamps are in real microseconds.
+    std::uint64_t nowTicks = readCycleCounter();
+    std::int64_t nowNanos = steadyNanos();
+    while (nowNanos - reg.baseNanos < 1000000)
+    {
+        nowTicks = readCycleCounter();
+        nowNanos = steadyNanos();
+    }
+    double ticksPerMicro = static_cast<double>(nowTicks - reg.baseTicks) /
+                           (static_cast<double>(nowNanos - reg.baseNanos) / 1000.0);
+
+    /// A thread's first span starts before its buffer is registered,
+    /// so take the earliest span as the trace origin.
+    std::uint64_t originTicks = reg.baseTicks;
+    for (const auto &buffer : reg.buffers)
+    {
+        for (std::size_t e = 0; e < buffer->count(); e++)
+        {
+            if (buffer->event(e).begin < originTicks)
+            {
+                originTicks = buffer->event(e).begin;
+            }
+        }
+    }
+
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    bool first = true;
+    for (std::size_t i = 0; i < reg.buffers.size(); i++)
+    {
+        const TraceBuffer &buffer = *reg.buffers[i];
+
+        os << (first ? "\n" : ",\n");
+        first = false;
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.threadId()
+           << ",\"args\":{\"name\":";
+        writeJsonString(os, reg.names[i].c_str());
+        os << "}}";
+
+        for (std::size_t e = 0; e < buffer.count(); e++)
+        {
+            const TraceEvent &event = buffer.event(e);
+            double ts = static_cast<double>(event.begin - originTicks) / ticksPerMicro;
+            double dur = static_cast<double>(event.end - event.begin) / ticksPerMicro;
+
+            os << ",\n{\"name\":";
+            writeJsonString(os, event.name);
+            os << ",\"cat\":\"tlc\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.threadId()
+               << std::fixed << std::setprecision(3)
+               << ",\"ts\":" << ts << ",\"dur\":" << dur << "}";
+        }
+    }
+
+    os << "\n]}\n";
+}
+
+void Tracer::reset()
+{
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    for (auto &buffer : reg.buffers)
+    {
+        buffer->clear();
+    }
+}
@@ -0,0 +1,86 @@
+#include "AllocationHook.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local std::size_t threadAllocations = 0;   ///< operator new calls on this thread
+    thread_local std::size_t threadDeallocations = 0; ///< operator delete calls on this thread
+}
+
+void* operator new(std::size_t size)
+{
+    threadAllocations++;
+
+    if (void *memory = std::malloc(size ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    threadAllocations++;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *memory) noexcept
+{
+    if (memory)
+    {
+        threadDeallocations++;
+        std::free(memory);
+    }
+}
+
+void operator delete[](void *memory) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t&) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t&) noexcept
+{
+    operator delete(memory);
+}
+
+AllocationCounter::AllocationCounter()
+    : allocationsAtStart_(threadAllocations),
+      deallocationsAtStart_(threadDeallocations)
+{ }
+
+std::size_t AllocationCounter::allocations() const
+{
+    return threadAllocations - allocationsAtStart_;
+}
+
+std::size_t AllocationCounter::deallocations() const
+{
+    return threadDeallocations - deallocationsAtStart_;
+}
@@ -0,0 +1,45 @@
+#ifndef INCLUDE_ALLOCATIONHOOK_H_
+#define INCLUDE_ALLOCATIONHOOK_H_
+
+#include <cstddef>
+
+////////////////////////////////////////////////////////////
+///  @brief Counts heap allocations made by the calling
+///  thread while in scope.
+///
+///     The unit test binary replaces the global operator new
+///     and operator delete to count into a thread-local
+///     counter, so allocations made by other threads (e.g.
+///     the test framework) are never attributed to the code
+///     under test.
+///
+////////////////////////////////////////////////////////////
+class AllocationCounter
+{
+public:
+    ////////////////////////////////////////////////////////////
+    ///  @brief Start counting from zero
+    ///
+    ////////////////////////////////////////////////////////////
+    AllocationCounter();
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the allocations made since construction
+    ///
+    ///  @return std::size_t Calls to operator new
+    ////////////////////////////////////////////////////////////
+    std::size_t allocations() const;
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Get the deallocations made since construction
+    ///
+    ///  @return std::size_t Calls to operator delete
+    ////////////////////////////////////////////////////////////
+    std::size_t deallocations() const;
+
+private:
+    std::size_t allocationsAtStart_;   ///< thread's allocations at construction
+    std::size_t deallocationsAtStart_; ///< thread's deallocations at construction
+};
+
+#endif // INCLUDE_ALLOCATIONHOOK_H_
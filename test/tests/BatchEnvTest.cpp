@@ -0,0 +1,168 @@
+#include "gtest/gtest.h"
+
+#include "impl/env/batchEnv.hpp"
+#include "impl/env/tlcEnv.h"
+
+#include "AllocationHook.hpp"
+
+#include <cstring>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Step a batch through the C interface with a
+///  fixed pattern of actions, collecting everything shown.
+///
+////////////////////////////////////////////////////////////
+static std::vector<tlc_observation> runBatch(std::uint32_t numThreads, unsigned numSteps, std::vector<float> &rewards)
+{
+    const std::uint32_t numEnvs = 6;
+    tlc_batch *batch = tlc_batch_create(numEnvs, numThreads, 3);
+    EXPECT_NE(batch, nullptr);
+
+    std::vector<std::uint32_t> seeds = {1, 2, 3, 4, 5, 6};
+    std::vector<tlc_observation> observations(numEnvs);
+    std::vector<float> stepRewards(numEnvs);
+    std::vector<std::uint8_t> dones(numEnvs);
+    std::vector<std::int32_t> actions(numEnvs);
+    EXPECT_EQ(tlc_batch_reset(batch, seeds.data(), observations.data()), TLC_OK);
+
+    std::vector<tlc_observation> shown;
+    for (unsigned step = 0; step < numSteps; step++)
+    {
+        for (std::uint32_t env = 0; env < numEnvs; env++)
+        {
+            actions[env] = static_cast<std::int32_t>((step / 7 + env) % 3);
+        }
+        EXPECT_EQ(tlc_batch_step(batch, actions.data(), observations.data(), stepRewards.data(), dones.data()), TLC_OK);
+        shown.insert(shown.end(), observations.begin(), observations.end());
+        rewards.insert(rewards.end(), stepRewards.begin(), stepRewards.end());
+    }
+
+    tlc_batch_destroy(batch);
+    return shown;
+}
+
+TEST(BatchEnvTest, ResultsDoNotDependOnThreads)
+{
+    std::vector<float> oneThread;
+    std::vector<float> threeThreads;
+    std::vector<tlc_observation> a = runBatch(1, 400, oneThread);
+    std::vector<tlc_observation> b = runBatch(3, 400, threeThreads);
+
+    ASSERT_EQ(a.size(), b.size());
+    EXPECT_EQ(std::memcmp(a.data(), b.data(), a.size() * sizeof(tlc_observation)), 0);
+    EXPECT_EQ(oneThread, threeThreads);
+
+    /// Some traffic waited, and some was served.
+    float total = 0.0f;
+    unsigned green = 0;
+    for (std::size_t i = 0; i < a.size(); i++)
+    {
+        total += oneThread[i];
+        green += a[i].green != 0;
+    }
+    EXPECT_LT(total, 0.0f);
+    EXPECT_GT(green, 0u);
+}
+
+TEST(BatchEnvTest, HoldKeepsThePatternUntilItsMaximum)
+{
+    BatchEnvConfig config = defaultBatchEnvConfig(1);
+    config.numThreads = 1;
+    BatchEnv batch(config);
+
+    tlc_observation observation;
+    batch.reset(0, 9, observation);
+
+    /// Cars are waiting somewhere from the morning on, so
+    /// only the max active time can end a held pattern.
+    std::int32_t action = TLC_ACTION_RULES;
+    float reward;
+    std::uint8_t done;
+    for (int t = 0; t < 8 * 3600; t++)
+    {
+        batch.step(&action, &observation, &reward, &done);
+    }
+
+    /// Every pattern's max active time is 30s or more.
+    action = TLC_ACTION_HOLD;
+    std::uint8_t pattern = observation.pattern;
+    float held = 0.0f;
+    while (observation.pattern == pattern)
+    {
+        held = observation.elapsedGreen;
+        batch.step(&action, &observation, &reward, &done);
+        ASSERT_LE(observation.elapsedGreen, 120.0f);
+    }
+    EXPECT_GE(held, 29.0f);
+
+    /// ADVANCE ends the next pattern at its minimum.
+    action = TLC_ACTION_ADVANCE;
+    pattern = observation.pattern;
+    float elapsed = 0.0f;
+    while (observation.pattern == pattern)
+    {
+        elapsed = observation.elapsedGreen;
+        batch.step(&action, &observation, &reward, &done);
+    }
+    EXPECT_LE(elapsed, 31.0f);
+}
+
+TEST(BatchEnvTest, StepDoesNotAllocateAndEndsWithTheDay)
+{
+    BatchEnvConfig config = defaultBatchEnvConfig(2);
+    config.numThreads = 1;
+    config.stepSeconds = 60;
+    BatchEnv batch(config);
+
+    std::int32_t actions[2] = {TLC_ACTION_RULES, TLC_ACTION_HOLD};
+    tlc_observation observations[2];
+    float rewards[2];
+    std::uint8_t dones[2] = {0, 0};
+
+    std::size_t allocations = 0;
+    unsigned steps = 0;
+    while (!dones[0])
+    {
+        AllocationCounter counter;
+        batch.step(actions, observations, rewards, dones);
+        allocations += counter.allocations();
+        steps++;
+        ASSERT_LE(steps, 1440u);
+    }
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(steps, 1440u);
+    EXPECT_EQ(dones[1], 1);
+
+    /// A finished environment stands still until reset.
+    batch.step(actions, observations, rewards, dones);
+    EXPECT_EQ(rewards[0], 0.0f);
+    batch.reset(0, 4, observations[0]);
+    batch.step(actions, observations, rewards, dones);
+    EXPECT_EQ(dones[0], 0);
+}
+
+TEST(BatchEnvTest, RejectsBadArguments)
+{
+    EXPECT_EQ(tlc_batch_create(0, 1, 1), nullptr);
+    EXPECT_EQ(tlc_batch_create(1, 1, 0), nullptr);
+    EXPECT_EQ(tlc_batch_size(nullptr), 0u);
+    tlc_batch_destroy(nullptr);
+
+    tlc_batch *batch = tlc_batch_create(2, 1, 1);
+    ASSERT_NE(batch, nullptr);
+    EXPECT_EQ(tlc_batch_size(batch), 2u);
+
+    tlc_observation observations[2];
+    float rewards[2];
+    std::uint8_t dones[2];
+    std::int32_t actions[2] = {TLC_ACTION_HOLD, 3};
+    EXPECT_EQ(tlc_batch_step(batch, actions, observations, rewards, dones), TLC_ERROR_ARGUMENT);
+    EXPECT_EQ(tlc_batch_step(batch, actions, observations, nullptr, dones), TLC_ERROR_ARGUMENT);
+    EXPECT_EQ(tlc_batch_reset_one(batch, 2, 0, observations), TLC_ERROR_ARGUMENT);
+    EXPECT_EQ(tlc_batch_reset(batch, nullptr, observations), TLC_ERROR_ARGUMENT);
+
+    actions[1] = TLC_ACTION_ADVANCE;
+    EXPECT_EQ(tlc_batch_step(batch, actions, observations, rewards, dones), TLC_OK);
+    tlc_batch_destroy(batch);
+}
@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/config/configManager.hpp"
+#include "impl/simulator/simulator.hpp"
+
+#include "AllocationHook.hpp"
+
+using SS = SensorState;
+
+TEST(ConfigManagerTest, OldConfigOutlivesPublishUntilReaderLeaves)
+{
+    TimingConfig first = defaultTimingConfig();
+    first.maxWaitTime = 50;
+    ConfigManager config(first, nullptr);
+    ConfigManager::ReaderId holder = config.registerReader();
+    ConfigManager::ReaderId other = config.registerReader();
+
+    /// A reader takes the config, then a new one is published
+    /// under it.
+    const TimingConfig &held = config.read();
+    TimingConfig second = defaultTimingConfig();
+    second.maxWaitTime = 70;
+    config.publish(second);
+
+    EXPECT_EQ(config.read().maxWaitTime, 70);
+    EXPECT_EQ(held.maxWaitTime, 50);
+    EXPECT_EQ(config.reclaim(), 1u);
+
+    /// Another reader passing a quiescent point is not enough.
+    config.quiescent(other);
+    EXPECT_EQ(config.reclaim(), 1u);
+    EXPECT_EQ(held.maxWaitTime, 50);
+
+    /// The holder's quiescent point ends the grace period.
+    config.quiescent(holder);
+    EXPECT_EQ(config.reclaim(), 0u);
+
+    /// Unregistering ends it too.
+    const TimingConfig &heldAgain = config.read();
+    config.publish(first);
+    EXPECT_EQ(config.reclaim(), 1u);
+    EXPECT_EQ(heldAgain.maxWaitTime, 70);
+    config.quiescent(other);
+    config.unregisterReader(holder);
+    EXPECT_EQ(config.reclaim(), 0u);
+
+    config.unregisterReader(other);
+}
+
+TEST(ConfigManagerTest, ReloadBetweenTicksDoesNotAllocateInRun)
+{
+    Scenario scenario = {{0, 600, {SS::SET, SS::SET, SS::SET, SS::SET, SS::SET, SS::SET, SS::SET, SS::SET}}};
+    Simulator simulator(scenario);
+    ConfigManager config(defaultTimingConfig(), nullptr);
+    ConfigManager::ReaderId reader = config.registerReader();
+    TrafficLightControllerApp tlcApp(simulator.clock(), simulator.sensors(), DEFAULT_MAX_WAIT_TIME, nullptr);
+    tlcApp.attachConfig(config, reader);
+    tlcApp.initApp();
+
+    TimingConfig timing = defaultTimingConfig();
+    std::size_t allocations = 0;
+    std::size_t reloads = 0;
+    for (unsigned tick = 0; !simulator.done(); tick++)
+    {
+        /// Reload every few ticks, as the file watcher would.
+        if (tick % 7 == 3)
+        {
+            timing.patterns[NorthSouthThrough].maxActiveTime = 40 + static_cast<IClock::Time>(tick % 50);
+            config.publish(timing);
+            reloads++;
+        }
+
+        AllocationCounter counter;
+        tlcApp.run();
+        allocations += counter.allocations();
+
+        simulator.update_lane_signals(tlcApp.getSignals());
+        simulator.advance(5);
+    }
+
+    EXPECT_GT(reloads, 10u);
+    EXPECT_EQ(allocations, 0u);
+
+    /// Every tick was a quiescent point, so only the config
+    /// published after the last tick may still be held.
+    EXPECT_LE(config.reclaim(), 1u);
+    config.unregisterReader(reader);
+    EXPECT_EQ(config.reclaim(), 0u);
+}
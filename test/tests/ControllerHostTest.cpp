@@ -0,0 +1,143 @@
+#include "gtest/gtest.h"
+
+#include "impl/host/controllerHost.hpp"
+#include "impl/simulator/workload.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Poll a controller's signals until a lane shows a
+///  signal or a second passes.
+///
+////////////////////////////////////////////////////////////
+static bool waitForSignal(const ControllerHost &host, ControllerId id, Lane lane, SignalState state)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (host.signals(id)[lane] != state)
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+}
+
+TEST(ControllerHostTest, PreemptionWakesASleepingShard)
+{
+    /// Ticks a minute apart: only the wake-up can show the
+    /// YELLOW within the test.
+    HostConfig config = defaultHostConfig();
+    config.numShards = 1;
+    config.shardCapacity = 4;
+    config.tickPeriod = std::chrono::seconds(60);
+    config.pinThreads = false;
+    ControllerHost host(config);
+
+    ControllerId id = host.addController();
+    host.start();
+    ASSERT_TRUE(waitForSignal(host, id, Lane::N_W, SignalState::GREEN));
+
+    EXPECT_TRUE(host.preempt(id, EastWestThrough));
+    EXPECT_TRUE(waitForSignal(host, id, Lane::N_W, SignalState::YELLOW));
+    EXPECT_EQ(host.signals(id)[Lane::E_E], SignalState::RED);
+
+    EXPECT_TRUE(host.releasePreemption(id));
+    EXPECT_FALSE(host.preempt(id, TrafficLightPattern::NUM_PATTERNS));
+    EXPECT_FALSE(host.preempt(id + 1, EastWestThrough));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (host.report(0).preemptions < 2 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    host.stop();
+
+    ShardReport report = host.report(0);
+    EXPECT_EQ(report.preemptions, 2u);
+    EXPECT_GT(report.preemptMax, 0u);
+    EXPECT_EQ(report.ticks, 1u);
+}
+
+TEST(ControllerHostTest, SensorFeedDrivesEveryController)
+{
+    HostConfig config = defaultHostConfig();
+    config.numShards = 2;
+    config.shardCapacity = 4;
+    config.tickPeriod = std::chrono::microseconds(0);
+    config.tickLimit = 300;
+    config.pinThreads = false;
+
+    Workload workload(defaultWorkloadConfig(config.numShards * config.shardCapacity));
+    config.sensorFeed = &workload;
+
+    ControllerHost host(config);
+    std::vector<ControllerId> ids;
+    for (int i = 0; i < 6; i++)
+    {
+        ids.push_back(host.addController());
+    }
+    host.start();
+    host.wait();
+
+    /// Each controller sees what a lone one fed the same
+    /// intersection's traffic does.
+    for (ControllerId id : ids)
+    {
+        Clock clock;
+        VehicleSensors sensors;
+        TrafficLightControllerApp app(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+        app.initApp();
+        for (IClock::Time t = 0; t < 300; t++)
+        {
+            workload.sensors(id, clock.now(), sensors);
+            app.run();
+            clock.advance(1);
+        }
+        EXPECT_EQ(host.signals(id), app.getSignals()) << "controller " << id;
+    }
+}
+
+TEST(ControllerHostTest, IgnoresIdsNotHandedOut)
+{
+    HostConfig config = defaultHostConfig();
+    config.numShards = 2;
+    config.shardCapacity = 4;
+    config.pinThreads = false;
+    ControllerHost host(config);
+
+    ControllerId id = host.addController();
+    ASSERT_NE(id, INVALID_CONTROLLER);
+    EXPECT_TRUE(host.setSensorMask(id, 0x5));
+    EXPECT_EQ(host.sensorMask(id), 0x5);
+
+    /// Past the last shard, never handed out, and removed.
+    ControllerId outOfRange = config.numShards * config.shardCapacity;
+    ControllerId unused = id ^ 1;
+    std::vector<ControllerId> invalid = {INVALID_CONTROLLER, outOfRange, outOfRange + 5, unused};
+    EXPECT_TRUE(host.removeController(id));
+    invalid.push_back(id);
+
+    for (ControllerId bad : invalid)
+    {
+        EXPECT_FALSE(host.setSensorMask(bad, 0xFF)) << bad;
+        EXPECT_FALSE(host.setSensors(bad, VehicleSensors())) << bad;
+        EXPECT_EQ(host.sensorMask(bad), 0) << bad;
+        for (SignalState signal : host.signals(bad))
+        {
+            EXPECT_EQ(signal, SignalState::RED) << bad;
+        }
+        EXPECT_FALSE(host.removeController(bad)) << bad;
+        EXPECT_FALSE(host.preempt(bad, EastWestThrough)) << bad;
+        EXPECT_FALSE(host.releasePreemption(bad)) << bad;
+    }
+
+    /// An id handed out again reaches the new controller.
+    ControllerId again = host.addController();
+    ASSERT_EQ(again, id);
+    EXPECT_TRUE(host.setSensorMask(again, 0x3));
+    EXPECT_EQ(host.sensorMask(again), 0x3);
+}
@@ -0,0 +1,36 @@
+#include "gtest/gtest.h"
+
+#include "interfaces/clock/IClock.hpp"
+#include "impl/simulator/simulator.hpp"
+#include "impl/util/deadlineHeap.hpp"
+
+TEST(DeadlineHeapTest, KeepsTheEarliestOnTop)
+{
+    DeadlineHeap<IClock::Time, Lane::COUNT> heap;
+    EXPECT_TRUE(heap.empty());
+
+    const IClock::Time keys[Lane::COUNT] = {50, 20, 70, 20, 90, 10, 60, 30};
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        heap.set(lane, keys[lane]);
+    }
+    EXPECT_EQ(heap.top(), 5u);
+
+    /// Equal keys come out by index; moved and erased items
+    /// leave the heap in order.
+    heap.erase(5);
+    heap.erase(5);
+    EXPECT_FALSE(heap.contains(5));
+    EXPECT_EQ(heap.top(), 1u);
+    heap.set(4, 0);
+    heap.set(7, 100);
+
+    const unsigned order[] = {4, 1, 3, 0, 6, 2, 7};
+    for (unsigned lane : order)
+    {
+        ASSERT_FALSE(heap.empty());
+        EXPECT_EQ(heap.top(), lane);
+        heap.erase(heap.top());
+    }
+    EXPECT_TRUE(heap.empty());
+}
@@ -0,0 +1,136 @@
+#include "gtest/gtest.h"
+
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/app/demandEstimator.hpp"
+
+#include "AllocationHook.hpp"
+
+////////////////////////////////////////////////////////////
+///  @brief Feed an estimator one lane's detector pulsing for
+///  one tick in every period, with some lanes GREEN.
+///
+////////////////////////////////////////////////////////////
+static void pulse(DemandEstimator &estimator, LaneMask lanes, IClock::Time period,
+                  IClock::Time from, IClock::Time to, LaneMask green)
+{
+    for (IClock::Time t = from; t < to; t++)
+    {
+        estimator.update(t, t % period == 0 ? lanes : 0, green);
+    }
+}
+
+TEST(DemandEstimatorTest, RateFollowsArrivals)
+{
+    DemandEstimator estimator;
+    pulse(estimator, laneBit(Lane::E_E), 4, 0, 1000, 0);
+    EXPECT_NEAR(estimator.arrivalRate(Lane::E_E), 0.25f, 0.05f);
+    EXPECT_EQ(estimator.arrivalRate(Lane::W_W), 0.0f);
+
+    pulse(estimator, 0, 1, 1000, 1400, 0);
+    EXPECT_LT(estimator.arrivalRate(Lane::E_E), 0.01f);
+}
+
+TEST(DemandEstimatorTest, OccupancyCountsOnlyGreenTicks)
+{
+    DemandEstimator estimator;
+    LaneMask held = laneBit(Lane::N_N) | laneBit(Lane::E_E);
+    for (IClock::Time t = 0; t < 100; t++)
+    {
+        estimator.update(t, held, laneBit(Lane::N_N));
+    }
+    EXPECT_EQ(estimator.occupancy(Lane::N_N), 1.0f);
+    EXPECT_EQ(estimator.occupancy(Lane::E_E), 0.0f);
+
+    /// Half a window of empty green, then red with the
+    /// detector SET, which leaves the window as it was.
+    for (IClock::Time t = 100; t < 132; t++)
+    {
+        estimator.update(t, 0, laneBit(Lane::N_N));
+    }
+    for (IClock::Time t = 132; t < 200; t++)
+    {
+        estimator.update(t, held, 0);
+    }
+    EXPECT_EQ(estimator.occupancy(Lane::N_N), 0.5f);
+}
+
+TEST(DemandEstimatorTest, ProfileLearnsEachTimeOfDay)
+{
+    DemandConfig config = defaultDemandConfig();
+    config.profileBin = 10;
+    DemandEstimator estimator(config);
+
+    /// Arrivals every 2s in the first bin of each day, none
+    /// in the second.
+    IClock::Time day = config.profileBin * DemandEstimator::PROFILE_BINS;
+    for (IClock::Time start = 0; start < 4 * day; start += day)
+    {
+        pulse(estimator, laneBit(Lane::S_S), 2, start, start + 10, 0);
+        pulse(estimator, 0, 1, start + 10, start + day, 0);
+    }
+
+    EXPECT_NEAR(estimator.profileRate(Lane::S_S, 5), 0.5f, 0.1f);
+    EXPECT_EQ(estimator.profileRate(Lane::S_S, 15), 0.0f);
+    EXPECT_EQ(estimator.profileRate(Lane::N_N, 5), 0.0f);
+}
+
+TEST(DemandEstimatorTest, AdaptKeepsTheBoundsUntilItSeesTraffic)
+{
+    DemandEstimator estimator;
+    TimingConfig bounds = defaultTimingConfig();
+    pulse(estimator, 0, 1, 0, 100, ALL_LANES);
+
+    const TimingConfig &adapted = estimator.adapt(bounds);
+    for (unsigned p = 0; p < NUM_PATTERNS; p++)
+    {
+        EXPECT_EQ(adapted.patterns[p].minActiveTime, bounds.patterns[p].minActiveTime);
+        EXPECT_EQ(adapted.patterns[p].maxActiveTime, bounds.patterns[p].maxActiveTime);
+    }
+    EXPECT_EQ(adapted.maxWaitTime, bounds.maxWaitTime);
+}
+
+TEST(DemandEstimatorTest, AdaptGivesTheBusyPatternItsMaximum)
+{
+    DemandConfig config = defaultDemandConfig();
+    config.features = ARRIVAL_RATE;
+    DemandEstimator estimator(config);
+    TimingConfig bounds = defaultTimingConfig();
+
+    /// Both through lanes at saturation flow, nothing else.
+    pulse(estimator, laneBit(Lane::N_N) | laneBit(Lane::S_S), 2, 0, 600, 0);
+
+    const TimingConfig &adapted = estimator.adapt(bounds);
+    EXPECT_EQ(adapted.patterns[NorthSouthThrough].minActiveTime, bounds.patterns[NorthSouthThrough].maxActiveTime);
+    for (unsigned p = 0; p < NUM_PATTERNS; p++)
+    {
+        EXPECT_GE(adapted.patterns[p].minActiveTime, bounds.patterns[p].minActiveTime);
+        EXPECT_LE(adapted.patterns[p].minActiveTime, adapted.patterns[p].maxActiveTime);
+        EXPECT_EQ(adapted.patterns[p].maxActiveTime, bounds.patterns[p].maxActiveTime);
+    }
+}
+
+TEST(DemandEstimatorTest, TickWithEstimatorDoesNotAllocate)
+{
+    Clock clock;
+    VehicleSensors sensors;
+    sensors.fill(SensorState::CLEAR);
+    DemandEstimator estimator;
+    TrafficLightControllerApp app(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+    app.attachEstimator(&estimator);
+    app.initApp();
+
+    std::size_t allocations = 0;
+    for (IClock::Time t = 0; t < 2000; t++)
+    {
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            sensors[lane] = (t + lane * 3) % (lane + 2) == 0 ? SensorState::SET : SensorState::CLEAR;
+        }
+
+        AllocationCounter counter;
+        app.run();
+        allocations += counter.allocations();
+        clock.advance(1);
+    }
+    EXPECT_EQ(allocations, 0u);
+}
@@ -0,0 +1,199 @@
+#include "gtest/gtest.h"
+
+#include "impl/app/patternTable.hpp"
+#include "impl/simulator/detectorLog.hpp"
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Import a log held in a string.
+///
+////////////////////////////////////////////////////////////
+static bool import(const std::string &text, const DetectorLogOptions &options, Scenario &scenario,
+                   DetectorLogStats &stats, std::string &error)
+{
+    return parseDetectorLog(text.data(), text.size(), options, scenario, stats, error);
+}
+
+static void expectSlice(const SimulationTimeslice &slice, Clock::Time start, Clock::Time end, LaneMask set)
+{
+    EXPECT_EQ(slice.start, start);
+    EXPECT_EQ(slice.end, end);
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        EXPECT_EQ(slice.sensors[lane], (set & laneBit(lane)) ? SensorState::SET : SensorState::CLEAR)
+            << "slice [" << start << ", " << end << ") lane " << lane;
+    }
+}
+
+TEST(DetectorLogTest, BuildsTimeslicesFromEvents)
+{
+    std::string log =
+        "timestamp,detector,state\r\n"
+        "1700000000,0,1\r\n"
+        "1700000000.25,1,SET\r\n"
+        "1700000003,0,0\r\n"
+        "\r\n"
+        "1700000003,9,1\r\n"         // no lane
+        "1700000004,1,garbage\r\n"   // malformed
+        "1700000005, 2 ,on\r\n"
+        "1700000005,2,off\r\n"       // last event of a second wins
+        "1700000006,1,clear\r\n"
+        "1700000008,3,1";           // no line feed
+
+    Scenario scenario;
+    DetectorLogStats stats;
+    std::string error;
+    ASSERT_TRUE(import(log, defaultDetectorLogOptions(), scenario, stats, error)) << error;
+
+    ASSERT_EQ(scenario.size(), 4u);
+    expectSlice(scenario[0], 0, 3, laneBit(Lane::N_N) | laneBit(Lane::N_W));
+    expectSlice(scenario[1], 3, 6, laneBit(Lane::N_W));
+    expectSlice(scenario[2], 6, 8, 0);
+    expectSlice(scenario[3], 8, 9, laneBit(Lane::S_E));
+
+    EXPECT_EQ(stats.lines, 9u);
+    EXPECT_EQ(stats.events, 7u);
+    EXPECT_EQ(stats.unmapped, 1u);
+    EXPECT_EQ(stats.malformed, 1u);
+    EXPECT_EQ(stats.changes, 5u);
+}
+
+TEST(DetectorLogTest, KeepsAbsoluteTimesWhenAsked)
+{
+    DetectorLogOptions options = defaultDetectorLogOptions();
+    options.rebase = false;
+
+    Scenario scenario;
+    DetectorLogStats stats;
+    std::string error;
+    ASSERT_TRUE(import("100,4,1\n110,4,0\n", options, scenario, stats, error)) << error;
+    ASSERT_EQ(scenario.size(), 2u);
+    expectSlice(scenario[0], 100, 110, laneBit(Lane::E_E));
+    expectSlice(scenario[1], 110, 111, 0);
+}
+
+TEST(DetectorLogTest, RejectsTimeGoingBackwards)
+{
+    Scenario scenario(1);
+    DetectorLogStats stats;
+    std::string error;
+    EXPECT_FALSE(import("10,0,1\n12,0,0\n11,0,1\n", defaultDetectorLogOptions(), scenario, stats, error));
+    EXPECT_NE(error.find("byte 14"), std::string::npos) << error;
+    EXPECT_EQ(scenario.size(), 1u);
+
+    /// Also where one chunk meets the next.
+    DetectorLogOptions options = defaultDetectorLogOptions();
+    options.chunkSize = 64;
+    options.numThreads = 3;
+    std::string log;
+    for (int t = 0; t < 40; t++)
+    {
+        log += std::to_string(1000 + t) + ",1,1\n";
+    }
+    log += "999,1,0\n";
+    EXPECT_FALSE(import(log, options, scenario, stats, error));
+
+    EXPECT_FALSE(import("time,detector,state\n", options, scenario, stats, error));
+    EXPECT_EQ(error, "no events");
+}
+
+TEST(DetectorLogTest, ChunksAndThreadsMatchAPlainReplay)
+{
+    /// A polled log: every detector every second, with bursts
+    /// of several events in a second and detectors 8 and up
+    /// that no lane listens to.
+    std::mt19937 rng(3);
+    std::string log = "ts,id,value\n";
+    std::vector<LaneMask> expected;
+    LaneMask state = 0;
+    for (int second = 0; second < 5000; second++)
+    {
+        for (unsigned detector = 0; detector < 10; detector++)
+        {
+            unsigned events = rng() % 7 == 0 ? 1 + rng() % 3 : 1;
+            for (unsigned event = 0; event < events; event++)
+            {
+                bool on = detector < Lane::COUNT && rng() % 10 == 0 ? !(state & laneBit(detector)) : (state & laneBit(detector));
+                log += std::to_string(1600000000 + second) + (rng() % 2 ? ".5" : "") + "," +
+                       std::to_string(detector) + "," + (on ? "1" : "0") + "\n";
+                if (detector < Lane::COUNT)
+                {
+                    state = on ? state | laneBit(detector) : state & ~laneBit(detector);
+                }
+            }
+        }
+        expected.push_back(state);
+    }
+
+    Scenario whole;
+    DetectorLogStats wholeStats;
+    std::string error;
+    DetectorLogOptions options = defaultDetectorLogOptions();
+    options.numThreads = 1;
+    options.chunkSize = log.size() * 2;
+    ASSERT_TRUE(import(log, options, whole, wholeStats, error)) << error;
+
+    /// The sensors of every second match the events replayed.
+    ASSERT_FALSE(whole.empty());
+    EXPECT_EQ(whole.front().start, 0);
+    EXPECT_EQ(whole.back().end, 5000);
+    for (std::size_t i = 0; i < whole.size(); i++)
+    {
+        if (i > 0)
+        {
+            EXPECT_EQ(whole[i].start, whole[i - 1].end);
+            EXPECT_NE(whole[i].sensors, whole[i - 1].sensors);
+        }
+        for (Clock::Time t = whole[i].start; t < whole[i].end; t++)
+        {
+            expectSlice({t, t + 1, whole[i].sensors}, t, t + 1, expected[static_cast<std::size_t>(t)]);
+        }
+    }
+
+    /// Small chunks on several threads cut lines everywhere.
+    for (std::size_t chunkSize : {64, 1000, 4099})
+    {
+        options.numThreads = 4;
+        options.chunkSize = chunkSize;
+        Scenario chunked;
+        DetectorLogStats stats;
+        ASSERT_TRUE(import(log, options, chunked, stats, error)) << error;
+
+        ASSERT_EQ(chunked.size(), whole.size()) << "chunks of " << chunkSize;
+        for (std::size_t i = 0; i < whole.size(); i++)
+        {
+            ASSERT_EQ(chunked[i].start, whole[i].start);
+            ASSERT_EQ(chunked[i].end, whole[i].end);
+            ASSERT_EQ(chunked[i].sensors, whole[i].sensors);
+        }
+        EXPECT_EQ(stats.lines, wholeStats.lines);
+        EXPECT_EQ(stats.events, wholeStats.events);
+        EXPECT_EQ(stats.unmapped, wholeStats.unmapped);
+        EXPECT_EQ(stats.changes, wholeStats.changes);
+        EXPECT_EQ(stats.malformed, 0u);
+    }
+}
+
+TEST(DetectorLogTest, ParsesDetectorMaps)
+{
+    std::istringstream good("# loops of the cabinet\n12 = N_W\n3=W_S  # stop bar\n\n");
+    std::vector<Lane> lanes;
+    std::string error;
+    ASSERT_TRUE(parseDetectorMap(good, lanes, error)) << error;
+    ASSERT_EQ(lanes.size(), 13u);
+    EXPECT_EQ(lanes[12], Lane::N_W);
+    EXPECT_EQ(lanes[3], Lane::W_S);
+    EXPECT_EQ(lanes[0], Lane::PLACEHOLDER);
+
+    std::istringstream badLane("4 = N_S\n");
+    EXPECT_FALSE(parseDetectorMap(badLane, lanes, error));
+    EXPECT_EQ(error, "line 1: unknown lane \"N_S\"");
+    EXPECT_EQ(lanes.size(), 13u);
+
+    std::istringstream badId("x = N_N\n");
+    EXPECT_FALSE(parseDetectorMap(badId, lanes, error));
+}
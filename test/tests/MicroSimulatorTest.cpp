@@ -0,0 +1,80 @@
+#include "gtest/gtest.h"
+
+#include "impl/simulator/microSimulator.hpp"
+
+static TrafficSignals allSignals(SignalState state)
+{
+    TrafficSignals signals;
+    signals.fill(state);
+    return signals;
+}
+
+TEST(MicroSimulatorTest, VehiclesQueueAtRed)
+{
+    MicroSimulator simulator(1, 200.0f);
+    simulator.setDemand(0, Lane::N_N, 1800.0f);
+    simulator.setSignals(0, allSignals(SignalState::RED));
+
+    simulator.advance(120);
+
+    EXPECT_EQ(simulator.stats().vehiclesDischarged, 0u);
+    EXPECT_GT(simulator.queueLength(0, Lane::N_N), 5u);
+    EXPECT_EQ(simulator.sensors(0)[Lane::N_N], SensorState::SET);
+    EXPECT_EQ(simulator.sensors(0)[Lane::S_S], SensorState::CLEAR);
+}
+
+TEST(MicroSimulatorTest, QueueDischargesAtGreen)
+{
+    MicroSimulator simulator(1, 200.0f);
+    simulator.setDemand(0, Lane::N_N, 1800.0f);
+    simulator.setSignals(0, allSignals(SignalState::RED));
+    simulator.advance(120);
+
+    std::uint32_t queued = simulator.vehiclesOn(0, Lane::N_N);
+    simulator.setSignals(0, allSignals(SignalState::GREEN));
+    simulator.advance(60);
+
+    /// Saturation flow is roughly one vehicle per two seconds
+    /// once the start-up lost time is over.
+    EXPECT_GT(simulator.stats().vehiclesDischarged, 15u);
+    EXPECT_LT(simulator.stats().vehiclesDischarged, 45u);
+    EXPECT_LT(simulator.vehiclesOn(0, Lane::N_N), queued);
+}
+
+TEST(MicroSimulatorTest, FullDownstreamLaneSpillsBack)
+{
+    MicroSimulator simulator(2, 60.0f);
+    simulator.link(0, Lane::E_E, 1, Lane::E_E);
+    simulator.setDemand(0, Lane::E_E, 1800.0f);
+    simulator.setSignals(0, allSignals(SignalState::GREEN));
+    simulator.setSignals(1, allSignals(SignalState::RED));
+
+    simulator.advance(300);
+
+    const MicroStats &stats = simulator.stats();
+    EXPECT_GT(stats.spillbackSteps, 0u);
+    EXPECT_EQ(stats.vehiclesExited, 0u);
+    EXPECT_EQ(stats.vehiclesDischarged, simulator.vehiclesOn(1, Lane::E_E));
+    EXPECT_EQ(simulator.sensors(0)[Lane::E_E], SensorState::SET);
+}
+
+TEST(MicroSimulatorTest, SameSeedSameResult)
+{
+    MicroSimulator first(4, 150.0f, defaultIdmParameters(), 10, 42);
+    MicroSimulator second(4, 150.0f, defaultIdmParameters(), 10, 42);
+
+    for (IntersectionId i = 0; i < 4; i++)
+    {
+        first.setDemand(i, Lane::W_W, 900.0f);
+        second.setDemand(i, Lane::W_W, 900.0f);
+        first.setSignals(i, allSignals(SignalState::GREEN));
+        second.setSignals(i, allSignals(SignalState::GREEN));
+    }
+
+    first.advance(600);
+    second.advance(600);
+
+    EXPECT_EQ(first.stats().vehiclesSpawned, second.stats().vehiclesSpawned);
+    EXPECT_EQ(first.stats().vehiclesExited, second.stats().vehiclesExited);
+    EXPECT_DOUBLE_EQ(first.stats().delay, second.stats().delay);
+}
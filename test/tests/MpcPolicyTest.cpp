@@ -0,0 +1,142 @@
+#include "gtest/gtest.h"
+
+#include "impl/policy/mpcPolicy.hpp"
+#include "impl/replay/replay.hpp"
+#include "impl/simulator/scenarios.hpp"
+#include "impl/solver/scheduleSolver.hpp"
+
+#include "AllocationHook.hpp"
+
+////////////////////////////////////////////////////////////
+///  @brief Policy that always gives the same answer.
+///
+////////////////////////////////////////////////////////////
+class FixedPolicy : public IDecisionPolicy
+{
+public:
+    explicit FixedPolicy(Decision decision) : decision_(decision) { }
+
+    Decision decide(const ControllerSnapshot&) override
+    {
+        return decision_;
+    }
+
+private:
+    Decision decision_;
+};
+
+TEST(MpcPolicyTest, RestoredControllerContinuesIdentically)
+{
+    Simulator simulator(SCENARIO_4);
+    TrafficLightControllerApp original(simulator.clock(), simulator.sensors(), DEFAULT_MAX_WAIT_TIME, nullptr);
+    original.initApp();
+
+    for (int tick = 0; tick < 317; tick++)
+    {
+        original.run();
+        simulator.update_lane_signals(original.getSignals());
+        simulator.advance(1);
+    }
+
+    TrafficLightControllerApp copy(simulator.clock(), simulator.sensors(), DEFAULT_MAX_WAIT_TIME, nullptr);
+    copy.initApp();
+    copy.restore(original.snapshot());
+
+    while (!simulator.done())
+    {
+        original.run();
+        copy.run();
+        ASSERT_EQ(original.getSignals(), copy.getSignals()) << "at " << simulator.clock().now();
+
+        simulator.update_lane_signals(original.getSignals());
+        simulator.advance(1);
+    }
+}
+
+TEST(MpcPolicyTest, PolicyCannotBreakTimingPlan)
+{
+    ScheduleSolver solver(defaultTimingConfig(), 1);
+    SensorTimeline timeline = sampleScenario(SCENARIO_4, 1);
+
+    FixedPolicy eager(Decision::ADVANCE);
+    PatternSchedule schedule = replayController(SCENARIO_4, 1, defaultTimingConfig(), &eager).schedule;
+    EXPECT_TRUE(solver.isFeasible(schedule, timeline));
+
+    FixedPolicy stubborn(Decision::HOLD);
+    schedule = replayController(SCENARIO_4, 1, defaultTimingConfig(), &stubborn).schedule;
+    EXPECT_TRUE(solver.isFeasible(schedule, timeline));
+}
+
+TEST(MpcPolicyTest, HoldRestsPastMaxUntilACarWaits)
+{
+    /// Only the turning lanes of the first pattern are busy
+    /// until a car arrives on E_E at 200s.
+    const Scenario scenario =
+    {
+        {0,   200, {SensorState::CLEAR, SensorState::SET,   SensorState::CLEAR, SensorState::SET,
+                    SensorState::CLEAR, SensorState::CLEAR, SensorState::CLEAR, SensorState::CLEAR}},
+        {200, 400, {SensorState::CLEAR, SensorState::SET,   SensorState::CLEAR, SensorState::SET,
+                    SensorState::SET,   SensorState::CLEAR, SensorState::CLEAR, SensorState::CLEAR}}
+    };
+    IClock::Time maxActiveTime = defaultTimingConfig().patterns[NorthSouthTurning].maxActiveTime;
+
+    FixedPolicy stubborn(Decision::HOLD);
+    PatternSchedule schedule = replayController(scenario, 1, defaultTimingConfig(), &stubborn).schedule;
+    ASSERT_EQ(schedule.size(), 400u);
+
+    for (std::size_t t = 0; t < 200; t++)
+    {
+        ASSERT_EQ(schedule[t], NorthSouthTurning) << "at " << t << ", max " << maxActiveTime;
+    }
+
+    /// The first tick that sees the car waiting ends it.
+    EXPECT_EQ(schedule[200], NorthSouthTurning);
+    EXPECT_NE(schedule[201], NorthSouthTurning);
+}
+
+TEST(MpcPolicyTest, WaitsLessThanRules)
+{
+    MpcPolicy policy;
+    ReplayResult rules = replayController(SCENARIO_2, 1);
+    ReplayResult mpc = replayController(SCENARIO_2, 1, defaultTimingConfig(), &policy);
+
+    EXPECT_GT(policy.stats().searches, 0u);
+    EXPECT_LT(mpc.metrics.totalWait, rules.metrics.totalWait);
+}
+
+TEST(MpcPolicyTest, FollowsRulesWhenOutOfBudget)
+{
+    MpcConfig config = defaultMpcConfig();
+    config.budget = std::chrono::microseconds(0);
+    MpcPolicy policy(config);
+
+    ReplayResult rules = replayController(SCENARIO_4, 1);
+    ReplayResult mpc = replayController(SCENARIO_4, 1, defaultTimingConfig(), &policy);
+
+    EXPECT_EQ(policy.stats().searches, 0u);
+    EXPECT_GT(policy.stats().overruns, 0u);
+    EXPECT_EQ(mpc.schedule, rules.schedule);
+}
+
+TEST(MpcPolicyTest, DecisionsDoNotAllocate)
+{
+    MpcPolicy policy;
+    Simulator simulator(SCENARIO_4);
+    TrafficLightControllerApp tlcApp(simulator.clock(), simulator.sensors(), DEFAULT_MAX_WAIT_TIME, nullptr);
+    tlcApp.attachPolicy(&policy);
+    tlcApp.initApp();
+
+    std::size_t allocations = 0;
+    while (!simulator.done())
+    {
+        AllocationCounter counter;
+        tlcApp.run();
+        allocations += counter.allocations();
+
+        simulator.update_lane_signals(tlcApp.getSignals());
+        simulator.advance(1);
+    }
+
+    EXPECT_GT(policy.stats().searches, 0u);
+    EXPECT_EQ(allocations, 0u);
+}
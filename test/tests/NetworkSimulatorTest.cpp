@@ -0,0 +1,134 @@
+#include "gtest/gtest.h"
+
+#include "impl/simulator/networkSimulator.hpp"
+
+#include <memory>
+#include <vector>
+
+static constexpr IClock::Time MAX_WAIT_TIME = 60; ///< max wait given to every controller
+
+////////////////////////////////////////////////////////////
+///  @brief A corridor of intersections joined east and west,
+///  with pulsed demand entering at both ends and turning
+///  demand at every intersection.
+///
+////////////////////////////////////////////////////////////
+static std::unique_ptr<NetworkSimulator> makeCorridor(IntersectionId length, unsigned numPartitions)
+{
+    std::vector<NetworkLink> links;
+    for (IntersectionId i = 0; i + 1 < length; i++)
+    {
+        links.push_back({i, Lane::E_E, i + 1, Lane::E_E, 25 + static_cast<Clock::Time>(i % 3) * 5});
+        links.push_back({i + 1, Lane::W_W, i, Lane::W_W, 30});
+        links.push_back({i, Lane::S_E, i + 1, Lane::E_E, 25 + static_cast<Clock::Time>(i % 3) * 5});
+    }
+
+    std::unique_ptr<NetworkSimulator> network(new NetworkSimulator(length, links, numPartitions, 1, MAX_WAIT_TIME));
+    for (IntersectionId i = 0; i < length; i++)
+    {
+        VehicleSensors busy;
+        busy.fill(SensorState::CLEAR);
+        busy[Lane::N_W] = busy[Lane::S_E] = SensorState::SET;
+        busy[Lane::E_E] = i == 0 ? SensorState::SET : SensorState::CLEAR;
+        busy[Lane::W_W] = i + 1 == length ? SensorState::SET : SensorState::CLEAR;
+        VehicleSensors quiet;
+        quiet.fill(SensorState::CLEAR);
+
+        Scenario demand;
+        Clock::Time offset = static_cast<Clock::Time>(i * 11 % 80);
+        for (Clock::Time t = 0; t < 4 * 3600; t += 80)
+        {
+            demand.push_back({t, t + offset, quiet});
+            demand.push_back({t + offset, t + 80, busy});
+        }
+        network->setBoundaryDemand(i, demand);
+    }
+    return network;
+}
+
+TEST(NetworkSimulatorTest, PartitionsDoNotChangeTheResult)
+{
+    const IntersectionId length = 8;
+    std::unique_ptr<NetworkSimulator> serial = makeCorridor(length, 1);
+    serial->run(3600);
+    NetworkStats expected = serial->stats();
+    EXPECT_GT(expected.vehiclesDelivered, 0u);
+    EXPECT_EQ(expected.crossPartitionVehicles, 0u);
+
+    for (unsigned numPartitions : {2u, 4u})
+    {
+        std::unique_ptr<NetworkSimulator> network = makeCorridor(length, numPartitions);
+
+        /// Uneven runs end mid-window, and must still line up.
+        network->run(1000);
+        network->run(2600);
+        NetworkStats stats = network->stats();
+
+        EXPECT_EQ(network->now(), serial->now());
+        EXPECT_EQ(stats.vehiclesDischarged, expected.vehiclesDischarged) << numPartitions << " partitions";
+        EXPECT_EQ(stats.vehiclesDelivered, expected.vehiclesDelivered) << numPartitions << " partitions";
+        EXPECT_EQ(stats.queuedVehicleTime, expected.queuedVehicleTime) << numPartitions << " partitions";
+        EXPECT_GT(stats.crossPartitionVehicles, 0u);
+
+        for (IntersectionId i = 0; i < length; i++)
+        {
+            EXPECT_EQ(network->signals(i), serial->signals(i)) << "intersection " << i;
+            for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+            {
+                EXPECT_EQ(network->queueLength(i, static_cast<Lane>(lane)),
+                          serial->queueLength(i, static_cast<Lane>(lane)));
+            }
+        }
+    }
+}
+
+TEST(NetworkSimulatorTest, ReleasedVehicleArrivesOneTravelTimeLater)
+{
+    const Clock::Time travelTime = 40;
+    std::vector<NetworkLink> links = {{0, Lane::E_E, 1, Lane::W_S, travelTime}};
+
+    VehicleSensors car;
+    car.fill(SensorState::CLEAR);
+    car[Lane::E_E] = SensorState::SET;
+
+    for (unsigned numPartitions : {1u, 2u})
+    {
+        NetworkSimulator network(2, links, numPartitions, 1, MAX_WAIT_TIME);
+        network.setBoundaryDemand(0, {{0, 600, car}});
+        if (numPartitions > 1)
+        {
+            /// The link crosses the boundary, so it sets the window.
+            EXPECT_NE(network.partitionOf(0), network.partitionOf(1));
+            EXPECT_EQ(network.window(), travelTime);
+        }
+
+        /// Find the tick that releases the first vehicle on GREEN.
+        Clock::Time released = -1;
+        while (released < 0 && network.now() < 600)
+        {
+            Clock::Time now = network.now();
+            network.run(1);
+            if (network.stats().vehiclesDischarged > 0)
+            {
+                released = now;
+                EXPECT_EQ(network.signals(0)[Lane::E_E], SignalState::GREEN);
+            }
+        }
+        ASSERT_GE(released, 0);
+
+        /// Nothing arrives downstream until one travel time on.
+        while (network.now() < released + travelTime)
+        {
+            network.run(1);
+            EXPECT_EQ(network.stats().vehiclesDelivered, 0u) << "at " << network.now();
+            EXPECT_EQ(network.queueLength(1, Lane::W_S), 0u);
+        }
+
+        /// It joins the queue on that tick, where the downstream
+        /// controller reads it as a SET sensor.
+        network.run(1);
+        EXPECT_EQ(network.stats().vehiclesDelivered, 1u);
+        EXPECT_EQ(network.queueLength(1, Lane::W_S) +
+                  (network.signals(1)[Lane::W_S] == SignalState::GREEN ? 1u : 0u), 1u);
+    }
+}
@@ -0,0 +1,282 @@
+#include "gtest/gtest.h"
+
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/replay/pipeline.hpp"
+#include "impl/replay/replay.hpp"
+#include "impl/simulator/scenarios.hpp"
+
+#include <random>
+#include <sstream>
+
+static void expectSameReplay(const Scenario &scenario, Clock::Time timeStep)
+{
+    ReplayResult stepped = replayController(scenario, timeStep, defaultTimingConfig(), nullptr, false);
+    ReplayResult skipped = replayController(scenario, timeStep);
+
+    EXPECT_EQ(stepped.fastForwardSteps, 0u);
+    EXPECT_EQ(skipped.schedule, stepped.schedule);
+    EXPECT_EQ(skipped.metrics.duration, stepped.metrics.duration);
+    EXPECT_EQ(skipped.metrics.totalWait, stepped.metrics.totalWait);
+    EXPECT_EQ(skipped.metrics.maxWait, stepped.metrics.maxWait);
+    EXPECT_EQ(skipped.metrics.patternChanges, stepped.metrics.patternChanges);
+}
+
+TEST(ReplayTest, SimulatorReportsSliceEnd)
+{
+    Simulator simulator(SCENARIO_4);
+    EXPECT_EQ(simulator.sliceEnd(), 300);
+
+    simulator.advance(305);
+    EXPECT_EQ(simulator.sliceEnd(), 310);
+    EXPECT_EQ(simulator.sensors()[Lane::N_N], SensorState::CLEAR);
+
+    simulator.advance(400);
+    EXPECT_EQ(simulator.sliceEnd(), 900);
+    EXPECT_EQ(simulator.sensors()[Lane::N_N], SensorState::SET);
+
+    simulator.advance(200);
+    EXPECT_TRUE(simulator.done());
+}
+
+TEST(ReplayTest, FastForwardMatchesSteppedReplay)
+{
+    for (const Scenario *scenario : {&SCENARIO_1, &SCENARIO_2, &SCENARIO_3, &SCENARIO_4})
+    {
+        expectSameReplay(*scenario, 1);
+        expectSameReplay(*scenario, 10);
+    }
+    expectSameReplay(makeDayScenario(7), 1);
+
+    /// Random sensors held for long enough to settle into cycles
+    std::mt19937 rng(11);
+    for (int trial = 0; trial < 20; trial++)
+    {
+        Scenario scenario;
+        for (Clock::Time start = 0; start < 20000;)
+        {
+            Clock::Time end = start + 100 + static_cast<Clock::Time>(rng() % 2000);
+            VehicleSensors sensors;
+            for (SensorState &sensor : sensors)
+            {
+                sensor = rng() % 2 ? SensorState::SET : SensorState::CLEAR;
+            }
+            scenario.push_back({start, end, sensors});
+            start = end;
+        }
+        expectSameReplay(scenario, 1 + static_cast<Clock::Time>(rng() % 7));
+    }
+}
+
+TEST(ReplayTest, FastForwardSkipsSteadyCycles)
+{
+    /// A week of alternating steady traffic: all lanes busy for
+    /// a day, then only the north-south arterial for a day.
+    Scenario week;
+    VehicleSensors busy;
+    VehicleSensors arterial;
+    busy.fill(SensorState::SET);
+    arterial.fill(SensorState::CLEAR);
+    arterial[Lane::N_N] = SensorState::SET;
+    arterial[Lane::S_S] = SensorState::SET;
+
+    for (Clock::Time day = 0; day < 7; day++)
+    {
+        week.push_back({day * 86400, (day + 1) * 86400, day % 2 ? arterial : busy});
+    }
+
+    expectSameReplay(week, 1);
+
+    ReplayResult skipped = replayController(week, 1);
+    EXPECT_EQ(skipped.schedule.size(), 7u * 86400u);
+    EXPECT_GT(skipped.fastForwardSteps, skipped.schedule.size() * 9 / 10);
+}
+
+/// Policy that never ends a pattern
+class HoldPolicy : public IDecisionPolicy
+{
+public:
+    Decision decide(const ControllerSnapshot&) override
+    {
+        return Decision::HOLD;
+    }
+};
+
+TEST(ReplayTest, NoVehicleWaitsPastMaxWaitTime)
+{
+    TimingConfig timing = defaultTimingConfig();
+    timing.enforceMaxWait = true;
+    TimingConfig skipping = timing;
+    skipping.skipUncalled = true;
+
+    std::vector<Scenario> scenarios = {SCENARIO_1, SCENARIO_2, SCENARIO_3, SCENARIO_4,
+                                       makeDayScenario(1), makeDayScenario(2)};
+    std::mt19937 rng(23);
+    for (int trial = 0; trial < 10; trial++)
+    {
+        Scenario scenario;
+        for (Clock::Time start = 0; start < 5000;)
+        {
+            Clock::Time end = start + 1 + static_cast<Clock::Time>(rng() % 200);
+            VehicleSensors sensors;
+            for (SensorState &sensor : sensors)
+            {
+                sensor = rng() % 3 ? SensorState::SET : SensorState::CLEAR;
+            }
+            scenario.push_back({start, end, sensors});
+            start = end;
+        }
+        scenarios.push_back(scenario);
+    }
+
+    /// The rules alone let vehicles wait far longer.
+    EXPECT_GT(replayController(SCENARIO_4, 1).metrics.maxWait, timing.maxWaitTime);
+
+    /// The lead scales with the tick, up to the app's 10s.
+    for (Clock::Time timeStep : {1, 5, 10})
+    {
+        for (std::size_t i = 0; i < scenarios.size(); i++)
+        {
+            ReplayResult stepped = replayController(scenarios[i], timeStep, timing, nullptr, false);
+            ReplayResult skipped = replayController(scenarios[i], timeStep, timing);
+            EXPECT_LE(stepped.metrics.maxWait, timing.maxWaitTime) << "scenario " << i << ", step " << timeStep;
+            EXPECT_EQ(skipped.schedule, stepped.schedule) << "scenario " << i << ", step " << timeStep;
+
+            EXPECT_LE(replayController(scenarios[i], timeStep, skipping).metrics.maxWait, timing.maxWaitTime)
+                << "scenario " << i << ", step " << timeStep;
+        }
+
+        /// A policy cannot hold a vehicle past it either.
+        HoldPolicy hold;
+        EXPECT_LE(replayController(SCENARIO_4, timeStep, timing, &hold).metrics.maxWait, timing.maxWaitTime)
+            << "step " << timeStep;
+    }
+}
+
+TEST(ReplayTest, ParallelReplayMatchesSteppedReplay)
+{
+    TimingConfig skipping = defaultTimingConfig();
+    skipping.skipUncalled = true;
+    skipping.enforceMaxWait = true;
+
+    std::vector<Scenario> scenarios = {SCENARIO_1, SCENARIO_2, SCENARIO_3, SCENARIO_4,
+                                       makeDayScenario(3), makeDayScenario(4), {}};
+    std::mt19937 rng(31);
+    for (int trial = 0; trial < 6; trial++)
+    {
+        Scenario scenario;
+        for (Clock::Time start = 0; start < 20000;)
+        {
+            Clock::Time end = start + 1 + static_cast<Clock::Time>(rng() % 400);
+            VehicleSensors sensors;
+            for (SensorState &sensor : sensors)
+            {
+                sensor = rng() % 4 ? SensorState::CLEAR : SensorState::SET;
+            }
+            scenario.push_back({start, end, sensors});
+            start = end;
+        }
+        scenarios.push_back(scenario);
+    }
+
+    for (unsigned workers : {0u, 3u, 7u})
+    {
+        WorkerPool pool(workers);
+        for (std::size_t i = 0; i < scenarios.size(); i++)
+        {
+            for (const TimingConfig &timing : {defaultTimingConfig(), skipping})
+            {
+                ReplayResult stepped = replayController(scenarios[i], 1, timing, nullptr, false);
+                ParallelReplayStats stats;
+                ReplayResult parallel = replayControllerParallel(scenarios[i], 1, pool, timing, &stats);
+
+                EXPECT_EQ(parallel.schedule, stepped.schedule) << "scenario " << i << ", " << workers << " workers";
+                EXPECT_EQ(parallel.metrics.totalWait, stepped.metrics.totalWait);
+                EXPECT_EQ(parallel.metrics.maxWait, stepped.metrics.maxWait);
+                EXPECT_EQ(parallel.metrics.patternChanges, stepped.metrics.patternChanges);
+                EXPECT_EQ(stats.steps, stepped.schedule.size());
+                EXPECT_LE(stats.segments, pool.size());
+                EXPECT_LE(stats.fixupSteps, stats.steps);
+            }
+        }
+    }
+
+    /// Coarser steps, and a gap in the scenario that the
+    /// Simulator stops at only if a step lands in it.
+    Scenario gapped = SCENARIO_4;
+    VehicleSensors clear;
+    clear.fill(SensorState::CLEAR);
+    gapped.push_back({900, 1005, SCENARIO_2.back().sensors});
+    gapped.push_back({1008, 1500, clear});
+    gapped.push_back({1500, 3000, SCENARIO_1.front().sensors});
+    WorkerPool three(2);
+    for (Clock::Time timeStep : {3, 4, 7})
+    {
+        ReplayResult stepped = replayController(gapped, timeStep, defaultTimingConfig(), nullptr, false);
+        EXPECT_EQ(replayControllerParallel(gapped, timeStep, three).schedule, stepped.schedule);
+        EXPECT_EQ(stepped.schedule.size() > 1005u / timeStep, timeStep != 3);
+    }
+
+    /// A day cut in four is mostly predicted right.
+    WorkerPool pool(3);
+    ParallelReplayStats stats;
+    replayControllerParallel(makeDayScenario(1), 1, pool, defaultTimingConfig(), &stats);
+    EXPECT_EQ(stats.segments, 4u);
+    EXPECT_GE(stats.converged, 3u);
+    EXPECT_LT(stats.fixupSteps, stats.steps / 20);
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Replay a scenario in one loop, printing as the
+///  app does.
+///
+////////////////////////////////////////////////////////////
+static std::string runSerialLoop(const Scenario &scenario, Clock::Time timeStep)
+{
+    std::ostringstream out;
+    ConfigManager config;
+    ConfigManager::ReaderId reader = config.registerReader();
+
+    Simulator simulator(scenario);
+    TrafficLightControllerApp tlcApp(simulator.clock(), simulator.sensors(), config.read().maxWaitTime, &out);
+    tlcApp.attachConfig(config, reader);
+    tlcApp.initApp();
+
+    out << simulator.BANNER << std::endl;
+    while (!simulator.done())
+    {
+        tlcApp.run();
+        simulator.update_lane_signals(tlcApp.getSignals());
+        out << simulator << std::endl;
+        simulator.advance(timeStep);
+    }
+
+    config.unregisterReader(reader);
+    return out.str();
+}
+
+TEST(ReplayTest, PipelinedReplayMatchesSerialLoop)
+{
+    std::vector<std::pair<Scenario, Clock::Time>> runs = {{SCENARIO_1, 10}, {SCENARIO_2, 10}, {SCENARIO_3, 1},
+                                                          {SCENARIO_4, 10}, {makeDayScenario(5), 10}, {{}, 1}};
+    for (const std::pair<Scenario, Clock::Time> &run : runs)
+    {
+        ConfigManager config;
+        ConfigManager::ReaderId reader = config.registerReader();
+        std::ostringstream out;
+        PipelineStats stats;
+        ReplayResult printed = replayPipelined(run.first, run.second, config, reader, &out, &stats);
+        ReplayResult silent = replayPipelined(run.first, run.second, config, reader);
+        config.unregisterReader(reader);
+
+        EXPECT_EQ(out.str(), runSerialLoop(run.first, run.second));
+
+        ReplayResult stepped = replayController(run.first, run.second, defaultTimingConfig(), nullptr, false);
+        EXPECT_EQ(printed.schedule, stepped.schedule);
+        EXPECT_EQ(silent.schedule, stepped.schedule);
+        EXPECT_EQ(printed.metrics.totalWait, stepped.metrics.totalWait);
+        EXPECT_EQ(printed.metrics.maxWait, stepped.metrics.maxWait);
+        EXPECT_EQ(printed.metrics.patternChanges, stepped.metrics.patternChanges);
+        EXPECT_EQ(printed.metrics.duration, stepped.metrics.duration);
+        EXPECT_EQ(stats.ticks, stepped.schedule.size());
+    }
+}
@@ -0,0 +1,91 @@
+#include "gtest/gtest.h"
+
+#include "impl/replay/replay.hpp"
+#include "impl/simulator/scenarios.hpp"
+#include "impl/solver/scheduleSolver.hpp"
+
+#include <random>
+
+static TimingConfig shortTiming()
+{
+    TimingConfig timing = defaultTimingConfig();
+    for (PatternTiming &pattern : timing.patterns)
+    {
+        pattern.minActiveTime = 1;
+        pattern.maxActiveTime = 3;
+    }
+    return timing;
+}
+
+TEST(ScheduleSolverTest, EmptyIntersectionHasNoWait)
+{
+    SensorTimeline timeline(50);
+    for (VehicleSensors &sensors : timeline)
+    {
+        sensors.fill(SensorState::CLEAR);
+    }
+
+    ScheduleSolver solver(defaultTimingConfig(), 1);
+    PatternSchedule schedule = solver.solve(timeline);
+
+    ASSERT_EQ(schedule.size(), timeline.size());
+    EXPECT_TRUE(solver.isFeasible(schedule, timeline));
+    EXPECT_EQ(scoreSchedule(timeline, schedule, 1).totalWait, 0);
+}
+
+TEST(ScheduleSolverTest, MatchesExhaustiveSearch)
+{
+    /// Every schedule of a short random timeline is checked;
+    /// the solver must find one with the least wait.
+    const std::size_t steps = 9;
+    ScheduleSolver solver(shortTiming(), 1);
+    std::mt19937 rng(3);
+
+    for (int trial = 0; trial < 5; trial++)
+    {
+        SensorTimeline timeline(steps);
+        for (VehicleSensors &sensors : timeline)
+        {
+            for (SensorState &sensor : sensors)
+            {
+                sensor = rng() % 3 == 0 ? SensorState::SET : SensorState::CLEAR;
+            }
+        }
+
+        std::int64_t best = -1;
+        PatternSchedule candidate(steps);
+        for (std::uint32_t code = 0; code < (1u << (2 * steps)); code++)
+        {
+            for (std::size_t step = 0; step < steps; step++)
+            {
+                candidate[step] = static_cast<TrafficLightPattern>((code >> (2 * step)) & 3);
+            }
+            if (solver.isFeasible(candidate, timeline))
+            {
+                std::int64_t wait = scoreSchedule(timeline, candidate, 1).totalWait;
+                best = best < 0 ? wait : std::min(best, wait);
+            }
+        }
+
+        PatternSchedule schedule = solver.solve(timeline);
+        ASSERT_TRUE(solver.isFeasible(schedule, timeline));
+        EXPECT_EQ(scoreSchedule(timeline, schedule, 1).totalWait, best) << "trial " << trial;
+    }
+}
+
+TEST(ScheduleSolverTest, OracleNeverWaitsLongerThanController)
+{
+    const Scenario *scenarios[] = {&SCENARIO_1, &SCENARIO_2, &SCENARIO_3, &SCENARIO_4};
+    ScheduleSolver solver(defaultTimingConfig(), 1);
+
+    for (const Scenario *scenario : scenarios)
+    {
+        SensorTimeline timeline = sampleScenario(*scenario, 1);
+        ReplayResult controller = replayController(*scenario, 1);
+        PatternSchedule oracle = solver.solve(timeline);
+
+        EXPECT_TRUE(solver.isFeasible(controller.schedule, timeline));
+        EXPECT_TRUE(solver.isFeasible(oracle, timeline));
+        EXPECT_LE(scoreSchedule(timeline, oracle, 1).totalWait, controller.metrics.totalWait);
+    }
+}
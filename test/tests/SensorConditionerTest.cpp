@@ -0,0 +1,156 @@
+#include "gtest/gtest.h"
+
+#include "impl/sensor/sensorConditioner.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief One detector filtered the obvious way, to check
+///  the bit-sliced filters against.
+///
+////////////////////////////////////////////////////////////
+struct ReferenceDetector
+{
+    DetectorTiming timing;
+    bool call = false;
+    unsigned run = 0;
+    unsigned held = 0;
+
+    bool update(bool raw)
+    {
+        unsigned onDelay = std::min<unsigned>(timing.onDelay, SensorConditioner::MAX_TICKS);
+        unsigned minPresence = std::min<unsigned>(timing.minPresence, SensorConditioner::MAX_TICKS);
+        unsigned gapOut = std::min<unsigned>(timing.gapOut, SensorConditioner::MAX_TICKS);
+
+        run = raw != call ? std::min(run + 1, SensorConditioner::MAX_TICKS) : 0;
+        held = call ? std::min(held + 1, SensorConditioner::MAX_TICKS) : 0;
+
+        bool flip = raw != call && (call ? run >= gapOut && held >= minPresence : run >= onDelay);
+        if (flip)
+        {
+            call = !call;
+            run = 0;
+            held = 0;
+        }
+        return call;
+    }
+};
+
+TEST(SensorConditionerTest, MatchesReferenceFilters)
+{
+    const IntersectionId numIntersections = 21;
+    SensorConditioner conditioner(numIntersections);
+    std::vector<ReferenceDetector> reference(numIntersections * Lane::COUNT);
+    std::mt19937 rng(5);
+
+    for (IntersectionId i = 0; i < numIntersections; i++)
+    {
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            DetectorTiming timing;
+            timing.onDelay = static_cast<std::uint8_t>(rng() % 6);
+            timing.minPresence = static_cast<std::uint8_t>(rng() % 8);
+            timing.gapOut = static_cast<std::uint8_t>(rng() % 6);
+            if (i == 0 && lane == 0)
+            {
+                timing.minPresence = 200;
+            }
+            conditioner.setTiming(i, static_cast<Lane>(lane), timing);
+            reference[i * Lane::COUNT + lane].timing = timing;
+        }
+    }
+
+    for (int tick = 0; tick < 3000; tick++)
+    {
+        /// Long presences broken up by chatter.
+        for (IntersectionId i = 0; i < numIntersections; i++)
+        {
+            LaneMask raw = 0;
+            for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+            {
+                bool present = ((tick / (7 + i + lane)) % 2) != 0;
+                raw |= (present != (rng() % 5 == 0)) ? laneBit(lane) : 0;
+            }
+            conditioner.setRaw(i, raw);
+
+            for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+            {
+                reference[i * Lane::COUNT + lane].update((raw & laneBit(lane)) != 0);
+            }
+        }
+        conditioner.update();
+
+        for (IntersectionId i = 0; i < numIntersections; i++)
+        {
+            LaneMask expected = 0;
+            for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+            {
+                expected |= reference[i * Lane::COUNT + lane].call ? laneBit(lane) : 0;
+            }
+            ASSERT_EQ(conditioner.conditioned(i), expected) << "intersection " << i << " tick " << tick;
+        }
+    }
+
+    EXPECT_LT(conditioner.conditionedEdges(), conditioner.rawEdges());
+}
+
+TEST(SensorConditionerTest, PassThroughTimingIsIdentity)
+{
+    DetectorTiming passThrough = {1, 0, 1};
+    SensorConditioner conditioner(3);
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        conditioner.setLaneTiming(static_cast<Lane>(lane), passThrough);
+    }
+
+    std::mt19937 rng(9);
+    for (int tick = 0; tick < 500; tick++)
+    {
+        LaneMask raw = static_cast<LaneMask>(rng());
+        conditioner.setRaw(2, raw);
+        conditioner.update();
+        ASSERT_EQ(conditioner.conditioned(2), raw);
+    }
+}
+
+TEST(SensorConditionerTest, DefaultsFilterChatter)
+{
+    SensorConditioner conditioner(1);
+    VehicleSensors sensors;
+
+    /// A one-tick blip never places a call.
+    conditioner.setRaw(0, laneBit(Lane::E_E));
+    conditioner.update();
+    conditioner.setRaw(0, 0);
+    conditioner.update();
+    conditioner.conditioned(0, sensors);
+    EXPECT_EQ(sensors[Lane::E_E], SensorState::CLEAR);
+
+    /// A steady vehicle does, and a one-tick dropout does not
+    /// drop it.
+    conditioner.setRaw(0, laneBit(Lane::E_E));
+    conditioner.update();
+    conditioner.update();
+    EXPECT_EQ(conditioner.conditioned(0), laneBit(Lane::E_E));
+
+    conditioner.setRaw(0, 0);
+    conditioner.update();
+    conditioner.setRaw(0, laneBit(Lane::E_E));
+    conditioner.update();
+    EXPECT_EQ(conditioner.conditioned(0), laneBit(Lane::E_E));
+
+    /// Once the vehicle leaves, the call ends after the gap.
+    conditioner.setRaw(0, 0);
+    conditioner.update();
+    EXPECT_EQ(conditioner.conditioned(0), laneBit(Lane::E_E));
+    conditioner.update();
+    EXPECT_EQ(conditioner.conditioned(0), 0);
+
+    conditioner.setRaw(0, laneBit(Lane::N_N));
+    conditioner.update();
+    conditioner.update();
+    conditioner.reset(0);
+    EXPECT_EQ(conditioner.conditioned(0), 0);
+}
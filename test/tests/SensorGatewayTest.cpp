@@ -0,0 +1,193 @@
+#include "gtest/gtest.h"
+
+#include "impl/gateway/sensorGateway.hpp"
+
+#if defined(__linux__)
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief A host with a few idle controllers and a gateway
+///  bound to a socket of its own, routing field id i to
+///  controller i.
+///
+////////////////////////////////////////////////////////////
+class SensorGatewayTest : public ::testing::Test
+{
+protected:
+    static constexpr std::uint32_t NUM_INTERSECTIONS = 8;
+
+    SensorGatewayTest()
+        : host_(hostConfig()),
+          path_("/tmp/tlc-gateway-test-" + std::to_string(getpid()) + ".sock"),
+          gateway_(host_, gatewayConfig(path_)),
+          client_(socket(AF_UNIX, SOCK_DGRAM, 0))
+    {
+        std::string error;
+        EXPECT_TRUE(gateway_.open(error)) << error;
+        for (std::uint32_t i = 0; i < NUM_INTERSECTIONS; i++)
+        {
+            ids_.push_back(host_.addController());
+            gateway_.route(i, ids_.back());
+        }
+    }
+
+    ~SensorGatewayTest()
+    {
+        close(client_);
+    }
+
+    static HostConfig hostConfig()
+    {
+        HostConfig config = defaultHostConfig();
+        config.numShards = 1;
+        config.shardCapacity = NUM_INTERSECTIONS;
+        return config;
+    }
+
+    static GatewayConfig gatewayConfig(const std::string &path)
+    {
+        GatewayConfig config = defaultGatewayConfig();
+        config.socketPaths = {path};
+        config.maxIntersections = 2 * NUM_INTERSECTIONS;
+        config.batch = 4;
+        config.drainLimit = 2;
+        return config;
+    }
+
+    /// Send one datagram of raw bytes to the gateway.
+    void sendBytes(const std::vector<std::uint8_t> &bytes)
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path_.c_str(), path_.size());
+        ASSERT_EQ(sendto(client_, bytes.data(), bytes.size(), 0, reinterpret_cast<sockaddr*>(&address), sizeof(address)),
+                  static_cast<ssize_t>(bytes.size()));
+    }
+
+    /// Send one datagram of frames to the gateway.
+    void sendFrames(const std::vector<SensorFrame> &frames)
+    {
+        std::vector<std::uint8_t> bytes(frames.size() * SENSOR_FRAME_SIZE);
+        for (std::size_t i = 0; i < frames.size(); i++)
+        {
+            encodeSensorFrame(frames[i], bytes.data() + i * SENSOR_FRAME_SIZE);
+        }
+        sendBytes(bytes);
+    }
+
+    ControllerHost host_;
+    std::string path_;
+    SensorGateway gateway_;
+    int client_;
+    std::vector<ControllerId> ids_;
+};
+
+constexpr std::uint32_t SensorGatewayTest::NUM_INTERSECTIONS;
+
+TEST_F(SensorGatewayTest, FramesReachTheirControllers)
+{
+    std::uint64_t sent = monotonicNanos();
+    sendFrames({{0x81, 1, 0, sent}, {0x42, 1, 3, sent}});
+    sendFrames({{0x0F, 1, 7, 0}});
+
+    EXPECT_EQ(gateway_.poll(1000), 3u);
+    EXPECT_EQ(host_.sensorMask(ids_[0]), 0x81);
+    EXPECT_EQ(host_.sensorMask(ids_[3]), 0x42);
+    EXPECT_EQ(host_.sensorMask(ids_[7]), 0x0F);
+    EXPECT_EQ(host_.sensorMask(ids_[1]), 0x00);
+
+    EXPECT_EQ(gateway_.stats().datagrams, 2u);
+    EXPECT_EQ(gateway_.stats().frames, 3u);
+    EXPECT_EQ(gateway_.latency().count(), 2u) << "unstamped frames are not timed";
+}
+
+TEST_F(SensorGatewayTest, DropsMalformedAndUnroutedFrames)
+{
+    /// A datagram that is not whole frames is dropped entirely.
+    std::vector<std::uint8_t> partial(SENSOR_FRAME_SIZE + 3, 0);
+    sendBytes(partial);
+
+    /// A frame of another version is dropped; its neighbour is not.
+    std::vector<std::uint8_t> mixed(2 * SENSOR_FRAME_SIZE);
+    encodeSensorFrame({0x01, 1, 2, 0}, mixed.data());
+    encodeSensorFrame({0x02, 1, 4, 0}, mixed.data() + SENSOR_FRAME_SIZE);
+    mixed[0] = SENSOR_FRAME_VERSION + 1;
+    sendBytes(mixed);
+
+    /// Routed nowhere, and beyond every route.
+    gateway_.route(5, INVALID_CONTROLLER);
+    sendFrames({{0x01, 1, 5, 0}, {0x01, 1, 2 * NUM_INTERSECTIONS, 0}});
+
+    EXPECT_EQ(gateway_.poll(1000), 1u);
+    EXPECT_EQ(host_.sensorMask(ids_[2]), 0x00);
+    EXPECT_EQ(host_.sensorMask(ids_[4]), 0x02);
+    EXPECT_EQ(host_.sensorMask(ids_[5]), 0x00);
+    EXPECT_EQ(gateway_.stats().malformed, 2u);
+    EXPECT_EQ(gateway_.stats().unrouted, 2u);
+}
+
+TEST_F(SensorGatewayTest, DropsStaleFramesButFollowsARestart)
+{
+    sendFrames({{0x01, 1000, 0, 0}});
+    sendFrames({{0x02, 1000, 0, 0}, {0x03, 999, 0, 0}});
+    sendFrames({{0x04, 1001, 0, 0}});
+    EXPECT_EQ(gateway_.poll(1000), 2u);
+    EXPECT_EQ(host_.sensorMask(ids_[0]), 0x04);
+    EXPECT_EQ(gateway_.stats().stale, 2u);
+
+    /// Further back than the window: the cabinet restarted.
+    sendFrames({{0x05, 0, 0, 0}, {0x06, 1, 0, 0}});
+    EXPECT_EQ(gateway_.poll(1000), 2u);
+    EXPECT_EQ(host_.sensorMask(ids_[0]), 0x06);
+
+    /// And across the 16-bit wrap.
+    sendFrames({{0x07, 0xFFFF, 1, 0}, {0x08, 0, 1, 0}, {0x09, 0xFFFF, 1, 0}});
+    EXPECT_EQ(gateway_.poll(1000), 2u);
+    EXPECT_EQ(host_.sensorMask(ids_[1]), 0x08);
+}
+
+TEST_F(SensorGatewayTest, DrainsABurstLargerThanTheSocketQueue)
+{
+    /// Far more datagrams than the socket holds; the sender
+    /// blocks until the gateway makes room.
+    static constexpr std::uint16_t NUM_DATAGRAMS = 2000;
+    std::thread sender([this]()
+    {
+        for (std::uint16_t sequence = 1; sequence <= NUM_DATAGRAMS; sequence++)
+        {
+            std::vector<SensorFrame> frames;
+            for (std::uint32_t i = 0; i < NUM_INTERSECTIONS; i++)
+            {
+                frames.push_back({static_cast<SensorMask>(sequence + i), sequence, i, monotonicNanos()});
+            }
+            sendFrames(frames);
+        }
+    });
+
+    std::uint64_t expected = static_cast<std::uint64_t>(NUM_DATAGRAMS) * NUM_INTERSECTIONS;
+    for (int idle = 0; gateway_.stats().frames < expected && idle < 100; )
+    {
+        idle = gateway_.poll(100) ? 0 : idle + 1;
+    }
+    sender.join();
+
+    EXPECT_EQ(gateway_.stats().frames, expected);
+    EXPECT_EQ(gateway_.stats().stale, 0u);
+    EXPECT_GT(gateway_.stats().calls, 0u);
+    EXPECT_LE(gateway_.stats().calls, gateway_.stats().datagrams);
+    for (std::uint32_t i = 0; i < NUM_INTERSECTIONS; i++)
+    {
+        EXPECT_EQ(host_.sensorMask(ids_[i]), static_cast<SensorMask>(NUM_DATAGRAMS + i));
+    }
+}
+
+#endif
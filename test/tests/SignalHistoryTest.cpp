@@ -0,0 +1,147 @@
+#include "gtest/gtest.h"
+
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/history/signalHistory.hpp"
+#include "impl/simulator/workload.hpp"
+
+#include <random>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Signals with one lane GREEN and the rest RED
+///
+////////////////////////////////////////////////////////////
+static TrafficSignals greenOn(unsigned lane)
+{
+    TrafficSignals signals;
+    signals.fill(SignalState::RED);
+    signals[lane % Lane::COUNT] = SignalState::GREEN;
+    return signals;
+}
+
+TEST(SignalHistoryTest, AnswersEverySecondOfAControllerRun)
+{
+    /// Long enough to span many blocks.
+    Workload workload(defaultWorkloadConfig(2));
+    SignalHistory history(2);
+    std::vector<std::vector<TrafficSignals>> shown(2);
+
+    for (std::uint32_t i = 0; i < 2; i++)
+    {
+        Clock clock;
+        clock.set(7 * 3600);
+        VehicleSensors sensors;
+        TrafficLightControllerApp app(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+        app.initApp();
+        for (Clock::Time t = 0; t < 20000; t++)
+        {
+            workload.sensors(i, clock.now(), sensors);
+            app.run();
+            ASSERT_TRUE(history.record(i, t, app.getSignals()));
+            shown[i].push_back(app.getSignals());
+            clock.advance(1);
+        }
+    }
+
+    EXPECT_GT(history.stats().blocks, 2u * 4);
+    for (std::uint32_t i = 0; i < 2; i++)
+    {
+        for (Clock::Time t = 0; t < 20000; t++)
+        {
+            TrafficSignals signals;
+            ASSERT_TRUE(history.at(i, t, signals));
+            ASSERT_EQ(signals, shown[i][t]) << "intersection " << i << " at " << t;
+        }
+        TrafficSignals signals;
+        ASSERT_TRUE(history.at(i, 1000000, signals));
+        EXPECT_EQ(signals, shown[i].back());
+    }
+
+    /// A span rebuilds the same seconds from its changes.
+    std::vector<SignalChange> changes;
+    ASSERT_GT(history.range(1, 5000, 9000, changes), 1u);
+    EXPECT_EQ(changes.front().time, 5000);
+    for (std::size_t c = 0; c < changes.size(); c++)
+    {
+        Clock::Time end = c + 1 < changes.size() ? changes[c + 1].time : 9000;
+        ASSERT_LT(changes[c].time, end);
+        for (Clock::Time t = changes[c].time; t < end; t++)
+        {
+            ASSERT_EQ(changes[c].signals, shown[1][t]);
+        }
+    }
+}
+
+TEST(SignalHistoryTest, DecodesIrregularStates)
+{
+    /// States in no repeating order, many of them, and gaps
+    /// of all sizes, so every code path is taken.
+    SignalHistory history(1);
+    std::mt19937 rng(3);
+    std::vector<std::pair<Clock::Time, TrafficSignals>> recorded;
+    Clock::Time t = -500;
+    for (int change = 0; change < 2000; change++)
+    {
+        TrafficSignals signals;
+        for (SignalState &signal : signals)
+        {
+            signal = static_cast<SignalState>(rng() % 3);
+        }
+        if (!recorded.empty() && signals == recorded.back().second)
+        {
+            continue;
+        }
+        ASSERT_TRUE(history.record(0, t, signals));
+        recorded.push_back({t, signals});
+        t += 1 + static_cast<Clock::Time>(rng() % (change % 7 == 0 ? 100000 : 30));
+    }
+
+    TrafficSignals signals;
+    EXPECT_FALSE(history.at(0, -501, signals));
+    for (std::size_t c = 0; c < recorded.size(); c++)
+    {
+        ASSERT_TRUE(history.at(0, recorded[c].first, signals));
+        ASSERT_EQ(signals, recorded[c].second);
+        if (c + 1 < recorded.size())
+        {
+            ASSERT_TRUE(history.at(0, recorded[c + 1].first - 1, signals));
+            ASSERT_EQ(signals, recorded[c].second);
+        }
+    }
+    EXPECT_GT(history.stats().states, 100u);
+}
+
+TEST(SignalHistoryTest, KeepsOnlyChangesInTimeOrder)
+{
+    SignalHistory history(3);
+    EXPECT_TRUE(history.record(1, 10, greenOn(0)));
+    EXPECT_TRUE(history.record(1, 11, greenOn(0)));
+    EXPECT_TRUE(history.record(1, 20, greenOn(2)));
+    EXPECT_FALSE(history.record(1, 20, greenOn(4)));
+    EXPECT_FALSE(history.record(1, 15, greenOn(4)));
+    EXPECT_TRUE(history.record(1, 30, greenOn(0)));
+
+    SignalHistoryStats stats = history.stats();
+    EXPECT_EQ(stats.changes, 3u);
+    EXPECT_EQ(stats.states, 2u);
+
+    TrafficSignals signals;
+    EXPECT_FALSE(history.at(0, 20, signals));
+    EXPECT_FALSE(history.at(1, 9, signals));
+    ASSERT_TRUE(history.at(1, 19, signals));
+    EXPECT_EQ(signals, greenOn(0));
+    ASSERT_TRUE(history.at(1, 25, signals));
+    EXPECT_EQ(signals, greenOn(2));
+
+    /// A span from before the first change starts at it.
+    std::vector<SignalChange> changes;
+    ASSERT_EQ(history.range(1, 0, 30, changes), 2u);
+    EXPECT_EQ(changes[0].time, 10);
+    EXPECT_EQ(changes[1].time, 20);
+
+    changes.clear();
+    ASSERT_EQ(history.range(1, 40, 50, changes), 1u);
+    EXPECT_EQ(changes[0].time, 40);
+    EXPECT_EQ(changes[0].signals, greenOn(0));
+    EXPECT_EQ(history.range(2, 0, 50, changes), 0u);
+}
@@ -0,0 +1,38 @@
+#include "gtest/gtest.h"
+
+#include "impl/util/spscQueue.hpp"
+
+#include <cstdint>
+#include <thread>
+
+TEST(SpscQueueTest, KeepsOrderAcrossThreads)
+{
+    SpscQueue<std::uint32_t, 8> queue;
+    const std::uint32_t count = 100000;
+    std::thread producer([&]()
+    {
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            queue.push(i);
+        }
+    });
+
+    std::uint32_t item = 0;
+    std::uint32_t outOfOrder = 0;
+    for (std::uint32_t i = 0; i < count; i++)
+    {
+        queue.pop(item);
+        outOfOrder += item != i;
+    }
+    producer.join();
+    EXPECT_EQ(outOfOrder, 0u);
+
+    EXPECT_FALSE(queue.tryPop(item));
+    for (std::uint32_t i = 0; i < 8; i++)
+    {
+        EXPECT_TRUE(queue.tryPush(i));
+    }
+    EXPECT_FALSE(queue.tryPush(8));
+    EXPECT_TRUE(queue.tryPop(item));
+    EXPECT_EQ(item, 0u);
+}
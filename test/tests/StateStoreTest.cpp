@@ -0,0 +1,243 @@
+#include "gtest/gtest.h"
+
+#include "impl/host/controllerHost.hpp"
+#include "impl/host/stateStore.hpp"
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief A state file of its own, removed afterwards.
+///
+////////////////////////////////////////////////////////////
+class StateStoreTest : public ::testing::Test
+{
+protected:
+    StateStoreTest()
+        : path_("/tmp/tlc-state-test-" + std::to_string(getpid()) + ".bin")
+    {
+        unlink(path_.c_str());
+    }
+
+    ~StateStoreTest() override
+    {
+        unlink(path_.c_str());
+    }
+
+    ////////////////////////////////////////////////////////////
+    ///  @brief Snapshot a controller after some ticks with
+    ///  cars waiting.
+    ///
+    ////////////////////////////////////////////////////////////
+    static ControllerSnapshot snapshotAfter(IClock::Time seconds)
+    {
+        Clock clock;
+        VehicleSensors sensors;
+        sensors.fill(SensorState::SET);
+        TrafficLightControllerApp app(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+        app.initApp();
+        for (IClock::Time t = 0; t < seconds; t++)
+        {
+            app.run();
+            clock.advance(1);
+        }
+        return app.snapshot();
+    }
+
+    std::string path_;
+};
+
+static bool sameBytes(const ControllerSnapshot &a, const ControllerSnapshot &b)
+{
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+TEST_F(StateStoreTest, LoadsTheNewestCommittedSnapshot)
+{
+    StateStore store;
+    std::string error;
+    ASSERT_TRUE(store.open(path_, 2, 4, error)) << error;
+    EXPECT_TRUE(store.wasReset());
+
+    ControllerSnapshot loaded;
+    EXPECT_FALSE(store.load(1, loaded));
+
+    ControllerSnapshot first = snapshotAfter(25);
+    ControllerSnapshot second = snapshotAfter(70);
+    store.save(1, first);
+    store.save(1, second);
+    store.saveClock(1, 70);
+    ASSERT_TRUE(store.load(1, loaded));
+    EXPECT_TRUE(sameBytes(loaded, second));
+    store.close();
+
+    /// Tear the second save, as a crash while writing it
+    /// would: the slot falls back to the first.
+    std::size_t copySize = (16 + sizeof(ControllerSnapshot) + 63) / 64 * 64;
+    off_t secondCopy = static_cast<off_t>(128 + 2 * copySize + copySize + 16 + 40);
+    int fd = ::open(path_.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    unsigned char byte = 0;
+    ASSERT_EQ(pread(fd, &byte, 1, secondCopy), 1);
+    byte ^= 0x5a;
+    ASSERT_EQ(pwrite(fd, &byte, 1, secondCopy), 1);
+    ::close(fd);
+
+    ASSERT_TRUE(store.open(path_, 2, 4, error)) << error;
+    EXPECT_FALSE(store.wasReset());
+    EXPECT_EQ(store.clock(1), 70);
+    ASSERT_TRUE(store.load(1, loaded));
+    EXPECT_TRUE(sameBytes(loaded, first));
+
+    store.erase(1);
+    EXPECT_FALSE(store.load(1, loaded));
+}
+
+TEST_F(StateStoreTest, ResetsAFileOfAnotherLayout)
+{
+    StateStore store;
+    std::string error;
+    ASSERT_TRUE(store.open(path_, 1, 4, error)) << error;
+    store.save(0, snapshotAfter(5));
+    store.saveClock(0, 5);
+    store.close();
+
+    ASSERT_TRUE(store.open(path_, 1, 8, error)) << error;
+    EXPECT_TRUE(store.wasReset());
+    ControllerSnapshot loaded;
+    EXPECT_FALSE(store.load(0, loaded));
+    EXPECT_EQ(store.clock(0), 0);
+    store.close();
+
+    ASSERT_TRUE(store.open(path_, 1, 8, error)) << error;
+    EXPECT_FALSE(store.wasReset());
+
+    EXPECT_FALSE(store.open("/nonexistent/state.bin", 1, 8, error));
+    EXPECT_FALSE(store.isOpen());
+}
+
+TEST_F(StateStoreTest, RestoredMidClearanceGreensThePreemptingPattern)
+{
+    StateStore store;
+    std::string error;
+    ASSERT_TRUE(store.open(path_, 1, 1, error)) << error;
+
+    /// Save a controller one tick into its preemption
+    /// clearance, as the host does every tick.
+    Clock clock;
+    VehicleSensors sensors;
+    sensors.fill(SensorState::SET);
+    {
+        TrafficLightControllerApp app(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+        app.initApp();
+        for (int tick = 0; tick < 15; tick++)
+        {
+            app.run();
+            clock.advance(1);
+        }
+        app.preempt(EastWestThrough);
+        app.run();
+        ASSERT_TRUE(app.isClearingForPreemption());
+        store.save(0, app.snapshot());
+    }
+
+    /// A fresh controller restored from the file finishes the
+    /// clearance and greens the preempting pattern in time.
+    ControllerSnapshot saved;
+    ASSERT_TRUE(store.load(0, saved));
+    TrafficLightControllerApp restored(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+    restored.initApp();
+    restored.restore(saved);
+    EXPECT_TRUE(restored.isPreempted());
+
+    IClock::Time clearance = TrafficLightControllerApp::PREEMPTION_YELLOW_TIME +
+                             TrafficLightControllerApp::PREEMPTION_RED_TIME;
+    IClock::Time deadline = clock.now() + clearance;
+    while (restored.isClearingForPreemption() && clock.now() <= deadline)
+    {
+        clock.advance(1);
+        restored.run();
+        for (SignalState signal : restored.getSignals())
+        {
+            EXPECT_TRUE(signal != SignalState::GREEN || !restored.isClearingForPreemption());
+        }
+    }
+
+    EXPECT_FALSE(restored.isClearingForPreemption());
+    EXPECT_EQ(restored.getActivePattern(), EastWestThrough);
+    EXPECT_EQ(restored.getSignals()[Lane::E_E], SignalState::GREEN);
+    EXPECT_EQ(restored.getSignals()[Lane::W_W], SignalState::GREEN);
+
+    /// Released, it goes back to its cycle.
+    restored.releasePreemption();
+    EXPECT_FALSE(restored.isPreempted());
+}
+
+TEST_F(StateStoreTest, RestartedHostContinuesTheCycle)
+{
+    HostConfig config = defaultHostConfig();
+    config.numShards = 2;
+    config.shardCapacity = 4;
+    config.timeStep = 7;
+    config.tickPeriod = std::chrono::microseconds(0);
+    config.pinThreads = false;
+
+    /// One host runs straight through as the reference.
+    std::vector<TrafficSignals> expected;
+    {
+        config.tickLimit = 57;
+        ControllerHost host(config);
+        for (int i = 0; i < 6; i++)
+        {
+            host.addController();
+        }
+        host.start();
+        host.wait();
+        for (ControllerId id : {0u, 1u, 2u, 4u, 5u, 6u})
+        {
+            expected.push_back(host.signals(id));
+        }
+    }
+
+    /// The other stops after 29 ticks and a new host picks up
+    /// from its file for the remaining 28; starting afresh
+    /// would be in another pattern by then.
+    std::string error;
+    {
+        config.tickLimit = 29;
+        ControllerHost host(config);
+        ASSERT_TRUE(host.attachState(path_, error)) << error;
+        for (int i = 0; i < 6; i++)
+        {
+            host.addController();
+        }
+        host.start();
+        host.wait();
+    }
+
+    config.tickLimit = 28;
+    ControllerHost host(config);
+    ASSERT_TRUE(host.attachState(path_, error)) << error;
+    EXPECT_FALSE(host.state().wasReset());
+    std::vector<TrafficSignals> resumed;
+    for (int i = 0; i < 6; i++)
+    {
+        host.addController();
+    }
+    host.start();
+    host.wait();
+    for (ControllerId id : {0u, 1u, 2u, 4u, 5u, 6u})
+    {
+        resumed.push_back(host.signals(id));
+    }
+
+    EXPECT_EQ(resumed, expected);
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+
+#include "impl/config/timingConfig.hpp"
+
+#include <sstream>
+#include <string>
+
+////////////////////////////////////////////////////////////
+///  @brief Parse text over the default timing plan,
+///  checking a failed parse leaves the plan untouched.
+///
+///  @param text Timing plan text to parse
+///  @param error Description of the first problem found
+///  @return true If the text parsed and validated
+////////////////////////////////////////////////////////////
+static bool parseOverDefaults(const std::string &text, std::string &error)
+{
+    std::istringstream in(text);
+    TimingConfig config = defaultTimingConfig();
+    bool parsed = parseTimingConfig(in, config, error);
+    if (!parsed)
+    {
+        TimingConfig defaults = defaultTimingConfig();
+        EXPECT_EQ(config.maxWaitTime, defaults.maxWaitTime);
+        EXPECT_EQ(config.skipUncalled, defaults.skipUncalled);
+        EXPECT_EQ(config.enforceMaxWait, defaults.enforceMaxWait);
+        for (int p = 0; p < NUM_PATTERNS; p++)
+        {
+            EXPECT_EQ(config.patterns[p].minActiveTime, defaults.patterns[p].minActiveTime);
+            EXPECT_EQ(config.patterns[p].maxActiveTime, defaults.patterns[p].maxActiveTime);
+        }
+    }
+    return parsed;
+}
+
+TEST(TimingConfigTest, OverridesOnlyTheKeysGiven)
+{
+    std::istringstream in("# rush hour\n"
+                          "\n"
+                          "maxWaitTime = 55\n"
+                          "  NorthSouthThrough.maxActiveTime=45   # longer main road\n"
+                          "enforceMaxWait = 1\n");
+    TimingConfig config = defaultTimingConfig();
+    std::string error;
+    ASSERT_TRUE(parseTimingConfig(in, config, error)) << error;
+
+    TimingConfig defaults = defaultTimingConfig();
+    EXPECT_EQ(config.maxWaitTime, 55);
+    EXPECT_TRUE(config.enforceMaxWait);
+    EXPECT_EQ(config.skipUncalled, defaults.skipUncalled);
+    for (int p = 0; p < NUM_PATTERNS; p++)
+    {
+        EXPECT_EQ(config.patterns[p].minActiveTime, defaults.patterns[p].minActiveTime) << PATTERN_NAMES[p];
+        EXPECT_EQ(config.patterns[p].maxActiveTime,
+                  p == NorthSouthThrough ? 45 : defaults.patterns[p].maxActiveTime) << PATTERN_NAMES[p];
+    }
+}
+
+TEST(TimingConfigTest, RejectsUnknownKeys)
+{
+    std::string error;
+    EXPECT_FALSE(parseOverDefaults("maxWaitTime = 50\nNorthSouthThrough.maxGreen = 30\n", error));
+    EXPECT_EQ(error, "line 2: unknown key \"NorthSouthThrough.maxGreen\"");
+
+    EXPECT_FALSE(parseOverDefaults("maxWaitTime 50\n", error));
+    EXPECT_EQ(error, "line 1: expected \"key = seconds\"");
+}
+
+TEST(TimingConfigTest, RejectsMinAboveMax)
+{
+    std::string error;
+    EXPECT_FALSE(parseOverDefaults("EastWestTurning.minActiveTime = 30\n"
+                                   "EastWestTurning.maxActiveTime = 20\n", error));
+    EXPECT_EQ(error, "EastWestTurning: minActiveTime is above maxActiveTime");
+
+    /// Equal limits are allowed.
+    EXPECT_TRUE(parseOverDefaults("EastWestTurning.minActiveTime = 20\n"
+                                  "EastWestTurning.maxActiveTime = 20\n", error)) << error;
+}
+
+TEST(TimingConfigTest, RejectsTimesOutsideOneDay)
+{
+    std::string error;
+    EXPECT_TRUE(parseOverDefaults("maxWaitTime = 0\n", error)) << error;
+    EXPECT_TRUE(parseOverDefaults("NorthSouthThrough.maxActiveTime = 86400\n", error)) << error;
+
+    EXPECT_FALSE(parseOverDefaults("NorthSouthThrough.maxActiveTime = 86401\n", error));
+    EXPECT_EQ(error, "line 1: expected \"key = seconds\"");
+    EXPECT_FALSE(parseOverDefaults("maxWaitTime = -1\n", error));
+    EXPECT_FALSE(parseOverDefaults("maxWaitTime = 4s\n", error));
+    EXPECT_FALSE(parseOverDefaults("maxWaitTime =\n", error));
+}
+
+TEST(TimingConfigTest, OptionsTakeOnlyZeroOrOne)
+{
+    for (const char *key : {"skipUncalled", "enforceMaxWait"})
+    {
+        std::string name = key;
+        std::string error;
+        TimingConfig config = defaultTimingConfig();
+
+        std::istringstream on(name + " = 1\n");
+        ASSERT_TRUE(parseTimingConfig(on, config, error)) << error;
+        EXPECT_TRUE(name == "skipUncalled" ? config.skipUncalled : config.enforceMaxWait);
+
+        std::istringstream off(name + " = 0\n");
+        ASSERT_TRUE(parseTimingConfig(off, config, error)) << error;
+        EXPECT_FALSE(name == "skipUncalled" ? config.skipUncalled : config.enforceMaxWait);
+
+        EXPECT_FALSE(parseOverDefaults(name + " = 2\n", error));
+        EXPECT_EQ(error, "line 1: " + name + " must be 0 or 1");
+    }
+}
@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+
+#include "impl/trace/trace.hpp"
+
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief One "X" event read back from an export
+///
+////////////////////////////////////////////////////////////
+struct ExportedSpan
+{
+    std::string name; ///< span name
+    unsigned tid;     ///< thread id
+    double ts;        ///< start, in microseconds
+    double dur;       ///< duration, in microseconds
+};
+
+/// Record an outer span around two inner ones
+static void recordNestedSpans()
+{
+    TraceSpan outer("testOuter");
+    {
+        TraceSpan inner("testInner");
+    }
+    {
+        TraceSpan inner("testInner");
+    }
+}
+
+TEST(TraceTest, ExportsNestedSpansOfEachThread)
+{
+    Tracer::reset();
+    recordNestedSpans();
+    std::thread worker([]()
+    {
+        Tracer::registerThread("worker");
+        recordNestedSpans();
+    });
+    worker.join();
+
+    std::ostringstream json;
+    Tracer::writeChromeTrace(json);
+
+    std::regex spanPattern("\\{\"name\":\"(testOuter|testInner)\",\"cat\":\"tlc\",\"ph\":\"X\",\"pid\":1,"
+                           "\"tid\":([0-9]+),\"ts\":([0-9.]+),\"dur\":([0-9.]+)\\}");
+    std::vector<ExportedSpan> spans;
+    std::string text = json.str();
+    for (std::sregex_iterator match(text.begin(), text.end(), spanPattern), end; match != end; ++match)
+    {
+        spans.push_back(ExportedSpan{(*match)[1].str(),
+                                     static_cast<unsigned>(std::stoul((*match)[2].str())),
+                                     std::stod((*match)[3].str()),
+                                     std::stod((*match)[4].str())});
+    }
+
+    /// Each thread has its own tid, one outer and two inner spans.
+    std::map<unsigned, std::vector<ExportedSpan>> byThread;
+    for (const ExportedSpan &span : spans)
+    {
+        byThread[span.tid].push_back(span);
+    }
+    ASSERT_EQ(byThread.size(), 2u);
+    EXPECT_NE(text.find("\"args\":{\"name\":\"worker\"}"), std::string::npos);
+
+    for (const auto &thread : byThread)
+    {
+        const ExportedSpan *outer = nullptr;
+        unsigned inners = 0;
+        for (const ExportedSpan &span : thread.second)
+        {
+            outer = span.name == "testOuter" ? &span : outer;
+            inners += span.name == "testInner";
+        }
+        ASSERT_NE(outer, nullptr);
+        EXPECT_EQ(thread.second.size(), 3u);
+        EXPECT_EQ(inners, 2u);
+
+        /// The inner spans lie within the outer one, allowing
+        /// for the rounding of the printed times.
+        for (const ExportedSpan &span : thread.second)
+        {
+            EXPECT_GE(span.ts + 0.001, outer->ts);
+            EXPECT_LE(span.ts + span.dur, outer->ts + outer->dur + 0.002);
+        }
+    }
+
+    Tracer::reset();
+}
@@ -1,6 +1,323 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
-#include "interfaces/app/IApp.h"
+#include "interfaces/app/IApp.hpp"
 #include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/config/configManager.hpp"
+#include "impl/trace/trace.hpp"
 
+#include "AllocationHook.hpp"
+
+#include <ostream>
+#include <streambuf>
+
+using SS = SensorState;
+
+////////////////////////////////////////////////////////////
+///  @brief Stream buffer that discards everything without
+///  allocating, so only the controller's own allocations
+///  are counted when it logs.
+///
+////////////////////////////////////////////////////////////
+class DiscardBuffer : public std::streambuf
+{
+protected:
+    int_type overflow(int_type c) override
+    {
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char_type*, std::streamsize count) override
+    {
+        return count;
+    }
+};
+
+/// Every lane busy, then a mix that walks the controller through
+/// each pattern and the opposing-lanes-clear paths.
+static const Scenario MIXED_SCENARIO =
+{   //             N-N        N-W        S-S        S-E        E-E        E-N        W-W        W-S
+    { 0,   300,  { SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET,   SS::SET   }},
+    { 300, 310,  { SS::CLEAR, SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
+    { 310, 330,  { SS::SET,   SS::SET,   SS::CLEAR, SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
+    { 330, 600,  { SS::SET,   SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR }},
+    { 600, 900,  { SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::CLEAR, SS::SET,   SS::SET,   SS::CLEAR, SS::CLEAR }}
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Run a controller through a scenario, counting
+///  only the allocations made inside run().
+///
+////////////////////////////////////////////////////////////
+static std::size_t allocationsPerScenario(const Scenario &scenario, ConfigManager *config, std::ostream *log)
+{
+#if defined(TLC_TRACE_ENABLED)
+    Tracer::registerThread();
+#endif
+
+    Simulator simulator(scenario);
+    TrafficLightControllerApp tlcApp(simulator.clock(), simulator.sensors(), DEFAULT_MAX_WAIT_TIME, log);
+    ConfigManager::ReaderId reader = ConfigManager::MAX_READERS;
+    if (config)
+    {
+        reader = config->registerReader();
+        tlcApp.attachConfig(*config, reader);
+    }
+    tlcApp.initApp();
+
+    std::size_t allocations = 0;
+    while (!simulator.done())
+    {
+        AllocationCounter counter;
+        tlcApp.run();
+        allocations += counter.allocations();
+
+        simulator.update_lane_signals(tlcApp.getSignals());
+        simulator.advance(10);
+    }
+
+    if (config)
+    {
+        config->unregisterReader(reader);
+    }
+    return allocations;
+}
+
+TEST(AllocationHookTest, CountsAllocationsOnCallingThread)
+{
+    AllocationCounter counter;
+    int *value = new int(7);
+    delete value;
+
+    EXPECT_EQ(counter.allocations(), 1u);
+    EXPECT_EQ(counter.deallocations(), 1u);
+}
+
+TEST(TrafficLightControllerAppTest, TickDoesNotAllocate)
+{
+    EXPECT_EQ(allocationsPerScenario(MIXED_SCENARIO, nullptr, nullptr), 0u);
+}
+
+TEST(TrafficLightControllerAppTest, TickWithConfigDoesNotAllocate)
+{
+    ConfigManager config(defaultTimingConfig(), nullptr);
+    EXPECT_EQ(allocationsPerScenario(MIXED_SCENARIO, &config, nullptr), 0u);
+}
+
+TEST(TrafficLightControllerAppTest, TickDoesNotAllocateAfterReload)
+{
+    ConfigManager config(defaultTimingConfig(), nullptr);
+    TimingConfig timing = defaultTimingConfig();
+    timing.patterns[NorthSouthThrough].maxActiveTime = 45;
+    config.publish(timing);
+
+    EXPECT_EQ(allocationsPerScenario(MIXED_SCENARIO, &config, nullptr), 0u);
+}
+
+TEST(TrafficLightControllerAppTest, TickWithLogDoesNotAllocate)
+{
+    DiscardBuffer buffer;
+    std::ostream log(&buffer);
+    EXPECT_EQ(allocationsPerScenario(MIXED_SCENARIO, nullptr, &log), 0u);
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Expect lanes of a mask to show one signal and
+///  every other lane RED.
+///
+////////////////////////////////////////////////////////////
+static void expectSignals(const TrafficSignals &signals, LaneMask lanes, SignalState state)
+{
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        EXPECT_EQ(signals[lane], (lanes & laneBit(lane)) ? state : SignalState::RED) << "lane " << lane;
+    }
+}
+
+TEST(TrafficLightControllerAppTest, PreemptionClearsThenGreensThePattern)
+{
+    Clock clock;
+    VehicleSensors sensors;
+    sensors.fill(SS::SET);
+    TrafficLightControllerApp tlcApp(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+    tlcApp.initApp();
+    tlcApp.run();
+    ASSERT_EQ(tlcApp.getActivePattern(), NorthSouthTurning);
+
+    /// The signals change in the call, before any run().
+    tlcApp.preempt(EastWestThrough);
+    EXPECT_TRUE(tlcApp.isClearingForPreemption());
+    expectSignals(tlcApp.getSignals(), PATTERN_TRANSITIONS[NorthSouthTurning].greenLanes, SignalState::YELLOW);
+
+    tlcApp.run();
+    clock.advance(TrafficLightControllerApp::PREEMPTION_YELLOW_TIME - 1);
+    tlcApp.run();
+    expectSignals(tlcApp.getSignals(), PATTERN_TRANSITIONS[NorthSouthTurning].greenLanes, SignalState::YELLOW);
+
+    clock.advance(1);
+    tlcApp.run();
+    expectSignals(tlcApp.getSignals(), 0, SignalState::GREEN);
+
+    clock.advance(TrafficLightControllerApp::PREEMPTION_RED_TIME - 1);
+    tlcApp.run();
+    expectSignals(tlcApp.getSignals(), 0, SignalState::GREEN);
+
+    clock.advance(1);
+    tlcApp.run();
+    EXPECT_FALSE(tlcApp.isClearingForPreemption());
+    EXPECT_EQ(tlcApp.getActivePattern(), EastWestThrough);
+    expectSignals(tlcApp.getSignals(), PATTERN_TRANSITIONS[EastWestThrough].greenLanes, SignalState::GREEN);
+
+    /// Held far past its max active time with cars waiting.
+    for (int t = 0; t < 600; t += 10)
+    {
+        clock.advance(10);
+        tlcApp.run();
+        ASSERT_EQ(tlcApp.getActivePattern(), EastWestThrough);
+    }
+
+    tlcApp.releasePreemption();
+    EXPECT_FALSE(tlcApp.isPreempted());
+    tlcApp.run();
+    EXPECT_EQ(tlcApp.getActivePattern(), PATTERN_TRANSITIONS[EastWestThrough].next);
+}
+
+TEST(TrafficLightControllerAppTest, PreemptionHoldsTheGreenPattern)
+{
+    Clock clock;
+    VehicleSensors sensors;
+    sensors.fill(SS::SET);
+    TrafficLightControllerApp tlcApp(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+    tlcApp.initApp();
+
+    TrafficSignals before = tlcApp.getSignals();
+    tlcApp.preempt(NorthSouthTurning);
+    EXPECT_TRUE(tlcApp.isPreempted());
+    EXPECT_FALSE(tlcApp.isClearingForPreemption());
+    EXPECT_EQ(tlcApp.getSignals(), before);
+
+    clock.advance(1000);
+    tlcApp.run();
+    EXPECT_EQ(tlcApp.getSignals(), before);
+}
+
+TEST(TrafficLightControllerAppTest, PreemptionShowsAllRedForATickAndReleasesOnGreen)
+{
+    Clock clock;
+    VehicleSensors sensors;
+    sensors.fill(SS::CLEAR);
+    TrafficLightControllerApp tlcApp(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+    tlcApp.initApp();
+
+    tlcApp.preempt(NorthSouthThrough);
+    tlcApp.releasePreemption();
+    EXPECT_TRUE(tlcApp.isPreempted());
+
+    /// A clock jump past the whole clearance still shows the
+    /// all-RED for one run() before the GREEN.
+    clock.advance(100);
+    tlcApp.run();
+    expectSignals(tlcApp.getSignals(), 0, SignalState::GREEN);
+
+    /// A second vehicle retargets the clearance under way.
+    tlcApp.preempt(EastWestTurning);
+    tlcApp.releasePreemption();
+    tlcApp.run();
+    EXPECT_EQ(tlcApp.getActivePattern(), EastWestTurning);
+    expectSignals(tlcApp.getSignals(), PATTERN_TRANSITIONS[EastWestTurning].greenLanes, SignalState::GREEN);
+    EXPECT_FALSE(tlcApp.isPreempted());
+}
+
+TEST(TrafficLightControllerAppTest, CallTableFollowsTheCycleToTheFirstCall)
+{
+    EXPECT_EQ(CALL_TABLE.calls[0], 0);
+    EXPECT_EQ(CALL_TABLE.calls[ALL_LANES], (1u << NUM_PATTERNS) - 1);
+    EXPECT_EQ(CALL_TABLE.calls[laneBit(Lane::W_S)], 1u << EastWestTurning);
+
+    for (unsigned active = 0; active < NUM_PATTERNS; active++)
+    {
+        EXPECT_EQ(CALL_TABLE.next[active][0], PATTERN_TRANSITIONS[active].next);
+        EXPECT_EQ(CALL_TABLE.next[active][(1u << NUM_PATTERNS) - 1], PATTERN_TRANSITIONS[active].next);
+        EXPECT_EQ(CALL_TABLE.next[active][1u << active], active);
+    }
+    EXPECT_EQ(CALL_TABLE.next[EastWestTurning][(1u << NorthSouthTurning) | (1u << NorthSouthThrough)], NorthSouthTurning);
+    EXPECT_EQ(CALL_TABLE.next[NorthSouthTurning][(1u << NorthSouthTurning) | (1u << EastWestThrough)], EastWestThrough);
+}
+
+TEST(TrafficLightControllerAppTest, SkipUncalledGoesStraightToTheWaitingLane)
+{
+    Clock clock;
+    VehicleSensors sensors;
+    sensors.fill(SS::CLEAR);
+    sensors[Lane::E_E] = SS::SET;
+
+    TimingConfig timing = defaultTimingConfig();
+    timing.skipUncalled = true;
+    ConfigManager config(timing, nullptr);
+    ConfigManager::ReaderId reader = config.registerReader();
+
+    TrafficLightControllerApp tlcApp(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+    tlcApp.attachConfig(config, reader);
+    tlcApp.initApp();
+    tlcApp.run();
+    EXPECT_EQ(tlcApp.getCalls(), 1u << EastWestThrough);
+
+    /// NorthSouthThrough and EastWestTurning have no call.
+    clock.advance(PATTERN_TRANSITIONS[NorthSouthTurning].minActiveTime);
+    tlcApp.run();
+    EXPECT_EQ(tlcApp.getActivePattern(), EastWestThrough);
+    tlcApp.run();
+    EXPECT_EQ(tlcApp.getCalls(), 0);
+
+    /// The next call skips NorthSouthTurning, which follows in
+    /// the cycle.
+    sensors[Lane::E_E] = SS::CLEAR;
+    sensors[Lane::N_N] = SS::SET;
+    tlcApp.run();
+    EXPECT_EQ(tlcApp.getCalls(), 1u << NorthSouthThrough);
+    clock.advance(PATTERN_TRANSITIONS[EastWestThrough].minActiveTime);
+    tlcApp.run();
+    EXPECT_EQ(tlcApp.getActivePattern(), NorthSouthThrough);
+
+    config.unregisterReader(reader);
+}
+
+TEST(TrafficLightControllerAppTest, EnforceMaxWaitCutsTheActivePattern)
+{
+    Clock clock;
+    VehicleSensors sensors;
+    sensors.fill(SS::CLEAR);
+    sensors[Lane::N_N] = SS::SET;
+    sensors[Lane::E_N] = SS::SET;
+
+    TimingConfig timing = defaultTimingConfig();
+    timing.enforceMaxWait = true;
+    timing.maxWaitTime = 20;
+    ConfigManager config(timing, nullptr);
+    ConfigManager::ReaderId reader = config.registerReader();
+
+    TrafficLightControllerApp tlcApp(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+    tlcApp.attachConfig(config, reader);
+    tlcApp.initApp();
+    tlcApp.run();
+
+    /// NorthSouthThrough serves N_N from t=10 for at least 30s;
+    /// E_N, waiting since t=0, is due at t=20 less the lead of
+    /// one-second ticks.
+    clock.advance(PATTERN_TRANSITIONS[NorthSouthTurning].minActiveTime);
+    tlcApp.run();
+    ASSERT_EQ(tlcApp.getActivePattern(), NorthSouthThrough);
+
+    IClock::Time due = timing.maxWaitTime - TrafficLightControllerApp::DEADLINE_LEAD_TICKS;
+    while (clock.now() < due - 1)
+    {
+        clock.advance(1);
+        tlcApp.run();
+        ASSERT_EQ(tlcApp.getActivePattern(), NorthSouthThrough) << "at " << clock.now();
+    }
+    clock.advance(1);
+    tlcApp.run();
+    EXPECT_EQ(tlcApp.getActivePattern(), EastWestTurning);
+
+    config.unregisterReader(reader);
+}
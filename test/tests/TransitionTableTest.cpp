@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/app/transitionTable.hpp"
+#include "impl/config/configManager.hpp"
+
+#include <random>
+#include <string>
+
+////////////////////////////////////////////////////////////
+///  @brief Tick a controller by its rules and one by the
+///  table through random traffic, checking they agree after
+///  every tick.
+///
+////////////////////////////////////////////////////////////
+static void expectSameAsRules(const TimingConfig &timing, unsigned seed)
+{
+    Clock clock;
+    VehicleSensors sensors;
+    sensors.fill(SensorState::CLEAR);
+
+    ConfigManager config(timing, nullptr);
+    ConfigManager::ReaderId reader = config.registerReader();
+
+    TrafficLightControllerApp rules(clock, sensors, timing.maxWaitTime, nullptr);
+    TrafficLightControllerApp lookup(clock, sensors, timing.maxWaitTime, nullptr);
+    rules.attachConfig(config, reader);
+    lookup.attachConfig(config, reader);
+    lookup.attachTransitionTable(&TransitionTable::instance());
+    rules.initApp();
+    lookup.initApp();
+
+    std::mt19937 rng(seed);
+    for (int tick = 0; tick < 20000; tick++)
+    {
+        for (SensorState &sensor : sensors)
+        {
+            if (rng() % 8 == 0)
+            {
+                sensor = sensor == SensorState::SET ? SensorState::CLEAR : SensorState::SET;
+            }
+        }
+
+        rules.run();
+        lookup.run();
+
+        ControllerSnapshot expected = rules.snapshot();
+        ControllerSnapshot actual = lookup.snapshot();
+        ASSERT_EQ(actual.activePattern, expected.activePattern) << "tick " << tick;
+        ASSERT_EQ(actual.signals, expected.signals) << "tick " << tick;
+        ASSERT_EQ(actual.carsAwaiting, expected.carsAwaiting) << "tick " << tick;
+        for (unsigned pattern = 0; pattern < NUM_PATTERNS; pattern++)
+        {
+            ASSERT_EQ(actual.lightStates[pattern].startTime, expected.lightStates[pattern].startTime) << "tick " << tick;
+            ASSERT_EQ(actual.lightStates[pattern].areOpposingLanesClear,
+                      expected.lightStates[pattern].areOpposingLanesClear) << "tick " << tick;
+        }
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            ASSERT_EQ(actual.vehicleStates[lane].waitTime, expected.vehicleStates[lane].waitTime) << "tick " << tick;
+        }
+
+        clock.advance(1 + static_cast<IClock::Time>(rng() % 15));
+    }
+
+    config.unregisterReader(reader);
+}
+
+TEST(TransitionTableTest, MatchesRulesOnEveryState)
+{
+    std::string error;
+    EXPECT_TRUE(verifyTransitionTable(TransitionTable::instance(), error)) << error;
+}
+
+TEST(TransitionTableTest, MatchesRulesOverRandomTraffic)
+{
+    expectSameAsRules(defaultTimingConfig(), 1);
+
+    std::mt19937 rng(5);
+    for (unsigned trial = 0; trial < 10; trial++)
+    {
+        TimingConfig timing = defaultTimingConfig();
+        for (PatternTiming &pattern : timing.patterns)
+        {
+            pattern.minActiveTime = 1 + static_cast<IClock::Time>(rng() % 40);
+            pattern.maxActiveTime = pattern.minActiveTime + static_cast<IClock::Time>(rng() % 60);
+        }
+        expectSameAsRules(timing, trial);
+    }
+}
+
+TEST(TransitionTableTest, FallsBackToRulesWithZeroLimits)
+{
+    /// A pattern that may end the moment it starts is outside
+    /// the table; the controller must run its rules instead.
+    TimingConfig timing = defaultTimingConfig();
+    timing.patterns[EastWestTurning].minActiveTime = 0;
+    expectSameAsRules(timing, 9);
+}
+
+TEST(TransitionTableTest, EastNorthTurnCrossesOnlyTheOtherPairs)
+{
+    /// E_N runs beside W_S in EastWestTurning, and crosses the
+    /// S_E turn that runs in NorthSouthTurning.
+    EXPECT_NE(OPPOSING_LANES[Lane::E_N] & laneBit(Lane::S_E), 0);
+    EXPECT_NE(OPPOSING_LANES[Lane::S_E] & laneBit(Lane::E_N), 0);
+    EXPECT_EQ(OPPOSING_LANES[Lane::E_N] & laneBit(Lane::W_S), 0);
+    EXPECT_EQ(OPPOSING_LANES[Lane::W_S] & laneBit(Lane::E_N), 0);
+}
@@ -0,0 +1,24 @@
+#include "gtest/gtest.h"
+
+#include "impl/util/workerPool.hpp"
+
+#include <atomic>
+#include <vector>
+
+TEST(WorkerPoolTest, RunsEveryIndexOnce)
+{
+    WorkerPool pool(3);
+    std::vector<std::atomic<int>> runs(1000);
+
+    for (int round = 0; round < 50; round++)
+    {
+        std::size_t count = 1 + (round * 37) % runs.size();
+        auto job = [&runs](std::size_t index) { runs[index].fetch_add(1, std::memory_order_relaxed); };
+        pool.run(count, job);
+
+        for (std::size_t index = 0; index < runs.size(); index++)
+        {
+            ASSERT_EQ(runs[index].exchange(0), index < count ? 1 : 0) << "round " << round;
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+
+#include "impl/simulator/workload.hpp"
+
+/// Intersections sampled by the tests
+static constexpr std::uint32_t NUM_INTERSECTIONS = 50;
+
+////////////////////////////////////////////////////////////
+///  @brief Count SET detector-seconds of some lanes over a
+///  span of the day, across every intersection.
+///
+////////////////////////////////////////////////////////////
+static unsigned countSet(const Workload &workload, std::uint8_t lanes, IClock::Time from, IClock::Time to)
+{
+    unsigned set = 0;
+    for (std::uint32_t i = 0; i < NUM_INTERSECTIONS; i++)
+    {
+        for (IClock::Time t = from; t < to; t++)
+        {
+            set += static_cast<unsigned>(__builtin_popcount(workload.sensorMask(i, t) & lanes));
+        }
+    }
+    return set;
+}
+
+TEST(WorkloadTest, SameSeedGivesTheSameTrafficInAnyOrder)
+{
+    WorkloadConfig config = defaultWorkloadConfig(NUM_INTERSECTIONS);
+    Workload forward(config);
+    Workload backward(config);
+    config.seed = 2;
+    Workload reseeded(config);
+
+    unsigned differences = 0;
+    for (IClock::Time t = 0; t < 600; t++)
+    {
+        for (std::uint32_t i = 0; i < NUM_INTERSECTIONS; i++)
+        {
+            std::uint32_t j = NUM_INTERSECTIONS - 1 - i;
+            ASSERT_EQ(forward.sensorMask(i, t), backward.sensorMask(i, t));
+            ASSERT_EQ(forward.sensorMask(j, 600 - t), backward.sensorMask(j, 600 - t));
+            differences += forward.sensorMask(i, t) != reseeded.sensorMask(i, t);
+        }
+    }
+    EXPECT_GT(differences, 0u);
+}
+
+TEST(WorkloadTest, RushHoursAreBusiestAndTidal)
+{
+    Workload workload(defaultWorkloadConfig(NUM_INTERSECTIONS));
+    std::uint8_t inbound = (1u << Lane::N_N) | (1u << Lane::E_E);
+    std::uint8_t outbound = (1u << Lane::S_S) | (1u << Lane::W_W);
+
+    unsigned night = countSet(workload, inbound | outbound, 2 * 3600, 3 * 3600);
+    unsigned morningIn = countSet(workload, inbound, 8 * 3600 - 1800, 8 * 3600 + 1800);
+    unsigned morningOut = countSet(workload, outbound, 8 * 3600 - 1800, 8 * 3600 + 1800);
+    unsigned eveningIn = countSet(workload, inbound, 17 * 3600, 18 * 3600);
+    unsigned eveningOut = countSet(workload, outbound, 17 * 3600, 18 * 3600);
+
+    EXPECT_GT(morningIn, 3 * night);
+    EXPECT_GT(eveningOut, 3 * night);
+    EXPECT_GT(morningIn, morningOut);
+    EXPECT_GT(eveningOut, eveningIn);
+
+    /// The curve repeats the next day.
+    EXPECT_NEAR(countSet(workload, inbound, Workload::DAY + 8 * 3600 - 1800, Workload::DAY + 8 * 3600 + 1800),
+                morningIn, morningIn / 10);
+}
+
+TEST(WorkloadTest, DetectorsFollowTheArrivalRate)
+{
+    WorkloadConfig config = defaultWorkloadConfig(NUM_INTERSECTIONS);
+    config.occupancyTime = 1;
+    Workload workload(config);
+
+    /// With one second per arrival, the share of SET seconds
+    /// is the arrival rate.
+    IClock::Time from = 8 * 3600;
+    IClock::Time to = from + Workload::CURVE_STEP;
+    double expected = 0.0;
+    for (std::uint32_t i = 0; i < NUM_INTERSECTIONS; i++)
+    {
+        expected += workload.arrivalRate(i, Lane::N_N, from) * Workload::CURVE_STEP;
+    }
+    unsigned set = countSet(workload, 1u << Lane::N_N, from, to);
+    EXPECT_NEAR(set, expected, 0.15 * expected);
+}
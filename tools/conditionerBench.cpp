@@ -0,0 +1,142 @@
+#include "impl/sensor/sensorConditioner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/// Chance per tick that a loop reads the opposite of the truth
+static constexpr double CHATTER = 0.05;
+
+////////////////////////////////////////////////////////////
+///  @brief The same filters one detector at a time, for
+///  comparison.
+///
+////////////////////////////////////////////////////////////
+struct ScalarDetector
+{
+    std::uint8_t call;
+    std::uint8_t run;
+    std::uint8_t held;
+};
+
+static void scalarUpdate(std::vector<ScalarDetector> &detectors, const std::vector<LaneMask> &raw,
+                         const DetectorTiming &timing)
+{
+    for (std::size_t i = 0; i < detectors.size(); i++)
+    {
+        ScalarDetector &detector = detectors[i];
+        bool set = (raw[i / Lane::COUNT] >> (i % Lane::COUNT)) & 1u;
+        bool disagree = set != (detector.call != 0);
+
+        detector.run = disagree ? static_cast<std::uint8_t>(std::min(detector.run + 1, 63)) : 0;
+        detector.held = detector.call ? static_cast<std::uint8_t>(std::min(detector.held + 1, 63)) : 0;
+
+        bool flip = disagree && (detector.call ? detector.run >= timing.gapOut && detector.held >= timing.minPresence
+                                               : detector.run >= timing.onDelay);
+        if (flip)
+        {
+            detector.call ^= 1;
+            detector.run = 0;
+            detector.held = 0;
+        }
+    }
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    IntersectionId numIntersections = argc > 1 ? static_cast<IntersectionId>(std::atoi(argv[1])) : 100000;
+    int numTicks = argc > 2 ? std::atoi(argv[2]) : 500;
+
+    SensorConditioner conditioner(numIntersections);
+    std::vector<ScalarDetector> scalar(numIntersections * Lane::COUNT, ScalarDetector());
+    DetectorTiming timing = defaultDetectorTiming();
+
+    /// Vehicles arrive and leave every few tens of ticks; the
+    /// loops flip on top of that.
+    std::mt19937_64 rng(3);
+    std::bernoulli_distribution change(0.05);
+    std::bernoulli_distribution chatter(CHATTER);
+    std::vector<LaneMask> truth(numIntersections, 0);
+    std::vector<LaneMask> raw(numIntersections, 0);
+
+    double slicedSeconds = 0.0;
+    double scalarSeconds = 0.0;
+    std::vector<LaneMask> lastRaw(numIntersections, 0);
+    std::vector<LaneMask> lastCalls(numIntersections, 0);
+    std::uint64_t rawFalseCalls = 0;
+    std::uint64_t conditionedFalseCalls = 0;
+    std::uint64_t missedCalls = 0;
+
+    for (int tick = 0; tick < numTicks; tick++)
+    {
+        for (IntersectionId i = 0; i < numIntersections; i++)
+        {
+            LaneMask flips = 0;
+            LaneMask noise = 0;
+            for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+            {
+                flips |= change(rng) ? laneBit(lane) : 0;
+                noise |= chatter(rng) ? laneBit(lane) : 0;
+            }
+            truth[i] ^= flips;
+            raw[i] = truth[i] ^ noise;
+            conditioner.setRaw(i, raw[i]);
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        conditioner.update();
+        auto middle = std::chrono::steady_clock::now();
+        scalarUpdate(scalar, raw, timing);
+        auto end = std::chrono::steady_clock::now();
+
+        slicedSeconds += std::chrono::duration<double>(middle - begin).count();
+        scalarSeconds += std::chrono::duration<double>(end - middle).count();
+
+        for (IntersectionId i = 0; i < numIntersections; i++)
+        {
+            /// A false call is one placed with no vehicle there.
+            LaneMask calls = conditioner.conditioned(i);
+            LaneMask rawPlaced = raw[i] & ~lastRaw[i];
+            LaneMask placed = calls & ~lastCalls[i];
+            lastRaw[i] = raw[i];
+            lastCalls[i] = calls;
+
+            for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+            {
+                bool present = truth[i] & laneBit(lane);
+                rawFalseCalls += !present && (rawPlaced & laneBit(lane));
+                conditionedFalseCalls += !present && (placed & laneBit(lane));
+                missedCalls += present && !(calls & laneBit(lane));
+                if (((calls >> lane) & 1u) != scalar[i * Lane::COUNT + lane].call)
+                {
+                    std::cout << "Bit-sliced and scalar filters disagree." << std::endl;
+                    return 1;
+                }
+            }
+        }
+    }
+
+    double detectorTicks = static_cast<double>(numIntersections) * Lane::COUNT * numTicks;
+    std::cout << numIntersections * Lane::COUNT << " detectors, " << numTicks << " ticks, "
+              << CHATTER * 100 << "% chatter." << std::endl;
+    std::cout << std::fixed << std::setprecision(3)
+              << "bit-sliced " << slicedSeconds * 1e9 / detectorTicks << " ns/detector, "
+              << slicedSeconds * 1e3 / numTicks << " ms/tick" << std::endl
+              << "scalar     " << scalarSeconds * 1e9 / detectorTicks << " ns/detector, "
+              << scalarSeconds * 1e3 / numTicks << " ms/tick" << std::endl;
+    std::cout << "edges: raw " << conditioner.rawEdges() << ", conditioned " << conditioner.conditionedEdges()
+              << std::endl;
+    std::cout << std::setprecision(2)
+              << "false calls: raw " << rawFalseCalls << ", conditioned " << conditionedFalseCalls
+              << "; ticks with a vehicle but no call " << 100.0 * missedCalls / detectorTicks << "%" << std::endl;
+
+    return 0;
+}
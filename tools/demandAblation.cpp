@@ -0,0 +1,188 @@
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/app/demandEstimator.hpp"
+#include "impl/simulator/microSimulator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+static constexpr float APPROACH_LENGTH = 250.0f; ///< block length in metres
+static constexpr Clock::Time DEMAND_STEP = 300;  ///< seconds between demand changes
+
+////////////////////////////////////////////////////////////
+///  @brief Get a peak of demand over a day.
+///
+///  @param phase Time of day, 0 to 1
+///  @param centre Time of day of the peak
+///  @return float 0 away from the peak up to 1 at it
+////////////////////////////////////////////////////////////
+static float peak(float phase, float centre)
+{
+    float distance = (phase - centre) / 0.08f;
+    return std::exp(-distance * distance);
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Set the corridor's demand for a time of day: the
+///  arterial peaks in the morning, the cross streets and
+///  turns in the evening.
+///
+////////////////////////////////////////////////////////////
+static void setDemand(MicroSimulator &simulator, IntersectionId numIntersections, float phase)
+{
+    float through = 250.0f + 550.0f * peak(phase, 0.3f);
+    float side = 120.0f + 380.0f * peak(phase, 0.7f);
+    float turn = 50.0f + 150.0f * peak(phase, 0.7f);
+
+    for (IntersectionId i = 0; i < numIntersections; i++)
+    {
+        simulator.setDemand(i, Lane::N_N, side);
+        simulator.setDemand(i, Lane::S_S, side);
+        simulator.setDemand(i, Lane::N_W, turn);
+        simulator.setDemand(i, Lane::S_E, turn);
+        simulator.setDemand(i, Lane::E_N, turn);
+        simulator.setDemand(i, Lane::W_S, turn);
+    }
+    simulator.setDemand(0, Lane::E_E, through);
+    simulator.setDemand(numIntersections - 1, Lane::W_W, through);
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Outcome of one closed-loop run
+///
+////////////////////////////////////////////////////////////
+struct AblationResult
+{
+    double meanDelay;        ///< delay per exited vehicle on the last day (s)
+    std::uint64_t exited;    ///< vehicles that left the network on the last day
+    double controllerNanos;  ///< wall time of each run(), estimator included (ns)
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Run an east-west corridor for several compressed
+///  days with or without demand estimation.
+///
+///  @param numIntersections Intersections in the corridor
+///  @param days Days to run; the last is scored
+///  @param day Seconds per day
+///  @param features DemandFeature bits, 0 for fixed limits
+///  @return AblationResult The last day's delay and the
+///  controllers' cost
+////////////////////////////////////////////////////////////
+static AblationResult runCorridor(IntersectionId numIntersections, unsigned days, Clock::Time day, unsigned features)
+{
+    MicroSimulator simulator(numIntersections, APPROACH_LENGTH);
+    for (IntersectionId i = 0; i + 1 < numIntersections; i++)
+    {
+        simulator.link(i, Lane::E_E, i + 1, Lane::E_E);
+        simulator.link(i + 1, Lane::W_W, i, Lane::W_W);
+    }
+
+    DemandConfig config = defaultDemandConfig();
+    config.features = features;
+    config.profileBin = day / DemandEstimator::PROFILE_BINS;
+
+    std::vector<std::unique_ptr<TrafficLightControllerApp>> controllers;
+    std::vector<std::unique_ptr<DemandEstimator>> estimators;
+    for (IntersectionId i = 0; i < numIntersections; i++)
+    {
+        controllers.emplace_back(new TrafficLightControllerApp(simulator.clock(), simulator.sensors(i),
+                                                               DEFAULT_MAX_WAIT_TIME, nullptr));
+        estimators.emplace_back(new DemandEstimator(config));
+        controllers.back()->attachEstimator(features ? estimators.back().get() : nullptr);
+        controllers.back()->initApp();
+    }
+
+    MicroStats lastDay = simulator.stats();
+    std::chrono::steady_clock::duration controlling(0);
+    Clock::Time duration = day * static_cast<Clock::Time>(days);
+    for (Clock::Time t = 0; t < duration; t++)
+    {
+        if (t % DEMAND_STEP == 0)
+        {
+            setDemand(simulator, numIntersections, static_cast<float>(t % day) / static_cast<float>(day));
+        }
+        if (t == duration - day)
+        {
+            lastDay = simulator.stats();
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        for (IntersectionId i = 0; i < numIntersections; i++)
+        {
+            controllers[i]->run();
+        }
+        controlling += std::chrono::steady_clock::now() - begin;
+
+        for (IntersectionId i = 0; i < numIntersections; i++)
+        {
+            simulator.setSignals(i, controllers[i]->getSignals());
+        }
+        simulator.advance(1);
+    }
+
+    const MicroStats &stats = simulator.stats();
+    AblationResult result;
+    result.exited = stats.vehiclesExited - lastDay.vehiclesExited;
+    result.meanDelay = result.exited ? (stats.delay - lastDay.delay) / static_cast<double>(result.exited) : 0.0;
+    result.controllerNanos = std::chrono::duration<double, std::nano>(controlling).count() /
+                             (static_cast<double>(duration) * numIntersections);
+    return result;
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    IntersectionId numIntersections = argc > 1 ? static_cast<IntersectionId>(std::atoi(argv[1])) : 8;
+    unsigned days = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 3;
+    Clock::Time day = argc > 3 ? static_cast<Clock::Time>(std::atoi(argv[3])) : 4 * 3600;
+
+    if (numIntersections == 0 || days == 0 || day < static_cast<Clock::Time>(DemandEstimator::PROFILE_BINS))
+    {
+        std::cerr << "usage: demandAblation [intersections] [days] [secondsPerDay]" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Corridor of " << numIntersections << " intersections, " << days << " days of "
+              << day << "s; the last day is scored." << std::endl;
+    std::cout << "estimates                 delay(s)  change(%)  exited  run(ns)" << std::endl;
+
+    struct Variant
+    {
+        const char *name;
+        unsigned features;
+    };
+    const Variant variants[] =
+    {
+        {"fixed limits", 0},
+        {"arrival rate", ARRIVAL_RATE},
+        {"occupancy", OCCUPANCY},
+        {"profile", PROFILE},
+        {"rate + occupancy", ARRIVAL_RATE | OCCUPANCY},
+        {"rate + profile", ARRIVAL_RATE | PROFILE},
+        {"all", ALL_FEATURES},
+    };
+
+    double baseline = 0.0;
+    for (const Variant &variant : variants)
+    {
+        AblationResult result = runCorridor(numIntersections, days, day, variant.features);
+        baseline = variant.features ? baseline : result.meanDelay;
+
+        std::cout << std::left << std::setw(24) << variant.name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(10) << result.meanDelay
+                  << std::setw(11) << (baseline > 0.0 ? 100.0 * (result.meanDelay - baseline) / baseline : 0.0)
+                  << std::setw(8) << result.exited
+                  << std::setw(9) << result.controllerNanos << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include "impl/simulator/detectorLog.hpp"
+#include "impl/simulator/scenarios.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// First timestamp of the written log
+static constexpr long long LOG_EPOCH = 1700000000;
+
+/// Detectors in the written log; those past the lanes are
+/// other cabinets' loops sharing the export
+static constexpr unsigned LOG_DETECTORS = 12;
+
+////////////////////////////////////////////////////////////
+///  @brief Write a polled detector log: every detector's
+///  state once a second, each day of makeDayScenario.
+///
+///  @param path File to write
+///  @param days Days of data
+///  @return true If the file was written
+////////////////////////////////////////////////////////////
+static bool writeLog(const std::string &path, unsigned days)
+{
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    std::fputs("timestamp,detector,state\n", file);
+    std::vector<char> buffer(1 << 20);
+    std::size_t used = 0;
+    for (unsigned day = 0; day < days; day++)
+    {
+        Scenario scenario = makeDayScenario(day + 1);
+        for (const SimulationTimeslice &slice : scenario)
+        {
+            for (Clock::Time t = slice.start; t < slice.end; t++)
+            {
+                long long timestamp = LOG_EPOCH + 86400ll * day + t;
+                for (unsigned detector = 0; detector < LOG_DETECTORS; detector++)
+                {
+                    bool on = detector < Lane::COUNT ? slice.sensors[detector] == SensorState::SET
+                                                     : ((t / 45 + detector) & 3) == 0;
+                    if (buffer.size() - used < 64)
+                    {
+                        std::fwrite(buffer.data(), 1, used, file);
+                        used = 0;
+                    }
+                    used += static_cast<std::size_t>(std::snprintf(buffer.data() + used, 64, "%lld,%u,%c\n",
+                                                                   timestamp, detector, on ? '1' : '0'));
+                }
+            }
+        }
+    }
+    std::fwrite(buffer.data(), 1, used, file);
+
+    return std::fclose(file) == 0;
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    /// A log that does not exist yet is written first.
+    std::string path = argc > 1 ? argv[1] : "/tmp/detectors.csv";
+    unsigned days = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 30;
+    unsigned numThreads = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 0;
+    std::string mapPath = argc > 4 ? argv[4] : "";
+
+    DetectorLogOptions options = defaultDetectorLogOptions();
+    options.numThreads = numThreads;
+
+    std::string error;
+    if (!mapPath.empty())
+    {
+        std::ifstream map(mapPath);
+        if (!map || !parseDetectorMap(map, options.lanes, error))
+        {
+            std::cerr << mapPath << ": " << (map ? error : "cannot open") << std::endl;
+            return 1;
+        }
+    }
+
+    if (!std::ifstream(path))
+    {
+        std::cout << "Writing " << days << " days of polled detectors to " << path << "..." << std::endl;
+        if (!writeLog(path, days))
+        {
+            std::cerr << "Cannot write " << path << std::endl;
+            return 1;
+        }
+    }
+
+    /// The first pass may read from disk; the second finds
+    /// the file in the page cache and times the parser.
+    for (const char *pass : {"cold", "warm"})
+    {
+        Scenario scenario;
+        DetectorLogStats stats;
+        auto start = std::chrono::steady_clock::now();
+        if (!loadDetectorLog(path, options, scenario, stats, error))
+        {
+            std::cerr << path << ": " << error << std::endl;
+            return 1;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::fixed << std::setprecision(2) << pass << ": " << stats.bytes / 1e6 << " MB, "
+                  << stats.lines << " lines in " << seconds * 1000 << " ms, "
+                  << stats.bytes / seconds / 1e9 << " GB/s, " << stats.lines / seconds / 1e6 << " M lines/s." << std::endl;
+        std::cout << "    " << stats.events << " events, " << stats.unmapped << " unmapped, "
+                  << stats.malformed << " malformed, " << stats.changes << " sensor changes -> "
+                  << scenario.size() << " timeslices over " << (scenario.back().end - scenario.front().start) / 86400.0
+                  << " days." << std::endl;
+    }
+
+    return 0;
+}
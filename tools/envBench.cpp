@@ -0,0 +1,77 @@
+#include "impl/env/tlcEnv.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    std::uint32_t numEnvs = argc > 1 ? static_cast<std::uint32_t>(std::atoi(argv[1])) : 1024;
+    std::uint32_t numThreads = argc > 2 ? static_cast<std::uint32_t>(std::atoi(argv[2])) : 0;
+    unsigned numSteps = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 5000;
+
+    /// Through the C interface, as a training framework would.
+    tlc_batch *batch = tlc_batch_create(numEnvs, numThreads, 1);
+    if (!batch || numSteps == 0)
+    {
+        std::cerr << "usage: envBench [envs] [threads] [steps]" << std::endl;
+        tlc_batch_destroy(batch);
+        return 1;
+    }
+
+    std::vector<std::uint32_t> seeds(numEnvs);
+    std::vector<tlc_observation> observations(numEnvs);
+    std::vector<float> rewards(numEnvs);
+    std::vector<std::uint8_t> dones(numEnvs);
+    std::vector<std::int32_t> actions(numEnvs);
+    for (std::uint32_t env = 0; env < numEnvs; env++)
+    {
+        seeds[env] = env;
+    }
+
+    auto resetBegin = std::chrono::steady_clock::now();
+    tlc_batch_reset(batch, seeds.data(), observations.data());
+    double resetSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - resetBegin).count();
+
+    /// A random policy that mostly holds, as an untrained one
+    /// might.
+    std::mt19937 rng(5);
+    double totalReward = 0.0;
+    std::chrono::steady_clock::duration stepping(0);
+    for (unsigned step = 0; step < numSteps; step++)
+    {
+        for (std::int32_t &action : actions)
+        {
+            std::uint32_t roll = rng() % 16;
+            action = roll == 0 ? TLC_ACTION_ADVANCE : (roll == 1 ? TLC_ACTION_RULES : TLC_ACTION_HOLD);
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        tlc_batch_step(batch, actions.data(), observations.data(), rewards.data(), dones.data());
+        stepping += std::chrono::steady_clock::now() - begin;
+
+        for (float reward : rewards)
+        {
+            totalReward += reward;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(stepping).count();
+    double envSteps = static_cast<double>(numEnvs) * numSteps;
+    std::cout << numEnvs << " environments, " << numSteps << " steps of 1s." << std::endl;
+    std::cout << std::fixed << std::setprecision(1)
+              << "reset " << resetSeconds * 1000.0 << " ms; "
+              << envSteps / seconds / 1e6 * 60.0 << "M env-steps/min, "
+              << seconds * 1e9 / envSteps << " ns per env-step, "
+              << std::setprecision(3) << totalReward / envSteps << " mean reward." << std::endl;
+
+    tlc_batch_destroy(batch);
+    return 0;
+}
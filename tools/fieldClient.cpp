@@ -0,0 +1,178 @@
+#include "impl/gateway/sensorGateway.hpp"
+#include "impl/simulator/scenarios.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/// Datagrams handed to the kernel per sendmmsg
+static constexpr unsigned SEND_BATCH = 64;
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+#if defined(__linux__)
+    std::string basePath = argc > 1 ? argv[1] : "/tmp/tlc-gateway";
+    std::uint32_t numIntersections = argc > 2 ? static_cast<std::uint32_t>(std::atoi(argv[2])) : 5000;
+    unsigned rateHz = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 10;
+    unsigned seconds = argc > 4 ? static_cast<unsigned>(std::atoi(argv[4])) : 10;
+    unsigned numSockets = argc > 5 ? static_cast<unsigned>(std::atoi(argv[5])) : 1;
+    unsigned framesPerDatagram = argc > 6 ? static_cast<unsigned>(std::atoi(argv[6])) : 64;
+
+    if (numIntersections == 0 || rateHz == 0 || numSockets == 0 || framesPerDatagram == 0)
+    {
+        std::cerr << "usage: fieldClient [basePath] [intersections] [rateHz] [seconds] [sockets] [framesPerDatagram]" << std::endl;
+        return 1;
+    }
+
+    /// Every intersection plays the same day of traffic, each
+    /// from its own time of day, one scenario second per
+    /// rateHz frames.
+    Scenario day = makeDayScenario(1);
+    std::vector<SensorMask> script(static_cast<std::size_t>(day.back().end), 0);
+    for (const SimulationTimeslice &slice : day)
+    {
+        SensorMask mask = 0;
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            mask |= slice.sensors[lane] == SensorState::SET ? laneBit(lane) : 0;
+        }
+        for (Clock::Time t = slice.start; t < slice.end; t++)
+        {
+            script[static_cast<std::size_t>(t)] = mask;
+        }
+    }
+
+    /// Socket s carries intersections s, s + sockets, ...;
+    /// each link's frames are packed into full datagrams.
+    std::vector<sockaddr_un> addresses(numSockets);
+    std::vector<std::vector<std::uint32_t>> links(numSockets);
+    for (unsigned s = 0; s < numSockets; s++)
+    {
+        std::string path = basePath + "." + std::to_string(s) + ".sock";
+        std::memset(&addresses[s], 0, sizeof(sockaddr_un));
+        addresses[s].sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addresses[s].sun_path))
+        {
+            std::cerr << "Socket path too long: " << path << std::endl;
+            return 1;
+        }
+        std::memcpy(addresses[s].sun_path, path.c_str(), path.size());
+    }
+    for (std::uint32_t i = 0; i < numIntersections; i++)
+    {
+        links[i % numSockets].push_back(i);
+    }
+
+    std::size_t maxDatagrams = 0;
+    for (const std::vector<std::uint32_t> &link : links)
+    {
+        maxDatagrams += (link.size() + framesPerDatagram - 1) / framesPerDatagram;
+    }
+    std::vector<std::uint8_t> bytes(maxDatagrams * framesPerDatagram * SENSOR_FRAME_SIZE);
+    std::vector<iovec> vectors(maxDatagrams);
+    std::vector<mmsghdr> messages(maxDatagrams);
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        std::cerr << "socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    std::cout << numIntersections << " intersections at " << rateHz << " Hz over " << numSockets
+              << " sockets, " << framesPerDatagram << " frames per datagram, for " << seconds << " s." << std::endl;
+
+    std::uint64_t period = 1000000000u / rateHz;
+    std::uint64_t start = monotonicNanos();
+    std::uint64_t frames = 0;
+    std::uint64_t datagrams = 0;
+    unsigned late = 0;
+    std::uint64_t rounds = static_cast<std::uint64_t>(seconds) * rateHz;
+    for (std::uint64_t round = 0; round < rounds; round++)
+    {
+        std::uint64_t due = start + round * period;
+        timespec wake = {static_cast<time_t>(due / 1000000000u), static_cast<long>(due % 1000000000u)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr);
+
+        std::uint64_t sent = monotonicNanos();
+        late += sent > due + period / 2;
+        std::size_t second = static_cast<std::size_t>(round / rateHz);
+
+        std::size_t count = 0;
+        for (unsigned s = 0; s < numSockets; s++)
+        {
+            for (std::size_t first = 0; first < links[s].size(); first += framesPerDatagram)
+            {
+                std::size_t last = std::min(links[s].size(), first + framesPerDatagram);
+                std::uint8_t *out = bytes.data() + count * framesPerDatagram * SENSOR_FRAME_SIZE;
+                for (std::size_t k = first; k < last; k++)
+                {
+                    std::uint32_t intersection = links[s][k];
+                    SensorFrame frame;
+                    frame.sensors = script[(second + intersection * 61u) % script.size()];
+                    frame.sequence = static_cast<std::uint16_t>(round);
+                    frame.intersection = intersection;
+                    frame.sent = sent;
+                    encodeSensorFrame(frame, out + (k - first) * SENSOR_FRAME_SIZE);
+                }
+
+                vectors[count].iov_base = out;
+                vectors[count].iov_len = (last - first) * SENSOR_FRAME_SIZE;
+                std::memset(&messages[count], 0, sizeof(mmsghdr));
+                messages[count].msg_hdr.msg_name = &addresses[s];
+                messages[count].msg_hdr.msg_namelen = sizeof(sockaddr_un);
+                messages[count].msg_hdr.msg_iov = &vectors[count];
+                messages[count].msg_hdr.msg_iovlen = 1;
+                count++;
+            }
+        }
+
+        /// Blocking sends: a full gateway queue holds the client
+        /// back rather than losing frames.
+        for (std::size_t done = 0; done < count; )
+        {
+            unsigned batch = static_cast<unsigned>(std::min<std::size_t>(SEND_BATCH, count - done));
+            int result = sendmmsg(fd, &messages[done], batch, 0);
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                std::cerr << "sendmmsg: " << std::strerror(errno) << std::endl;
+                close(fd);
+                return 1;
+            }
+            done += static_cast<std::size_t>(result);
+        }
+        datagrams += count;
+        frames += numIntersections;
+    }
+
+    close(fd);
+    double wall = static_cast<double>(monotonicNanos() - start) / 1e9;
+    std::cout << "Sent " << frames << " frames in " << datagrams << " datagrams in " << wall << " s, "
+              << late << " of " << rounds << " rounds late." << std::endl;
+    return 0;
+#else
+    (void)argc;
+    (void)argv;
+    std::cerr << "The field client needs Linux sockets." << std::endl;
+    return 1;
+#endif
+}
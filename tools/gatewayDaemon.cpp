@@ -0,0 +1,150 @@
+#include "impl/gateway/sensorGateway.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+/// Set by SIGINT or SIGTERM
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void requestStop(int)
+{
+    stopRequested = 1;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Get the CPU time the process has used
+///
+///  @return double User and system seconds
+////////////////////////////////////////////////////////////
+static double cpuSeconds()
+{
+#if defined(__linux__)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#else
+    return 0.0;
+#endif
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    std::string basePath = argc > 1 ? argv[1] : "/tmp/tlc-gateway";
+    std::uint32_t numIntersections = argc > 2 ? static_cast<std::uint32_t>(std::atoi(argv[2])) : 5000;
+    unsigned seconds = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 0;
+    unsigned numSockets = argc > 4 ? static_cast<unsigned>(std::atoi(argv[4])) : 1;
+    unsigned tickHz = argc > 5 ? static_cast<unsigned>(std::atoi(argv[5])) : 10;
+
+    if (numIntersections == 0 || numSockets == 0 || tickHz == 0)
+    {
+        std::cerr << "usage: gatewayDaemon [basePath] [intersections] [seconds, 0 until signalled] [sockets] [tickHz]" << std::endl;
+        return 1;
+    }
+
+    /// One shard thread and the gateway thread: the whole
+    /// district on one core.
+    HostConfig hostConfig = defaultHostConfig();
+    hostConfig.numShards = 1;
+    hostConfig.shardCapacity = numIntersections;
+    hostConfig.tickPeriod = std::chrono::microseconds(1000000 / tickHz);
+    hostConfig.transitionTable = true;
+    ControllerHost host(hostConfig);
+
+    GatewayConfig gatewayConfig = defaultGatewayConfig();
+    gatewayConfig.maxIntersections = numIntersections;
+    for (unsigned s = 0; s < numSockets; s++)
+    {
+        gatewayConfig.socketPaths.push_back(basePath + "." + std::to_string(s) + ".sock");
+    }
+    SensorGateway gateway(host, gatewayConfig);
+
+    for (std::uint32_t i = 0; i < numIntersections; i++)
+    {
+        gateway.route(i, host.addController());
+    }
+
+    std::string error;
+    if (!gateway.open(error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    std::cout << "Listening on " << basePath << ".{0.." << numSockets - 1 << "}.sock for "
+              << numIntersections << " intersections, ticking at " << tickHz << " Hz." << std::endl;
+    std::cout << "    time    frames/s  datagrams/call  ingress p50(us)  p99(us)  max(us)  cpu(%)" << std::endl;
+
+    host.start();
+    auto begin = std::chrono::steady_clock::now();
+    auto nextReport = begin + std::chrono::seconds(1);
+    GatewayStats last = gateway.stats();
+    double lastCpu = cpuSeconds();
+
+    while (!stopRequested)
+    {
+        gateway.poll(50);
+
+        auto now = std::chrono::steady_clock::now();
+        if (now < nextReport)
+        {
+            continue;
+        }
+
+        const GatewayStats &stats = gateway.stats();
+        const LatencyHistogram &latency = gateway.latency();
+        double cpu = cpuSeconds();
+        std::uint64_t calls = stats.calls - last.calls;
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(8) << std::chrono::duration<double>(now - begin).count()
+                  << std::setw(12) << stats.frames - last.frames
+                  << std::setw(16) << (calls ? static_cast<double>(stats.datagrams - last.datagrams) / calls : 0.0)
+                  << std::setw(17) << latency.percentile(0.50) / 1000.0
+                  << std::setw(9) << latency.percentile(0.99) / 1000.0
+                  << std::setw(9) << latency.max() / 1000.0
+                  << std::setw(8) << 100.0 * (cpu - lastCpu) << std::endl;
+        last = stats;
+        lastCpu = cpu;
+        nextReport += std::chrono::seconds(1);
+
+        if (seconds != 0 && now - begin >= std::chrono::seconds(seconds))
+        {
+            break;
+        }
+    }
+
+    host.stop();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    const GatewayStats &stats = gateway.stats();
+    ShardReport ticks = host.report(0);
+    std::cout << "Applied " << stats.frames << " frames from " << stats.datagrams << " datagrams in "
+              << stats.calls << " recvmmsg calls and " << stats.wakeups << " wakeups; dropped "
+              << stats.malformed << " malformed, " << stats.unrouted << " unrouted, "
+              << stats.stale << " stale." << std::endl;
+    std::cout << "Ticked " << ticks.controllers << " controllers " << ticks.ticks << " times, p99 "
+              << ticks.p99 / 1000.0 << " us, max " << ticks.max / 1000.0 << " us. Process used "
+              << 100.0 * cpuSeconds() / wall << "% of one core." << std::endl;
+
+    /// A frame waits in its slot for at most one tick period,
+    /// then for the tick that reads it to finish.
+    double boundMs = (gateway.latency().max() + ticks.max) / 1e6 + 1000.0 / tickHz;
+    std::cout << "Sensor to signal within " << std::setprecision(2) << boundMs << " ms (ingress max + tick period + tick max)." << std::endl;
+
+    return 0;
+}
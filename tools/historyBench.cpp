@@ -0,0 +1,148 @@
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/history/signalHistory.hpp"
+#include "impl/simulator/workload.hpp"
+#include "impl/util/latencyHistogram.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Get the nanoseconds since a time
+///
+////////////////////////////////////////////////////////////
+static std::uint64_t nanosSince(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    std::uint32_t numIntersections = argc > 1 ? static_cast<std::uint32_t>(std::atoi(argv[1])) : 300;
+    unsigned days = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 2;
+    unsigned numQueries = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 100000;
+
+    if (numIntersections == 0 || days == 0 || numQueries == 0)
+    {
+        std::cerr << "usage: historyBench [intersections] [days] [queries]" << std::endl;
+        return 1;
+    }
+
+    /// Controllers on the macro benchmark's city workload,
+    /// recorded every second.
+    Workload workload(defaultWorkloadConfig(numIntersections));
+    Clock clock;
+    std::vector<VehicleSensors> sensors(numIntersections);
+    std::vector<std::unique_ptr<TrafficLightControllerApp>> controllers;
+    for (std::uint32_t i = 0; i < numIntersections; i++)
+    {
+        controllers.emplace_back(new TrafficLightControllerApp(clock, sensors[i], DEFAULT_MAX_WAIT_TIME, nullptr));
+        controllers.back()->initApp();
+    }
+
+    SignalHistory history(numIntersections);
+    Clock::Time duration = Workload::DAY * static_cast<Clock::Time>(days);
+    std::uint64_t recordNanos = 0;
+    for (Clock::Time t = 0; t < duration; t++)
+    {
+        for (std::uint32_t i = 0; i < numIntersections; i++)
+        {
+            workload.sensors(i, t, sensors[i]);
+            controllers[i]->run();
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        for (std::uint32_t i = 0; i < numIntersections; i++)
+        {
+            history.record(i, t, controllers[i]->getSignals());
+        }
+        recordNanos += nanosSince(begin);
+        clock.advance(1);
+    }
+
+    SignalHistoryStats stats = history.stats();
+    double seconds = static_cast<double>(duration) * numIntersections;
+    double bytesPerDay = static_cast<double>(stats.codeBytes + stats.indexBytes) / numIntersections / days;
+
+    std::cout << numIntersections << " intersections, " << days << " days at 1s: " << stats.changes << " changes, "
+              << stats.states << " distinct states, " << stats.blocks << " blocks." << std::endl;
+    std::cout << std::fixed << std::setprecision(2)
+              << "encoded " << static_cast<double>(stats.codeBytes) / stats.changes << " B/change, index "
+              << static_cast<double>(stats.indexBytes) / stats.changes << " B/change, "
+              << std::setprecision(1) << bytesPerDay / 1024.0 << " KiB per intersection-day; heap "
+              << static_cast<double>(stats.heapBytes) / (1024.0 * 1024.0) << " MiB." << std::endl;
+    std::cout << "a year of 1000 intersections: "
+              << bytesPerDay * 365.0 * 1000.0 / (1024.0 * 1024.0 * 1024.0) << " GiB; recording "
+              << static_cast<double>(recordNanos) / seconds << " ns per intersection-second." << std::endl;
+
+    /// Point queries at random intersections and times.
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<std::uint32_t> anyIntersection(0, numIntersections - 1);
+    std::uniform_int_distribution<Clock::Time> anyTime(0, duration - 1);
+    LatencyHistogram point;
+    unsigned red = 0;
+    for (unsigned q = 0; q < numQueries; q++)
+    {
+        std::uint32_t i = anyIntersection(rng);
+        Clock::Time t = anyTime(rng);
+        TrafficSignals signals;
+        auto begin = std::chrono::steady_clock::now();
+        history.at(i, t, signals);
+        point.record(nanosSince(begin));
+        red += signals[Lane::W_S] == SignalState::RED;
+    }
+
+    /// One lane at one second across every intersection, the
+    /// operators' question.
+    LatencyHistogram city;
+    for (unsigned q = 0; q < 1000; q++)
+    {
+        Clock::Time t = anyTime(rng);
+        auto begin = std::chrono::steady_clock::now();
+        for (std::uint32_t i = 0; i < numIntersections; i++)
+        {
+            TrafficSignals signals;
+            history.at(i, t, signals);
+            red += signals[Lane::W_S] == SignalState::RED;
+        }
+        city.record(nanosSince(begin));
+    }
+
+    /// An hour of changes at one intersection.
+    LatencyHistogram hour;
+    std::vector<SignalChange> changes;
+    std::uint64_t hourChanges = 0;
+    for (unsigned q = 0; q < 10000; q++)
+    {
+        std::uint32_t i = anyIntersection(rng);
+        Clock::Time t = anyTime(rng);
+        changes.clear();
+        auto begin = std::chrono::steady_clock::now();
+        hourChanges += history.range(i, t, t + 3600, changes);
+        hour.record(nanosSince(begin));
+    }
+
+    std::cout << "query                          p50(us)   p99(us)   max(us)" << std::endl;
+    auto row = [](const char *name, const LatencyHistogram &latency) {
+        std::cout << std::left << std::setw(29) << name << std::right << std::setprecision(2)
+                  << std::setw(10) << latency.percentile(0.50) / 1000.0
+                  << std::setw(10) << latency.percentile(0.99) / 1000.0
+                  << std::setw(10) << latency.max() / 1000.0 << std::endl;
+    };
+    row("one intersection at a time", point);
+    row("lane W_S, every intersection", city);
+    row("one intersection, an hour", hour);
+    std::cout << std::setprecision(1) << static_cast<double>(hourChanges) / 10000.0 << " changes per hour; "
+              << red << " RED readings." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "impl/host/controllerHost.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Check no two crossing lanes are GREEN together.
+///
+////////////////////////////////////////////////////////////
+static bool isSafe(const TrafficSignals &signals)
+{
+    LaneMask green = 0;
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        if (signals[lane] == SignalState::GREEN)
+        {
+            green |= laneBit(lane);
+        }
+    }
+
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        if ((green & laneBit(lane)) && (OPPOSING_LANES[lane] & green))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    std::uint32_t numControllers = argc > 1 ? static_cast<std::uint32_t>(std::atoi(argv[1])) : 10000;
+    unsigned numShards = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 0;
+    std::uint64_t numTicks = argc > 3 ? static_cast<std::uint64_t>(std::atoll(argv[3])) : 2000;
+    bool conditionSensors = argc > 4 && std::atoi(argv[4]) != 0;
+    bool transitionTable = argc > 5 && std::atoi(argv[5]) != 0;
+
+    if (numShards == 0)
+    {
+        numShards = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /// Room for every controller plus some churn on each shard.
+    HostConfig config = defaultHostConfig();
+    config.numShards = numShards;
+    config.shardCapacity = (numControllers + numShards - 1) / numShards + 64;
+    config.tickPeriod = std::chrono::microseconds(0);
+    config.tickLimit = numTicks;
+    config.conditionSensors = conditionSensors;
+    config.transitionTable = transitionTable;
+
+    ControllerHost host(config);
+
+    std::vector<ControllerId> ids;
+    for (std::uint32_t i = 0; i < numControllers; i++)
+    {
+        ids.push_back(host.addController());
+    }
+
+    std::cout << numControllers << " controllers on " << host.numShards() << " shards, "
+              << numTicks << " ticks per shard"
+              << (conditionSensors ? ", sensors conditioned" : "")
+              << (transitionTable ? ", transition table" : "") << "." << std::endl;
+
+    auto begin = std::chrono::steady_clock::now();
+    host.start();
+
+    /// Feed random sensors and churn intersections while the
+    /// shards run, as a district's field gateway would.
+    std::mt19937 rng(7);
+    std::uint64_t added = 0;
+    std::uint64_t removed = 0;
+    for (int round = 0; round < 200; round++)
+    {
+        for (ControllerId id : ids)
+        {
+            host.setSensorMask(id, static_cast<SensorMask>(rng()));
+        }
+
+        std::size_t victim = rng() % ids.size();
+        if (host.removeController(ids[victim]))
+        {
+            removed++;
+        }
+        ids[victim] = host.addController();
+        added += ids[victim] != INVALID_CONTROLLER;
+
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+
+    host.wait();
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << "shard  core  controllers    ticks   p50(us)   p99(us)   max(us)" << std::endl;
+
+    std::uint64_t controllerTicks = 0;
+    for (unsigned shard = 0; shard < host.numShards(); shard++)
+    {
+        ShardReport report = host.report(shard);
+        controllerTicks += static_cast<std::uint64_t>(report.controllers) * report.ticks;
+
+        std::cout << std::setw(5) << report.shard
+                  << std::setw(6) << report.core
+                  << std::setw(13) << report.controllers
+                  << std::setw(9) << report.ticks
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << report.p50 / 1000.0
+                  << std::setw(10) << report.p99 / 1000.0
+                  << std::setw(10) << report.max / 1000.0 << std::endl;
+    }
+
+    unsigned unsafe = 0;
+    for (ControllerId id : ids)
+    {
+        unsafe += !isSafe(host.signals(id));
+    }
+
+    double wall = std::chrono::duration<double>(end - begin).count();
+    std::cout << "Churned " << removed << " removes and " << added << " adds. "
+              << std::setprecision(0) << controllerTicks / wall << " controller-ticks/s." << std::endl;
+
+    if (unsafe)
+    {
+        std::cout << unsafe << " controllers show conflicting greens." << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,244 @@
+#include "impl/host/controllerHost.hpp"
+#include "impl/simulator/workload.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+/// Version of the JSON report; bump when a field changes meaning
+static constexpr unsigned REPORT_VERSION = 1;
+
+////////////////////////////////////////////////////////////
+///  @brief Feeds each hosted controller the Workload
+///  intersection it was added for, so the traffic does not
+///  depend on how controllers land on shards.
+///
+////////////////////////////////////////////////////////////
+class HostedWorkload : public ISensorFeed
+{
+public:
+    HostedWorkload(const Workload &workload, std::size_t numSlots)
+        : workload_(workload),
+          intersections_(numSlots, 0)
+    {
+    }
+
+    inline void place(ControllerId id, std::uint32_t intersection)
+    {
+        intersections_[id] = intersection;
+    }
+
+    std::uint8_t sensorMask(std::uint32_t id, IClock::Time now) const override
+    {
+        return workload_.sensorMask(intersections_[id], now);
+    }
+
+private:
+    const Workload &workload_;                 ///< traffic to feed
+    std::vector<std::uint32_t> intersections_; ///< Workload intersection of each controller id
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Forget the peak resident set size so far, where
+///  the kernel allows it.
+///
+////////////////////////////////////////////////////////////
+static void resetPeakRss()
+{
+#if defined(__linux__)
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+#endif
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Get the peak resident set size
+///
+///  @return std::uint64_t Peak since the last reset, KiB
+////////////////////////////////////////////////////////////
+static std::uint64_t peakRssKiB()
+{
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            return std::strtoull(line.c_str() + 6, nullptr, 10);
+        }
+    }
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<std::uint64_t>(usage.ru_maxrss);
+#else
+    return 0;
+#endif
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Outcome of one run
+///
+////////////////////////////////////////////////////////////
+struct MacroResult
+{
+    std::uint32_t intersections;   ///< controllers run
+    unsigned shards;               ///< shard threads
+    std::uint64_t ticks;           ///< ticks per controller
+    double wallSeconds;            ///< start to the last shard's tick limit
+    double throughput;             ///< intersection-ticks per second
+    std::uint64_t peakRssKiB;      ///< peak resident set of the run
+    std::uint64_t tickP50;         ///< worst shard's median tick, ns
+    std::uint64_t tickP99;         ///< worst shard's 99th percentile tick, ns
+    std::uint64_t tickP999;        ///< worst shard's 99.9th percentile tick, ns
+    std::uint64_t tickMax;         ///< worst tick of any shard, ns
+    std::uint64_t signalDigest;    ///< hash of every controller's final signals
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Run one city for a span of 1 second ticks
+///
+///  @param intersections Controllers to host
+///  @param seconds Ticks to run
+///  @param shards Shard threads, 0 for one per core
+///  @param seed Workload seed
+///  @return MacroResult The run's measurements
+////////////////////////////////////////////////////////////
+static MacroResult runCity(std::uint32_t intersections, std::uint64_t seconds, unsigned shards, unsigned seed)
+{
+    resetPeakRss();
+
+    WorkloadConfig shape = defaultWorkloadConfig(intersections);
+    shape.seed = seed;
+    Workload workload(shape);
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    HostConfig config = defaultHostConfig();
+    config.numShards = std::max(1u, std::min<unsigned>(shards ? shards : cores, intersections));
+    config.shardCapacity = (intersections + config.numShards - 1) / config.numShards;
+    config.tickPeriod = std::chrono::microseconds(0);
+    config.tickLimit = seconds;
+    config.timeStep = 1;
+
+    HostedWorkload feed(workload, static_cast<std::size_t>(config.numShards) * config.shardCapacity);
+    config.sensorFeed = &feed;
+
+    ControllerHost host(config);
+    std::vector<ControllerId> ids;
+    for (std::uint32_t i = 0; i < intersections; i++)
+    {
+        ids.push_back(host.addController());
+        feed.place(ids.back(), i);
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    host.start();
+    host.wait();
+    auto end = std::chrono::steady_clock::now();
+
+    MacroResult result = {};
+    result.intersections = intersections;
+    result.shards = host.numShards();
+    result.ticks = seconds;
+    result.wallSeconds = std::chrono::duration<double>(end - begin).count();
+    result.throughput = static_cast<double>(intersections) * static_cast<double>(seconds) / result.wallSeconds;
+    result.peakRssKiB = peakRssKiB();
+    for (unsigned shard = 0; shard < host.numShards(); shard++)
+    {
+        ShardReport report = host.report(shard);
+        result.tickP50 = std::max(result.tickP50, report.p50);
+        result.tickP99 = std::max(result.tickP99, report.p99);
+        result.tickP999 = std::max(result.tickP999, report.p999);
+        result.tickMax = std::max(result.tickMax, report.max);
+    }
+
+    /// FNV-1a over the signals in intersection order, the same
+    /// for any number of shards.
+    result.signalDigest = 14695981039346656037ull;
+    for (ControllerId id : ids)
+    {
+        for (SignalState signal : host.signals(id))
+        {
+            result.signalDigest = (result.signalDigest ^ static_cast<std::uint64_t>(signal)) * 1099511628211ull;
+        }
+    }
+    return result;
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    std::string sizes = argc > 1 ? argv[1] : "1,100,10000";
+    std::uint64_t seconds = argc > 2 ? static_cast<std::uint64_t>(std::atoll(argv[2])) : Workload::DAY;
+    unsigned shards = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 0;
+    unsigned seed = argc > 4 ? static_cast<unsigned>(std::atoi(argv[4])) : 1;
+
+    std::vector<std::uint32_t> cities;
+    std::stringstream list(sizes);
+    std::string size;
+    while (std::getline(list, size, ','))
+    {
+        cities.push_back(static_cast<std::uint32_t>(std::atoi(size.c_str())));
+    }
+
+    if (cities.empty() || std::count(cities.begin(), cities.end(), 0u) || seconds == 0)
+    {
+        std::cerr << "usage: macroBench [intersections,...] [seconds] [shards] [seed]" << std::endl;
+        return 1;
+    }
+
+    /// Progress goes to stderr so stdout is only the report.
+    std::vector<MacroResult> results;
+    for (std::uint32_t intersections : cities)
+    {
+        std::cerr << intersections << " intersections for " << seconds << "s... " << std::flush;
+        results.push_back(runCity(intersections, seconds, shards, seed));
+        std::cerr << std::fixed << std::setprecision(1) << results.back().wallSeconds << "s" << std::endl;
+    }
+
+    std::cout << "{\n"
+              << "  \"benchmark\": \"macroBench\",\n"
+              << "  \"version\": " << REPORT_VERSION << ",\n"
+              << "  \"seconds\": " << seconds << ",\n"
+              << "  \"seed\": " << seed << ",\n"
+              << "  \"runs\": [\n";
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        const MacroResult &r = results[i];
+        std::cout << "    {"
+                  << "\"intersections\": " << r.intersections
+                  << ", \"shards\": " << r.shards
+                  << ", \"ticks\": " << r.ticks
+                  << std::fixed << std::setprecision(3)
+                  << ", \"wallSeconds\": " << r.wallSeconds
+                  << std::setprecision(0)
+                  << ", \"intersectionTicksPerSecond\": " << r.throughput
+                  << ", \"peakRssKiB\": " << r.peakRssKiB
+                  << ", \"tickP50Ns\": " << r.tickP50
+                  << ", \"tickP99Ns\": " << r.tickP99
+                  << ", \"tickP999Ns\": " << r.tickP999
+                  << ", \"tickMaxNs\": " << r.tickMax
+                  << ", \"signalDigest\": \"" << std::hex << std::setw(16) << std::setfill('0') << r.signalDigest
+                  << std::dec << std::setfill(' ') << "\""
+                  << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n}" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/simulator/microSimulator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+static constexpr float APPROACH_LENGTH = 250.0f; ///< block length in metres
+static constexpr float THROUGH_DEMAND = 700.0f;  ///< vehicles per hour entering the arterial
+static constexpr float SIDE_DEMAND = 300.0f;     ///< vehicles per hour on each cross street
+static constexpr float TURN_DEMAND = 120.0f;     ///< vehicles per hour on each turning lane
+
+////////////////////////////////////////////////////////////
+///  @brief Build an east-west arterial of signalled
+///  intersections. Through traffic on the arterial runs the
+///  whole corridor; cross streets and turns leave after one
+///  intersection.
+///
+////////////////////////////////////////////////////////////
+static void makeCorridor(MicroSimulator &simulator, IntersectionId numIntersections)
+{
+    for (IntersectionId i = 0; i < numIntersections; i++)
+    {
+        if (i + 1 < numIntersections)
+        {
+            simulator.link(i, Lane::E_E, i + 1, Lane::E_E);
+            simulator.link(i + 1, Lane::W_W, i, Lane::W_W);
+        }
+
+        simulator.setDemand(i, Lane::N_N, SIDE_DEMAND);
+        simulator.setDemand(i, Lane::S_S, SIDE_DEMAND);
+        simulator.setDemand(i, Lane::N_W, TURN_DEMAND);
+        simulator.setDemand(i, Lane::S_E, TURN_DEMAND);
+        simulator.setDemand(i, Lane::E_N, TURN_DEMAND);
+        simulator.setDemand(i, Lane::W_S, TURN_DEMAND);
+    }
+
+    simulator.setDemand(0, Lane::E_E, THROUGH_DEMAND);
+    simulator.setDemand(numIntersections - 1, Lane::W_W, THROUGH_DEMAND);
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    int intersectionsArg = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int durationArg = argc > 2 ? std::atoi(argv[2]) : 1800;
+    int substepsArg = argc > 3 ? std::atoi(argv[3]) : 10;
+    if (intersectionsArg < 1 || durationArg < 1 || substepsArg < 1)
+    {
+        std::cerr << "usage: microBench [intersections] [seconds] [substepsPerSecond]" << std::endl;
+        return 1;
+    }
+    IntersectionId numIntersections = static_cast<IntersectionId>(intersectionsArg);
+    Clock::Time duration = static_cast<Clock::Time>(durationArg);
+    unsigned substepsPerSecond = static_cast<unsigned>(substepsArg);
+
+    MicroSimulator simulator(numIntersections, APPROACH_LENGTH, defaultIdmParameters(), substepsPerSecond);
+    makeCorridor(simulator, numIntersections);
+
+    std::vector<std::unique_ptr<TrafficLightControllerApp>> controllers;
+    for (IntersectionId i = 0; i < numIntersections; i++)
+    {
+        controllers.emplace_back(new TrafficLightControllerApp(simulator.clock(), simulator.sensors(i),
+                                                               DEFAULT_MAX_WAIT_TIME, nullptr));
+        controllers.back()->initApp();
+    }
+
+    std::cout << "Corridor of " << numIntersections << " intersections, " << duration << "s at "
+              << substepsPerSecond << " Hz." << std::endl;
+    std::cout << "  time  vehicles  queued(E_E)  discharged  spillback  realtime-x" << std::endl;
+
+    double simulating = 0.0;
+    std::size_t peakVehicles = 0;
+    auto begin = std::chrono::steady_clock::now();
+
+    for (Clock::Time t = 0; t < duration; t++)
+    {
+        for (IntersectionId i = 0; i < numIntersections; i++)
+        {
+            controllers[i]->run();
+            simulator.setSignals(i, controllers[i]->getSignals());
+        }
+
+        auto stepBegin = std::chrono::steady_clock::now();
+        simulator.advance(1);
+        simulating += std::chrono::duration<double>(std::chrono::steady_clock::now() - stepBegin).count();
+
+        peakVehicles = std::max(peakVehicles, simulator.vehicleCount());
+
+        if ((t + 1) % 300 == 0 || t + 1 == duration)
+        {
+            std::uint32_t queued = 0;
+            for (IntersectionId i = 0; i < numIntersections; i++)
+            {
+                queued += simulator.queueLength(i, Lane::E_E);
+            }
+
+            double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            const MicroStats &stats = simulator.stats();
+            std::cout << std::setw(6) << simulator.clock().now()
+                      << std::setw(10) << simulator.vehicleCount()
+                      << std::setw(13) << queued
+                      << std::setw(12) << stats.vehiclesDischarged
+                      << std::setw(11) << stats.spillbackSteps
+                      << std::setw(12) << std::fixed << std::setprecision(1) << simulator.clock().now() / wall
+                      << std::endl;
+        }
+    }
+
+    const MicroStats &stats = simulator.stats();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "Peak " << peakVehicles << " vehicles, " << std::setprecision(0)
+              << stats.vehicleUpdates / simulating << " vehicle-updates/s in the simulator, "
+              << std::setprecision(1) << duration / wall << "x real time overall." << std::endl;
+    std::cout << "Mean delay " << std::setprecision(1)
+              << (stats.vehiclesExited ? stats.delay / static_cast<double>(stats.vehiclesExited) : 0.0)
+              << "s per exited vehicle." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "impl/policy/mpcPolicy.hpp"
+#include "impl/replay/replay.hpp"
+#include "impl/simulator/scenarios.hpp"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+static void report(const std::string &name, const Scenario &scenario, const MpcConfig &config)
+{
+    ReplayResult rules = replayController(scenario, config.timeStep);
+
+    MpcPolicy policy(config);
+    ReplayResult mpc = replayController(scenario, config.timeStep, defaultTimingConfig(), &policy);
+
+    double gain = rules.metrics.totalWait
+                ? 100.0 * (rules.metrics.totalWait - mpc.metrics.totalWait) / rules.metrics.totalWait : 0.0;
+    const MpcStats &stats = policy.stats();
+
+    std::cout << std::left << std::setw(12) << name << std::right
+              << std::setw(10) << rules.metrics.totalWait
+              << std::setw(10) << mpc.metrics.totalWait
+              << std::setw(9) << std::fixed << std::setprecision(1) << gain
+              << std::setw(8) << rules.metrics.maxWait
+              << std::setw(8) << mpc.metrics.maxWait
+              << std::setw(10) << stats.searches
+              << std::setw(10) << stats.overruns
+              << std::setw(10) << std::setprecision(1) << policy.latency().percentile(0.50) / 1000.0
+              << std::setw(10) << policy.latency().percentile(0.99) / 1000.0
+              << std::setw(10) << policy.latency().max() / 1000.0
+              << std::endl;
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    MpcConfig config = defaultMpcConfig();
+    config.candidates = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : config.candidates;
+    config.samples = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : config.samples;
+    config.horizon = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : config.horizon;
+    config.workers = argc > 4 ? static_cast<unsigned>(std::atoi(argv[4])) : config.workers;
+
+    std::cout << "MPC with " << config.candidates << " choices x " << config.samples << " futures x "
+              << config.horizon << " steps, " << config.workers << " extra workers, "
+              << config.budget.count() << "us budget." << std::endl;
+    std::cout << "Total wait is lane-seconds with a SET sensor at a non-GREEN signal." << std::endl;
+    std::cout << "scenario         rules       mpc  gain(%)  maxW-r  maxW-m  searches  overruns   p50(us)   p99(us)   max(us)" << std::endl;
+
+    report("SCENARIO_1", SCENARIO_1, config);
+    report("SCENARIO_2", SCENARIO_2, config);
+    report("SCENARIO_3", SCENARIO_3, config);
+    report("SCENARIO_4", SCENARIO_4, config);
+    report("day", makeDayScenario(1), config);
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "impl/simulator/networkSimulator.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+using SS = SensorState;
+
+static constexpr Clock::Time TIME_STEP = 1; ///< one controller tick per second
+static constexpr Clock::Time LINK_TRAVEL_TIME = 30; ///< block length in seconds
+
+////////////////////////////////////////////////////////////
+///  @brief Build a rows x cols grid where every lane feeds
+///  the neighbouring intersection in its exit direction.
+///
+////////////////////////////////////////////////////////////
+static std::vector<NetworkLink> makeGrid(unsigned rows, unsigned cols)
+{
+    std::vector<NetworkLink> links;
+    auto id = [cols](unsigned r, unsigned c) { return static_cast<IntersectionId>(r * cols + c); };
+
+    for (unsigned r = 0; r < rows; r++)
+    {
+        for (unsigned c = 0; c < cols; c++)
+        {
+            if (r > 0)
+            {
+                links.push_back({id(r, c), Lane::N_N, id(r - 1, c), Lane::N_N, LINK_TRAVEL_TIME});
+                links.push_back({id(r, c), Lane::E_N, id(r - 1, c), Lane::N_N, LINK_TRAVEL_TIME});
+            }
+            if (r + 1 < rows)
+            {
+                links.push_back({id(r, c), Lane::S_S, id(r + 1, c), Lane::S_S, LINK_TRAVEL_TIME});
+                links.push_back({id(r, c), Lane::W_S, id(r + 1, c), Lane::S_S, LINK_TRAVEL_TIME});
+            }
+            if (c + 1 < cols)
+            {
+                links.push_back({id(r, c), Lane::E_E, id(r, c + 1), Lane::E_E, LINK_TRAVEL_TIME});
+                links.push_back({id(r, c), Lane::S_E, id(r, c + 1), Lane::E_E, LINK_TRAVEL_TIME});
+            }
+            if (c > 0)
+            {
+                links.push_back({id(r, c), Lane::W_W, id(r, c - 1), Lane::W_W, LINK_TRAVEL_TIME});
+                links.push_back({id(r, c), Lane::N_W, id(r, c - 1), Lane::W_W, LINK_TRAVEL_TIME});
+            }
+        }
+    }
+
+    return links;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Pulsed turning demand at every intersection, and
+///  through demand entering at the edges of the grid.
+///
+////////////////////////////////////////////////////////////
+static Scenario makeBoundaryDemand(unsigned r, unsigned c, unsigned rows, unsigned cols, Clock::Time duration)
+{
+    Scenario scenario;
+    Clock::Time period = 90;
+    Clock::Time offset = static_cast<Clock::Time>((r * 7 + c * 13) % period);
+
+    VehicleSensors busy;
+    busy.fill(SS::CLEAR);
+    busy[Lane::N_W] = busy[Lane::S_E] = busy[Lane::E_N] = busy[Lane::W_S] = SS::SET;
+    busy[Lane::S_S] = (r == 0) ? SS::SET : SS::CLEAR;
+    busy[Lane::N_N] = (r + 1 == rows) ? SS::SET : SS::CLEAR;
+    busy[Lane::E_E] = (c == 0) ? SS::SET : SS::CLEAR;
+    busy[Lane::W_W] = (c + 1 == cols) ? SS::SET : SS::CLEAR;
+
+    VehicleSensors quiet;
+    quiet.fill(SS::CLEAR);
+
+    for (Clock::Time t = 0; t < duration; t += period)
+    {
+        Clock::Time pulse = t + offset;
+        scenario.push_back({t, pulse, quiet});
+        scenario.push_back({pulse, pulse + 30, busy});
+        scenario.push_back({pulse + 30, t + period, quiet});
+    }
+
+    return scenario;
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    unsigned rows = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : 32;
+    unsigned cols = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 32;
+    Clock::Time duration = argc > 3 ? static_cast<Clock::Time>(std::atoi(argv[3])) : 3600;
+    unsigned maxThreads = argc > 4 ? static_cast<unsigned>(std::atoi(argv[4]))
+                                   : std::max(1u, std::thread::hardware_concurrency());
+
+    auto links = makeGrid(rows, cols);
+    std::size_t numIntersections = static_cast<std::size_t>(rows) * cols;
+
+    std::cout << "Network of " << numIntersections << " intersections, " << links.size()
+              << " links, " << duration << "s simulated." << std::endl;
+    std::cout << "threads  window(s)  wall(ms)  intersection-ticks/s  speedup  discharged  cross-partition" << std::endl;
+
+    double baseline = 0.0;
+    NetworkStats reference = {};
+
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        NetworkSimulator network(numIntersections, links, threads, TIME_STEP, 40);
+        for (unsigned r = 0; r < rows; r++)
+        {
+            for (unsigned c = 0; c < cols; c++)
+            {
+                network.setBoundaryDemand(r * cols + c, makeBoundaryDemand(r, c, rows, cols, duration));
+            }
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        network.run(duration);
+        auto end = std::chrono::steady_clock::now();
+
+        double wall = std::chrono::duration<double>(end - begin).count();
+        double rate = static_cast<double>(numIntersections) * (duration / TIME_STEP) / wall;
+        NetworkStats stats = network.stats();
+
+        if (threads == 1)
+        {
+            baseline = wall;
+            reference = stats;
+        }
+
+        bool matches = stats.vehiclesDischarged == reference.vehiclesDischarged &&
+                       stats.vehiclesDelivered == reference.vehiclesDelivered &&
+                       stats.queuedVehicleTime == reference.queuedVehicleTime;
+
+        std::cout << std::setw(7) << threads
+                  << std::setw(11) << network.window()
+                  << std::setw(10) << std::fixed << std::setprecision(1) << wall * 1000.0
+                  << std::setw(22) << std::setprecision(0) << rate
+                  << std::setw(9) << std::setprecision(2) << baseline / wall
+                  << std::setw(12) << stats.vehiclesDischarged
+                  << std::setw(17) << stats.crossPartitionVehicles
+                  << (matches ? "" : "  MISMATCH") << std::endl;
+
+        if (!matches)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "impl/replay/replay.hpp"
+#include "impl/simulator/scenarios.hpp"
+#include "impl/solver/scheduleSolver.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+static void report(const std::string &name, const Scenario &scenario, Clock::Time timeStep)
+{
+    ReplayResult controller = replayController(scenario, timeStep);
+
+    ScheduleSolver solver(defaultTimingConfig(), timeStep);
+    SensorTimeline timeline = sampleScenario(scenario, timeStep);
+    SolverStats stats;
+
+    auto begin = std::chrono::steady_clock::now();
+    PatternSchedule oracle = solver.solve(timeline, &stats);
+    auto end = std::chrono::steady_clock::now();
+
+    ReplayMetrics best = scoreSchedule(timeline, oracle, timeStep);
+    double gap = best.totalWait ? 100.0 * (controller.metrics.totalWait - best.totalWait) / best.totalWait : 0.0;
+    double pruned = stats.statesExpanded + stats.statesPruned
+                  ? 100.0 * stats.statesPruned / (stats.statesExpanded + stats.statesPruned) : 0.0;
+
+    std::cout << std::left << std::setw(12) << name << std::right
+              << std::setw(5) << timeStep
+              << std::setw(8) << timeline.size()
+              << std::setw(13) << controller.metrics.totalWait
+              << std::setw(11) << best.totalWait
+              << std::setw(9) << std::fixed << std::setprecision(1) << gap
+              << std::setw(8) << controller.metrics.maxWait
+              << std::setw(8) << best.maxWait
+              << std::setw(10) << std::setprecision(2)
+              << std::chrono::duration<double, std::milli>(end - begin).count()
+              << std::setw(9) << std::setprecision(1) << pruned
+              << (solver.isFeasible(controller.schedule, timeline) ? "" : "  (controller rested past max on a stale flag)")
+              << std::endl;
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    Clock::Time timeStep = argc > 1 ? static_cast<Clock::Time>(std::atoi(argv[1])) : 1;
+
+    std::cout << "Total wait is lane-seconds with a SET sensor at a non-GREEN signal." << std::endl;
+    std::cout << "scenario    step   steps  controller    oracle   gap(%)  maxW-c  maxW-o  solve(ms)  pruned(%)" << std::endl;
+
+    report("SCENARIO_1", SCENARIO_1, timeStep);
+    report("SCENARIO_2", SCENARIO_2, timeStep);
+    report("SCENARIO_3", SCENARIO_3, timeStep);
+    report("SCENARIO_4", SCENARIO_4, timeStep);
+    report("day", makeDayScenario(1), timeStep);
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "impl/replay/replay.hpp"
+#include "impl/simulator/scenarios.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+////////////////////////////////////////////////////////////
+///  @brief Get the seconds a replay takes
+///
+////////////////////////////////////////////////////////////
+template <typename Replay>
+static double timeReplay(Replay &replay, ReplayResult &result)
+{
+    auto begin = std::chrono::steady_clock::now();
+    result = replay();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    int numThreads = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(hardware);
+    int numDays = argc > 2 ? std::atoi(argv[2]) : 7;
+    if (numThreads < 1 || numDays < 1)
+    {
+        std::cerr << "usage: parallelReplayBench [threads] [days]" << std::endl;
+        return 1;
+    }
+
+    /// A different day of the city each day of the run
+    Scenario scenario;
+    for (int day = 0; day < numDays; day++)
+    {
+        for (SimulationTimeslice slice : makeDayScenario(static_cast<unsigned>(day + 1)))
+        {
+            slice.start += day * 86400;
+            slice.end += day * 86400;
+            scenario.push_back(slice);
+        }
+    }
+
+    TimingConfig timing = defaultTimingConfig();
+    WorkerPool pool(static_cast<unsigned>(numThreads - 1));
+    ParallelReplayStats stats;
+
+    ReplayResult stepped;
+    ReplayResult parallel;
+    auto runStepped = [&]() { return replayController(scenario, 1, timing, nullptr, false); };
+    auto runParallel = [&]() { return replayControllerParallel(scenario, 1, pool, timing, &stats); };
+    double steppedSeconds = timeReplay(runStepped, stepped);
+    double parallelSeconds = timeReplay(runParallel, parallel);
+
+    /// The wall time the split would take with a core per
+    /// thread: the speculative runs side by side, then the
+    /// fix-up one segment after another.
+    double steps = static_cast<double>(stats.steps);
+    double span = static_cast<double>(stats.parallelSteps) / pool.size() + static_cast<double>(stats.fixupSteps);
+
+    std::cout << numDays << " days, " << pool.size() << " threads on " << hardware << " cores: "
+              << stats.segments << " segments, " << stats.converged << " predicted right." << std::endl;
+    std::cout << std::fixed << std::setprecision(1)
+              << "stepped " << steppedSeconds * 1000.0 << " ms, parallel " << parallelSeconds * 1000.0 << " ms ("
+              << std::setprecision(2) << steppedSeconds / parallelSeconds << "x); schedules "
+              << (parallel.schedule == stepped.schedule ? "identical" : "DIFFER") << "." << std::endl;
+    std::cout << std::setprecision(1)
+              << "work " << 100.0 * static_cast<double>(stats.parallelSteps) / steps << "% of the steps in parallel, "
+              << 100.0 * static_cast<double>(stats.fixupSteps) / steps << "% run again; "
+              << std::setprecision(2) << steps / span << "x bound with a core per thread." << std::endl;
+
+    return parallel.schedule == stepped.schedule ? 0 : 1;
+}
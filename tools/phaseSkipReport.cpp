@@ -0,0 +1,146 @@
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/config/configManager.hpp"
+#include "impl/replay/replay.hpp"
+#include "impl/simulator/microSimulator.hpp"
+#include "impl/simulator/scenarios.hpp"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+static constexpr float APPROACH_LENGTH = 250.0f; ///< block length in metres
+
+////////////////////////////////////////////////////////////
+///  @brief Get the reduction from one value to another
+///
+///  @return double Percent of before saved, 0 when before is 0
+////////////////////////////////////////////////////////////
+static double gain(double before, double after)
+{
+    return before != 0.0 ? 100.0 * (before - after) / before : 0.0;
+}
+
+static void reportReplay(const std::string &name, const Scenario &scenario)
+{
+    TimingConfig skipping = defaultTimingConfig();
+    skipping.skipUncalled = true;
+
+    ReplayResult cycle = replayController(scenario, 1);
+    ReplayResult skip = replayController(scenario, 1, skipping);
+
+    std::cout << std::left << std::setw(12) << name << std::right
+              << std::setw(10) << cycle.metrics.totalWait
+              << std::setw(10) << skip.metrics.totalWait
+              << std::setw(9) << std::fixed << std::setprecision(1)
+              << gain(static_cast<double>(cycle.metrics.totalWait), static_cast<double>(skip.metrics.totalWait))
+              << std::setw(8) << cycle.metrics.maxWait
+              << std::setw(8) << skip.metrics.maxWait
+              << std::setw(10) << cycle.metrics.patternChanges
+              << std::setw(10) << skip.metrics.patternChanges
+              << std::endl;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Outcome of one closed-loop run
+///
+////////////////////////////////////////////////////////////
+struct ServedResult
+{
+    double perHour;   ///< vehicles that left the intersection per hour
+    double meanDelay; ///< delay per exited vehicle (s)
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Run one intersection of real vehicles under a
+///  fixed demand.
+///
+///  @param through Vehicles per hour on each through lane
+///  @param cross Vehicles per hour on each cross-street lane
+///  @param turn Vehicles per hour on each turning lane
+///  @param duration Seconds to run
+///  @param skipUncalled Skip patterns with no call
+///  @return ServedResult Throughput and delay
+////////////////////////////////////////////////////////////
+static ServedResult runIntersection(float through, float cross, float turn, Clock::Time duration, bool skipUncalled)
+{
+    MicroSimulator simulator(1, APPROACH_LENGTH);
+    simulator.setDemand(0, Lane::E_E, through);
+    simulator.setDemand(0, Lane::W_W, through);
+    simulator.setDemand(0, Lane::N_N, cross);
+    simulator.setDemand(0, Lane::S_S, cross);
+    simulator.setDemand(0, Lane::N_W, turn);
+    simulator.setDemand(0, Lane::S_E, turn);
+    simulator.setDemand(0, Lane::E_N, turn);
+    simulator.setDemand(0, Lane::W_S, turn);
+
+    TimingConfig timing = defaultTimingConfig();
+    timing.skipUncalled = skipUncalled;
+    ConfigManager config(timing, nullptr);
+    ConfigManager::ReaderId reader = config.registerReader();
+
+    TrafficLightControllerApp tlcApp(simulator.clock(), simulator.sensors(0), timing.maxWaitTime, nullptr);
+    tlcApp.attachConfig(config, reader);
+    tlcApp.initApp();
+
+    for (Clock::Time t = 0; t < duration; t++)
+    {
+        tlcApp.run();
+        simulator.setSignals(0, tlcApp.getSignals());
+        simulator.advance(1);
+    }
+    config.unregisterReader(reader);
+
+    const MicroStats &stats = simulator.stats();
+    ServedResult result;
+    result.perHour = static_cast<double>(stats.vehiclesExited) * 3600.0 / static_cast<double>(duration);
+    result.meanDelay = stats.vehiclesExited ? stats.delay / static_cast<double>(stats.vehiclesExited) : 0.0;
+    return result;
+}
+
+static void reportServed(const std::string &name, float through, float cross, float turn, Clock::Time duration)
+{
+    ServedResult cycle = runIntersection(through, cross, turn, duration, false);
+    ServedResult skip = runIntersection(through, cross, turn, duration, true);
+
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(10) << cycle.perHour
+              << std::setw(10) << skip.perHour
+              << std::setw(9) << std::setprecision(1) << 0.0 - gain(cycle.perHour, skip.perHour)
+              << std::setw(10) << cycle.meanDelay
+              << std::setw(10) << skip.meanDelay
+              << std::setw(9) << gain(cycle.meanDelay, skip.meanDelay)
+              << std::endl;
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    Clock::Time duration = argc > 1 ? static_cast<Clock::Time>(std::atoi(argv[1])) : 4 * 3600;
+    if (duration <= 0)
+    {
+        std::cerr << "usage: phaseSkipReport [seconds]" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Replays: total wait is lane-seconds with a SET sensor at a non-GREEN signal." << std::endl;
+    std::cout << "scenario         cycle      skip  gain(%)  maxW-c  maxW-s  changes-c changes-s" << std::endl;
+    reportReplay("SCENARIO_1", SCENARIO_1);
+    reportReplay("SCENARIO_2", SCENARIO_2);
+    reportReplay("SCENARIO_3", SCENARIO_3);
+    reportReplay("SCENARIO_4", SCENARIO_4);
+    reportReplay("day", makeDayScenario(1));
+
+    std::cout << std::endl << "One intersection of vehicles for " << duration << "s: vehicles served per hour "
+              << "and delay per vehicle (s)." << std::endl;
+    std::cout << "demand       veh/h-c   veh/h-s  gain(%)   delay-c   delay-s  gain(%)" << std::endl;
+    reportServed("balanced", 300.0f, 300.0f, 120.0f, duration);
+    reportServed("arterial", 700.0f, 120.0f, 40.0f, duration);
+    reportServed("few turns", 500.0f, 300.0f, 15.0f, duration);
+    reportServed("night", 80.0f, 40.0f, 10.0f, duration);
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/replay/pipeline.hpp"
+#include "impl/simulator/scenarios.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <thread>
+
+////////////////////////////////////////////////////////////
+///  @brief Stream buffer that keeps only a hash of what is
+///  written, so output costs its formatting and nothing more.
+///
+////////////////////////////////////////////////////////////
+class HashBuffer : public std::streambuf
+{
+public:
+    std::uint64_t hash = 0xCBF29CE484222325ull; ///< FNV-1a of every character written
+
+protected:
+    int overflow(int c) override
+    {
+        if (c != traits_type::eof())
+        {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ull;
+        }
+        return c;
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        for (std::streamsize i = 0; i < n; i++)
+        {
+            overflow(s[i]);
+        }
+        return n;
+    }
+};
+
+/// Seconds since a start time
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Run the serial loop the app used to run.
+///
+///  @param stageSeconds Time spent in the simulator, the
+///  controller and the output, in that order, nullptr to not
+///  time them
+///  @return std::size_t Ticks run
+////////////////////////////////////////////////////////////
+static std::size_t runSerial(const Scenario &scenario, Clock::Time timeStep, ConfigManager &config,
+                             ConfigManager::ReaderId reader, std::ostream &out, double *stageSeconds)
+{
+    Simulator simulator(scenario);
+    TrafficLightControllerApp tlcApp(simulator.clock(), simulator.sensors(), config.read().maxWaitTime, &out);
+    tlcApp.attachConfig(config, reader);
+    tlcApp.initApp();
+    out << simulator.BANNER << std::endl;
+
+    std::size_t ticks = 0;
+    auto begin = std::chrono::steady_clock::now();
+    while (!simulator.done())
+    {
+        if (stageSeconds)
+        {
+            begin = std::chrono::steady_clock::now();
+        }
+        tlcApp.run();
+        simulator.update_lane_signals(tlcApp.getSignals());
+        if (stageSeconds)
+        {
+            stageSeconds[1] += secondsSince(begin);
+            begin = std::chrono::steady_clock::now();
+        }
+
+        out << simulator << std::endl;
+        if (stageSeconds)
+        {
+            stageSeconds[2] += secondsSince(begin);
+            begin = std::chrono::steady_clock::now();
+        }
+
+        simulator.advance(timeStep);
+        if (stageSeconds)
+        {
+            stageSeconds[0] += secondsSince(begin);
+        }
+        ticks++;
+    }
+    return ticks;
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    int numDays = argc > 1 ? std::atoi(argv[1]) : 1;
+    Clock::Time timeStep = argc > 2 ? static_cast<Clock::Time>(std::atoi(argv[2])) : 1;
+    if (numDays < 1 || timeStep < 1)
+    {
+        std::cerr << "usage: pipelineBench [days] [timeStep]" << std::endl;
+        return 1;
+    }
+
+    Scenario scenario;
+    for (int day = 0; day < numDays; day++)
+    {
+        for (SimulationTimeslice slice : makeDayScenario(static_cast<unsigned>(day + 1)))
+        {
+            slice.start += day * 86400;
+            slice.end += day * 86400;
+            scenario.push_back(slice);
+        }
+    }
+
+    ConfigManager config;
+    ConfigManager::ReaderId reader = config.registerReader();
+
+    /// The serial loop as a whole, then a stage at a time.
+    HashBuffer serialBuffer;
+    std::ostream serialOut(&serialBuffer);
+    auto begin = std::chrono::steady_clock::now();
+    std::size_t ticks = runSerial(scenario, timeStep, config, reader, serialOut, nullptr);
+    double serialSeconds = secondsSince(begin);
+
+    HashBuffer stageBuffer;
+    std::ostream stageOut(&stageBuffer);
+    double stageSeconds[3] = {0.0, 0.0, 0.0};
+    runSerial(scenario, timeStep, config, reader, stageOut, stageSeconds);
+    double stagesSeconds = stageSeconds[0] + stageSeconds[1] + stageSeconds[2];
+
+    HashBuffer pipelinedBuffer;
+    std::ostream pipelinedOut(&pipelinedBuffer);
+    PipelineStats stats;
+    begin = std::chrono::steady_clock::now();
+    replayPipelined(scenario, timeStep, config, reader, &pipelinedOut, &stats);
+    double pipelinedSeconds = secondsSince(begin);
+    config.unregisterReader(reader);
+
+    /// With a core per stage, the slowest stage sets the pace.
+    double slowest = std::max(stageSeconds[0], std::max(stageSeconds[1], stageSeconds[2]));
+    bool identical = serialBuffer.hash == pipelinedBuffer.hash && stats.ticks == ticks;
+
+    std::cout << ticks << " ticks of " << timeStep << "s on " << std::thread::hardware_concurrency() << " cores."
+              << std::endl;
+    std::cout << std::fixed << std::setprecision(1)
+              << "serial " << serialSeconds * 1000.0 << " ms: simulator " << 100.0 * stageSeconds[0] / stagesSeconds
+              << "%, controller " << 100.0 * stageSeconds[1] / stagesSeconds
+              << "%, output " << 100.0 * stageSeconds[2] / stagesSeconds << "%; "
+              << std::setprecision(2) << stagesSeconds / slowest << "x bound with a core per stage." << std::endl;
+    std::cout << std::setprecision(1)
+              << "pipelined " << pipelinedSeconds * 1000.0 << " ms (" << std::setprecision(2)
+              << serialSeconds / pipelinedSeconds << "x), output " << (identical ? "identical" : "DIFFERS")
+              << "; waits: simulator " << stats.simulatorWaits << ", controller " << stats.controllerWaits
+              << ", output " << stats.outputWaits << "." << std::endl;
+
+    return identical ? 0 : 1;
+}
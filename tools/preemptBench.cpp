@@ -0,0 +1,185 @@
+#include "impl/host/controllerHost.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+///  @brief Check no two crossing lanes are GREEN together.
+///
+////////////////////////////////////////////////////////////
+static bool isSafe(const TrafficSignals &signals)
+{
+    LaneMask green = 0;
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        if (signals[lane] == SignalState::GREEN)
+        {
+            green |= laneBit(lane);
+        }
+    }
+
+    for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+    {
+        if ((green & laneBit(lane)) && (OPPOSING_LANES[lane] & green))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Get the ticks a preemption needs, from the first
+///  tick after it is serviced until its pattern is GREEN.
+///
+///  The YELLOW ends on the first tick whose clock is past
+///  PREEMPTION_YELLOW_TIME, the all-RED holds at least one
+///  tick, and the GREEN waits for the clock to pass both.
+///
+///  @param timeStep Shard clock advance per tick
+///  @return std::uint64_t Ticks, counting the first
+////////////////////////////////////////////////////////////
+static std::uint64_t ticksToGreen(IClock::Time timeStep)
+{
+    auto ticksUntil = [timeStep](IClock::Time time) {
+        return static_cast<std::uint64_t>((time + timeStep - 1) / timeStep);
+    };
+    std::uint64_t red = ticksUntil(TrafficLightControllerApp::PREEMPTION_YELLOW_TIME);
+    std::uint64_t green = std::max(red + 1, ticksUntil(TrafficLightControllerApp::PREEMPTION_YELLOW_TIME +
+                                                       TrafficLightControllerApp::PREEMPTION_RED_TIME));
+    return green + 1;
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    std::uint32_t numControllers = argc > 1 ? static_cast<std::uint32_t>(std::atoi(argv[1])) : 5000;
+    unsigned numShards = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 0;
+    unsigned seconds = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 10;
+    unsigned requestHz = argc > 4 ? static_cast<unsigned>(std::atoi(argv[4])) : 500;
+    unsigned tickHz = argc > 5 ? static_cast<unsigned>(std::atoi(argv[5])) : 10;
+
+    if (numControllers == 0 || seconds == 0 || requestHz == 0)
+    {
+        std::cerr << "usage: preemptBench [controllers] [shards] [seconds] [requestHz] [tickHz, 0 to free-run]" << std::endl;
+        return 1;
+    }
+
+    if (numShards == 0)
+    {
+        numShards = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    HostConfig config = defaultHostConfig();
+    config.numShards = numShards;
+    config.shardCapacity = (numControllers + numShards - 1) / numShards;
+    config.tickPeriod = std::chrono::microseconds(tickHz ? 1000000 / tickHz : 0);
+    config.transitionTable = true;
+    ControllerHost host(config);
+
+    std::vector<ControllerId> ids;
+    for (std::uint32_t i = 0; i < numControllers; i++)
+    {
+        ids.push_back(host.addController());
+    }
+
+    std::cout << numControllers << " controllers on " << host.numShards() << " shards, "
+              << (tickHz ? std::to_string(tickHz) + " Hz ticks" : std::string("free-running")) << ", "
+              << requestHz << " preemptions and releases/s for " << seconds << " s." << std::endl;
+
+    host.start();
+
+    /// A field gateway keeps every controller's sensors moving
+    /// and watches for conflicting greens.
+    std::atomic<bool> feeding(true);
+    std::atomic<unsigned> unsafe(0);
+    std::thread feeder([&]() {
+        std::mt19937 rng(7);
+        while (feeding.load(std::memory_order_relaxed))
+        {
+            for (ControllerId id : ids)
+            {
+                host.setSensorMask(id, static_cast<SensorMask>(rng()));
+                unsafe.fetch_add(!isSafe(host.signals(id)), std::memory_order_relaxed);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+
+    /// Emergency vehicles: each request preempts a random
+    /// controller for a random pattern, or releases it if it
+    /// is already held.
+    std::mt19937 rng(11);
+    std::vector<bool> held(ids.size(), false);
+    std::uint64_t requests = 0;
+    auto period = std::chrono::nanoseconds(1000000000 / requestHz);
+    auto begin = std::chrono::steady_clock::now();
+    auto end = begin + std::chrono::seconds(seconds);
+    for (auto next = begin; next < end; next += period)
+    {
+        std::this_thread::sleep_until(next);
+
+        std::size_t index = rng() % ids.size();
+        bool queued = held[index] ? host.releasePreemption(ids[index])
+                                  : host.preempt(ids[index], static_cast<TrafficLightPattern>(rng() % NUM_PATTERNS));
+        held[index] = !held[index];
+        requests += queued;
+    }
+
+    host.stop();
+    feeding.store(false);
+    feeder.join();
+
+    std::cout << "shard  requests  change p99(us)  p99.9(us)   max(us)  green max(ms)  tick max(us)" << std::endl;
+
+    std::uint64_t serviced = 0;
+    std::uint64_t tickMax = 0;
+    std::uint64_t changeMax = 0;
+    std::uint64_t greenMax = 0;
+    for (unsigned shard = 0; shard < host.numShards(); shard++)
+    {
+        ShardReport report = host.report(shard);
+        serviced += report.preemptions;
+        tickMax = std::max(tickMax, report.max);
+        changeMax = std::max(changeMax, report.preemptMax);
+        greenMax = std::max(greenMax, report.preemptGreenMax);
+
+        std::cout << std::setw(5) << report.shard
+                  << std::setw(10) << report.preemptions
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(16) << report.preemptP99 / 1000.0
+                  << std::setw(11) << report.preemptP999 / 1000.0
+                  << std::setw(10) << report.preemptMax / 1000.0
+                  << std::setw(15) << report.preemptGreenMax / 1e6
+                  << std::setw(14) << report.max / 1000.0 << std::endl;
+    }
+
+    std::cout << "Serviced " << serviced << " of " << requests << " requests." << std::endl;
+
+    /// The pattern is GREEN after the change, the clearance
+    /// ticks (the first up to a period away) and the last
+    /// tick's own run time. Free-running ticks are back to back.
+    std::uint64_t ticks = ticksToGreen(config.timeStep);
+    double boundMs = tickHz ? (changeMax + tickMax) / 1e6 + ticks * 1000.0 / tickHz
+                            : (changeMax + ticks * tickMax) / 1e6;
+    std::cout << std::setprecision(2) << "Request to GREEN within " << boundMs << " ms ("
+              << ticks << " ticks after the change); worst seen " << greenMax / 1e6 << " ms." << std::endl;
+
+    if (unsafe.load())
+    {
+        std::cout << unsafe.load() << " samples showed conflicting greens." << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
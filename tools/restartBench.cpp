@@ -0,0 +1,121 @@
+#include "impl/host/controllerHost.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+////////////////////////////////////////////////////////////
+///  @brief Get the microseconds since a time
+///
+////////////////////////////////////////////////////////////
+static double microsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Run a host to its tick limit, optionally keeping
+///  state, and time its restart.
+///
+///  @param config Host settings
+///  @param numControllers Controllers to add
+///  @param path State file, empty to start cold
+///  @param attachMicros Set to the time attachState() took
+///  @param firstTickMicros Set to the time from construction
+///  to the end of the first tick
+///  @param resumedAt Set to the clock time the host resumed at
+///  @param tickMicros Set to the median tick time
+///  @return true If the state file attached
+////////////////////////////////////////////////////////////
+static bool runHost(const HostConfig &config, std::uint32_t numControllers, const std::string &path,
+                    double &attachMicros, double &firstTickMicros, IClock::Time &resumedAt, double &tickMicros)
+{
+    auto begin = std::chrono::steady_clock::now();
+    ControllerHost host(config);
+
+    std::string error;
+    auto attach = std::chrono::steady_clock::now();
+    if (!path.empty() && !host.attachState(path, error))
+    {
+        std::cerr << error << std::endl;
+        return false;
+    }
+    attachMicros = microsSince(attach);
+    resumedAt = host.state().isOpen() ? host.state().clock(0) : 0;
+
+    for (std::uint32_t i = 0; i < numControllers; i++)
+    {
+        host.addController();
+    }
+    host.start();
+
+    while (host.report(0).ticks == 0)
+    {
+        std::this_thread::yield();
+    }
+    firstTickMicros = microsSince(begin);
+
+    host.wait();
+    tickMicros = host.report(0).p50 / 1000.0;
+    return true;
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    std::string path = argc > 1 ? argv[1] : "/tmp/tlc-state.bin";
+    std::uint32_t numControllers = argc > 2 ? static_cast<std::uint32_t>(std::atoi(argv[2])) : 10000;
+    std::uint64_t numTicks = argc > 3 ? static_cast<std::uint64_t>(std::atoll(argv[3])) : 100;
+
+    if (numControllers == 0 || numTicks == 0)
+    {
+        std::cerr << "usage: restartBench [stateFile] [controllers] [ticks]" << std::endl;
+        return 1;
+    }
+
+    /// One shard, so the first tick's time is the whole
+    /// restart rather than the fastest shard's. The first tick
+    /// of a run with state also faults in the file's pages.
+    HostConfig config = defaultHostConfig();
+    config.numShards = 1;
+    config.shardCapacity = numControllers;
+    config.timeStep = 7;
+    config.tickPeriod = std::chrono::microseconds(0);
+    config.tickLimit = numTicks;
+    config.transitionTable = true;
+
+    std::remove(path.c_str());
+
+    std::cout << numControllers << " controllers, " << numTicks << " ticks per run." << std::endl;
+    std::cout << "run          attach(us)  first tick(us)  resumed at  tick p50(us)" << std::endl;
+
+    const char *runs[] = {"cold", "first", "restart", "restart"};
+    for (unsigned run = 0; run < 4; run++)
+    {
+        double attachMicros = 0.0;
+        double firstTickMicros = 0.0;
+        IClock::Time resumedAt = 0;
+        double tickMicros = 0.0;
+        if (!runHost(config, numControllers, run == 0 ? "" : path, attachMicros, firstTickMicros,
+                     resumedAt, tickMicros))
+        {
+            return 1;
+        }
+
+        std::cout << std::left << std::setw(9) << runs[run] << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << attachMicros
+                  << std::setw(16) << firstTickMicros
+                  << std::setw(12) << resumedAt
+                  << std::setw(14) << tickMicros << std::endl;
+    }
+
+    return 0;
+}
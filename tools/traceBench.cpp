@@ -0,0 +1,78 @@
+#include "impl/trace/trace.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+/// Keeps the compiler from dropping the timed loops
+static volatile std::uint64_t sink = 0;
+
+////////////////////////////////////////////////////////////
+///  @brief Get the nanoseconds per iteration of a loop body
+///
+////////////////////////////////////////////////////////////
+template <typename Body>
+static double nanosPerIteration(std::size_t iterations, Body body)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+        body(i);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return seconds * 1e9 / static_cast<double>(iterations);
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    int rounds = argc > 1 ? std::atoi(argv[1]) : 50;
+    if (rounds < 1)
+    {
+        std::cerr << "usage: traceBench [rounds]" << std::endl;
+        return 1;
+    }
+
+    /// Stay within one buffer, so no span is dropped.
+    const std::size_t spans = Tracer::BUFFER_CAPACITY;
+    Tracer::registerThread("bench");
+
+    double empty = 0.0;
+    double span = 0.0;
+    double scope = 0.0;
+    for (int round = 0; round < rounds; round++)
+    {
+        empty += nanosPerIteration(spans, [](std::size_t i) { sink = sink + i; });
+
+        Tracer::reset();
+        span += nanosPerIteration(spans, [](std::size_t i)
+        {
+            TraceSpan traced("bench");
+            sink = sink + i;
+        });
+
+        Tracer::reset();
+        scope += nanosPerIteration(spans, [](std::size_t i)
+        {
+            TRACE_SCOPE("bench");
+            sink = sink + i;
+        });
+    }
+    Tracer::reset();
+
+#if defined(TLC_TRACE_ENABLED)
+    const char *build = "compiled in";
+#else
+    const char *build = "compiled out";
+#endif
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "TraceSpan " << (span - empty) / rounds << " ns per span; "
+              << "TRACE_SCOPE (" << build << ") " << (scope - empty) / rounds << " ns per span; "
+              << "empty loop " << empty / rounds << " ns." << std::endl;
+    return 0;
+}
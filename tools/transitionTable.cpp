@@ -0,0 +1,122 @@
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/app/transitionTable.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/// Ticks in the repeated sensor stream, a power of two
+static constexpr std::size_t STREAM_TICKS = 4096;
+
+////////////////////////////////////////////////////////////
+///  @brief Time the ticks of a controller through a fixed
+///  stream of sensors, repeated.
+///
+///  @param table Table to attach, nullptr for the rules
+///  @param stream Sensors of each tick
+///  @param numTicks Ticks to run
+///  @return double Nanoseconds per tick
+////////////////////////////////////////////////////////////
+static double nanosPerTick(const TransitionTable *table, const std::vector<VehicleSensors> &stream, int numTicks)
+{
+    Clock clock;
+    VehicleSensors sensors;
+    sensors.fill(SensorState::CLEAR);
+    TrafficLightControllerApp tlcApp(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+    tlcApp.attachTransitionTable(table);
+    tlcApp.initApp();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < numTicks; tick++)
+    {
+        sensors = stream[static_cast<std::size_t>(tick) & (STREAM_TICKS - 1)];
+        tlcApp.run();
+        clock.advance(1);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / numTicks;
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    /// With a path, the table is also written there as C++.
+    std::string emitPath = argc > 1 ? argv[1] : "";
+    int numTicks = argc > 2 ? std::atoi(argv[2]) : 2000000;
+
+    auto start = std::chrono::steady_clock::now();
+    TransitionTable table = TransitionTable::generate();
+    double generateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    std::string error;
+    bool verified = verifyTransitionTable(table, error);
+    double verifyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::array<std::size_t, 256> uses = {};
+    std::size_t restarts = 0;
+    for (std::uint32_t index = 0; index < TransitionTable::SIZE; index++)
+    {
+        std::uint8_t entry = table.at(index);
+        uses[entry]++;
+        restarts += (entry & TransitionTable::RESTARTED) != 0;
+    }
+    std::size_t distinct = 0;
+    for (std::size_t count : uses)
+    {
+        distinct += count != 0;
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << TransitionTable::SIZE << " states, " << TransitionTable::SIZE / 1024 << " KiB, "
+              << distinct << " distinct entries, " << restarts << " states change pattern." << std::endl;
+    std::cout << "Generated in " << generateMs << " ms, verified in " << verifyMs << " ms: "
+              << (verified ? "matches the rules on every state" : error) << std::endl;
+
+    /// Vehicles come and go every few ticks on each lane; the
+    /// stream stays in cache so only the ticks are timed.
+    std::mt19937 rng(1);
+    std::vector<VehicleSensors> stream(STREAM_TICKS);
+    VehicleSensors sensors;
+    sensors.fill(SensorState::CLEAR);
+    for (VehicleSensors &tick : stream)
+    {
+        for (SensorState &sensor : sensors)
+        {
+            if (rng() % 8 == 0)
+            {
+                sensor = sensor == SensorState::SET ? SensorState::CLEAR : SensorState::SET;
+            }
+        }
+        tick = sensors;
+    }
+
+    double rulesNs = nanosPerTick(nullptr, stream, numTicks);
+    double tableNs = nanosPerTick(&table, stream, numTicks);
+    std::cout << "Per tick: rules " << std::setprecision(2) << rulesNs << " ns, table " << tableNs
+              << " ns (" << std::setprecision(1) << rulesNs / tableNs << "x)." << std::endl;
+
+    if (!emitPath.empty())
+    {
+        std::ofstream out(emitPath);
+        table.emit(out, "TRANSITION_TABLE");
+        if (!out)
+        {
+            std::cerr << "Cannot write " << emitPath << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << emitPath << std::endl;
+    }
+
+    return verified ? 0 : 1;
+}
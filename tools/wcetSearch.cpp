@@ -0,0 +1,463 @@
+#include "impl/app/TrafficLightControllerApp.hpp"
+#include "impl/simulator/scenarios.hpp"
+#include "impl/util/latencyHistogram.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define WCET_UNIT "cycles"
+#else
+#define WCET_UNIT "ns"
+#endif
+
+/// Longest input, in ticks
+static constexpr std::size_t MAX_STEPS = 256;
+
+/// Worst inputs kept and saved
+static constexpr std::size_t WORST_KEPT = 16;
+
+/// Runs of each input; each tick keeps its fastest run, which
+/// filters out interrupts and cache misses from elsewhere
+static constexpr unsigned REPEATS = 3;
+
+/// Runs of each worst input when re-measured for the report
+static constexpr unsigned FINAL_REPEATS = 1000;
+
+/// Clock advances a mutation picks from: the tick period, the
+/// pattern timing limits and the max wait time
+static constexpr IClock::Time INTERESTING_DELTAS[] = {1, 1, 1, 2, 9, 10, 11, 29, 30, 31, 40, 59, 60, 61, 119, 120, 121};
+
+/// One controller tick: how far the clock moves, then the sensors
+struct Step
+{
+    IClock::Time delta; ///< clock advance before the tick
+    LaneMask sensors;   ///< lanes SET on the tick
+};
+
+using Input = std::vector<Step>;
+
+/// What running an input measured
+struct Execution
+{
+    std::vector<std::uint64_t> ticks;   ///< time of each tick, fastest of the repeats
+    std::vector<std::uint16_t> features; ///< behaviour seen on each tick
+    std::uint64_t worst;                ///< slowest tick
+    std::size_t worstTick;              ///< index of the slowest tick
+};
+
+/// An input kept for mutation
+struct Entry
+{
+    Input input;
+    std::uint64_t worst;
+    std::size_t worstTick;
+};
+
+////////////////////////////////////////////////////////////
+///  @brief Read the cycle counter, or a nanosecond clock
+///  where there is none.
+///
+////////////////////////////////////////////////////////////
+static inline std::uint64_t now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    std::uint64_t cycles = __rdtsc();
+    _mm_lfence();
+    return cycles;
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Name the behaviour of one tick: the pattern it
+///  started in, how many patterns it advanced, how many
+///  sensors were SET on green and red lanes, and how far the
+///  clock moved. Inputs reaching a new feature are kept.
+///
+////////////////////////////////////////////////////////////
+static std::uint16_t featureOf(TrafficLightPattern before, TrafficLightPattern after, const Step &step)
+{
+    unsigned advanced = (after + NUM_PATTERNS - before) % NUM_PATTERNS;
+    LaneMask green = PATTERN_TRANSITIONS[before].greenLanes;
+    unsigned setGreen = static_cast<unsigned>(std::bitset<8>(step.sensors & green).count());
+    unsigned setRed = static_cast<unsigned>(std::bitset<8>(step.sensors & ~green).count());
+    unsigned deltaBucket = step.delta <= 1 ? 0 : step.delta < 10 ? 1 : step.delta < 60 ? 2 : 3;
+
+    return static_cast<std::uint16_t>(before | advanced << 2 | setGreen << 4 | setRed << 8 | deltaBucket << 12);
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Run an input through fresh controllers and time
+///  every tick.
+///
+///  @param input Input to run
+///  @param repeats Runs; each tick keeps its fastest
+///  @param execution Set to what was measured
+///  @param watchTick Tick whose every run is recorded
+///  @param watch Histogram for watchTick, nullptr for none
+////////////////////////////////////////////////////////////
+static void execute(const Input &input, unsigned repeats, Execution &execution,
+                    std::size_t watchTick = 0, LatencyHistogram *watch = nullptr)
+{
+    execution.ticks.assign(input.size(), ~0ull);
+    execution.features.assign(input.size(), 0);
+
+    for (unsigned repeat = 0; repeat < repeats; repeat++)
+    {
+        Clock clock;
+        VehicleSensors sensors;
+        sensors.fill(SensorState::CLEAR);
+        TrafficLightControllerApp tlcApp(clock, sensors, DEFAULT_MAX_WAIT_TIME, nullptr);
+        tlcApp.initApp();
+
+        for (std::size_t tick = 0; tick < input.size(); tick++)
+        {
+            const Step &step = input[tick];
+            clock.advance(step.delta);
+            for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+            {
+                sensors[lane] = (step.sensors & laneBit(lane)) ? SensorState::SET : SensorState::CLEAR;
+            }
+
+            TrafficLightPattern before = tlcApp.getActivePattern();
+            std::uint64_t start = now();
+            tlcApp.run();
+            std::uint64_t elapsed = now() - start;
+
+            execution.ticks[tick] = std::min(execution.ticks[tick], elapsed);
+            if (watch && tick == watchTick)
+            {
+                watch->record(elapsed);
+            }
+            execution.features[tick] = featureOf(before, tlcApp.getActivePattern(), step);
+        }
+    }
+
+    execution.worst = 0;
+    execution.worstTick = 0;
+    for (std::size_t tick = 0; tick < input.size(); tick++)
+    {
+        if (execution.ticks[tick] > execution.worst)
+        {
+            execution.worst = execution.ticks[tick];
+            execution.worstTick = tick;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Turn a scenario into an input, one tick per
+///  timeStep seconds.
+///
+////////////////////////////////////////////////////////////
+static Input fromScenario(const Scenario &scenario, IClock::Time timeStep)
+{
+    Input input;
+    Simulator simulator(scenario);
+    while (!simulator.done() && input.size() < MAX_STEPS)
+    {
+        LaneMask sensors = 0;
+        for (unsigned lane = 0; lane < Lane::COUNT; lane++)
+        {
+            sensors |= simulator.sensors()[lane] == SensorState::SET ? laneBit(lane) : 0;
+        }
+        input.push_back({input.empty() ? 0 : timeStep, sensors});
+        simulator.advance(timeStep);
+    }
+    return input;
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Apply one to four random edits.
+///
+////////////////////////////////////////////////////////////
+static Input mutate(const Input &parent, const std::vector<Entry> &corpus, std::mt19937_64 &rng)
+{
+    Input input = parent.empty() ? Input(1, Step{1, 0}) : parent;
+    unsigned edits = 1 + rng() % 4;
+
+    for (unsigned edit = 0; edit < edits; edit++)
+    {
+        std::size_t at = rng() % input.size();
+        switch (rng() % 7)
+        {
+            case 0:
+                input[at].sensors ^= laneBit(rng() % Lane::COUNT);
+                break;
+
+            case 1:
+                input[at].sensors = static_cast<LaneMask>(rng());
+                break;
+
+            case 2:
+                input[at].delta = INTERESTING_DELTAS[rng() % (sizeof(INTERESTING_DELTAS) / sizeof(IClock::Time))];
+                break;
+
+            case 3:
+            {
+                /// Repeat a stretch, to reach timing limits with
+                /// the same sensors.
+                std::size_t length = 1 + rng() % std::min<std::size_t>(16, input.size() - at);
+                Input stretch(input.begin() + at, input.begin() + at + length);
+                input.insert(input.begin() + at, stretch.begin(), stretch.end());
+                break;
+            }
+
+            case 4:
+                if (input.size() > 1)
+                {
+                    std::size_t length = 1 + rng() % std::min<std::size_t>(16, input.size() - at);
+                    input.erase(input.begin() + at, input.begin() + std::min(input.size() - 1, at + length));
+                }
+                break;
+
+            case 5:
+            {
+                /// Splice in the tail of another kept input.
+                const Input &other = corpus[rng() % corpus.size()].input;
+                std::size_t from = rng() % other.size();
+                input.resize(at);
+                input.insert(input.end(), other.begin() + from, other.end());
+                break;
+            }
+
+            default:
+            {
+                LaneMask fill = (rng() & 1) ? ALL_LANES : 0;
+                std::size_t length = 1 + rng() % std::min<std::size_t>(8, input.size() - at);
+                for (std::size_t tick = at; tick < at + length; tick++)
+                {
+                    input[tick].sensors = fill;
+                }
+                break;
+            }
+        }
+
+        if (input.empty())
+        {
+            input.push_back({1, 0});
+        }
+        if (input.size() > MAX_STEPS)
+        {
+            input.resize(MAX_STEPS);
+        }
+    }
+
+    return input;
+}
+
+static std::string corpusFile(const std::string &directory, std::size_t rank)
+{
+    std::string number = std::to_string(rank);
+    return directory + "/wcet-" + std::string(2 - std::min<std::size_t>(2, number.size()), '0') + number + ".txt";
+}
+
+////////////////////////////////////////////////////////////
+///  @brief Read a saved input: one "delta sensors" line per
+///  tick, sensors in hex.
+///
+////////////////////////////////////////////////////////////
+static bool loadInput(const std::string &path, Input &input)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        return false;
+    }
+
+    input.clear();
+    IClock::Time delta;
+    unsigned sensors;
+    while (input.size() < MAX_STEPS && in >> std::dec >> delta >> std::hex >> sensors)
+    {
+        input.push_back({delta, static_cast<LaneMask>(sensors)});
+    }
+    return !input.empty();
+}
+
+static bool saveInput(const std::string &path, const Input &input)
+{
+    std::ofstream out(path);
+    for (const Step &step : input)
+    {
+        out << std::dec << step.delta << " " << std::hex << static_cast<unsigned>(step.sensors) << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+int main
+(
+    int argc,
+    char const *argv[]
+)
+{
+    std::uint64_t iterations = argc > 1 ? static_cast<std::uint64_t>(std::atoll(argv[1])) : 20000;
+    std::string directory = argc > 2 ? argv[2] : "";
+    std::uint64_t budget = argc > 3 ? static_cast<std::uint64_t>(std::atoll(argv[3])) : 0;
+
+    std::mt19937_64 rng(11);
+    std::vector<Entry> corpus;
+    std::vector<Entry> worst;
+    std::vector<std::uint64_t> featureBest(1u << 16, 0);
+    std::size_t featuresSeen = 0;
+    LatencyHistogram distribution;
+    Execution execution;
+
+    /// Keep an input when it shows new behaviour, or known
+    /// behaviour a good deal slower than before.
+    auto consider = [&](const Input &input) {
+        execute(input, REPEATS, execution);
+
+        bool interesting = false;
+        for (std::size_t tick = 0; tick < input.size(); tick++)
+        {
+            distribution.record(execution.ticks[tick]);
+
+            std::uint64_t &best = featureBest[execution.features[tick]];
+            if (best == 0)
+            {
+                featuresSeen++;
+                interesting = true;
+            }
+            if (execution.ticks[tick] > best + best / 8)
+            {
+                best = execution.ticks[tick];
+                interesting = true;
+            }
+        }
+
+        Entry entry = {input, execution.worst, execution.worstTick};
+        if (interesting)
+        {
+            corpus.push_back(entry);
+        }
+
+        if (worst.size() < WORST_KEPT || execution.worst > worst.back().worst)
+        {
+            worst.push_back(entry);
+            std::sort(worst.begin(), worst.end(), [](const Entry &a, const Entry &b) { return a.worst > b.worst; });
+            worst.resize(std::min(worst.size(), WORST_KEPT));
+        }
+    };
+
+    /// Seeds: the hand-written scenarios at two tick periods,
+    /// plus whatever an earlier search saved.
+    const Scenario *scenarios[] = {&SCENARIO_1, &SCENARIO_2, &SCENARIO_3, &SCENARIO_4};
+    std::uint64_t scenarioWorst = 0;
+    for (const Scenario *scenario : scenarios)
+    {
+        for (IClock::Time timeStep : {1, 10})
+        {
+            consider(fromScenario(*scenario, timeStep));
+            scenarioWorst = std::max(scenarioWorst, execution.worst);
+        }
+    }
+
+    std::size_t loaded = 0;
+    for (std::size_t rank = 0; !directory.empty() && rank < WORST_KEPT; rank++)
+    {
+        Input input;
+        if (loadInput(corpusFile(directory, rank), input))
+        {
+            consider(input);
+            loaded++;
+        }
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    for (std::uint64_t iteration = 0; iteration < iterations; iteration++)
+    {
+        /// Half the time grow from the worst inputs, half from
+        /// the coverage corpus.
+        const std::vector<Entry> &pool = (rng() & 1) ? worst : corpus;
+        consider(mutate(pool[rng() % pool.size()].input, corpus, rng));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    /// Re-measure the worst inputs many times: the fastest
+    /// run of a tick is the cost of its path, the spread of its
+    /// runs is what the platform adds on top.
+    std::vector<LatencyHistogram> spread(worst.size());
+    for (std::size_t rank = 0; rank < worst.size(); rank++)
+    {
+        Entry &entry = worst[rank];
+        execute(entry.input, FINAL_REPEATS, execution);
+        entry.worst = execution.worst;
+        entry.worstTick = execution.worstTick;
+        execute(entry.input, FINAL_REPEATS, execution, entry.worstTick, &spread[rank]);
+    }
+
+    std::vector<std::size_t> order(worst.size());
+    for (std::size_t rank = 0; rank < order.size(); rank++)
+    {
+        order[rank] = rank;
+    }
+    std::sort(order.begin(), order.end(), [&worst](std::size_t a, std::size_t b) { return worst[a].worst > worst[b].worst; });
+
+    std::cout << iterations << " inputs in " << std::fixed << std::setprecision(1) << seconds << "s, "
+              << corpus.size() << " kept, " << featuresSeen << " behaviours, "
+              << loaded << " loaded from the saved corpus." << std::endl;
+    std::cout << "Per-tick time over " << distribution.count() << " ticks (" WCET_UNIT "):" << std::endl;
+    std::cout << "     p50     p90     p99   p99.9     max" << std::endl;
+    std::cout << std::setw(8) << distribution.percentile(0.50)
+              << std::setw(8) << distribution.percentile(0.90)
+              << std::setw(8) << distribution.percentile(0.99)
+              << std::setw(8) << distribution.percentile(0.999)
+              << std::setw(8) << distribution.max() << std::endl;
+
+    std::cout << "Worst inputs, slowest tick re-run " << FINAL_REPEATS << " times (" WCET_UNIT
+              << "; scenarios' slowest tick " << scenarioWorst << "):" << std::endl;
+    std::cout << "rank  ticks  tick  delta  sensors  advanced     min     p50     p99     max" << std::endl;
+    for (std::size_t rank = 0; rank < order.size(); rank++)
+    {
+        const Entry &entry = worst[order[rank]];
+        const LatencyHistogram &runs = spread[order[rank]];
+        execute(entry.input, 1, execution);
+        const Step &step = entry.input[entry.worstTick];
+        unsigned advanced = (execution.features[entry.worstTick] >> 2) & 3u;
+
+        std::cout << std::setw(4) << rank
+                  << std::setw(7) << entry.input.size()
+                  << std::setw(6) << entry.worstTick
+                  << std::setw(7) << step.delta
+                  << "     0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<unsigned>(step.sensors)
+                  << std::dec << std::setfill(' ')
+                  << std::setw(10) << advanced
+                  << std::setw(8) << entry.worst
+                  << std::setw(8) << runs.percentile(0.50)
+                  << std::setw(8) << runs.percentile(0.99)
+                  << std::setw(8) << runs.max() << std::endl;
+
+        if (!directory.empty() && !saveInput(corpusFile(directory, rank), entry.input))
+        {
+            std::cerr << "Cannot write " << corpusFile(directory, rank) << std::endl;
+            directory.clear();
+        }
+    }
+
+    /// The budget is checked against the worst path cost, not
+    /// the worst single run, which an interrupt can inflate.
+    if (budget != 0 && !order.empty() && worst[order.front()].worst > budget)
+    {
+        std::cout << "WCET " << worst[order.front()].worst << " exceeds the budget of " << budget << " " WCET_UNIT "."
+                  << std::endl;
+        return 1;
+    }
+
+    return 0;
+}